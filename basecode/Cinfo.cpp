@@ -25,7 +25,8 @@ Cinfo::Cinfo(const string& name, const Cinfo* baseCinfo, Finfo** finfoArray,
       baseCinfo_(baseCinfo),
       dinfo_(d),
       numBindIndex_(0),
-      banCreation_(banCreation)
+      banCreation_(banCreation),
+      parallelProcess_(false)
 {
     if(cinfoMap().find(name) != cinfoMap().end()) {
         cout << "Warning: Duplicate Cinfo name " << name << endl;
@@ -50,7 +51,8 @@ Cinfo::Cinfo()
       baseCinfo_(0),
       dinfo_(0),
       numBindIndex_(0),
-      banCreation_(false)
+      banCreation_(false),
+      parallelProcess_(false)
 {
     ;
 }
@@ -60,7 +62,8 @@ Cinfo::Cinfo(const Cinfo& other)
       baseCinfo_(0),
       dinfo_(0),
       numBindIndex_(0),
-      banCreation_(false)
+      banCreation_(false),
+      parallelProcess_(false)
 {
     ;
 }
@@ -274,6 +277,16 @@ bool Cinfo::banCreation() const
     return banCreation_;
 }
 
+void Cinfo::setParallelProcess()
+{
+    parallelProcess_ = true;
+}
+
+bool Cinfo::parallelProcess() const
+{
+    return parallelProcess_;
+}
+
 /**
  * looks up OpFunc by FuncId
  */
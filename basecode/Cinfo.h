@@ -100,6 +100,19 @@ public:
      * in isolation but only as a child of another class.
      */
     bool banCreation() const;
+
+    /**
+     * Declares that the process function of this class only touches the
+     * data of the entry it is called on, apart from messages it sends,
+     * and that it does not look at anything those sends give back. The
+     * Clock may then call it for many entries at once on its thread
+     * pool, delivering the sends after the tick. This is not inherited,
+     * as a derived class may override process.
+     */
+    void setParallelProcess();
+
+    /// True if setParallelProcess has been called for this class.
+    bool parallelProcess() const;
     //////////////////////////////////////////////////////////////////////////
 
     const OpFunc* getOpFunc(FuncId fid) const;
@@ -292,6 +305,8 @@ private:
 
     bool banCreation_;
 
+    bool parallelProcess_;
+
     /**
      * This looks up Finfos by name.
      */
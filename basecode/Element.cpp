@@ -7,6 +7,7 @@
 ** See the file COPYING.LIB for the full notice.
 **********************************************************************/
 
+#include <thread>
 #include "header.h"
 #include "FuncOrder.h"
 #include "HopFunc.h"
@@ -19,14 +20,32 @@ Element::Element( Id id, const Cinfo* c, const string& name )
       id_( id ),
       cinfo_( c ),
       msgBinding_( c->numBindIndex() ),
-      msgDigest_( c->numBindIndex() ),
+      digestStart_( c->numBindIndex() + 1, 0 ),
       tick_( -1 ),
       isRewired_( false ),
-      isDoomed_( false )
+      digestVersion_( 0 ),
+      isDoomed_( false ),
+      childIndexBuilt_( false ),
+      pathCacheIndex_( 0 ),
+      pathCacheEpoch_( 0 )
 {
     id.bindIdToElement( this );
 }
 
+std::atomic< unsigned long > Element::pathEpoch_( 1 );
+
+/**
+ * The thread that loaded MOOSE, which runs the Shell. Only it builds or
+ * uses the lazily filled caches on Element, since process calls and
+ * searches may run on pool threads at the same time.
+ */
+static const std::thread::id mainThreadId = std::this_thread::get_id();
+
+static bool onMainThread()
+{
+    return std::this_thread::get_id() == mainThreadId;
+}
+
 
 Element::~Element()
 {
@@ -60,7 +79,139 @@ const string& Element::getName() const
 
 void Element::setName( const string& val )
 {
+    static const DestFinfo* pf = dynamic_cast< const DestFinfo* >(
+            Neutral::initCinfo()->findFinfo( "parentMsg" ) );
+    static const FuncId pafid = pf->getFid();
+
+    if ( val == name_ )
+        return;
+    // Keep the parent's child index in step.
+    if ( !isDoomed() && id_ != Id() )
+    {
+        ObjId mid = findCaller( pafid );
+        const Msg* m = mid.bad() ? 0 : Msg::getMsg( mid );
+        if ( m && m->e1()->childIndexBuilt_ )
+        {
+            m->e1()->unindexChild( mid );
+            m->e1()->indexChild( mid, val );
+        }
+    }
     name_ = val;
+    invalidatePaths();
+}
+
+//////////////////////////////////////////////////////////////
+// Child index and path cache
+//////////////////////////////////////////////////////////////
+
+/// True if the binding is one from a parent to a child.
+static bool isChildBinding( FuncId fid, BindIndex b )
+{
+    static const SrcFinfo* cf = dynamic_cast< const SrcFinfo* >(
+            Neutral::initCinfo()->findFinfo( "childOut" ) );
+    static const DestFinfo* pf = dynamic_cast< const DestFinfo* >(
+            Neutral::initCinfo()->findFinfo( "parentMsg" ) );
+    static const BindIndex bi = cf->getBindIndex();
+    static const FuncId pafid = pf->getFid();
+    return b == bi && fid == pafid;
+}
+
+void Element::getChildMsgs( const string& name, vector< ObjId >& mids ) const
+{
+    if ( !childIndexBuilt_ )
+    {
+        if ( !onMainThread() )
+        {
+            scanChildMsgs( name, mids );
+            return;
+        }
+        buildChildIndex();
+    }
+    unordered_map< string, vector< ObjId > >::const_iterator i =
+        childIndex_.find( name );
+    if ( i == childIndex_.end() )
+        mids.clear();
+    else
+        mids = i->second;
+}
+
+void Element::scanChildMsgs( const string& name, vector< ObjId >& mids ) const
+{
+    mids.clear();
+    for ( unsigned int b = 0; b < msgBinding_.size(); ++b )
+    {
+        for ( vector< MsgFuncBinding >::const_iterator
+                i = msgBinding_[b].begin(); i != msgBinding_[b].end(); ++i )
+        {
+            if ( !isChildBinding( i->fid, b ) )
+                continue;
+            const Msg* m = Msg::getMsg( i->mid );
+            assert( m );
+            if ( m->e2()->getName() == name )
+                mids.push_back( i->mid );
+        }
+    }
+}
+
+void Element::buildChildIndex() const
+{
+    childIndex_.clear();
+    childName_.clear();
+    for ( unsigned int b = 0; b < msgBinding_.size(); ++b )
+    {
+        for ( vector< MsgFuncBinding >::const_iterator
+                i = msgBinding_[b].begin(); i != msgBinding_[b].end(); ++i )
+        {
+            if ( !isChildBinding( i->fid, b ) )
+                continue;
+            const Msg* m = Msg::getMsg( i->mid );
+            assert( m );
+            indexChild( i->mid, m->e2()->getName() );
+        }
+    }
+    childIndexBuilt_ = true;
+}
+
+void Element::indexChild( ObjId mid, const string& name ) const
+{
+    childIndex_[ name ].push_back( mid );
+    childName_[ mid ] = name;
+}
+
+void Element::unindexChild( ObjId mid ) const
+{
+    map< ObjId, string >::iterator i = childName_.find( mid );
+    if ( i == childName_.end() )
+        return;
+    vector< ObjId >& mids = childIndex_[ i->second ];
+    mids.erase( remove( mids.begin(), mids.end(), mid ), mids.end() );
+    if ( mids.empty() )
+        childIndex_.erase( i->second );
+    childName_.erase( i );
+}
+
+bool Element::getCachedPath( unsigned int dataIndex, string& path ) const
+{
+    if ( !onMainThread() )
+        return false;
+    if ( pathCacheEpoch_ != pathEpoch_ || pathCacheIndex_ != dataIndex )
+        return false;
+    path = pathCache_;
+    return true;
+}
+
+void Element::setCachedPath( unsigned int dataIndex, const string& path ) const
+{
+    if ( !onMainThread() )
+        return;
+    pathCache_ = path;
+    pathCacheIndex_ = dataIndex;
+    pathCacheEpoch_ = pathEpoch_;
+}
+
+void Element::invalidatePaths()
+{
+    ++pathEpoch_;
 }
 
 const Cinfo* Element::cinfo() const
@@ -122,6 +273,8 @@ void Element::dropMsg( ObjId mid )
         matchMid match( mid );
         i->erase( remove_if( i->begin(), i->end(), match ), i->end() );
     }
+    if ( childIndexBuilt_ )
+        unindexChild( mid );
     markRewired();
 }
 
@@ -130,6 +283,12 @@ void Element::addMsgAndFunc( ObjId mid, FuncId fid, BindIndex bindIndex )
     if ( msgBinding_.size() < bindIndex + 1U )
         msgBinding_.resize( bindIndex + 1 );
     msgBinding_[ bindIndex ].push_back( MsgFuncBinding( mid, fid ) );
+    if ( childIndexBuilt_ && isChildBinding( fid, bindIndex ) )
+    {
+        const Msg* m = Msg::getMsg( mid );
+        assert( m );
+        indexChild( mid, m->e2()->getName() );
+    }
     markRewired();
 }
 
@@ -152,7 +311,13 @@ void Element::clearAllMsgs()
     markAsDoomed();
     m_.clear();
     msgBinding_.clear();
+    childIndex_.clear();
+    childName_.clear();
+    childIndexBuilt_ = false;
     msgDigest_.clear();
+    digestStart_.assign( 1, 0 );
+    digestTargets_.clear();
+    digestSparse_.clear();
 }
 
 /// virtual func, this base version must be called by all derived classes
@@ -286,15 +451,23 @@ void Element::setTick( int t )
 // Msg Information
 /////////////////////////////////////////////////////////////////////////
 
-const vector< MsgDigest >& Element::msgDigest( unsigned int index )
+MsgDigestRange Element::msgDigest( unsigned int index )
 {
     if ( isRewired_ )
     {
         digestMessages();
         isRewired_ = false;
     }
-    assert( index < msgDigest_.size() );
-    return msgDigest_[ index ];
+    if ( index + 1 >= digestStart_.size() )
+        return MsgDigestRange();
+    const MsgDigest* md = msgDigest_.data();
+    return MsgDigestRange( md + digestStart_[ index ],
+                           md + digestStart_[ index + 1 ] );
+}
+
+unsigned int Element::digestVersion() const
+{
+    return digestVersion_;
 }
 
 const vector< MsgFuncBinding >* Element::getMsgAndFunc( BindIndex b ) const
@@ -466,10 +639,33 @@ void filterOffNodeTargets(
 void Element::putTargetsInDigest(
     unsigned int srcNum, const MsgFuncBinding& mfb,
     const FuncOrder& fo,
-    vector< vector< bool > >& targetNodes )
+    vector< vector< bool > >& targetNodes,
+    vector< vector< DigestEntry > >& digest )
 // targetNodes[srcDataId][node]
 {
     const Msg* msg = Msg::getMsg( mfb.mid );
+
+    // Sparse projections are referenced in place, a run per source entry,
+    // instead of being expanded into Erefs. Off-node targets still need
+    // the Erefs so that they can be filtered.
+    vector< SparseTargets > runs;
+    if ( msg->e1() == this && Shell::numNodes() == 1 &&
+            msg->sparseTargets( runs ) )
+    {
+        for ( unsigned int j = 0; j < runs.size(); ++j )
+        {
+            if ( runs[j].size == 0 )
+                continue;
+            vector< DigestEntry >& md =
+                digest[ msgBinding_.size() * j + srcNum ];
+            if ( md.size() == 0 || md.back().func != fo.func() )
+                md.push_back( DigestEntry{ fo.func(), {}, { runs[j] } } );
+            else
+                md.back().sparse.push_back( runs[j] );
+        }
+        return;
+    }
+
     vector< vector < Eref > > erefs;
     if ( msg->e1() == this )
         msg->targets( erefs );
@@ -487,12 +683,12 @@ void Element::putTargetsInDigest(
 
     for ( unsigned int j = 0; j < erefs.size(); ++j )
     {
-        vector< MsgDigest >& md =
-            msgDigest_[ msgBinding_.size() * j + srcNum ];
+        vector< DigestEntry >& md =
+            digest[ msgBinding_.size() * j + srcNum ];
         // k->func(); erefs[ j ];
         if ( md.size() == 0 || md.back().func != fo.func() )
         {
-            md.push_back( MsgDigest( fo.func(), erefs[j] ) );
+            md.push_back( DigestEntry{ fo.func(), erefs[j], {} } );
             /*
             if ( md.back().targets.size() > 0 )
             	cout << "putTargetsInDigest: " << md.back().targets[0] <<
@@ -515,7 +711,8 @@ void Element::putTargetsInDigest(
 // remote node. This Eref will then invoke its own send call to complete
 // the message transfer.
 void Element::putOffNodeTargetsInDigest(
-    unsigned int srcNum, vector< vector< bool > >& targetNodes )
+    unsigned int srcNum, vector< vector< bool > >& targetNodes,
+    vector< vector< DigestEntry > >& digest )
 // targetNodes[srcDataId][node]
 {
     if ( msgBinding_[ srcNum ].size() == 0 )
@@ -548,14 +745,15 @@ void Element::putOffNodeTargetsInDigest(
         }
         if ( tgts.size() > 0 )
         {
-            vector< MsgDigest >& md =
-                msgDigest_[ msgBinding_.size() * i + srcNum ];
-            md.push_back( MsgDigest( hop, tgts ) );
+            vector< DigestEntry >& md =
+                digest[ msgBinding_.size() * i + srcNum ];
+            md.push_back( DigestEntry{ hop, tgts, {} } );
         }
     }
 }
 
-unsigned int findNumDigest( const vector< vector< MsgDigest > > & md,
+unsigned int findNumDigest(
+    const vector< vector< Element::DigestEntry > > & md,
                             unsigned int totFunc, unsigned int numData, unsigned int funcNum	)
 {
     unsigned int ret = 0;
@@ -569,8 +767,7 @@ unsigned int findNumDigest( const vector< vector< MsgDigest > > & md,
 void Element::digestMessages()
 {
     bool report = 0; // for debugging
-    msgDigest_.clear();
-    msgDigest_.resize( msgBinding_.size() * numData() );
+    vector< vector< DigestEntry > > digest( msgBinding_.size() * numData() );
     vector< bool > temp( Shell::numNodes(), false );
     vector< vector< bool > > targetNodes( numData(), temp );
     // targetNodes[srcDataId][node]. The idea is that if any dataEntry has
@@ -584,16 +781,16 @@ void Element::digestMessages()
                 k = fo.begin(); k != fo.end(); ++k )
         {
             const MsgFuncBinding& mfb = msgBinding_[i][ k->index() ];
-            putTargetsInDigest( i, mfb, *k, targetNodes );
+            putTargetsInDigest( i, mfb, *k, targetNodes, digest );
         }
         if ( Shell::numNodes() > 1 )
         {
             if ( report )
             {
-                unsigned int numPre = findNumDigest( msgDigest_,
+                unsigned int numPre = findNumDigest( digest,
                                                      msgBinding_.size(), numData(), i );
-                putOffNodeTargetsInDigest( i, targetNodes );
-                unsigned int numPost = findNumDigest( msgDigest_,
+                putOffNodeTargetsInDigest( i, targetNodes, digest );
+                unsigned int numPost = findNumDigest( digest,
                                                       msgBinding_.size(), numData(), i );
                 cout << "\nfor Element " << name_;
                 cout << ", Func: " << i << ", numFunc = " << fo.size() <<
@@ -611,10 +808,57 @@ void Element::digestMessages()
             }
             else
             {
-                putOffNodeTargetsInDigest( i, targetNodes );
+                putOffNodeTargetsInDigest( i, targetNodes, digest );
             }
         }
     }
+    packDigest( digest );
+}
+
+void Element::packDigest( const vector< vector< DigestEntry > >& digest )
+{
+    unsigned int numEntries = 0;
+    unsigned int numTargets = 0;
+    unsigned int numSparse = 0;
+    for ( vector< vector< DigestEntry > >::const_iterator
+            i = digest.begin(); i != digest.end(); ++i )
+    {
+        numEntries += i->size();
+        for ( vector< DigestEntry >::const_iterator
+                j = i->begin(); j != i->end(); ++j )
+        {
+            numTargets += j->targets.size();
+            numSparse += j->sparse.size();
+        }
+    }
+    msgDigest_.clear();
+    msgDigest_.reserve( numEntries );
+    digestTargets_.clear();
+    digestTargets_.reserve( numTargets );
+    digestSparse_.clear();
+    digestSparse_.reserve( numSparse );
+    digestStart_.resize( digest.size() + 1 );
+    // Reserved up front, so the target pointers stay put while we fill.
+    for ( unsigned int i = 0; i < digest.size(); ++i )
+    {
+        digestStart_[i] = msgDigest_.size();
+        for ( vector< DigestEntry >::const_iterator
+                j = digest[i].begin(); j != digest[i].end(); ++j )
+        {
+            const Eref* begin = digestTargets_.data() + digestTargets_.size();
+            digestTargets_.insert( digestTargets_.end(),
+                                   j->targets.begin(), j->targets.end() );
+            const SparseTargets* sb =
+                digestSparse_.data() + digestSparse_.size();
+            digestSparse_.insert( digestSparse_.end(),
+                                  j->sparse.begin(), j->sparse.end() );
+            msgDigest_.push_back( MsgDigest( j->func,
+                DigestSpan< Eref >( begin, begin + j->targets.size() ),
+                DigestSpan< SparseTargets >( sb, sb + j->sparse.size() ) ) );
+        }
+    }
+    digestStart_.back() = msgDigest_.size();
+    ++digestVersion_;
 }
 
 /////////////////////////////////////////////////////////////////////////
@@ -721,8 +965,11 @@ void Element::printMsgDigest( unsigned int srcIndex, unsigned int dataId ) const
     for (unsigned int i = start; i < end; ++i )
     {
         cout << i << ":	";
-        const vector< MsgDigest> & md =
-            msgDigest_[numSrcMsgs * i + srcIndex];
+        unsigned int slot = numSrcMsgs * i + srcIndex;
+        if ( slot + 1 >= digestStart_.size() )
+            break;
+        MsgDigestRange md( msgDigest_.data() + digestStart_[ slot ],
+                           msgDigest_.data() + digestStart_[ slot + 1 ] );
         for ( unsigned int j = 0; j < md.size(); ++j )
         {
             cout << j << ":	";
@@ -732,6 +979,12 @@ void Element::printMsgDigest( unsigned int srcIndex, unsigned int dataId ) const
                      md[j].targets[k].dataIndex() << "," <<
                      md[j].targets[k].fieldIndex();
             }
+            for ( const SparseTargets& st : md[j].sparseTargets )
+            {
+                for ( unsigned int k = 0; k < st.size; ++k )
+                    cout << "	" << st.dataIndex[k] << "," <<
+                         st.fieldIndex[k];
+            }
         }
         cout << endl;
     }
@@ -862,12 +1115,10 @@ vector< ObjId > Element::getMsgTargets( DataId srcDataId,
     vector< ObjId > ret;
     Eref er( const_cast< Element* >( this ), srcDataId );
 
-    const vector< MsgDigest >&md = er.msgDigest( finfo->getBindIndex() );
-    for ( vector< MsgDigest >::const_iterator
-            i = md.begin(); i != md.end(); ++i )
+    MsgDigestRange md = er.msgDigest( finfo->getBindIndex() );
+    for ( const MsgDigest* i = md.begin(); i != md.end(); ++i )
     {
-        for ( vector< Eref >::const_iterator
-                j = i->targets.begin(); j != i->targets.end(); ++j )
+        for ( const Eref* j = i->targets.begin(); j != i->targets.end(); ++j )
         {
             if ( j->dataIndex() == ALLDATA )
             {
@@ -880,6 +1131,12 @@ vector< ObjId > Element::getMsgTargets( DataId srcDataId,
                 ret.push_back( j->objId() );
             }
         }
+        for ( const SparseTargets& s : i->sparseTargets )
+        {
+            for ( unsigned int k = 0; k < s.size; ++k )
+                ret.push_back(
+                    Eref( s.e, s.dataIndex[k], s.fieldIndex[k] ).objId() );
+        }
     }
     return ret;
 }
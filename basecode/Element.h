@@ -9,6 +9,8 @@
 #ifndef _ELEMENT_H
 #define _ELEMENT_H
 
+#include <atomic>
+
 class SrcFinfo;
 class FuncOrder;
 
@@ -57,6 +59,29 @@ public:
      */
     void setName( const string& val );
 
+    /**
+     * Fills mids with the parent->child Msgs from this Element to its
+     * children named name, in the order the children were added. Used
+     * by Neutral::child. The name index behind it is built on first use
+     * and then kept up to date as children are added, removed or renamed.
+     * Off the main thread an index that is not yet built is not built,
+     * and the children are scanned instead.
+     */
+    void getChildMsgs( const string& name, vector< ObjId >& mids ) const;
+
+    /**
+     * Cached path of data entry dataIndex, for Neutral::path. Returns
+     * false if there is none, or if it may be out of date.
+     * The cache is only read and written on the main thread, as the
+     * Clock and solvers may call path() from pool threads. Elsewhere
+     * getCachedPath always fails and setCachedPath does nothing.
+     */
+    bool getCachedPath( unsigned int dataIndex, string& path ) const;
+    void setCachedPath( unsigned int dataIndex, const string& path ) const;
+
+    /// Marks all cached paths as out of date, on a rename or move.
+    static void invalidatePaths();
+
     /// Returns number of data entries across all nodes
     virtual unsigned int numData() const = 0;
 
@@ -216,6 +241,17 @@ public:
      */
     void digestMessages();
 
+    /**
+     * Targets gathered for one func while building the digest. These
+     * are packed into the flat digest arrays once all are known.
+     */
+    struct DigestEntry
+    {
+        const OpFunc* func;
+        vector< Eref > targets;
+        vector< SparseTargets > sparse;
+    };
+
     /**
      * Inner function that adds targets to a single function in the
      * MsgDigest
@@ -223,13 +259,21 @@ public:
     void putTargetsInDigest(
         unsigned int srcNum, const MsgFuncBinding& mfb,
         const FuncOrder& fo,
-        vector< vector< bool > >& targetNodes
+        vector< vector< bool > >& targetNodes,
+        vector< vector< DigestEntry > >& digest
     );
     /**
      * Inner function that adds off-node targets to the MsgDigest
      */
     void putOffNodeTargetsInDigest(
-        unsigned int srcNum, vector< vector< bool > >& targetNodes );
+        unsigned int srcNum, vector< vector< bool > >& targetNodes,
+        vector< vector< DigestEntry > >& digest );
+
+    /**
+     * Packs the gathered digest entries into the flat arrays used
+     * by msgDigest().
+     */
+    void packDigest( const vector< vector< DigestEntry > >& digest );
 
     /**
      * Gets the class information for this Element
@@ -277,7 +321,14 @@ public:
      * If the messages have been rewired, this call triggers the
      * re-parsing of all messages before returning the digested msgs.
      */
-    const vector< MsgDigest >& msgDigest( unsigned int index );
+    MsgDigestRange msgDigest( unsigned int index );
+
+    /**
+     * Incremented every time the messages are re-digested, so that
+     * anything holding on to digested targets can tell when to look
+     * them up again.
+     */
+    unsigned int digestVersion() const;
 
     /**
      * Returns the binding index of the specified entry.
@@ -395,6 +446,12 @@ private:
     unsigned int getInputs( vector< Id >& ret, const DestFinfo* finfo )
     const;
 
+    /// Helpers for the child name index.
+    void buildChildIndex() const;
+    void scanChildMsgs( const string& name, vector< ObjId >& mids ) const;
+    void indexChild( ObjId mid, const string& name ) const;
+    void unindexChild( ObjId mid ) const;
+
 
     string name_; /// Name of the Element.
 
@@ -427,14 +484,26 @@ private:
      * Func and element to lead off, followed by a list of target
      * indices and fields.
      * The indexing is like this:
-     * msgDigest_[ numSrcMsgs * dataIndex + srcMsgIndex ][ func# ]
-     * So we look up a vector of MsgDigests, each with a unique func,
+     * msgDigest_[ digestStart_[ numSrcMsgs * dataIndex + srcMsgIndex ]
+     * 		+ func# ]
+     * So we look up a run of MsgDigests, each with a unique func,
      * based on both the dataIndex and the message number. This is
      * designed
      * so that if we expand the number of data entries we don't have
      * to redo the ordering.
+     * All runs are packed into one array, and their targets into
+     * digestTargets_, so that sends walk contiguous memory.
      */
-    vector< vector < MsgDigest > > msgDigest_;
+    vector< MsgDigest > msgDigest_;
+
+    /// Start of the run in msgDigest_ for each src X data entry. One extra
+    vector< unsigned int > digestStart_;
+
+    /// Targets of all entries in msgDigest_, in the same order.
+    vector< Eref > digestTargets_;
+
+    /// Sparse target runs of all entries in msgDigest_, in the same order.
+    vector< SparseTargets > digestSparse_;
 
     /// Returns tick on which element is scheduled. -1 for disabled.
     int tick_;
@@ -442,8 +511,29 @@ private:
     /// True if messages have been changed and need to digestMessages.
     bool isRewired_;
 
+    /// Number of times the messages have been digested.
+    unsigned int digestVersion_;
+
     /// True if the element is marked for destruction.
     bool isDoomed_;
+
+    /**
+     * Index of children by name, mapping to their parent->child Msgs,
+     * and the reverse so that dropped Msgs can be removed. Only valid
+     * if childIndexBuilt_.
+     */
+    mutable bool childIndexBuilt_;
+    mutable unordered_map< string, vector< ObjId > > childIndex_;
+    mutable map< ObjId, string > childName_;
+
+    /// Last path computed for this Element, see getCachedPath. Only
+    /// touched on the main thread.
+    mutable string pathCache_;
+    mutable unsigned int pathCacheIndex_;
+    mutable unsigned long pathCacheEpoch_;
+
+    /// Bumped by invalidatePaths. Cached paths from older epochs are stale.
+    static std::atomic< unsigned long > pathEpoch_;
 };
 
 #endif // _ELEMENT_H
@@ -70,7 +70,7 @@ Id Eref::id() const
 	return e_->id();
 }
 
-const vector< MsgDigest >& Eref::msgDigest( unsigned int bindIndex ) const
+MsgDigestRange Eref::msgDigest( unsigned int bindIndex ) const
 {
 	return e_->msgDigest( i_ * e_->cinfo()->numBindIndex() + bindIndex );
 }
@@ -65,7 +65,7 @@ public:
      * Returns the digested version of the specified msgsrc. If the
      * message has changed, this call triggers the digestion operation.
      */
-    const vector< MsgDigest >& msgDigest(unsigned int bindIndex ) const;
+    MsgDigestRange msgDigest(unsigned int bindIndex ) const;
 
     /**
      * True if the data are on the current node
@@ -0,0 +1,127 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _FIELD_ACCESSOR_H
+#define _FIELD_ACCESSOR_H
+
+/**
+ * Reusable handle for getting and setting one value field.
+ *
+ * Field< A >::get and ::set build the "get"/"set" name, look it up in
+ * the Cinfo and cast the OpFunc on every call. A FieldAccessor does
+ * that once per Cinfo and keeps the resulting OpFuncs, so loops over
+ * many objects only pay for the call itself:
+ *
+ *	FieldAccessor< double > dia( "diameter" );
+ *	for ( auto i = elist.begin(); i != elist.end(); ++i )
+ *		total += dia.get( *i );
+ *
+ * Anything the handle cannot do directly, such as fields of child
+ * elements or objects on other nodes, goes through Field< A > as
+ * before, with the same warnings. The cache is not locked, so each
+ * thread should use its own handle.
+ */
+template< class A > class FieldAccessor
+{
+public:
+    FieldAccessor( const string& field )
+        : field_( field ), last_( 0 )
+    {
+        getName_ = "get" + field;
+        getName_[3] = std::toupper( getName_[3] );
+        setName_ = "set" + field;
+        setName_[3] = std::toupper( setName_[3] );
+    }
+
+    const string& field() const
+    {
+        return field_;
+    }
+
+    A get( const ObjId& oid ) const
+    {
+        const Entry& e = resolve( oid.element()->cinfo() );
+        if ( e.get && oid.isDataHere() )
+            return e.get->returnOp( oid.eref() );
+        return Field< A >::get( oid, field_ );
+    }
+
+    bool set( const ObjId& oid, A arg ) const
+    {
+        const Entry& e = resolve( oid.element()->cinfo() );
+        if ( e.set && !oid.isOffNode() )
+        {
+            e.set->op( oid.eref(), arg );
+            return true;
+        }
+        return Field< A >::set( oid, field_, arg );
+    }
+
+    /// Fills ret with the field value of each of oids, in order.
+    void getAll( const vector< ObjId >& oids, vector< A >& ret ) const
+    {
+        ret.resize( oids.size() );
+        for ( unsigned int i = 0; i < oids.size(); ++i )
+            ret[i] = get( oids[i] );
+    }
+
+    /**
+     * Sets the field on each of oids. As in Field< A >::setVec, args
+     * is used as a circular buffer if it is shorter than oids, so a
+     * single value is set on all of them.
+     * Returns true only if every set succeeded.
+     */
+    bool setAll( const vector< ObjId >& oids, const vector< A >& args ) const
+    {
+        if ( args.size() == 0 )
+            return false;
+        bool ret = true;
+        for ( unsigned int i = 0; i < oids.size(); ++i )
+            ret &= set( oids[i], args[ i % args.size() ] );
+        return ret;
+    }
+
+private:
+    struct Entry
+    {
+        const Cinfo* cinfo;
+        const GetOpFuncBase< A >* get;
+        const OpFunc1Base< A >* set;
+    };
+
+    /// Looks up the OpFuncs for cinfo. Null ones mean use Field< A >.
+    const Entry& resolve( const Cinfo* cinfo ) const
+    {
+        if ( last_ < cache_.size() && cache_[ last_ ].cinfo == cinfo )
+            return cache_[ last_ ];
+        for ( last_ = 0; last_ < cache_.size(); ++last_ )
+            if ( cache_[ last_ ].cinfo == cinfo )
+                return cache_[ last_ ];
+
+        Entry e = { cinfo, 0, 0 };
+        const DestFinfo* df =
+            dynamic_cast< const DestFinfo* >( cinfo->findFinfo( getName_ ) );
+        if ( df )
+            e.get = dynamic_cast< const GetOpFuncBase< A >* >( df->getOpFunc() );
+        df = dynamic_cast< const DestFinfo* >( cinfo->findFinfo( setName_ ) );
+        if ( df )
+            e.set = dynamic_cast< const OpFunc1Base< A >* >( df->getOpFunc() );
+        cache_.push_back( e );
+        last_ = cache_.size() - 1;
+        return cache_[ last_ ];
+    }
+
+    string field_;
+    string getName_;
+    string setName_;
+    mutable vector< Entry > cache_;
+    mutable unsigned int last_;
+};
+
+#endif // _FIELD_ACCESSOR_H
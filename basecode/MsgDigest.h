@@ -10,6 +10,57 @@
 #ifndef _MSG_DIGEST_H
 #define _MSG_DIGEST_H
 
+/**
+ * Read-only view onto a contiguous run of entries owned by someone else,
+ * here the flat digest arrays held by the Element. Cheap to pass around
+ * by value. Remains valid until the Element re-digests its messages.
+ */
+template< class T > class DigestSpan
+{
+	public:
+		typedef const T* const_iterator;
+
+		DigestSpan()
+				: begin_( 0 ), end_( 0 )
+		{;}
+		DigestSpan( const T* b, const T* e )
+				: begin_( b ), end_( e )
+		{;}
+
+		const T* begin() const {
+			return begin_;
+		}
+		const T* end() const {
+			return end_;
+		}
+		unsigned int size() const {
+			return end_ - begin_;
+		}
+		bool empty() const {
+			return begin_ == end_;
+		}
+		const T& operator[]( unsigned int i ) const {
+			return begin_[i];
+		}
+	private:
+		const T* begin_;
+		const T* end_;
+};
+
+/**
+ * A run of targets read in place from the storage of a Msg, rather than
+ * copied into Erefs: target k is Eref( e, dataIndex[k], fieldIndex[k] ).
+ * SparseMsg hands out one per source entry, pointing into the CSR row of
+ * its matrix, so the digest adds nothing per synapse.
+ */
+struct SparseTargets
+{
+	Element* e;
+	const unsigned int* dataIndex;
+	const unsigned int* fieldIndex;
+	unsigned int size;
+};
+
 /**
  * This class manages digested Messages. Each entry is boiled down to the
  * function, and an array of targets. The targets are actually stored
@@ -17,15 +68,39 @@
  * As a further refinement, if the target DataIndex is ALLDATA, then it
  * means that all data entries in the target are to be iterated over. Note
  * that this does not extend to Field targets.
+ *
+ * The targets of all digests on an Element live in one flat array on the
+ * Element, so a send walks contiguous memory. The func is type-checked
+ * against the SrcFinfo when the Msg is created (Finfo::checkTarget), so
+ * the send loop can use typedFunc rather than a dynamic_cast per send.
+ * Targets that come from sparse matrices are in sparseTargets instead,
+ * and are visited after the Erefs.
  */
 class MsgDigest
 {
 	public:
-		MsgDigest( const OpFunc* f, const vector< Eref >& t )
-				: func( f ), targets( t )
+		MsgDigest( const OpFunc* f, const DigestSpan< Eref >& t,
+				const DigestSpan< SparseTargets >& s =
+						DigestSpan< SparseTargets >() )
+				: func( f ), targets( t ), sparseTargets( s )
 		{;}
+
+		/**
+		 * Returns func as the OpFunc base class matching the SrcFinfo.
+		 * Debug builds verify the type, release builds do a plain
+		 * static_cast.
+		 */
+		template< class F > const F* typedFunc() const {
+			assert( dynamic_cast< const F* >( func ) );
+			return static_cast< const F* >( func );
+		}
+
 		const OpFunc* func;
-		vector< Eref > targets;
+		DigestSpan< Eref > targets;
+		DigestSpan< SparseTargets > sparseTargets;
 };
 
+/// All the digests for one MsgSrc on one data entry.
+typedef DigestSpan< MsgDigest > MsgDigestRange;
+
 #endif // _MSG_DIGEST_H
@@ -423,6 +423,23 @@ public:
                           colIndexArg.begin(), colIndexArg.end() );
         rowStart_[rowNum + 1] = N_.size();
     }
+    /**
+     * Takes over entries that are already in CSR form, without copying.
+     * rowStart must have nRows() + 1 entries. The arguments are left
+     * holding the old contents of the matrix.
+     */
+    void swapArrays( vector< T >& entry,
+                     vector< unsigned int >& colIndexArg,
+                     vector< unsigned int >& rowStartArg )
+    {
+        assert( rowStartArg.size() == nrows_ + 1 );
+        assert( entry.size() == colIndexArg.size() );
+        assert( rowStartArg.back() == entry.size() );
+        N_.swap( entry );
+        colIndex_.swap( colIndexArg );
+        rowStart_.swap( rowStartArg );
+    }
+
 	/// Here we expose the sparse matrix for MOOSE use.
 	const vector< T >& matrixEntry() const
 	{
@@ -15,6 +15,8 @@
 
 const BindIndex SrcFinfo::BadBindIndex = 65535;
 
+thread_local vector< function< void() > >* SrcFinfo::sendQueue = 0;
+
 SrcFinfo::SrcFinfo( const string& name, const string& doc )
 	: Finfo( name, doc ), bindIndex_( BadBindIndex )
 { ; }
@@ -68,14 +70,17 @@ SrcFinfo0::SrcFinfo0( const string& name, const string& doc )
 
 class OpFunc0Base;
 void SrcFinfo0::send( const Eref& e ) const {
-	const vector< MsgDigest >& md = e.msgDigest( getBindIndex() );
-	for ( vector< MsgDigest >::const_iterator
-		i = md.begin(); i != md.end(); ++i ) {
+	if ( sendQueue ) {
+		sendQueue->push_back( [this, e]() { send( e ); } );
+		return;
+	}
+	MsgDigestRange md = e.msgDigest( getBindIndex() );
+	for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 		const OpFunc0Base* f =
-			dynamic_cast< const OpFunc0Base* >( i->func );
+			i->typedFunc< OpFunc0Base >();
 		assert( f );
-		for ( vector< Eref >::const_iterator
-			j = i->targets.begin(); j != i->targets.end(); ++j ) {
+		for ( const Eref* j = i->targets.begin();
+				j != i->targets.end(); ++j ) {
 			if ( j->dataIndex() == ALLDATA ) {
 				Element* e = j->element();
 				unsigned int start = e->localDataStart();
@@ -86,6 +91,12 @@ void SrcFinfo0::send( const Eref& e ) const {
 				f->op( *j );
 			}
 		}
+		for ( const SparseTargets* s = i->sparseTargets.begin();
+				s != i->sparseTargets.end(); ++s ) {
+			for ( unsigned int k = 0; k < s->size; ++k )
+				f->op( Eref( s->e, s->dataIndex[k],
+						s->fieldIndex[k] ) );
+		}
 	}
 }
 
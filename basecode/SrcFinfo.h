@@ -56,6 +56,15 @@ class SrcFinfo: public Finfo
 				const = 0;
 
 		static const BindIndex BadBindIndex;
+
+		/**
+		 * While the Clock runs process calls on its thread pool, each
+		 * task points this at its own queue. Sends made meanwhile are
+		 * queued rather than delivered, and the Clock delivers them
+		 * serially in task order once the parallel run is over, so that
+		 * no target is called from two threads at once.
+		 */
+		static thread_local vector< function< void() > >* sendQueue;
 	private:
 		/**
 		 * Index into the msgBinding_ vector.
@@ -98,14 +107,17 @@ template < class T > class SrcFinfo1: public SrcFinfo
 
 		void send( const Eref& er, T arg ) const
 		{
-			const vector< MsgDigest >& md = er.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, er, arg]() { send( er, arg ); } );
+				return;
+			}
+			MsgDigestRange md = er.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc1Base< T >* f =
-					dynamic_cast< const OpFunc1Base< T >* >( i->func );
+					i->typedFunc< OpFunc1Base< T > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->dataIndex() == ALLDATA ) {
 						Element* e = j->element();
 						unsigned int start = e->localDataStart();
@@ -121,19 +133,29 @@ template < class T > class SrcFinfo1: public SrcFinfo
 						// its own send command with the passed in args.
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ), arg );
+				}
 			}
 		}
 
 		void sendTo( const Eref& er, Id tgt, T arg ) const
 		{
-			const vector< MsgDigest >& md = er.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, er, tgt, arg]()
+						{ sendTo( er, tgt, arg ); } );
+				return;
+			}
+			MsgDigestRange md = er.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc1Base< T >* f =
-					dynamic_cast< const OpFunc1Base< T >* >( i->func );
+					i->typedFunc< OpFunc1Base< T > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->element() != tgt.element() )
 						continue; // Wasteful unless very few dests.
 					if ( j->dataIndex() == ALLDATA ) {
@@ -151,6 +173,14 @@ template < class T > class SrcFinfo1: public SrcFinfo
 						// its own send command with the passed in args.
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					if ( s->e != tgt.element() )
+						continue;
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ), arg );
+				}
 			}
 		}
 
@@ -163,15 +193,19 @@ template < class T > class SrcFinfo1: public SrcFinfo
 		{
 			if ( arg.size() == 0 )
 				return;
-			const vector< MsgDigest >& md = er.msgDigest( getBindIndex() );
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, er, arg]()
+						{ sendVec( er, arg ); } );
+				return;
+			}
+			MsgDigestRange md = er.msgDigest( getBindIndex() );
 			unsigned int argPos = 0;
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc1Base< T >* f =
-					dynamic_cast< const OpFunc1Base< T >* >( i->func );
+					i->typedFunc< OpFunc1Base< T > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->dataIndex() == ALLDATA ) {
 						Element* e = j->element();
 						unsigned int start = e->localDataStart();
@@ -192,6 +226,15 @@ template < class T > class SrcFinfo1: public SrcFinfo
 						// its own send command with the passed in args.
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					for ( unsigned int k = 0; k < s->size; ++k ) {
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ), arg[ argPos++ ] );
+						if ( argPos >= arg.size() )
+							argPos = 0;
+					}
+				}
 			}
 		}
 
@@ -220,14 +263,18 @@ template < class T1, class T2 > class SrcFinfo2: public SrcFinfo
 
 		void send( const Eref& e, const T1& arg1, const T2& arg2 ) const
 		{
-			const vector< MsgDigest >& md = e.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, e, arg1, arg2]()
+						{ send( e, arg1, arg2 ); } );
+				return;
+			}
+			MsgDigestRange md = e.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc2Base< T1, T2 >* f =
-					dynamic_cast< const OpFunc2Base< T1, T2 >* >( i->func );
+					i->typedFunc< OpFunc2Base< T1, T2 > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->dataIndex() == ALLDATA ) {
 						Element* e = j->element();
 						unsigned int start = e->localDataStart();
@@ -238,20 +285,30 @@ template < class T1, class T2 > class SrcFinfo2: public SrcFinfo
 						f->op( *j, arg1, arg2 );
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ), arg1, arg2 );
+				}
 			}
 		}
 
 		void sendTo( const Eref& e, Id tgt,
 						const T1& arg1, const T2& arg2 ) const
 		{
-			const vector< MsgDigest >& md = e.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, e, tgt, arg1, arg2]()
+						{ sendTo( e, tgt, arg1, arg2 ); } );
+				return;
+			}
+			MsgDigestRange md = e.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc2Base< T1, T2 >* f =
-					dynamic_cast< const OpFunc2Base< T1, T2 >* >( i->func );
+					i->typedFunc< OpFunc2Base< T1, T2 > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->element() != tgt.element() )
 						continue; // Wasteful unless very few dests.
 					if ( j->dataIndex() == ALLDATA ) {
@@ -264,6 +321,14 @@ template < class T1, class T2 > class SrcFinfo2: public SrcFinfo
 						f->op( *j, arg1, arg2 );
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					if ( s->e != tgt.element() )
+						continue;
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ), arg1, arg2 );
+				}
 			}
 		}
 
@@ -298,15 +363,18 @@ template < class T1, class T2, class T3 > class SrcFinfo3: public SrcFinfo
 		void send( const Eref& e,
 			const T1& arg1, const T2& arg2, const T3& arg3 ) const
 		{
-			const vector< MsgDigest >& md = e.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, e, arg1, arg2, arg3]()
+						{ send( e, arg1, arg2, arg3 ); } );
+				return;
+			}
+			MsgDigestRange md = e.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc3Base< T1, T2, T3 >* f =
-					dynamic_cast< const OpFunc3Base< T1, T2, T3 >* >(
-									i->func );
+					i->typedFunc< OpFunc3Base< T1, T2, T3 > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->dataIndex() == ALLDATA ) {
 						Element* e = j->element();
 						unsigned int start = e->localDataStart();
@@ -317,6 +385,12 @@ template < class T1, class T2, class T3 > class SrcFinfo3: public SrcFinfo
 						f->op( *j, arg1, arg2, arg3 );
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ), arg1, arg2, arg3 );
+				}
 			}
 		}
 
@@ -350,15 +424,18 @@ template < class T1, class T2, class T3, class T4 > class SrcFinfo4: public SrcF
 			const T1& arg1, const T2& arg2,
 			const T3& arg3, const T4& arg4 ) const
 		{
-			const vector< MsgDigest >& md = e.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, e, arg1, arg2, arg3, arg4]()
+						{ send( e, arg1, arg2, arg3, arg4 ); } );
+				return;
+			}
+			MsgDigestRange md = e.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc4Base< T1, T2, T3, T4 >* f =
-					dynamic_cast< const OpFunc4Base< T1, T2, T3, T4 >* >(
-									i->func );
+					i->typedFunc< OpFunc4Base< T1, T2, T3, T4 > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->dataIndex() == ALLDATA ) {
 						Element* e = j->element();
 						unsigned int start = e->localDataStart();
@@ -369,6 +446,12 @@ template < class T1, class T2, class T3, class T4 > class SrcFinfo4: public SrcF
 						f->op( *j, arg1, arg2, arg3, arg4 );
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ), arg1, arg2, arg3, arg4 );
+				}
 			}
 		}
 
@@ -404,15 +487,18 @@ template < class T1, class T2, class T3, class T4, class T5 > class SrcFinfo5: p
 			const T1& arg1, const T2& arg2, const T3& arg3, const T4& arg4,
 			const T5& arg5 ) const
 		{
-			const vector< MsgDigest >& md = e.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, e, arg1, arg2, arg3, arg4, arg5]()
+						{ send( e, arg1, arg2, arg3, arg4, arg5 ); } );
+				return;
+			}
+			MsgDigestRange md = e.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc5Base< T1, T2, T3, T4, T5 >* f =
-					dynamic_cast<
-					const OpFunc5Base< T1, T2, T3, T4, T5 >* >( i->func );
+					i->typedFunc< OpFunc5Base< T1, T2, T3, T4, T5 > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->dataIndex() == ALLDATA ) {
 						Element* e = j->element();
 						unsigned int start = e->localDataStart();
@@ -424,6 +510,13 @@ template < class T1, class T2, class T3, class T4, class T5 > class SrcFinfo5: p
 						f->op( *j, arg1, arg2, arg3, arg4, arg5 );
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ),
+								arg1, arg2, arg3, arg4, arg5 );
+				}
 			}
 		}
 
@@ -461,16 +554,18 @@ template < class T1, class T2, class T3, class T4, class T5, class T6 > class Sr
 			const T1& arg1, const T2& arg2, const T3& arg3, const T4& arg4,
 			const T5& arg5, const T6& arg6 ) const
 		{
-			const vector< MsgDigest >& md = e.msgDigest( getBindIndex() );
-			for ( vector< MsgDigest >::const_iterator
-				i = md.begin(); i != md.end(); ++i ) {
+			if ( sendQueue ) {
+				sendQueue->push_back( [this, e, arg1, arg2, arg3, arg4, arg5, arg6]()
+						{ send( e, arg1, arg2, arg3, arg4, arg5, arg6 ); } );
+				return;
+			}
+			MsgDigestRange md = e.msgDigest( getBindIndex() );
+			for ( const MsgDigest* i = md.begin(); i != md.end(); ++i ) {
 				const OpFunc6Base< T1, T2, T3, T4, T5, T6 >* f =
-					dynamic_cast<
-					const OpFunc6Base< T1, T2, T3, T4, T5, T6 >* >(
-									i->func );
+					i->typedFunc< OpFunc6Base< T1, T2, T3, T4, T5, T6 > >();
 				assert( f );
-				for ( vector< Eref >::const_iterator
-					j = i->targets.begin(); j != i->targets.end(); ++j ) {
+				for ( const Eref* j = i->targets.begin();
+						j != i->targets.end(); ++j ) {
 					if ( j->dataIndex() == ALLDATA ) {
 						Element* e = j->element();
 						unsigned int start = e->localDataStart();
@@ -482,6 +577,13 @@ template < class T1, class T2, class T3, class T4, class T5, class T6 > class Sr
 						f->op( *j, arg1, arg2, arg3, arg4, arg5, arg6 );
 					}
 				}
+				for ( const SparseTargets* s = i->sparseTargets.begin();
+						s != i->sparseTargets.end(); ++s ) {
+					for ( unsigned int k = 0; k < s->size; ++k )
+						f->op( Eref( s->e, s->dataIndex[k],
+								s->fieldIndex[k] ),
+								arg1, arg2, arg3, arg4, arg5, arg6 );
+				}
 			}
 		}
 
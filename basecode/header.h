@@ -16,6 +16,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <functional>
 #include <unordered_map>
 #include <iostream>
 #include <sstream>
@@ -73,6 +74,7 @@ extern DestFinfo* receiveGet();
 #include "OpFuncBase.h"
 #include "HopFunc.h"
 #include "SetGet.h"
+#include "FieldAccessor.h"
 #include "OpFunc.h"
 #include "EpFunc.h"
 #include "ProcOpFunc.h"
@@ -336,6 +336,7 @@ int main( int argc, char** argv )
     }
     Msg::clearAllMsgs();
     Id::clearAllElements();
+    Shell::cleanUp();
 #ifdef USE_MPI
     MPI_Finalize();
 #endif
@@ -33,6 +33,7 @@
 #include "../randnum/randnum.h"
 
 #include <queue>
+#include <chrono>
 
 int _seed_ = 0;
 
@@ -85,7 +86,7 @@ void testSendMsg()
     s.setBindIndex(0);
     e1.element()->addMsgAndFunc(m->mid(), fid, s.getBindIndex());
     // e1.element()->digestMessages();
-    const vector<MsgDigest>& md = e1.element()->msgDigest(0);
+    MsgDigestRange md = e1.element()->msgDigest(0);
     assert(md.size() == 1);
     assert(md[0].targets.size() == 1);
     assert(md[0].targets[0].element() == e2.element());
@@ -108,6 +109,86 @@ void testSendMsg()
     delete i2.element();
 }
 
+/**
+ * Microbenchmark for SrcFinfo1::send. Compares the current send path,
+ * which walks the flat digest with a pre-checked static cast, against
+ * the old inner loop that did a dynamic_cast per digest entry on every
+ * send. Reports sends per second for both. Only run when the
+ * MOOSE_BENCHMARK environment variable is set.
+ */
+void benchmarkSendRate()
+{
+    const Cinfo* ac = Arith::initCinfo();
+    const unsigned int size = 1000;
+    const unsigned int numReps = 1000;
+
+    const DestFinfo* df =
+        dynamic_cast<const DestFinfo*>(ac->findFinfo("setOutputValue"));
+    assert(df != 0);
+    FuncId fid = df->getFid();
+
+    Id i1 = Id::nextId();
+    Id i2 = Id::nextId();
+    new GlobalDataElement(i1, ac, "bench1", size);
+    new GlobalDataElement(i2, ac, "bench2", size);
+    Eref e1 = i1.eref();
+    Eref e2 = i2.eref();
+    Msg* m = new OneToOneMsg(e1, e2, 0);
+    SrcFinfo1<double> s("bench", "");
+    s.setBindIndex(0);
+    e1.element()->addMsgAndFunc(m->mid(), fid, s.getBindIndex());
+    e1.element()->msgDigest(0); // Digest outside the timed loop.
+
+    typedef std::chrono::steady_clock Clk;
+    Clk::time_point t0 = Clk::now();
+    for(unsigned int rep = 0; rep < numReps; ++rep)
+        for(unsigned int i = 0; i < size; ++i)
+            s.send(Eref(e1.element(), i), i + rep);
+    Clk::time_point t1 = Clk::now();
+
+    // The pre-flattening inner loop of SrcFinfo1::send, kept here only
+    // for comparison. Only the digest types differ from the original.
+    for(unsigned int rep = 0; rep < numReps; ++rep) {
+        for(unsigned int i = 0; i < size; ++i) {
+            Eref er(e1.element(), i);
+            double arg = i + rep;
+            MsgDigestRange md = er.msgDigest(s.getBindIndex());
+            for(const MsgDigest* d = md.begin(); d != md.end(); ++d) {
+                const OpFunc1Base<double>* f =
+                    dynamic_cast<const OpFunc1Base<double>*>(d->func);
+                assert(f);
+                for(const Eref* j = d->targets.begin();
+                    j != d->targets.end(); ++j) {
+                    if(j->dataIndex() == ALLDATA) {
+                        Element* e = j->element();
+                        unsigned int start = e->localDataStart();
+                        unsigned int end = start + e->numLocalData();
+                        for(unsigned int k = start; k < end; ++k)
+                            f->op(Eref(e, k), arg);
+                    }
+                    else {
+                        f->op(*j, arg);
+                    }
+                }
+            }
+        }
+    }
+    Clk::time_point t2 = Clk::now();
+
+    double numSends = double(size) * numReps;
+    double tNew = std::chrono::duration<double>(t1 - t0).count();
+    double tOld = std::chrono::duration<double>(t2 - t1).count();
+    double val =
+        reinterpret_cast<Arith*>(e2.element()->data(size - 1))->getOutput();
+    assert(doubleEq(val, size - 1 + numReps - 1));
+    cout << "\nbenchmarkSendRate: flat digest " << numSends / tNew
+         << " sends/s, per-send dynamic_cast " << numSends / tOld
+         << " sends/s" << endl;
+
+    delete i1.element();
+    delete i2.element();
+}
+
 // This used to use parent/child msg, but that has other implications
 // as it causes deletion of elements.
 void testCreateMsg()
@@ -342,6 +423,59 @@ void testSetGetDouble()
     // delete i3.element();
 }
 
+/**
+ * FieldAccessor must agree with Field<>::get/set, including across
+ * objects of different classes and in bulk.
+ */
+void testFieldAccessor()
+{
+    const Cinfo* ic = IntFire::initCinfo();
+    unsigned int size = 100;
+    Id i2 = Id::nextId();
+    Element* ret = new GlobalDataElement(i2, ic, "test2", size);
+    assert(ret);
+    Id i3 = Id::nextId();
+    ret = new GlobalDataElement(i3, Arith::initCinfo(), "arith", 1);
+    assert(ret);
+
+    FieldAccessor<double> vm("Vm");
+    vector<ObjId> oids;
+    vector<double> vals;
+    for(unsigned int i = 0; i < size; ++i) {
+        ObjId oid(i2, i);
+        bool ok = vm.set(oid, i * 2.0);
+        assert(ok);
+        assert(doubleEq(Field<double>::get(oid, "Vm"), i * 2.0));
+        assert(doubleEq(vm.get(oid), i * 2.0));
+        oids.push_back(oid);
+        vals.push_back(i + 0.5);
+    }
+
+    bool ok = vm.setAll(oids, vals);
+    assert(ok);
+    vector<double> got;
+    vm.getAll(oids, got);
+    assert(got.size() == size);
+    for(unsigned int i = 0; i < size; ++i)
+        assert(doubleEq(got[i], i + 0.5));
+
+    // A single value is repeated over all targets.
+    ok = vm.setAll(oids, vector<double>(1, -0.07));
+    assert(ok);
+    for(unsigned int i = 0; i < size; ++i)
+        assert(doubleEq(Field<double>::get(oids[i], "Vm"), -0.07));
+
+    // One handle over two classes.
+    FieldAccessor<string> name("name");
+    assert(name.get(ObjId(i2, 3)) == "test2");
+    assert(name.get(ObjId(i3)) == "arith");
+    assert(name.get(ObjId(i2, 4)) == "test2");
+
+    cout << "." << flush;
+    delete i2.element();
+    delete i3.element();
+}
+
 void testSetGetSynapse()
 {
     const Cinfo* ssh = SimpleSynHandler::initCinfo();
@@ -833,6 +967,28 @@ void testSparseMsg()
     f1->addMsg(f2, sm->mid(), t3);
     sm->randomConnect(connectionProbability);
 
+    // The digest refers to the rows of the matrix rather than copying them.
+    const SrcFinfo* sf = dynamic_cast<const SrcFinfo*>(f1);
+    assert(sf);
+    for(unsigned int i = 0; i < size; i += 100) {
+        MsgDigestRange md = Eref(t3, i).msgDigest(sf->getBindIndex());
+        const unsigned int* entry;
+        const unsigned int* colIndex;
+        unsigned int num = sm->getMatrix().getRow(i, &entry, &colIndex);
+        if(num == 0) {
+            assert(md.size() == 0);
+            continue;
+        }
+        assert(md.size() == 1);
+        assert(md[0].targets.size() == 0);
+        assert(md[0].sparseTargets.size() == 1);
+        const SparseTargets& st = md[0].sparseTargets[0];
+        assert(st.e == syns.element());
+        assert(st.size == num);
+        assert(st.dataIndex == colIndex);
+        assert(st.fieldIndex == entry);
+    }
+
     vector<double> temp(size, 0.0);
     for(unsigned int i = 0; i < size; ++i)
         temp[i] = moose::mtrand() * Vmax;
@@ -1812,9 +1968,12 @@ void testAsync()
     showFields();
 #ifdef DO_UNIT_TESTS
     testSendMsg();
+    if(getenv("MOOSE_BENCHMARK"))
+        benchmarkSendRate();
     testCreateMsg();
     testSetGet();
     testSetGetDouble();
+    testFieldAccessor();
     testSetGetSynapse();
     testSetGetVec();
     test2ArgSetVec();
@@ -134,6 +134,8 @@ private:
     double dt_;
     static const double EPSILON;
 
+    friend class IntFirePop;
+
 };
 }
 
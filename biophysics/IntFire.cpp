@@ -95,6 +95,7 @@ const Cinfo* IntFire::initCinfo()
 		&dinfo
 	);
 
+	intFireCinfo.setParallelProcess();
 	return &intFireCinfo;
 }
 
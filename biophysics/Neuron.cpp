@@ -1536,6 +1536,12 @@ void Neuron::evalExprForElist( const vector< ObjId >& elist,
     double len = 0; // Length of compt in metres
     double dia = 0; // Diameter of compt in metres
     unsigned int valIndex = 0;
+    // Resolved once for the whole list rather than per compartment.
+    FieldAccessor< double > x0( "x0" );
+    FieldAccessor< double > y0( "y0" );
+    FieldAccessor< double > z0( "z0" );
+    FieldAccessor< double > diameter( "diameter" );
+    FieldAccessor< double > length( "length" );
     try
     {
         nuParser parser( expn );
@@ -1556,12 +1562,12 @@ void Neuron::evalExprForElist( const vector< ObjId >& elist,
                     val[valIndex + nuParser::EL] =
                         segs_[j->second].getElecDistFromSoma();
                 } else {
-					double somaX0 = Field<double>::get( soma_, "x0" );
-					double somaY0 = Field<double>::get( soma_, "y0" );
-					double somaZ0 = Field<double>::get( soma_, "z0" );
-					double comptX0 = Field<double>::get( *i, "x0" );
-					double comptY0 = Field<double>::get( *i, "y0" );
-					double comptZ0 = Field<double>::get( *i, "z0" );
+					double somaX0 = x0.get( soma_ );
+					double somaY0 = y0.get( soma_ );
+					double somaZ0 = z0.get( soma_ );
+					double comptX0 = x0.get( *i );
+					double comptY0 = y0.get( *i );
+					double comptZ0 = z0.get( *i );
 					Vec temp( somaX0-comptX0, somaY0-comptY0, somaZ0-comptZ0 );
 					double geomDistFromSoma = temp.length();
                     val[valIndex + nuParser::G] = geomDistFromSoma;
@@ -1569,8 +1575,8 @@ void Neuron::evalExprForElist( const vector< ObjId >& elist,
 					// Dummy, using typical lambda of 0.5 mm
                     val[valIndex + nuParser::EL] = geomDistFromSoma * 2e3;
 				}
-                dia = Field< double >::get( *i, "diameter" );
-                len = Field< double >::get( *i, "length" );
+                dia = diameter.get( *i );
+                len = length.get( *i );
                 val[valIndex + nuParser::LEN] = len;
                 val[valIndex + nuParser::DIA] = dia;
                 val[valIndex + nuParser::MAXP] = maxP_;
@@ -117,6 +117,7 @@ const Cinfo* RandSpike::initCinfo()
         sizeof(doc)/sizeof(string)
     );
 
+    spikeGenCinfo.setParallelProcess();
     return &spikeGenCinfo;
 }
 
@@ -219,7 +220,7 @@ void RandSpike::process( const Eref& e, ProcPtr p )
     else
     {
         double prob = realRate_ * p->dt;
-        if ( prob >= 1.0 || prob >= moose::mtrand() )
+        if ( prob >= 1.0 || prob >= rng_.uniform() )
         {
             lastEvent_ = p->currTime;
             spikeOut()->send( e, p->currTime );
@@ -231,6 +232,8 @@ void RandSpike::process( const Eref& e, ProcPtr p )
 // Set it so that first spike is allowed.
 void RandSpike::reinit( const Eref& e, ProcPtr p )
 {
+    rng_.setStream( moose::getGlobalSeed(),
+                    moose::RNG::streamOf( e.id().value(), e.dataIndex() ) );
     if ( rate_ <= 0.0 )
     {
         lastEvent_ = 0.0;
@@ -238,7 +241,7 @@ void RandSpike::reinit( const Eref& e, ProcPtr p )
     }
     else
     {
-        double prob = moose::mtrand();
+        double prob = rng_.uniform();
         double m = 1.0 / rate_;
         lastEvent_ = m * log( prob );
     }
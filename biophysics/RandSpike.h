@@ -10,6 +10,8 @@
 #ifndef _RANDSPIKE_H
 #define _RANDSPIKE_H
 
+#include "../randnum/RNG.h"
+
 class RandSpike
 {
 public:
@@ -50,6 +52,9 @@ private:
     bool fired_;
     bool doPeriodic_;
 
+    /// Own stream of the global seed, so results do not depend on
+    /// which thread steps this entry or on what else draws numbers.
+    moose::RNG rng_;
 };
 
 #endif // _RANDSPIKE_H
@@ -119,6 +119,7 @@ const Cinfo* SpikeGen::initCinfo()
                 sizeof(doc)/sizeof(string)
 	);
 
+	spikeGenCinfo.setParallelProcess();
 	return &spikeGenCinfo;
 }
 
@@ -34,7 +34,7 @@ void testIntFireNetwork(unsigned int runsteps = 5)
     static const double delayMax = 4;
     static const double delayMin = 0;
     static const double connectionProbability = 0.1;
-    static const unsigned int NUM_TOT_SYN = 104831;
+    static const unsigned int NUM_TOT_SYN = 105238;
     unsigned int size = 1024;
     string arg;
     Eref sheller(Id().eref());
@@ -213,13 +213,13 @@ void testIntFireNetwork(unsigned int runsteps = 5)
         cout << std::setprecision(12) <<  retVm901 << endl;
         cout << std::setprecision(12) <<  retVm902 << endl;
 #endif
-        ASSERT_DOUBLE_EQ(retVm100, 0.0752853031478, "");
-        ASSERT_DOUBLE_EQ(retVm101, 0.226731547886, "");
-        ASSERT_DOUBLE_EQ(retVm102, 0.204294350789, "");
-        ASSERT_DOUBLE_EQ(retVm99, 0.2814616871, "");
-        ASSERT_DOUBLE_EQ(retVm900, 0.194820080944, "");
-        ASSERT_DOUBLE_EQ(retVm901, 0.0490452677121, "");
-        ASSERT_DOUBLE_EQ(retVm902, 0.214295483534, "");
+        ASSERT_DOUBLE_EQ(retVm100, 0.111543125759, "");
+        ASSERT_DOUBLE_EQ(retVm101, 0.239055938728, "");
+        ASSERT_DOUBLE_EQ(retVm102, 0.206465855903, "");
+        ASSERT_DOUBLE_EQ(retVm99, 0.22604307058, "");
+        ASSERT_DOUBLE_EQ(retVm900, 0.320279789924, "");
+        ASSERT_DOUBLE_EQ(retVm901, 0.114881194358, "");
+        ASSERT_DOUBLE_EQ(retVm902, 0.248942188521, "");
     }
     /*
     cout << "testIntFireNetwork: Vm100 = " << retVm100 << ", " <<
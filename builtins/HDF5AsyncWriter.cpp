@@ -0,0 +1,216 @@
+// HDF5AsyncWriter.cpp ---
+//
+// Filename: HDF5AsyncWriter.cpp
+// Description:
+// Author:
+// Maintainer:
+// Created: Fri Oct 16 2026
+//
+
+// Code:
+
+#ifdef USE_HDF5
+
+#include "hdf5.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "../basecode/header.h"
+#include "HDF5AsyncWriter.h"
+
+/**
+   The I/O thread shared by all HDF5AsyncWriters.
+ */
+class HDF5IOThread
+{
+  public:
+    HDF5IOThread(): stop_(false), active_(0)
+    {
+        thread_ = thread(&HDF5IOThread::loop, this);
+    }
+
+    ~HDF5IOThread()
+    {
+        {
+            lock_guard< mutex > lock(lock_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    void loop()
+    {
+        unique_lock< mutex > lock(lock_);
+        while (true){
+            wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()){
+                break;
+            }
+            HDF5AsyncWriter* w = queue_.front();
+            queue_.pop_front();
+            ++active_;
+            lock.unlock();
+            w->write();
+            lock.lock();
+            --active_;
+            w->busy_ = false;
+            done_.notify_all();
+        }
+    }
+
+    mutex lock_;
+    condition_variable wake_;
+    condition_variable done_;
+    deque< HDF5AsyncWriter* > queue_;
+    bool stop_;
+    unsigned int active_;
+    thread thread_;
+};
+
+static HDF5IOThread& ioThread()
+{
+    static HDF5IOThread t;
+    return t;
+}
+
+HDF5AsyncWriter::HDF5AsyncWriter(): numSources_(0), busy_(false)
+{
+}
+
+HDF5AsyncWriter::HDF5AsyncWriter(const HDF5AsyncWriter& other):
+        targets_(other.targets_),
+        numSources_(other.numSources_),
+        busy_(false)
+{
+}
+
+HDF5AsyncWriter::~HDF5AsyncWriter()
+{
+    if (busy_){
+        HDF5IOThread& t = ioThread();
+        unique_lock< mutex > lock(t.lock_);
+        t.done_.wait(lock, [this] { return !busy_; });
+    }
+}
+
+void HDF5AsyncWriter::setTargets(const vector< Target >& targets,
+                                 unsigned int numSources)
+{
+    HDF5IOThread& t = ioThread();
+    {
+        unique_lock< mutex > lock(t.lock_);
+        t.done_.wait(lock, [this] { return !busy_; });
+    }
+    targets_ = targets;
+    numSources_ = numSources;
+    filling_.clear();
+}
+
+void HDF5AsyncWriter::append(const vector< double >& row)
+{
+    filling_.insert(filling_.end(), row.begin(), row.end());
+}
+
+unsigned int HDF5AsyncWriter::steps() const
+{
+    return numSources_ == 0 ? 0 : filling_.size() / numSources_;
+}
+
+void HDF5AsyncWriter::handOff()
+{
+    if (filling_.empty()){
+        return;
+    }
+    HDF5IOThread& t = ioThread();
+    {
+        unique_lock< mutex > lock(t.lock_);
+        t.done_.wait(lock, [this] { return !busy_; });
+        // writing_ was emptied by the I/O thread, so the two blocks
+        // keep their allocations.
+        writing_.swap(filling_);
+        busy_ = true;
+        t.queue_.push_back(this);
+    }
+    t.wake_.notify_one();
+}
+
+void HDF5AsyncWriter::waitAll()
+{
+    HDF5IOThread& t = ioThread();
+    unique_lock< mutex > lock(t.lock_);
+    t.done_.wait(lock, [&t] { return t.queue_.empty() && t.active_ == 0; });
+}
+
+void HDF5AsyncWriter::write()
+{
+    const hsize_t steps = writing_.size() / numSources_;
+    for (unsigned int ii = 0; ii < targets_.size(); ++ii){
+        const Target& tgt = targets_[ii];
+        if (tgt.dataset < 0){
+            continue;
+        }
+        herr_t status = 0;
+        hid_t filespace = H5Dget_space(tgt.dataset);
+        if (!tgt.transposed){
+            // Pick one column of the block straight from memory.
+            hsize_t old = H5Sget_simple_extent_npoints(filespace);
+            hsize_t size = old + steps;
+            H5Sclose(filespace);
+            status = H5Dset_extent(tgt.dataset, &size);
+            filespace = H5Dget_space(tgt.dataset);
+            hsize_t memdims[2] = {steps, numSources_};
+            hid_t memspace = H5Screate_simple(2, memdims, NULL);
+            hsize_t mstart[2] = {0, tgt.first};
+            hsize_t mcount[2] = {steps, 1};
+            H5Sselect_hyperslab(memspace, H5S_SELECT_SET, mstart, NULL,
+                                mcount, NULL);
+            H5Sselect_hyperslab(filespace, H5S_SELECT_SET, &old, NULL,
+                                &steps, NULL);
+            if (status >= 0){
+                status = H5Dwrite(tgt.dataset, H5T_NATIVE_DOUBLE, memspace,
+                                  filespace, H5P_DEFAULT, &writing_[0]);
+            }
+            H5Sclose(memspace);
+        } else {
+            // The dataset is source x time, so the block is transposed.
+            transposed_.resize(tgt.count * steps);
+            for (unsigned int jj = 0; jj < tgt.count; ++jj){
+                for (hsize_t kk = 0; kk < steps; ++kk){
+                    transposed_[jj * steps + kk] =
+                            writing_[kk * numSources_ + tgt.first + jj];
+                }
+            }
+            hsize_t dims[2];
+            H5Sget_simple_extent_dims(filespace, dims, NULL);
+            H5Sclose(filespace);
+            hsize_t newdims[2] = {dims[0], dims[1] + steps};
+            status = H5Dset_extent(tgt.dataset, newdims);
+            filespace = H5Dget_space(tgt.dataset);
+            hsize_t start[2] = {0, dims[1]};
+            hsize_t count[2] = {tgt.count, steps};
+            hid_t memspace = H5Screate_simple(2, count, NULL);
+            H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, NULL,
+                                count, NULL);
+            if (status >= 0){
+                status = H5Dwrite(tgt.dataset, H5T_NATIVE_DOUBLE, memspace,
+                                  filespace, H5P_DEFAULT, &transposed_[0]);
+            }
+            H5Sclose(memspace);
+        }
+        H5Sclose(filespace);
+        if (status < 0){
+            cerr << "Warning: HDF5AsyncWriter: appending to dataset "
+                 << ii << " returned status " << status << endl;
+        }
+    }
+    writing_.clear();
+}
+
+#endif // USE_HDF5
+
+//
+// HDF5AsyncWriter.cpp ends here
@@ -0,0 +1,89 @@
+// HDF5AsyncWriter.h ---
+//
+// Filename: HDF5AsyncWriter.h
+// Description:
+// Author:
+// Maintainer:
+// Created: Fri Oct 16 2026
+//
+
+// Commentary:
+//
+// Background appends of uniformly sampled data for the HDF5 writers.
+//
+// The simulation thread adds one row per step, holding the values of
+// all sources, to a time x source fill block. A full block is swapped
+// with a second block and queued for a single I/O thread shared by all
+// HDF5 writers, which extends the datasets and writes the block into
+// them. Each writer has at most one block queued, so append blocks when
+// the disk falls behind and memory stays at two blocks per writer.
+//
+// The HDF5 library is not assumed to be thread safe. All other HDF5
+// calls are made on the simulation thread, and they must be preceded by
+// waitAll(), which returns when the I/O thread is idle.
+//
+
+// Code:
+#ifdef USE_HDF5
+#ifndef _HDF5ASYNCWRITER_H
+#define _HDF5ASYNCWRITER_H
+
+#include "hdf5.h"
+
+class HDF5AsyncWriter
+{
+  public:
+    /**
+       Where a range of sources goes. If transposed is false the
+       dataset is 1D, and count must be 1. Otherwise it is a 2D
+       (count x time) dataset, as in NSDF uniform data.
+    */
+    struct Target
+    {
+        hid_t dataset;
+        unsigned int first;
+        unsigned int count;
+        bool transposed;
+    };
+
+    HDF5AsyncWriter();
+    HDF5AsyncWriter(const HDF5AsyncWriter& other);
+    ~HDF5AsyncWriter();
+
+    /// Waits for any queued block, then drops buffered rows and sets
+    /// the layout of the rows to come.
+    void setTargets(const vector< Target >& targets, unsigned int numSources);
+
+    /// Adds one row of values, one per source.
+    void append(const vector< double >& row);
+
+    /// Number of rows not yet handed to the I/O thread.
+    unsigned int steps() const;
+
+    /// Queues the buffered rows, waiting for the previous block of this
+    /// writer if it is still being written.
+    void handOff();
+
+    /// Returns once the I/O thread is idle.
+    static void waitAll();
+
+  private:
+    friend class HDF5IOThread;
+
+    /// Called on the I/O thread, with the block in writing_.
+    void write();
+
+    vector< Target > targets_;
+    unsigned int numSources_;
+    vector< double > filling_;
+    vector< double > writing_;
+    /// Scratch for transposed targets, used on the I/O thread.
+    vector< double > transposed_;
+    bool busy_;
+};
+
+#endif // _HDF5ASYNCWRITER_H
+#endif // USE_HDF5
+
+//
+// HDF5AsyncWriter.h ends here
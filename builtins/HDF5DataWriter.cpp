@@ -57,9 +57,20 @@ const Cinfo * HDF5DataWriter::initCinfo()
       &HDF5DataWriter::setFlushLimit,
       &HDF5DataWriter::getFlushLimit);
 
+    static ValueFinfo< HDF5DataWriter, bool> asyncWrite(
+      "asyncWrite",
+      "If true, data are extended into the datasets and written on a"
+      " background thread, in double-buffered blocks of at most"
+      " `flushLimit` steps. The simulation only waits if the disk falls"
+      " behind, or when `flush` or `close` is called. Supported by"
+      " HDF5DataWriter and NSDFWriter2. Default false.",
+      &HDF5DataWriter::setAsyncWrite,
+      &HDF5DataWriter::getAsyncWrite);
+
     static Finfo * finfos[] = {
         requestOut(),
         &flushLimit,
+        &asyncWrite,
         &proc,
     };
 
@@ -102,7 +113,8 @@ const Cinfo * HDF5DataWriter::initCinfo()
 
 static const Cinfo * hdf5dataWriterCinfo = HDF5DataWriter::initCinfo();
 
-HDF5DataWriter::HDF5DataWriter(): flushLimit_(4*1024*1024), steps_(0)
+HDF5DataWriter::HDF5DataWriter(): flushLimit_(4*1024*1024), steps_(0),
+                                  asyncWrite_(false), blockSteps_(0)
 {
 }
 
@@ -138,6 +150,10 @@ void HDF5DataWriter::flush()
                 "Filehandle invalid. Cannot write data." << endl;
         return;
     }
+    if (asyncWrite_){
+        async_.handOff();
+    }
+    HDF5AsyncWriter::waitAll();
 
     for (unsigned int ii = 0; ii < datasets_.size(); ++ii){
         herr_t status = appendToDataset(datasets_[ii], data_[ii]);
@@ -162,12 +178,21 @@ void HDF5DataWriter::process(const Eref & e, ProcPtr p)
 
     vector <double> dataBuf;
         requestOut()->send(e, &dataBuf);
+    if (asyncWrite_){
+        async_.append(dataBuf);
+        if (async_.steps() >= blockSteps_){
+            async_.handOff();
+        }
+        return;
+    }
     for (unsigned int ii = 0; ii < dataBuf.size(); ++ii){
         data_[ii].push_back(dataBuf[ii]);
     }
     ++steps_;
     if (steps_ >= flushLimit_){
         steps_ = 0;
+        // Other writers may have blocks on the I/O thread.
+        HDF5AsyncWriter::waitAll();
         for (unsigned int ii = 0; ii < datasets_.size(); ++ii){
             herr_t status = appendToDataset(datasets_[ii], data_[ii]);
             data_[ii].clear();
@@ -182,6 +207,8 @@ void HDF5DataWriter::process(const Eref & e, ProcPtr p)
 void HDF5DataWriter::reinit(const Eref & e, ProcPtr p)
 {
     steps_ = 0;
+    dt_ = p->dt;
+    HDF5AsyncWriter::waitAll();
     for (unsigned int ii = 0; ii < data_.size(); ++ii){
         H5Dclose(datasets_[ii]);
     }
@@ -228,6 +255,24 @@ void HDF5DataWriter::reinit(const Eref & e, ProcPtr p)
         datasets_.push_back(dataset_id);
     }
     data_.resize(src_.size());
+
+    vector< HDF5AsyncWriter::Target > targets;
+    for (unsigned int ii = 0; ii < datasets_.size(); ++ii){
+        HDF5AsyncWriter::Target tgt = {datasets_[ii], ii, 1, false};
+        targets.push_back(tgt);
+    }
+    async_.setTargets(targets, src_.size());
+    blockSteps_ = asyncBlockSteps(src_.size());
+}
+
+/**
+   A few chunks' worth of steps, so that each block fills whole chunks
+   and its size does not grow with flushLimit.
+ */
+unsigned int HDF5DataWriter::asyncBlockSteps(unsigned int numSources) const
+{
+    hsize_t steps = 4 * chunkSteps(numSources);
+    return max((hsize_t)1, min(steps, (hsize_t)flushLimit_));
 }
 
 /**
@@ -282,7 +327,10 @@ hid_t HDF5DataWriter::getDataset(string path)
     if (exists > 0){
         dataset_id = H5Dopen2(prev_id, name.c_str(), H5P_DEFAULT);
     } else if (exists == 0){
-        dataset_id = createDoubleDataset(prev_id, name);
+        // All datasets grow by one value per step, so the chunks are
+        // sized for the whole set of sources.
+        dataset_id = createDoubleDataset(prev_id, name, 0, H5S_UNLIMITED,
+                                         chunkSteps(src_.size()));
     } else {
         cerr << "Error: H5Lexists returned "
              << exists << " for path \""
@@ -301,6 +349,19 @@ unsigned int HDF5DataWriter::getFlushLimit() const
     return flushLimit_;
 }
 
+void HDF5DataWriter::setAsyncWrite(bool value)
+{
+    if (value != asyncWrite_ && filehandle_ >= 0){
+        flush();
+    }
+    asyncWrite_ = value;
+}
+
+bool HDF5DataWriter::getAsyncWrite() const
+{
+    return asyncWrite_;
+}
+
 #endif // USE_HDF5
 //
 // HDF5DataWriter.cpp ends here
@@ -38,6 +38,7 @@
 #define _HDF5DATAWRITER_H
 
 #include "HDF5WriterBase.h"
+#include "HDF5AsyncWriter.h"
 
 class HDF5DataWriter: public HDF5WriterBase
 {
@@ -46,6 +47,8 @@ class HDF5DataWriter: public HDF5WriterBase
     virtual ~HDF5DataWriter();
     void setFlushLimit(unsigned int limit);
     unsigned int getFlushLimit() const;
+    void setAsyncWrite(bool value);
+    bool getAsyncWrite() const;
     // void flush();
     void process(const Eref &e, ProcPtr p);
     void reinit(const Eref &e, ProcPtr p);
@@ -61,7 +64,14 @@ class HDF5DataWriter: public HDF5WriterBase
     vector <string> func_;
     vector <hid_t> datasets_;
     unsigned long steps_;
+    // In asyncWrite mode the data go through async_ in blocks of
+    // blockSteps_ rows, instead of data_.
+    bool asyncWrite_;
+    HDF5AsyncWriter async_;
+    unsigned int blockSteps_;
     hid_t getDataset(string path);
+    /// Rows of data per block handed to the I/O thread.
+    unsigned int asyncBlockSteps(unsigned int numSources) const;
 };
 #endif // _HDF5DATAWRITER_H
 #endif // USE_HDF5
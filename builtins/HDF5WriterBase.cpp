@@ -31,6 +31,7 @@
 #ifdef USE_HDF5
 
 #include <algorithm>
+#include <cmath>
 #include <string>
 #include <fstream>
 
@@ -41,6 +42,7 @@
 #include "../utility/strutil.h"
 
 #include "HDF5WriterBase.h"
+#include "HDF5AsyncWriter.h"
 
 using namespace std;
 
@@ -115,14 +117,16 @@ hid_t require_group(hid_t file, string path)
 }
 
 /**
-   Create a new 1D dataset. Make it extensible.
+   Create a new 1D dataset. Make it extensible. Without an explicit
+   chunk length, as for event datasets, it uses chunkSize or else
+   CHUNK_SIZE.
 */
-hid_t HDF5WriterBase::createDoubleDataset(hid_t parent_id, std::string name, hsize_t size, hsize_t maxsize)
+hid_t HDF5WriterBase::createDoubleDataset(hid_t parent_id, std::string name, hsize_t size, hsize_t maxsize, hsize_t chunk)
 {
     herr_t status;
     hsize_t dims[1] = {size};
     hsize_t maxdims[] = {maxsize};
-    hsize_t _chunkSize = chunkSize_;
+    hsize_t _chunkSize = chunk > 0 ? chunk : fixedChunkSize();
     if (_chunkSize > maxsize){
         _chunkSize = maxsize;
     }
@@ -156,7 +160,7 @@ hid_t HDF5WriterBase::createStringDataset(hid_t parent_id, string name, hsize_t
     }
     hsize_t dims[] = {size};
     hsize_t maxdims[] = {maxsize};
-    hsize_t _chunkSize = chunkSize_;
+    hsize_t _chunkSize = fixedChunkSize();
     if (maxsize < _chunkSize){
         _chunkSize = maxsize;
     }
@@ -227,7 +231,7 @@ hid_t HDF5WriterBase::createDataset2D(hid_t parent, string name, unsigned int ro
     }
     herr_t status;
     // we need chunking here to allow extensibility
-    hsize_t chunkdims[] = {rows, chunkSize_};
+    hsize_t chunkdims[] = {rows, chunkSteps(rows)};
     hid_t chunk_params = H5Pcreate(H5P_DATASET_CREATE);
     status = H5Pset_chunk(chunk_params, 2, chunkdims);
     assert(status >= 0);
@@ -248,6 +252,33 @@ hid_t HDF5WriterBase::createDataset2D(hid_t parent, string name, unsigned int ro
     return dset;
 }
 
+/**
+   Unless the user set chunkSize, a chunk holds about 1 MiB of data from
+   all the sources, so that one block of steps fills one chunk in each
+   dataset. It covers at most a second of simulated time, which is the
+   usual granularity of reads, but never less than 64 steps.
+ */
+hsize_t HDF5WriterBase::chunkSteps(hsize_t sources) const
+{
+    if (chunkSize_ > 0){
+        return chunkSize_;
+    }
+    hsize_t steps = (1 << 17) / max(sources, (hsize_t)1);
+    if (dt_ > 0){
+        steps = min(steps, (hsize_t)ceil(1.0 / dt_));
+    }
+    return max(steps, (hsize_t)64);
+}
+
+/**
+   Event and string datasets do not grow by one value per step, so their
+   chunks keep the fixed length.
+ */
+hsize_t HDF5WriterBase::fixedChunkSize() const
+{
+    return chunkSize_ > 0 ? chunkSize_ : (hsize_t)CHUNK_SIZE;
+}
+
 /**
    Iterate through the path->value map of scalar attributes of type
    `A` and write to HDF5 file handle `file_id`.
@@ -417,7 +448,10 @@ const Cinfo* HDF5WriterBase::initCinfo()
 
   static ValueFinfo< HDF5WriterBase, unsigned int> chunkSize(
       "chunkSize",
-      "Chunksize for writing array data. Defaults to 100.",
+      "Chunk length along time for array data. The default, 0, picks it"
+      " for uniformly sampled data from the number of sources and the time"
+      " step, aiming at about 1 MiB per chunk, and uses 1024 for event"
+      " data.",
       &HDF5WriterBase::setChunkSize,
       &HDF5WriterBase::getChunkSize);
 
@@ -528,9 +562,10 @@ HDF5WriterBase::HDF5WriterBase():
         filehandle_(-1),
         filename_("moose_output.h5"),
         openmode_(H5F_ACC_EXCL),
-        chunkSize_(CHUNK_SIZE),
+        chunkSize_(0),
         compressor_("zlib"),
-        compression_(6)
+        compression_(6),
+        dt_(0)
 {
 }
 
@@ -571,6 +606,7 @@ bool HDF5WriterBase::isOpen() const
 herr_t HDF5WriterBase::openFile()
 {
     herr_t status = 0;
+    HDF5AsyncWriter::waitAll();
     if (filehandle_ >= 0){
         cout << "Warning: closing already open file and opening " << filename_ <<  endl;
         status = H5Fclose(filehandle_);
@@ -652,6 +688,7 @@ unsigned int HDF5WriterBase::getCompression() const
 // file.
 void HDF5WriterBase::flush()
 {
+    HDF5AsyncWriter::waitAll();
     flushAttributes();
     sattr_.clear();
     dattr_.clear();
@@ -80,12 +80,20 @@ class HDF5WriterBase
 
     herr_t openFile();
     // C++ sucks - does not allow template specialization inside class
-    hid_t createDoubleDataset(hid_t parent, std::string name, hsize_t size=0, hsize_t maxsize=H5S_UNLIMITED);
+    hid_t createDoubleDataset(hid_t parent, std::string name, hsize_t size=0, hsize_t maxsize=H5S_UNLIMITED, hsize_t chunk=0);
     hid_t createStringDataset(hid_t parent, std::string name, hsize_t size=0, hsize_t maxsize=H5S_UNLIMITED);
 
     herr_t appendToDataset(hid_t dataset, const vector<double>& data);
     hid_t createDataset2D(hid_t parent, string name, unsigned int rows);
 
+    /// Chunk length along time for datasets fed by `sources` sources
+    /// per step. This is chunkSize if set, else picked from sources and
+    /// dt_.
+    hsize_t chunkSteps(hsize_t sources) const;
+    /// Chunk length for event and string datasets: chunkSize if set,
+    /// else CHUNK_SIZE.
+    hsize_t fixedChunkSize() const;
+
     /// map from element path to nodes in hdf5file.  Multiple MOOSE
     /// tables can be written to the single file corresponding to a
     /// HDF5Writer. Each one will be represented by a specific data
@@ -106,6 +114,9 @@ class HDF5WriterBase
     unsigned int chunkSize_;
     string compressor_; // can be zlib or szip
     unsigned int compression_;
+    /// Time step of the recorded data, 0 if not known. Set by
+    /// subclasses before creating datasets.
+    double dt_;
 
 };
 
@@ -475,6 +475,8 @@ hid_t NSDFWriter::getEventDataset(string srcPath, string srcField)
 
 void NSDFWriter::flush()
 {
+    // Other writers may have blocks on the I/O thread.
+    HDF5AsyncWriter::waitAll();
     // We need to update the tend on each write since we do not know
     // when the simulation is getting over and when it is just paused.
     writeScalarAttr<string>(filehandle_, "tend", iso_time(NULL));
@@ -542,6 +544,7 @@ void NSDFWriter::reinit(const Eref& eref, const ProcPtr proc)
     // TODO: what to do when reinit is called? Close the existing file
     // and open a new one in append mode? Or keep adding to the
     // current file?
+    dt_ = proc->dt;
     if (filename_.empty()){
         filename_ = "moose_data.nsdf.h5";
     }
@@ -516,6 +516,12 @@ hid_t NSDFWriter2::getEventDataset(string srcPath, string srcField)
 
 void NSDFWriter2::flush()
 {
+    if (asyncWrite_){
+        async_.handOff();
+        // blocks_ hold no rows in async mode, steps_ only times events.
+        steps_ = 0;
+    }
+    HDF5AsyncWriter::waitAll();
     // We need to update the tend on each write since we do not know
     // when the simulation is getting over and when it is just paused.
     writeScalarAttr<string>(filehandle_, "tend", iso_time(NULL));
@@ -562,14 +568,18 @@ void NSDFWriter2::flush()
     }
 	steps_ = 0;
 
-    // append all event data
+    appendEvents();
+    // flush HDF5 nodes.
+    HDF5DataWriter::flush();
+}
+
+void NSDFWriter2::appendEvents()
+{
     for (unsigned int ii = 0; ii < eventSrc_.size(); ++ii){
         appendToDataset(getEventDataset(eventSrc_[ii], eventSrcFields_[ii]),
                         events_[ii]);
         events_[ii].clear();
     }
-    // flush HDF5 nodes.
-    HDF5DataWriter::flush();
 }
 
 void NSDFWriter2::reinit(const Eref& eref, const ProcPtr proc)
@@ -586,6 +596,7 @@ void NSDFWriter2::reinit(const Eref& eref, const ProcPtr proc)
     if (filename_.empty()){
         filename_ = "moose_data.nsdf.h5";
     }
+    dt_ = proc->dt;
     openFile();
     writeScalarAttr<string>(filehandle_, "created", iso_time(0));
     writeScalarAttr<string>(filehandle_, "tstart", iso_time(0));
@@ -604,6 +615,18 @@ void NSDFWriter2::reinit(const Eref& eref, const ProcPtr proc)
     createEventMap();
 	writeStaticCoords();
     steps_ = 0;
+
+    // Each block is a range of columns in the rows given to async_.
+    vector< HDF5AsyncWriter::Target > targets;
+    unsigned int numSources = 0;
+	for (auto bi = blocks_.begin(); bi != blocks_.end(); ++bi) {
+        HDF5AsyncWriter::Target tgt = {bi->dataset, numSources,
+            (unsigned int)bi->data.size(), true};
+        targets.push_back(tgt);
+        numSources += bi->data.size();
+	}
+    async_.setTargets(targets, numSources);
+    blockSteps_ = asyncBlockSteps(numSources);
 }
 
 void NSDFWriter2::process(const Eref& eref, ProcPtr proc)
@@ -618,6 +641,26 @@ void NSDFWriter2::process(const Eref& eref, ProcPtr proc)
 	assert( uniformData.size() == mapMsgIdx_.size() );
 	// Note that uniformData is ordered by msg tgt order. We want to store
 	// data in block_->objVec order.
+    if (asyncWrite_){
+        row_.resize(mapMsgIdx_.size());
+        for (unsigned int ii = 0; ii < row_.size(); ++ii){
+            row_[ii] = uniformData[ mapMsgIdx_[ii] ];
+        }
+        async_.append(row_);
+        if (async_.steps() >= blockSteps_){
+            async_.handOff();
+        }
+        // Uniform rows wait in async_ till the block is full, but events
+        // still go out every flushLimit steps, once the I/O thread is
+        // done with the file.
+        if (++steps_ < flushLimit_){
+            return;
+        }
+        HDF5AsyncWriter::waitAll();
+        appendEvents();
+        steps_ = 0;
+        return;
+    }
 	unsigned int ii = 0;
 	for (unsigned int blockIdx = 0; blockIdx < blocks_.size(); ++blockIdx) {
 		vector< vector< double > >&  bjd = blocks_[blockIdx].data;
@@ -145,6 +145,8 @@ class NSDFWriter2: public HDF5DataWriter
 
   protected:
     hid_t getEventDataset(string srcPath, string srcField);
+    // Appends the buffered event times to their datasets.
+    void appendEvents();
     // void sortOutUniformSources(const Eref& eref);
 	void buildUniformSources(const Eref& eref);
 	void sortMsgs(const Eref& eref);
@@ -205,6 +207,8 @@ class NSDFWriter2: public HDF5DataWriter
     map< string, vector < string > > classFieldToObjectField_;
     vector < string > vars_;
     string modelRoot_;
+    // One step of uniform data in block order, for asyncWrite.
+    vector < double > row_;
 
 };
 #endif // _NSDFWRITER2_H
@@ -0,0 +1,100 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "RequestSampler.h"
+
+RequestSampler::RequestSampler()
+    :
+    src_( 0 ),
+    isDirect_( false ),
+    element_( 0 ),
+    dataIndex_( 0 ),
+    digestVersion_( 0 )
+{;}
+
+void RequestSampler::resolve( const Eref& e,
+                              const SrcFinfo1< vector< double >* >* src )
+{
+    src_ = src;
+    sources_.clear();
+    isDirect_ = true;
+
+    MsgDigestRange md = e.msgDigest( src->getBindIndex() );
+    for ( const MsgDigest* i = md.begin(); i != md.end(); ++i )
+    {
+        const GetOpFuncBase< double >* f =
+            dynamic_cast< const GetOpFuncBase< double >* >( i->func );
+        if ( !f )
+        {
+            isDirect_ = false;
+            sources_.clear();
+            break;
+        }
+        for ( const Eref* j = i->targets.begin(); j != i->targets.end(); ++j )
+        {
+            Source s = { f, *j };
+            sources_.push_back( s );
+        }
+        for ( const SparseTargets& st : i->sparseTargets )
+        {
+            for ( unsigned int k = 0; k < st.size; ++k )
+            {
+                Source s = { f,
+                    Eref( st.e, st.dataIndex[k], st.fieldIndex[k] ) };
+                sources_.push_back( s );
+            }
+        }
+    }
+
+    // Taken after the msgDigest call, which may have re-digested.
+    element_ = e.element();
+    dataIndex_ = e.dataIndex();
+    digestVersion_ = e.element()->digestVersion();
+}
+
+void RequestSampler::sample( const Eref& e, vector< double >& ret )
+{
+    assert( src_ );
+    // The msgDigest call makes the Element re-digest if it was rewired.
+    e.msgDigest( src_->getBindIndex() );
+    if ( e.element() != element_ || e.dataIndex() != dataIndex_ ||
+            e.element()->digestVersion() != digestVersion_ )
+        resolve( e, src_ );
+
+    ret.clear();
+    if ( !isDirect_ )
+    {
+        src_->send( e, &ret );
+        return;
+    }
+    for ( vector< Source >::const_iterator
+            i = sources_.begin(); i != sources_.end(); ++i )
+    {
+        if ( i->target.dataIndex() == ALLDATA )
+        {
+            // Expanded here rather than in resolve, as the send does,
+            // since the target may be resized without a rewiring.
+            Element* t = i->target.element();
+            unsigned int start = t->localDataStart();
+            unsigned int end = start + t->numLocalData();
+            for ( unsigned int k = start; k < end; ++k )
+                ret.push_back( i->func->returnOp( Eref( t, k ) ) );
+        }
+        else
+        {
+            ret.push_back( i->func->returnOp( i->target ) );
+        }
+    }
+}
+
+bool RequestSampler::isDirect() const
+{
+    return isDirect_;
+}
@@ -0,0 +1,64 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _REQUEST_SAMPLER_H
+#define _REQUEST_SAMPLER_H
+
+/**
+ * Reads the fields that a recording object's requestOut message is
+ * connected to, without sending the message.
+ *
+ * A send of requestOut walks the message digest and calls each
+ * target's get OpFunc, which pushes its value onto the vector passed
+ * along. The sampler looks up the same get OpFuncs and targets once,
+ * and then calls returnOp on them directly at every step.
+ *
+ * The lookup is redone whenever the requesting Element re-digests its
+ * messages. If any target is not a local get function, as with targets
+ * on other nodes, the sampler falls back to sending the request.
+ */
+class RequestSampler
+{
+public:
+    RequestSampler();
+
+    /**
+     * Looks up the targets of src on e. Called from reinit. sample()
+     * also calls it if the messages have changed since.
+     */
+    void resolve( const Eref& e, const SrcFinfo1< vector< double >* >* src );
+
+    /**
+     * Replaces the contents of ret with the current values of the
+     * targets, in the order a send of the request would give them.
+     * ret keeps its capacity, so reusing it avoids allocation.
+     */
+    void sample( const Eref& e, vector< double >& ret );
+
+    /// True if the targets are read directly rather than by a send.
+    bool isDirect() const;
+
+private:
+    struct Source
+    {
+        const GetOpFuncBase< double >* func;
+        Eref target;	///< May have ALLDATA, as in the digest.
+    };
+
+    const SrcFinfo1< vector< double >* >* src_;
+    vector< Source > sources_;
+    bool isDirect_;
+
+    /// The Eref and digest version that sources_ were looked up for.
+    Element* element_;
+    unsigned int dataIndex_;
+    unsigned int digestVersion_;
+};
+
+#endif // _REQUEST_SAMPLER_H
@@ -0,0 +1,385 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "../basecode/global.h"
+#include "../utility/cnpy.hpp"
+#include "StreamWriter.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <fmt/format.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/**
+ * The I/O thread shared by all StreamWriters, and the table of open
+ * files. It is never destroyed: Tables may close their files during static
+ * destruction. StreamWriter::closeAll closes the files and stops the
+ * thread at exit, and open starts it again if needed.
+ */
+class WriterThread
+{
+public:
+    WriterThread()
+        : stop_( false ), running_( false )
+    {
+    }
+
+    /// Only called from the simulation thread, like stop.
+    void start()
+    {
+        if ( running_ )
+            return;
+        stop_ = false;
+        thread_ = thread( &WriterThread::loop, this );
+        running_ = true;
+    }
+
+    /// Returns once every queued block is written.
+    void stop()
+    {
+        if ( !running_ )
+            return;
+        {
+            lock_guard< mutex > lock( lock_ );
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+        running_ = false;
+    }
+
+    void loop()
+    {
+        unique_lock< mutex > lock( lock_ );
+        while ( true )
+        {
+            wake_.wait( lock, [this] { return stop_ || !queue_.empty(); } );
+            if ( queue_.empty() )
+                break;
+            StreamWriter* f = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            f->writeBlock();
+            lock.lock();
+            f->busy_ = false;
+            done_.notify_all();
+        }
+    }
+
+    /// Waits till f has no block queued or being written.
+    void waitIdle( StreamWriter* f, unique_lock< mutex >& lock )
+    {
+        done_.wait( lock, [f] { return !f->busy_; } );
+    }
+
+    mutex lock_;
+    condition_variable wake_;
+    condition_variable done_;
+    deque< StreamWriter* > queue_;
+    bool stop_;
+    thread thread_;
+
+    /// Only used from the simulation thread.
+    bool running_;
+    map< string, StreamWriter* > files_;
+};
+
+/// Seeks to a 64 bit offset, which fseek cannot take on Windows.
+static void seekTo( FILE* fp, uint64_t pos )
+{
+#ifdef _WIN32
+    _fseeki64( fp, pos, SEEK_SET );
+#else
+    fseeko( fp, pos, SEEK_SET );
+#endif
+}
+
+static WriterThread& writerThread()
+{
+    static WriterThread* w = new WriterThread();
+    return *w;
+}
+
+StreamWriter::StreamWriter( const string& path, Format format,
+                            const vector< string >& columns )
+    :
+    path_( path ), tmpPath_( path + ".tmp" ), published_( false ),
+    format_( format ), columns_( columns ), fp_( 0 ),
+    busy_( false ), numRows_( 0 ), headerRows_( 0 ), headerLength_( 0 ),
+    blockRows_( 1 ), dataEnd_( 0 ), footerCurrent_( false )
+{
+    if ( columns_.size() > 0 )
+        blockRows_ = max( ( size_t )1, BlockSize / columns_.size() );
+
+    fp_ = fopen( tmpPath_.c_str(), "wb" );
+    if ( !fp_ )
+        return;
+
+    string header;
+    if ( format_ == NPY )
+    {
+        header = cnpy2::headerBytes( columns_, vector< size_t >( 1, 0 ), 0 );
+        headerLength_ = header.size();
+    }
+    else if ( format_ == TRACE || format_ == TRACE_Z )
+    {
+        header = trace::headerBytes( columns_, blockRows_, format_ == TRACE_Z );
+        dataEnd_ = header.size();
+    }
+    else
+    {
+        for ( auto i = columns_.begin(); i != columns_.end(); ++i )
+            header += *i + ' ';
+        header += '\n';
+    }
+    fwrite( header.data(), 1, header.size(), fp_ );
+}
+
+StreamWriter::~StreamWriter()
+{
+    if ( fp_ )
+    {
+        flush();
+        fclose( fp_ );
+    }
+}
+
+StreamWriter* StreamWriter::open( const string& path, Format format,
+                                  const vector< string >& columns )
+{
+    close( path );
+    StreamWriter* f = new StreamWriter( path, format, columns );
+    if ( !f->fp_ )
+    {
+        delete f;
+        return 0;
+    }
+    WriterThread& w = writerThread();
+    w.files_[ path ] = f;
+    w.start();
+    return f;
+}
+
+StreamWriter* StreamWriter::find( const string& path )
+{
+    WriterThread& w = writerThread();
+    auto i = w.files_.find( path );
+    return ( i == w.files_.end() ) ? 0 : i->second;
+}
+
+void StreamWriter::close( const string& path )
+{
+    WriterThread& w = writerThread();
+    auto i = w.files_.find( path );
+    if ( i != w.files_.end() )
+    {
+        delete i->second;
+        w.files_.erase( i );
+    }
+}
+
+void StreamWriter::flushAll()
+{
+    WriterThread& w = writerThread();
+    for ( auto i = w.files_.begin(); i != w.files_.end(); ++i )
+        i->second->flush();
+}
+
+void StreamWriter::closeAll()
+{
+    WriterThread& w = writerThread();
+    for ( auto i = w.files_.begin(); i != w.files_.end(); ++i )
+        delete i->second;
+    w.files_.clear();
+    w.stop();
+}
+
+void StreamWriter::append( const vector< double >& data )
+{
+    if ( columns_.size() == 0 )
+        return;
+    filling_.insert( filling_.end(), data.begin(), data.end() );
+    numRows_ += data.size() / columns_.size();
+    if ( filling_.size() >= blockRows_ * columns_.size() )
+        handOff( false );
+}
+
+void StreamWriter::handOff( bool all )
+{
+    WriterThread& w = writerThread();
+    {
+        unique_lock< mutex > lock( w.lock_ );
+        w.waitIdle( this, lock );
+        // writing_ was emptied by the I/O thread, so the fill buffer
+        // keeps reusing the same two allocations.
+        writing_.swap( filling_ );
+        if ( !all && ( format_ == TRACE || format_ == TRACE_Z ) )
+        {
+            // Trace blocks are only written whole till the next flush.
+            size_t rest = writing_.size() % ( blockRows_ * columns_.size() );
+            filling_.assign( writing_.end() - rest, writing_.end() );
+            writing_.resize( writing_.size() - rest );
+        }
+        busy_ = true;
+        w.queue_.push_back( this );
+    }
+    w.wake_.notify_one();
+}
+
+void StreamWriter::flush()
+{
+    WriterThread& w = writerThread();
+    if ( !w.running_ )
+    {
+        // Stopped by closeAll, so nothing is queued. Write inline.
+        writing_.swap( filling_ );
+        writeBlock();
+    }
+    else
+    {
+        if ( !filling_.empty() )
+            handOff( true );
+        unique_lock< mutex > lock( w.lock_ );
+        w.waitIdle( this, lock );
+    }
+    if ( format_ == NPY )
+        updateHeader();
+    else if ( format_ == TRACE || format_ == TRACE_Z )
+        writeFooter();
+    fflush( fp_ );
+    if ( !published_ )
+        publish();
+}
+
+void StreamWriter::publish()
+{
+#ifdef _WIN32
+    // Windows renames neither an open file nor over an existing one that
+    // is still mapped.
+    fclose( fp_ );
+    bool ok = MoveFileExA( tmpPath_.c_str(), path_.c_str(),
+                           MOVEFILE_REPLACE_EXISTING );
+    fp_ = fopen( ( ok ? path_ : tmpPath_ ).c_str(), "r+b" );
+    _fseeki64( fp_, 0, SEEK_END );
+#else
+    bool ok = ( rename( tmpPath_.c_str(), path_.c_str() ) == 0 );
+#endif
+    if ( ok )
+        published_ = true;
+    else
+        LOG( moose::warning, "Could not replace " << path_
+             << ". Its new data is in " << tmpPath_ << " till the next flush." );
+}
+
+void StreamWriter::writeBlock()
+{
+    if ( format_ == NPY )
+    {
+        fwrite( writing_.data(), sizeof( double ), writing_.size(), fp_ );
+    }
+    else if ( format_ == TRACE || format_ == TRACE_Z )
+    {
+        writeTraceBlocks();
+    }
+    else
+    {
+        // Shortest text that reads back as the same double.
+        fmt::memory_buffer text;
+        const size_t numCols = columns_.size();
+        for ( size_t i = 0; i + numCols <= writing_.size(); i += numCols )
+        {
+            for ( size_t j = 0; j < numCols; ++j )
+            {
+                fmt::format_to( text, "{}", writing_[ i + j ] );
+                text.push_back( ' ' );
+            }
+            text[ text.size() - 1 ] = '\n';
+        }
+        fwrite( text.data(), 1, text.size(), fp_ );
+    }
+    writing_.clear();
+}
+
+void StreamWriter::updateHeader()
+{
+    if ( headerRows_ == numRows_ )
+        return;
+    string header = cnpy2::headerBytes( columns_,
+                                        vector< size_t >( 1, numRows_ ), headerLength_ );
+    if ( header.empty() )
+    {
+        LOG( moose::warning, "Too many rows for the npy header of " << path_ );
+        return;
+    }
+    fseek( fp_, 0, SEEK_SET );
+    fwrite( header.data(), 1, header.size(), fp_ );
+    fseek( fp_, 0, SEEK_END );
+    headerRows_ = numRows_;
+}
+
+void StreamWriter::writeTraceBlocks()
+{
+    const size_t numCols = columns_.size();
+    const size_t rows = writing_.size() / numCols;
+    vector< double > col;
+    string packed;
+
+    // Overwrites the index, if flush wrote one.
+    seekTo( fp_, dataEnd_ );
+    for ( size_t r0 = 0; r0 < rows; r0 += blockRows_ )
+    {
+        const size_t m = min( blockRows_, rows - r0 );
+        trace::Block b;
+        b.firstRow = blocks_.empty() ? 0 :
+                     blocks_.back().firstRow + blocks_.back().numRows;
+        b.numRows = m;
+        b.tStart = writing_[ r0 * numCols ];
+        b.tEnd = writing_[ ( r0 + m - 1 ) * numCols ];
+        col.resize( m );
+        for ( size_t j = 0; j < numCols; ++j )
+        {
+            for ( size_t i = 0; i < m; ++i )
+                col[ i ] = writing_[ ( r0 + i ) * numCols + j ];
+            b.offset.push_back( dataEnd_ );
+            packed.clear();
+            if ( format_ == TRACE_Z )
+                trace::encodeChunk( col.data(), m, packed );
+            if ( format_ == TRACE_Z && packed.size() < m * sizeof( double ) )
+            {
+                b.bytes.push_back( packed.size() );
+                // Keeps later raw chunks 8 byte aligned.
+                packed.append( ( 8 - packed.size() % 8 ) % 8, '\0' );
+                fwrite( packed.data(), 1, packed.size(), fp_ );
+                dataEnd_ += packed.size();
+            }
+            else
+            {
+                b.bytes.push_back( m * sizeof( double ) );
+                fwrite( col.data(), sizeof( double ), m, fp_ );
+                dataEnd_ += m * sizeof( double );
+            }
+        }
+        blocks_.push_back( b );
+    }
+    footerCurrent_ = false;
+}
+
+void StreamWriter::writeFooter()
+{
+    if ( footerCurrent_ )
+        return;
+    string footer = trace::footerBytes( blocks_, dataEnd_ );
+    seekTo( fp_, dataEnd_ );
+    fwrite( footer.data(), 1, footer.size(), fp_ );
+    footerCurrent_ = true;
+}
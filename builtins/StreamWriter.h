@@ -0,0 +1,134 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _STREAM_WRITER_H
+#define _STREAM_WRITER_H
+
+#include <cstdio>
+#include "../utility/TraceFile.h"
+
+/**
+ * Output file of a Table or Streamer, kept open for the whole run.
+ *
+ * Rows are appended on the simulation thread into a fill buffer. Once
+ * the buffer holds BlockSize values it is swapped with a second buffer
+ * and queued for a single I/O thread shared by all open files. The I/O
+ * thread formats the block (CSV through fmt, or raw doubles for npy) and
+ * writes it. Each file has at most one block queued, so if the disk falls
+ * behind, append blocks until the previous block of that file is written.
+ * Memory use is bounded at two blocks per file.
+ *
+ * The npy header is rewritten in place by flush(), and not on every
+ * append. Trace files (see utility/TraceFile.h) are written one block of
+ * blockRows rows at a time, and flush() writes the block index after the
+ * last block. Files are opened by StreamerBase::writeToOutFile and flushed at
+ * the end of every Shell::doStart, so they are complete whenever control
+ * returns to the user.
+ *
+ * A new file is written under a temporary name and renamed over path by
+ * the first flush. The file it replaces is never truncated, so arrays that
+ * map it (see moose.TraceFile) stay valid after the model is run again.
+ */
+class StreamWriter
+{
+public:
+    /// TRACE_Z is the trace format with compressed chunks.
+    enum Format { CSV, NPY, TRACE, TRACE_Z };
+
+    ~StreamWriter();
+
+    /**
+     * Creates a file that replaces path at the first flush, and writes the
+     * header. Any writer already open on path is closed first. Returns 0
+     * if the file could not be created.
+     */
+    static StreamWriter* open( const string& path, Format format,
+                               const vector< string >& columns );
+
+    /// Returns the open writer for path, or 0 if there is none.
+    static StreamWriter* find( const string& path );
+
+    /// Flushes and closes the writer for path, if it is open.
+    static void close( const string& path );
+
+    /// Flushes every open writer.
+    static void flushAll();
+
+    /**
+     * Flushes and closes every open writer, and stops the I/O thread.
+     * Called at exit by Shell::cleanUp, before static destructors run.
+     */
+    static void closeAll();
+
+    /**
+     * Queues data, which is a whole number of rows, row by row. Blocks
+     * only if the previous block of this file is still being written.
+     */
+    void append( const vector< double >& data );
+
+    /// Returns when all data appended so far is in the file.
+    void flush();
+
+    /// Number of values in a block handed to the I/O thread.
+    static const size_t BlockSize = 1 << 16;
+
+private:
+    StreamWriter( const string& path, Format format,
+                  const vector< string >& columns );
+
+    /// Called on the I/O thread, with the file's block in writing_.
+    void writeBlock();
+
+    /**
+     * Swaps the fill buffer into writing_ and queues it. Unless all is
+     * set, trace files keep back the rows that do not fill a block.
+     */
+    void handOff( bool all );
+
+    /// Sets the row count in the npy header.
+    void updateHeader();
+
+    /// Writes the rows in writing_ as trace blocks.
+    void writeTraceBlocks();
+
+    /// Writes the trace block index after the last block.
+    void writeFooter();
+
+    /// Renames the file from tmpPath_ to path_.
+    void publish();
+
+    friend class WriterThread;
+
+    string path_;
+    string tmpPath_;
+    bool published_;
+    Format format_;
+    vector< string > columns_;
+    FILE* fp_;
+
+    /// Filled on the simulation thread.
+    vector< double > filling_;
+
+    /// Owned by the I/O thread while busy_.
+    vector< double > writing_;
+    bool busy_;
+
+    /// Rows in the file, and the number given in the npy header.
+    size_t numRows_;
+    size_t headerRows_;
+    size_t headerLength_;
+
+    /// Rows in a trace block, and the index of blocks written so far.
+    size_t blockRows_;
+    vector< trace::Block > blocks_;
+    uint64_t dataEnd_;
+    bool footerCurrent_;
+};
+
+#endif // _STREAM_WRITER_H
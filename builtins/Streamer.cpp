@@ -39,7 +39,9 @@ const Cinfo* Streamer::initCinfo()
 
     static ValueFinfo< Streamer, string > format(
         "format"
-        , "Format of output file, default is csv"
+        , "Format of output file, default is csv. npy, mtr (chunked columnar"
+        " trace, read with moose.TraceFile) and mtrz (mtr with compressed"
+        " chunks) are also supported."
         , &Streamer::setFormat
         , &Streamer::getFormat
     );
@@ -163,6 +165,8 @@ Streamer& Streamer::operator=( const Streamer& st )
 
 Streamer::~Streamer()
 {
+    if( ! datafilePath_.empty() )
+        StreamerBase::closeOutFile( datafilePath_ );
 }
 
 /**
@@ -413,33 +417,23 @@ void Streamer::zipWithTime( )
 
     //LOG( moose::debug, "Entries in each table " << numEntriesInEachTable );
 
-    // Collect data from all table. If some table does not have enough data,
-    // fill it with nan
-    vector< vector< double > > collectedData;
+    // Read the tables in place, and write the rows straight into data_.
+    // If some table does not have enough data, fill it with zeros.
+    vector< const vector< double >* > columns( tables_.size() );
     for( unsigned int i = 0; i < tables_.size( ); i++ )
-    {
-        vector<double> tVec( tables_[i]->getVector( ) );
-        if( tVec.size( ) <= numEntriesInEachTable )
-        {
-#if 0
-            LOG( moose::debug
-                 , "Table " << tables_[i]->getName( ) << " is not functional. Filling with zero "
-               );
-#endif
-            tVec.resize( numEntriesInEachTable, 0 );
-        }
-        collectedData.push_back( tVec );
-    }
+        columns[i] = &tables_[i]->data( );
 
-    // Turn it into a table format. Its like taking a transpose of vector<
-    // vector >.
     double allTableDt = tableDt_[ 0 ];
-    for( unsigned int i = 0; i < collectedData[0].size( ); i++ )
+    data_.reserve( data_.size() + numEntriesInEachTable * ( columns.size() + 1 ) );
+    for( unsigned int i = 0; i < numEntriesInEachTable; i++ )
     {
         data_.push_back( currTime_ );
         currTime_ += allTableDt;
-        for( unsigned int ii = 0; ii < collectedData.size(); ii++ )
-            data_.push_back( collectedData[ ii ][ i ] );
+        for( unsigned int ii = 0; ii < columns.size(); ii++ )
+        {
+            const vector< double >& col = *columns[ ii ];
+            data_.push_back( i < col.size() ? col[ i ] : 0.0 );
+        }
     }
 
     // After collection data from table, clear tables.
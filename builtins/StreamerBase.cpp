@@ -18,6 +18,7 @@
 #include "../basecode/global.h"
 #include "../basecode/header.h"
 #include "StreamerBase.h"
+#include "StreamWriter.h"
 
 #include "../scheduling/Clock.h"
 #include "../utility/cnpy.hpp"
@@ -67,24 +68,64 @@ void StreamerBase::writeToOutFile( const string& filepath
     if( data.size() == 0 )
         return;
 
+    StreamWriter::Format format = StreamWriter::CSV;
     if("npy" == outputFormat  || "npz" == outputFormat)
+        format = StreamWriter::NPY;
+    else if( "mtr" == outputFormat )
+        format = StreamWriter::TRACE;
+    else if( "mtrz" == outputFormat )
+        format = StreamWriter::TRACE_Z;
+    else if( "csv" != outputFormat && "dat" != outputFormat )
     {
-        OpenMode m = (openmode == WRITE)?WRITE_BIN:APPEND_BIN;
-        writeToNPYFile( filepath, m, data, columns );
+        LOG( moose::warning, "Unsupported format " << outputFormat
+                << ". Use npy, mtr, mtrz or csv. Falling back to default csv"
+           );
     }
-    else if( "csv" == outputFormat || "dat" == outputFormat )
+
+    // The file stays open between calls, and is written by the I/O thread.
+    // A trace file cannot be appended to once closed, so the first data of
+    // the run creates it even if it comes as an append.
+    const bool isTrace = StreamWriter::TRACE == format || StreamWriter::TRACE_Z == format;
+    StreamWriter* writer = 0;
+    if( openmode == WRITE || openmode == WRITE_STR || openmode == WRITE_BIN
+            || ( isTrace && ! StreamWriter::find( filepath ) ) )
     {
-        OpenMode m = (openmode == WRITE)?WRITE_STR:APPEND_STR;
-        writeToCSVFile( filepath, m, data, columns );
+        writer = StreamWriter::open( filepath, format, columns );
+        if( ! writer )
+        {
+            LOG( moose::warning, "Failed to open " << filepath );
+            return;
+        }
     }
     else
+        writer = StreamWriter::find( filepath );
+
+    if( writer )
     {
-        LOG( moose::warning, "Unsupported format " << outputFormat
-                << ". Use npy or csv. Falling back to default csv"
-           );
-        OpenMode m = (openmode == WRITE)?WRITE_STR:APPEND_STR;
-        writeToCSVFile( filepath, m, data, columns );
+        writer->append( data );
+        return;
     }
+
+    // Appending to a file that this process did not create.
+    if( StreamWriter::NPY == format )
+        writeToNPYFile( filepath, APPEND_BIN, data, columns );
+    else
+        writeToCSVFile( filepath, APPEND_STR, data, columns );
+}
+
+void StreamerBase::flushOutFiles()
+{
+    StreamWriter::flushAll();
+}
+
+void StreamerBase::closeOutFile( const string& filepath )
+{
+    StreamWriter::close( filepath );
+}
+
+void StreamerBase::closeOutFiles()
+{
+    StreamWriter::closeAll();
 }
 
 /*  Write to a csv file.  */
@@ -55,8 +55,12 @@ public:
      *
      *  npy : numpy binary format (version 1 and 2), version 1 is default.
      *  csv or dat: comma separated value (delimiter ' ' )
+     *  mtr: chunked columnar trace (utility/TraceFile.h), mtrz: same with
+     *  compressed chunks.
      *
-     * @param  openmode (write or append)
+     * @param  openmode (write or append). Write creates the file and keeps it
+     * open; later appends are queued and written by a background thread (see
+     * StreamWriter). Call flushOutFiles before reading the file.
      *
      * @param  data, vector of values
      *
@@ -70,6 +74,24 @@ public:
             , const vector<string>& columns
             );
 
+    /**
+     * @brief Wait till every file opened by writeToOutFile has all the data
+     * given to it so far.
+     */
+    static void flushOutFiles();
+
+    /**
+     * @brief Flush and close the file opened by writeToOutFile at filepath.
+     * Later appends to it are written directly.
+     */
+    static void closeOutFile( const string& filepath );
+
+    /**
+     * @brief Flush and close every file opened by writeToOutFile, and stop
+     * the thread writing them. Called at exit by Shell::cleanUp.
+     */
+    static void closeOutFiles();
+
     /**
      * @brief Write data to csv file. See the documentation of writeToOutfile
      * for details.
@@ -238,6 +238,7 @@ Table::~Table( )
         mergeWithTime( data_ );
         assert( ! datafile_.empty() );
         StreamerBase::writeToOutFile( datafile_, format_, APPEND, data_, columns_);
+        StreamerBase::closeOutFile( datafile_ );
         clearAllVecs();
     }
 }
@@ -256,18 +257,7 @@ void Table::process( const Eref& e, ProcPtr p )
 {
     lastTime_ = p->currTime;
     tvec_.push_back(lastTime_);
-
-    // Copy incoming data to ret and insert into vector.
-    vector< double > ret;
-    requestOut()->send( e, &ret );
-
-    if (useSpikeMode_)
-    {
-        for ( auto i = ret.begin(); i != ret.end(); ++i )
-            spike( *i );
-    }
-    else
-        vec().insert( vec().end(), ret.begin(), ret.end() );
+    record( e );
 
     /*  If we are streaming to a file, let's write to a file. And clean the
      *  vector.
@@ -291,6 +281,18 @@ void Table::clearAllVecs()
     data_.clear();
 }
 
+void Table::record( const Eref& e )
+{
+    sampler_.sample( e, sample_ );
+    if (useSpikeMode_)
+    {
+        for ( auto i = sample_.begin(); i != sample_.end(); ++i )
+            spike( *i );
+    }
+    else
+        vec().insert( vec().end(), sample_.begin(), sample_.end() );
+}
+
 /**
  * @brief Reinitialize
  *
@@ -327,16 +329,8 @@ void Table::reinit( const Eref& e, ProcPtr p )
     input_ = 0.0;
     vec().resize( 0 );
     lastTime_ = 0;
-    vector< double > ret;
-    requestOut()->send( e, &ret );
-
-    if (useSpikeMode_)
-    {
-        for ( auto i = ret.begin(); i != ret.end(); ++i )
-            spike( *i );
-    }
-    else
-        vec().insert( vec().end(), ret.begin(), ret.end() );
+    sampler_.resolve( e, requestOut() );
+    record( e );
 
     tvec_.push_back(lastTime_);
 
@@ -470,7 +464,8 @@ double Table::getDt( void ) const
  */
 void Table::mergeWithTime( vector<double>& data )
 {
-    auto v = vec();
+    const vector< double >& v = vec();
+    data.reserve( data.size() + 2 * v.size() );
     for (unsigned int i = 0; i < v.size(); i++)
     {
         data.push_back(tvec_[i]);
@@ -488,7 +483,7 @@ void Table::mergeWithTime( vector<double>& data )
 string Table::toJSON(bool withTime, bool clear)
 {
     stringstream ss;
-    auto v = vec();
+    const vector< double >& v = vec();
     if( clear )
         lastN_ = 0;
 
@@ -523,7 +518,7 @@ string Table::toJSON(bool withTime, bool clear)
 /* ----------------------------------------------------------------------------*/
 void Table::collectData(vector<double>& data, bool withTime, bool clear)
 {
-    auto v = vec();
+    const vector< double >& v = vec();
     if( clear )
         lastN_ = 0;
 
@@ -10,6 +10,8 @@
 #ifndef _TABLE_H
 #define _TABLE_H
 
+#include "RequestSampler.h"
+
 using namespace std;
 
 /**
@@ -58,6 +60,9 @@ public:
 
     void clearAllVecs();
 
+    /// Reads the requested fields and records them, or their spikes.
+    void record( const Eref& e );
+
     //////////////////////////////////////////////////////////////////
     // Dest funcs
     //////////////////////////////////////////////////////////////////
@@ -85,6 +90,14 @@ private:
     vector<double> data_;
     vector<double> tvec_;                       /* time data */
 
+    /**
+     * Reads the fields on the other end of requestOut, looked up at
+     * reinit. sample_ holds the values of one step and is reused, so
+     * recording does not allocate once the vectors have grown.
+     */
+    RequestSampler sampler_;
+    vector<double> sample_;
+
     // A table have 2 columns. First is time. We initialize this in reinit().
     vector<string> columns_; 
 
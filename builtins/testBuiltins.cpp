@@ -14,6 +14,9 @@
 #include "Arith.h"
 #include "TableBase.h"
 #include "Table.h"
+#include "StreamWriter.h"
+#include <fstream>
+#include <sstream>
 #include <queue>
 
 #include "../shell/Shell.h"
@@ -354,6 +357,193 @@ void testGetMsg()
 
 }
 
+/**
+ * Checks that the RequestSampler reads the same values, in the same
+ * order, as a send of requestOut, and that it follows new messages.
+ */
+void testRequestSampler()
+{
+	Shell* shell = reinterpret_cast< Shell* >( Id().eref().data() );
+	ObjId tabid = shell->doCreate( "Table", ObjId(), "tab", 1 );
+	ObjId a1 = shell->doCreate( "Arith", ObjId(), "a1", 1 );
+	Id a2 = shell->doCreate( "Arith", ObjId(), "a2", 3 );
+	ObjId a3 = shell->doCreate( "Arith", ObjId(), "a3", 1 );
+	Field< double >::set( a1, "outputValue", 1.0 );
+	for ( unsigned int i = 0; i < 3; ++i )
+		Field< double >::set( ObjId( a2, i ), "outputValue", 10.0 + i );
+	Field< double >::set( a3, "outputValue", 20.0 );
+
+	ObjId mid = shell->doAddMsg( "Single", tabid, "requestOut",
+					a1, "getOutputValue" );
+	assert( mid != ObjId() );
+	mid = shell->doAddMsg( "OneToAll", tabid, "requestOut",
+					a2, "getOutputValue" );
+	assert( mid != ObjId() );
+
+	const SrcFinfo1< vector< double >* >* src =
+		dynamic_cast< const SrcFinfo1< vector< double >* >* >(
+		Table::initCinfo()->findFinfo( "requestOut" ) );
+	assert( src );
+	RequestSampler sampler;
+	sampler.resolve( tabid.eref(), src );
+	assert( sampler.isDirect() );
+
+	vector< double > ret;
+	vector< double > sent;
+	sampler.sample( tabid.eref(), ret );
+	src->send( tabid.eref(), &sent );
+	assert( ret.size() == 4 );
+	assert( ret == sent );
+	assert( doubleEq( ret[0] + ret[1] + ret[2] + ret[3], 34.0 ) );
+
+	// Adding a message rewires the Table, so the sampler looks again.
+	mid = shell->doAddMsg( "Single", tabid, "requestOut",
+					a3, "getOutputValue" );
+	assert( mid != ObjId() );
+	Field< double >::set( a1, "outputValue", 2.0 );
+	sampler.sample( tabid.eref(), ret );
+	sent.clear();
+	src->send( tabid.eref(), &sent );
+	assert( ret.size() == 5 );
+	assert( ret == sent );
+
+	shell->doDelete( tabid );
+	shell->doDelete( a1 );
+	shell->doDelete( a2 );
+	shell->doDelete( a3 );
+	cout << "." << flush;
+}
+
+/**
+ * Writes more than one block through StreamWriter in both formats and
+ * reads the files back.
+ */
+void testStreamWriter()
+{
+	const size_t numRows = StreamWriter::BlockSize / 2 + 123;
+	vector< string > columns = { "time", "x" };
+	vector< double > row( 2 );
+
+	StreamWriter* w = StreamWriter::open( "_testStreamWriter.csv",
+					StreamWriter::CSV, columns );
+	assert( w );
+	assert( StreamWriter::find( "_testStreamWriter.csv" ) == w );
+	for ( size_t i = 0; i < numRows; ++i ) {
+		row[0] = i * 0.1;
+		row[1] = sin( row[0] );
+		w->append( row );
+	}
+	StreamWriter::close( "_testStreamWriter.csv" );
+	assert( StreamWriter::find( "_testStreamWriter.csv" ) == 0 );
+
+	ifstream csv( "_testStreamWriter.csv" );
+	string line;
+	getline( csv, line );
+	assert( line == "time x " );
+	size_t n = 0;
+	double t, x;
+	while ( csv >> t >> x ) {
+		assert( t == n * 0.1 );
+		assert( x == sin( t ) );
+		++n;
+	}
+	assert( n == numRows );
+	csv.close();
+	remove( "_testStreamWriter.csv" );
+
+	w = StreamWriter::open( "_testStreamWriter.npy", StreamWriter::NPY,
+					columns );
+	assert( w );
+	for ( size_t i = 0; i < numRows; ++i ) {
+		row[0] = i;
+		row[1] = 2.0 * i;
+		w->append( row );
+	}
+	w->flush();
+	ifstream npy( "_testStreamWriter.npy", ios::binary );
+	stringstream ss;
+	ss << npy.rdbuf();
+	string bytes = ss.str();
+	uint32_t headerLength = 0;
+	memcpy( &headerLength, bytes.data() + 8, 4 );
+	const size_t dataStart = 12 + headerLength;
+	assert( bytes.size() == dataStart + 2 * numRows * sizeof( double ) );
+	assert( bytes.find( "(" + to_string( numRows ) + ",)" ) < dataStart );
+	double last[2];
+	memcpy( last, bytes.data() + bytes.size() - sizeof( last ), sizeof( last ) );
+	assert( last[0] == numRows - 1 );
+	assert( last[1] == 2.0 * ( numRows - 1 ) );
+	npy.close();
+	StreamWriter::close( "_testStreamWriter.npy" );
+	remove( "_testStreamWriter.npy" );
+	cout << "." << flush;
+}
+
+/**
+ * Writes a trace file with and without compression, flushing in the
+ * middle, and reads it back by column and by time window. Then writes it
+ * again while the first version is still mapped.
+ */
+void testTraceFile()
+{
+	const size_t numRows = StreamWriter::BlockSize + 77;
+	vector< string > columns = { "time", "x", "spike" };
+	vector< double > row( 3 );
+	StreamWriter::Format formats[] = { StreamWriter::TRACE,
+					StreamWriter::TRACE_Z };
+	for ( unsigned int f = 0; f < 2; ++f ) {
+		StreamWriter* w = StreamWriter::open( "_testTraceFile.mtr",
+						formats[f], columns );
+		assert( w );
+		for ( size_t i = 0; i < numRows; ++i ) {
+			row[0] = i * 0.001;
+			row[1] = sin( row[0] );
+			row[2] = ( i % 100 == 0 );
+			w->append( row );
+			if ( i == numRows / 3 )
+				w->flush();
+		}
+		w->flush();
+
+		trace::Reader r( "_testTraceFile.mtr" );
+		assert( r.numRows() == numRows );
+		assert( r.columns() == columns );
+		assert( r.columnIndex( "x" ) == 1 );
+		assert( r.blocks().size() > 2 );
+		assert( ( r.chunk( 0, 2 ) == 0 ) == ( f == 1 ) );
+		vector< double > x( numRows );
+		r.read( 1, 0, numRows, &x[0] );
+		for ( size_t i = 0; i < numRows; ++i )
+			assert( x[i] == sin( i * 0.001 ) );
+		r.read( 2, 5, 200, &x[0] );
+		assert( x[95] == 1.0 && x[96] == 0.0 );
+
+		uint64_t first, last;
+		r.timeWindow( 10.0, 20.0, first, last );
+		assert( first == 10000 && last == 20001 );
+		r.timeWindow( -2.0, -1.0, first, last );
+		assert( first == last );
+
+		// Writing the file again leaves the mapping of the old one intact.
+		w = StreamWriter::open( "_testTraceFile.mtr", formats[f], columns );
+		assert( w );
+		for ( size_t i = 0; i < 10; ++i ) {
+			row[0] = i;
+			row[1] = row[2] = -1.0;
+			w->append( row );
+		}
+		w->flush();
+		trace::Reader r2( "_testTraceFile.mtr" );
+		assert( r2.numRows() == 10 );
+		r.read( 1, 0, numRows, &x[0] );
+		for ( size_t i = 0; i < numRows; ++i )
+			assert( x[i] == sin( i * 0.001 ) );
+		StreamWriter::close( "_testTraceFile.mtr" );
+	}
+	remove( "_testTraceFile.mtr" );
+	cout << "." << flush;
+}
+
 void testStats()
 {
 	Shell* shell = reinterpret_cast< Shell* >( Id().eref().data() );
@@ -429,6 +619,9 @@ void testBuiltins()
 {
 	testArith();
 	testTable();
+	testRequestSampler();
+	testStreamWriter();
+	testTraceFile();
 #if ENABLE_NSDF
         testNSDF();
 #endif
@@ -84,6 +84,17 @@ void DiffPoolVec::setPrevVec()
     prev_ = n_;
 }
 
+double* DiffPoolVec::nData()
+{
+    return n_.data();
+}
+
+double* DiffPoolVec::prevData()
+{
+    prev_.resize( n_.size(), 0.0 );
+    return prev_.data();
+}
+
 double DiffPoolVec::getDiffConst() const
 {
     return diffConst_;
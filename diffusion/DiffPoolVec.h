@@ -48,6 +48,8 @@ public:
     void setNvec( unsigned int start, unsigned int num,
                   vector< double >::const_iterator q );
     void setPrevVec(); /// Assigns prev_ = n_
+    double* nData(); /// Used by parent solver to share 'n' in place
+    double* prevData(); /// Used by parent solver to share 'prev' in place
     void setOps( const vector< Triplet< double > >& ops_,
                  const vector< double >& diagVal_ ); /// Assign operations.
 
@@ -1299,6 +1299,31 @@ void Dsolve::setPrev()
     }
 }
 
+void Dsolve::getPoolVecs( vector< double* >& n, vector< double* >& prev )
+{
+    n.clear();
+    prev.clear();
+    // Views are indexed from pool 0, as the reac solvers expect.
+    if ( poolStartIndex_ != 0 )
+        return;
+    for ( auto i = pools_.begin(); i != pools_.end(); ++i )
+    {
+        n.push_back( i->nData() );
+        prev.push_back( i->prevData() );
+    }
+}
+
+double* Dsolve::getStateVec( unsigned int index, unsigned int& size )
+{
+    if ( index >= pools_.size() )
+    {
+        size = 0;
+        return 0;
+    }
+    size = pools_[index].getNvec().size();
+    return pools_[index].nData();
+}
+
 void Dsolve::setBlock( const vector< double >& values )
 {
     unsigned int startVoxel = values[0];
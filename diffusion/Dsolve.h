@@ -147,6 +147,8 @@ public:
     void getBlock( vector< double >& values ) const;
     void setBlock( const vector< double >& values );
     void setPrev();
+    void getPoolVecs( vector< double* >& n, vector< double* >& prev );
+    double* getStateVec( unsigned int index, unsigned int& size );
 
     // This one isn't used in Dsolve, but is defined as a dummy.
     void setupCrossSolverReacs(
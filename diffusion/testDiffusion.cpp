@@ -754,6 +754,18 @@ void testCylDiffnWithStoich()
     assert( nvec.size() == poolVec.size() );
     for ( unsigned int i = 0; i < nvec.size(); ++i )
         assert( doubleEq( nvec[i], poolVec[i] ) );
+    // The Ksolve ran last, so its voxels must match what it handed the
+    // Dsolve, for both pools.
+    vector< double > nvec2 = LookupField< unsigned int, vector< double > >::
+        get( dsolve, "nVec", 1 );
+    for ( unsigned int i = 0; i < ndc; ++i )
+    {
+        vector< double > kvec = LookupField< unsigned int, vector< double > >::
+            get( ksolve, "nVec", i );
+        assert( kvec.size() >= 2 );
+        assert( doubleEq( kvec[0], nvec[i] ) );
+        assert( doubleEq( kvec[1], nvec2[i] ) );
+    }
     /*
     cout << endl;
     for ( unsigned int i = 0; i < nvec.size(); ++i )
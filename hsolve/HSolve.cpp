@@ -155,6 +155,14 @@ const Cinfo* HSolve::initCinfo()
         &HSolve::getCaMax
     );
 
+    static ReadOnlyValueFinfo< HSolve, vector< Id > > compartments(
+        "compartments",
+        "Compartments handled by the solver, in its internal order. "
+        "Arrays of per-compartment solver state, such as the Vm view "
+        "given to Python, follow this order.",
+        &HSolve::getCompartments
+    );
+
     static Finfo* hsolveFinfos[] =
     {
         &seed,              // Value
@@ -167,6 +175,7 @@ const Cinfo* HSolve::initCinfo()
         &caDiv,             // Value
         &caMin,             // Value
         &caMax,             // Value
+        &compartments,      // ReadOnlyValue
         &proc,              // Shared
     };
 
@@ -220,6 +229,8 @@ HSolve::~HSolve()
 
 void HSolve::process( const Eref& hsolve, ProcPtr p )
 {
+    if ( pop_ != Id() )
+        return;
     t0_ = high_resolution_clock::now();
     this->HSolveActive::step( p );
     t1_ = high_resolution_clock::now();
@@ -338,6 +349,27 @@ string HSolve::getPath( const Eref& e) const
     return path_;
 }
 
+void HSolve::setPopulation( Id pop )
+{
+    pop_ = pop;
+}
+
+Id HSolve::getPopulation() const
+{
+    return pop_;
+}
+
+vector< Id > HSolve::getCompartments() const
+{
+    return compartmentId_;
+}
+
+double* HSolve::getVmVec( unsigned int& size )
+{
+    size = V_.size();
+    return V_.data();
+}
+
 /**
  * This function performs a depth-first search (for a compartment) in the tree
  * with its root at 'base'. Returns (Id of) a compartment if found, else a
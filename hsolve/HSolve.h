@@ -150,6 +150,25 @@ public:
 
     static const Cinfo* initCinfo();
 
+    /**
+     * Hands stepping of this solver over to an HSolvePop, which then
+     * advances it along with the rest of its population. Pass Id() to
+     * take it back.
+     */
+    void setPopulation( Id pop );
+    Id getPopulation() const;
+
+    /// Compartments handled by the solver, in its internal order.
+    vector< Id > getCompartments() const;
+
+    /**
+     * Returns the solver's own array of compartment Vm, in the order
+     * of getCompartments(), and sets size to its length. This lets
+     * callers read or write Vm in place. The array is only valid until
+     * the solver is set up again.
+     */
+    double* getVmVec( unsigned int& size );
+
     static const std::set<string>& handledClasses();
     /**< Returns the set of classes "handled" by HSolve */
     static void deleteIncomingMessages( Element * orig, const string finfo);
@@ -173,6 +192,7 @@ private:
     double dt_;
     string path_;
     Id seed_;
+    Id pop_;	///< HSolvePop doing our stepping, if any.
 
     double totalTime_ = 0.0;
     high_resolution_clock::time_point t0_, t1_;
@@ -33,6 +33,7 @@ const int HSolveActive::INSTANT_Z = 4;
 HSolveActive::HSolveActive()
 {
     caAdvance_ = 1;
+    version_ = 0;
 
     // Default lookup table size
     //~ vDiv_ = 3000;    // for voltage
@@ -43,6 +44,16 @@ HSolveActive::HSolveActive()
 // Solving differential equations
 //////////////////////////////////////////////////////////////////////
 void HSolveActive::step( ProcPtr info )
+{
+    advance( info );
+    sendOutputs( info );
+}
+
+/**
+ * Everything in a step that touches only this cell's own data, so that
+ * independent cells can be advanced on different threads.
+ */
+void HSolveActive::advance( ProcPtr info )
 {
     if ( nCompt_ <= 0 )
         return;
@@ -57,14 +68,41 @@ void HSolveActive::step( ProcPtr info )
     updateMatrix();
     HSolvePassive::forwardEliminate();
     HSolvePassive::backwardSubstitute();
+    finishStep( info );
+}
+
+/**
+ * The part of the advance that follows the matrix solve. Split out so
+ * that HSolveBatch can do the solve for many cells at once and then hand
+ * each cell back for its calcium and synapses.
+ */
+void HSolveActive::finishStep( ProcPtr info )
+{
     advanceCalcium();
     advanceSynChans( info );
+}
+
+/**
+ * Sends the results of the step out through messages. Kept apart from
+ * advance() so that callers stepping cells in parallel can do the sends
+ * serially, in a fixed order.
+ */
+void HSolveActive::sendOutputs( ProcPtr info )
+{
+    if ( nCompt_ <= 0 )
+        return;
+
     sendValues( info );
     sendSpikes( info );
     prevExtCurr_ = externalCurrent_;
     externalCurrent_.assign( externalCurrent_.size(), 0.0 );
 }
 
+unsigned long HSolveActive::getVersion() const
+{
+    return version_;
+}
+
 void HSolveActive::calculateChannelCurrents()
 {
     vector< ChannelStruct >::iterator ichan;
@@ -29,6 +29,7 @@
 class HSolveActive: public HSolvePassive
 {
     typedef vector< CurrentStruct >::iterator currentVecIter;
+    friend class HSolveBatch;
 
 public:
     HSolveActive();
@@ -37,6 +38,16 @@ public:
     void step( ProcPtr info );			///< Equivalent to process
     void reinit( ProcPtr info );
 
+    /// The two halves of step: the solve, and the outgoing messages.
+    void advance( ProcPtr info );
+    void sendOutputs( ProcPtr info );
+
+    /**
+     * Bumped whenever the model is reinited or a parameter is set from
+     * outside, so that HSolveBatch knows when to reload this cell.
+     */
+    unsigned long getVersion() const;
+
 protected:
     /**
      * Solver parameters: exposed as fields in MOOSE
@@ -134,6 +145,7 @@ protected:
 		*   channels so that you can send out Calcium concentrations in only
 		*   those compartments. */
      vector< unsigned int >    outIk_;
+    unsigned long             version_;
 
 private:
     /**
@@ -167,6 +179,7 @@ private:
     void advanceCalcium();
     void advanceChannels( double dt );
     void advanceSynChans( ProcPtr info );
+    void finishStep( ProcPtr info );	///< Calcium and synapses
     void sendSpikes( ProcPtr info );
     void sendValues( ProcPtr info );
 
@@ -30,6 +30,7 @@ void HSolveActive::setup( Id seed, double dt )
 
     //~ reinit();
     cleanup();
+    ++version_;
 
     //~ cout << "# of compartments: " << compartmentId_.size() << "." << endl;
     //~ cout << "# of channels: " << channelId_.size() << "." << endl;
@@ -42,6 +43,7 @@ void HSolveActive::setup( Id seed, double dt )
 
 void HSolveActive::reinit( ProcPtr info )
 {
+    ++version_;
     externalCurrent_.assign( externalCurrent_.size(), 0.0 );
 
     reinitSpikeGens( info );
@@ -0,0 +1,741 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "HSolveStruct.h"
+#include "HinesMatrix.h"
+#include "HSolvePassive.h"
+#include "RateLookup.h"
+#include "HSolveActive.h"
+#include "HSolveBatch.h"
+
+HSolveBatch::HSolveBatch()
+    :
+    W_( 0 ),
+    nCompt_( 0 )
+{
+    ;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Grouping
+//////////////////////////////////////////////////////////////////////
+
+void HSolveBatch::translate( const HSolveActive* h,
+                             const vector< vector< double >::iterator >& op,
+                             vector< OperandRef >& ret )
+{
+    const double* base[] = { h->HS_.data(), h->HJ_.data(), h->VMid_.data() };
+    const size_t size[] = { h->HS_.size(), h->HJ_.size(), h->VMid_.size() };
+
+    ret.resize( op.size() );
+    for ( unsigned int i = 0; i < op.size(); ++i )
+    {
+        const double* p = &*op[ i ];
+        ret[ i ].array = ~0U;
+        for ( unsigned int a = 0; a < 3; ++a )
+        {
+            if ( p >= base[ a ] && p < base[ a ] + size[ a ] )
+            {
+                ret[ i ].array = a;
+                ret[ i ].offset = p - base[ a ];
+                break;
+            }
+        }
+        assert( ret[ i ].array != ~0U );
+    }
+}
+
+void HSolveBatch::caRowIndex( const HSolveActive* h, vector< int >& ret )
+{
+    ret.resize( h->caRow_.size() );
+    for ( unsigned int i = 0; i < h->caRow_.size(); ++i )
+        ret[ i ] = h->caRow_[ i ] ?
+                   h->caRow_[ i ] - h->caRowCompt_.data() : -1;
+}
+
+bool HSolveBatch::matches( const HSolveActive* a, const HSolveActive* b )
+{
+    if ( a->nCompt_ != b->nCompt_ ||
+            a->dt_ != b->dt_ ||
+            a->HS_.size() != b->HS_.size() ||
+            a->HJ_.size() != b->HJ_.size() ||
+            a->junction_.size() != b->junction_.size() ||
+            a->channel_.size() != b->channel_.size() ||
+            a->state_.size() != b->state_.size() ||
+            a->ca_.size() != b->ca_.size() ||
+            a->externalCurrent_.size() != b->externalCurrent_.size() ||
+            a->externalCalcium_.size() != b->externalCalcium_.size() ||
+            a->channelCount_ != b->channelCount_ ||
+            a->caCount_ != b->caCount_ ||
+            a->column_.size() != b->column_.size() )
+        return false;
+
+    for ( unsigned int i = 0; i < a->junction_.size(); ++i )
+        if ( a->junction_[ i ].index != b->junction_[ i ].index ||
+                a->junction_[ i ].rank != b->junction_[ i ].rank )
+            return false;
+
+    for ( unsigned int i = 0; i < a->channel_.size(); ++i )
+    {
+        const ChannelStruct& ca = a->channel_[ i ];
+        const ChannelStruct& cb = b->channel_[ i ];
+        if ( ca.Xpower_ != cb.Xpower_ || ca.Ypower_ != cb.Ypower_ ||
+                ca.Zpower_ != cb.Zpower_ || ca.instant_ != cb.instant_ )
+            return false;
+    }
+
+    for ( unsigned int i = 0; i < a->column_.size(); ++i )
+        if ( a->column_[ i ].column != b->column_[ i ].column )
+            return false;
+
+    vector< int > rowA, rowB;
+    caRowIndex( a, rowA );
+    caRowIndex( b, rowB );
+    if ( rowA != rowB )
+        return false;
+
+    vector< OperandRef > opA, opB;
+    translate( a, a->operand_, opA );
+    translate( b, b->operand_, opB );
+    if ( opA != opB )
+        return false;
+    translate( a, a->backOperand_, opA );
+    translate( b, b->backOperand_, opB );
+    return opA == opB;
+}
+
+void HSolveBatch::setCells( const vector< HSolveActive* >& cells )
+{
+    cells_ = cells;
+    W_ = cells_.size();
+    version_.assign( W_, 0 );
+    build();
+    for ( unsigned int c = 0; c < W_; ++c )
+    {
+        assert( matches( cells_[ 0 ], cells_[ c ] ) );
+        gather( c );
+    }
+}
+
+const vector< HSolveActive* >& HSolveBatch::getCells() const
+{
+    return cells_;
+}
+
+bool HSolveBatch::refresh()
+{
+    if ( W_ == 0 )
+        return true;
+
+    if ( cells_[ 0 ]->version_ != version_[ 0 ] )
+    {
+        // The first cell defines the structure, so check everyone.
+        for ( unsigned int c = 1; c < W_; ++c )
+            if ( !matches( cells_[ 0 ], cells_[ c ] ) )
+                return false;
+        setCells( cells_ );
+        return true;
+    }
+
+    for ( unsigned int c = 1; c < W_; ++c )
+    {
+        if ( cells_[ c ]->version_ == version_[ c ] )
+            continue;
+        if ( !matches( cells_[ 0 ], cells_[ c ] ) )
+            return false;
+        gather( c );
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Loading and unloading cells
+//////////////////////////////////////////////////////////////////////
+
+void HSolveBatch::build()
+{
+    const HSolveActive* h = cells_[ 0 ];
+    unsigned int W = W_;
+
+    nCompt_ = h->nCompt_;
+
+    junctionIndex_.resize( h->junction_.size() );
+    junctionRank_.resize( h->junction_.size() );
+    for ( unsigned int i = 0; i < h->junction_.size(); ++i )
+    {
+        junctionIndex_[ i ] = h->junction_[ i ].index;
+        junctionRank_[ i ] = h->junction_[ i ].rank;
+    }
+
+    chanStart_.resize( nCompt_ + 1 );
+    caStart_.resize( nCompt_ + 1 );
+    chanStart_[ 0 ] = caStart_[ 0 ] = 0;
+    unsigned int maxCa = 0;
+    for ( unsigned int ic = 0; ic < nCompt_; ++ic )
+    {
+        chanStart_[ ic + 1 ] = chanStart_[ ic ] + h->channelCount_[ ic ];
+        caStart_[ ic + 1 ] = caStart_[ ic ] + h->caCount_[ ic ];
+        maxCa = max( maxCa, h->caCount_[ ic ] );
+    }
+
+    unsigned int nChan = h->channel_.size();
+    Xpower_.resize( nChan );
+    Ypower_.resize( nChan );
+    Zpower_.resize( nChan );
+    instant_.resize( nChan );
+    for ( unsigned int i = 0; i < nChan; ++i )
+    {
+        Xpower_[ i ] = h->channel_[ i ].Xpower_;
+        Ypower_[ i ] = h->channel_[ i ].Ypower_;
+        Zpower_[ i ] = h->channel_[ i ].Zpower_;
+        instant_[ i ] = h->channel_[ i ].instant_;
+    }
+
+    column_.resize( h->column_.size() );
+    for ( unsigned int i = 0; i < column_.size(); ++i )
+        column_[ i ] = h->column_[ i ].column;
+    caRowIndex( h, caRow_ );
+
+    HS_.assign( h->HS_.size() * W, 0.0 );
+    HJ_.assign( h->HJ_.size() * W, 0.0 );
+    HJCopy_.assign( h->HJCopy_.size() * W, 0.0 );
+    V_.assign( nCompt_ * W, 0.0 );
+    VMid_.assign( nCompt_ * W, 0.0 );
+    CmByDt_.assign( nCompt_ * W, 0.0 );
+    EmByRm_.assign( nCompt_ * W, 0.0 );
+    state_.assign( h->state_.size() * W, 0.0 );
+    Gbar_.assign( nChan * W, 0.0 );
+    modulation_.assign( nChan * W, 0.0 );
+    Gk_.assign( nChan * W, 0.0 );
+    Ek_.assign( nChan * W, 0.0 );
+    ca_.assign( h->ca_.size() * W, 0.0 );
+    externalCalcium_.assign( h->externalCalcium_.size() * W, 0.0 );
+
+    vRow_.resize( W );
+    dRow_.resize( W );
+    caRowCompt_.resize( maxCa * W );
+    C1_.resize( W );
+    C2_.resize( W );
+    sum_.resize( W );
+    sum2_.resize( W );
+    pivot_.resize( W );
+
+    // Operands now point at lane 0 of the corresponding element here.
+    double* base[] = { HS_.data(), HJ_.data(), VMid_.data() };
+    vector< OperandRef > ref;
+    translate( h, h->operand_, ref );
+    operand_.resize( ref.size() );
+    for ( unsigned int i = 0; i < ref.size(); ++i )
+        operand_[ i ] = base[ ref[ i ].array ] + ref[ i ].offset * W;
+    translate( h, h->backOperand_, ref );
+    backOperand_.resize( ref.size() );
+    for ( unsigned int i = 0; i < ref.size(); ++i )
+        backOperand_[ i ] = base[ ref[ i ].array ] + ref[ i ].offset * W;
+}
+
+void HSolveBatch::gather( unsigned int c )
+{
+    HSolveActive* h = cells_[ c ];
+    unsigned int W = W_;
+
+    if ( h->current_.size() != h->channel_.size() )
+        h->current_.resize( h->channel_.size() );
+
+    for ( unsigned int i = 0; i < h->HS_.size(); ++i )
+        HS_[ i * W + c ] = h->HS_[ i ];
+    for ( unsigned int i = 0; i < h->HJCopy_.size(); ++i )
+        HJCopy_[ i * W + c ] = h->HJCopy_[ i ];
+    for ( unsigned int ic = 0; ic < nCompt_; ++ic )
+    {
+        V_[ ic * W + c ] = h->V_[ ic ];
+        VMid_[ ic * W + c ] = h->VMid_[ ic ];
+        CmByDt_[ ic * W + c ] = h->compartment_[ ic ].CmByDt;
+        EmByRm_[ ic * W + c ] = h->compartment_[ ic ].EmByRm;
+    }
+    for ( unsigned int i = 0; i < h->state_.size(); ++i )
+        state_[ i * W + c ] = h->state_[ i ];
+    for ( unsigned int i = 0; i < h->channel_.size(); ++i )
+    {
+        Gbar_[ i * W + c ] = h->channel_[ i ].Gbar_;
+        modulation_[ i * W + c ] = h->channel_[ i ].modulation_;
+        Gk_[ i * W + c ] = h->current_[ i ].Gk;
+        Ek_[ i * W + c ] = h->current_[ i ].Ek;
+    }
+
+    version_[ c ] = h->version_;
+}
+
+/**
+ * Hands the solved state back to each cell, for its calcium, messages
+ * and field access.
+ */
+void HSolveBatch::scatter()
+{
+    unsigned int W = W_;
+    for ( unsigned int c = 0; c < W; ++c )
+    {
+        HSolveActive* h = cells_[ c ];
+        for ( unsigned int ic = 0; ic < nCompt_; ++ic )
+        {
+            h->V_[ ic ] = V_[ ic * W + c ];
+            h->VMid_[ ic ] = VMid_[ ic * W + c ];
+        }
+        for ( unsigned int i = 0; i < h->state_.size(); ++i )
+            h->state_[ i ] = state_[ i * W + c ];
+        for ( unsigned int i = 0; i < h->current_.size(); ++i )
+            h->current_[ i ].Gk = Gk_[ i * W + c ];
+        h->stage_ = 2;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// Integration. These follow their namesakes in HSolveActive and
+// HSolvePassive step for step, with an inner loop over lanes.
+//////////////////////////////////////////////////////////////////////
+
+void HSolveBatch::step( ProcPtr info )
+{
+    advance( info );
+    for ( unsigned int c = 0; c < W_; ++c )
+        cells_[ c ]->sendOutputs( info );
+}
+
+void HSolveBatch::advance( ProcPtr info )
+{
+    if ( nCompt_ == 0 )
+        return;
+
+    unsigned int W = W_;
+    for ( unsigned int c = 0; c < W; ++c )
+    {
+        const HSolveActive* h = cells_[ c ];
+        for ( unsigned int i = 0; i < h->ca_.size(); ++i )
+            ca_[ i * W + c ] = h->ca_[ i ];
+        for ( unsigned int i = 0; i < h->externalCalcium_.size(); ++i )
+            externalCalcium_[ i * W + c ] = h->externalCalcium_[ i ];
+    }
+
+    advanceChannels( info->dt );
+    calculateChannelCurrents();
+    updateMatrix();
+    forwardEliminate();
+    backwardSubstitute();
+    scatter();
+
+    for ( unsigned int c = 0; c < W; ++c )
+        cells_[ c ]->finishStep( info );
+}
+
+void HSolveBatch::advanceChannels( double dt )
+{
+    unsigned int W = W_;
+    unsigned int ichan = 0;
+    unsigned int istate = 0;
+    unsigned int icolumn = 0;
+    unsigned int icarow = 0;
+    double* C1 = C1_.data();
+    double* C2 = C2_.data();
+
+    for ( unsigned int ic = 0; ic < nCompt_; ++ic )
+    {
+        for ( unsigned int c = 0; c < W; ++c )
+            cells_[ c ]->vTable_.row( V_[ ic * W + c ], vRow_[ c ] );
+
+        for ( unsigned int ica = caStart_[ ic ]; ica < caStart_[ ic + 1 ]; ++ica )
+        {
+            LookupRow* row = &caRowCompt_[ ( ica - caStart_[ ic ] ) * W ];
+            for ( unsigned int c = 0; c < W; ++c )
+                cells_[ c ]->caTable_.row( ca_[ ica * W + c ], row[ c ] );
+        }
+
+        for ( ; ichan < chanStart_[ ic + 1 ]; ++ichan )
+        {
+            double power[] = { Xpower_[ ichan ], Ypower_[ ichan ], Zpower_[ ichan ] };
+            int instant[] = { HSolveActive::INSTANT_X,
+                              HSolveActive::INSTANT_Y,
+                              HSolveActive::INSTANT_Z
+                            };
+
+            for ( unsigned int gate = 0; gate < 3; ++gate )
+            {
+                if ( power[ gate ] <= 0.0 )
+                    continue;
+
+                LookupColumn column;
+                column.column = column_[ icolumn ];
+
+                if ( gate < 2 )
+                {
+                    for ( unsigned int c = 0; c < W; ++c )
+                        cells_[ c ]->vTable_.lookup( column, vRow_[ c ], C1[ c ], C2[ c ] );
+                }
+                else
+                {
+                    int caRow = caRow_[ icarow ];
+                    for ( unsigned int c = 0; c < W; ++c )
+                    {
+                        HSolveActive* h = cells_[ c ];
+                        double extCa = externalCalcium_[ ichan * W + c ];
+                        if ( caRow >= 0 )
+                        {
+                            h->caTable_.lookup( column, caRowCompt_[ caRow * W + c ],
+                                                C1[ c ], C2[ c ] );
+                        }
+                        else if ( extCa > 0 )
+                        {
+                            h->caTable_.row( extCa, dRow_[ c ] );
+                            h->caTable_.lookup( column, dRow_[ c ], C1[ c ], C2[ c ] );
+                        }
+                        else
+                        {
+                            h->vTable_.lookup( column, vRow_[ c ], C1[ c ], C2[ c ] );
+                        }
+                    }
+                    ++icarow;
+                }
+
+                double* s = &state_[ istate * W ];
+                if ( instant_[ ichan ] & instant[ gate ] )
+                {
+                    for ( unsigned int c = 0; c < W; ++c )
+                        s[ c ] = C1[ c ] / C2[ c ];
+                }
+                else
+                {
+                    for ( unsigned int c = 0; c < W; ++c )
+                    {
+                        double temp = 1.0 + dt / 2.0 * C2[ c ];
+                        s[ c ] = ( s[ c ] * ( 2.0 - temp ) + dt * C1[ c ] ) / temp;
+                    }
+                }
+
+                ++icolumn, ++istate;
+            }
+        }
+    }
+}
+
+/**
+ * Multiplies f by x^p, lane by lane, in the same way as the PFDD
+ * functions chosen by ChannelStruct::selectPower.
+ */
+static void multiplyPower( double* f, const double* x, double p, unsigned int W )
+{
+    if ( p == 1.0 )
+    {
+        for ( unsigned int c = 0; c < W; ++c )
+            f[ c ] *= x[ c ];
+    }
+    else if ( p == 2.0 )
+    {
+        for ( unsigned int c = 0; c < W; ++c )
+            f[ c ] *= x[ c ] * x[ c ];
+    }
+    else if ( p == 3.0 )
+    {
+        for ( unsigned int c = 0; c < W; ++c )
+            f[ c ] *= x[ c ] * x[ c ] * x[ c ];
+    }
+    else if ( p == 4.0 )
+    {
+        for ( unsigned int c = 0; c < W; ++c )
+        {
+            double x2 = x[ c ] * x[ c ];
+            f[ c ] *= x2 * x2;
+        }
+    }
+    else
+    {
+        for ( unsigned int c = 0; c < W; ++c )
+            f[ c ] *= x[ c ] > 0.0 ? exp( p * log( x[ c ] ) ) : 0.0;
+    }
+}
+
+void HSolveBatch::calculateChannelCurrents()
+{
+    if ( state_.empty() )
+        return;
+
+    unsigned int W = W_;
+    const double* s = state_.data();
+    double* fraction = sum_.data();
+
+    for ( unsigned int ichan = 0; ichan < Xpower_.size(); ++ichan )
+    {
+        const double* mod = &modulation_[ ichan * W ];
+        for ( unsigned int c = 0; c < W; ++c )
+            fraction[ c ] = mod[ c ];
+
+        if ( Xpower_[ ichan ] > 0.0 )
+        {
+            multiplyPower( fraction, s, Xpower_[ ichan ], W );
+            s += W;
+        }
+        if ( Ypower_[ ichan ] > 0.0 )
+        {
+            multiplyPower( fraction, s, Ypower_[ ichan ], W );
+            s += W;
+        }
+        if ( Zpower_[ ichan ] > 0.0 )
+        {
+            multiplyPower( fraction, s, Zpower_[ ichan ], W );
+            s += W;
+        }
+
+        const double* gbar = &Gbar_[ ichan * W ];
+        double* gk = &Gk_[ ichan * W ];
+        for ( unsigned int c = 0; c < W; ++c )
+            gk[ c ] = gbar[ c ] * fraction[ c ];
+    }
+}
+
+void HSolveBatch::updateMatrix()
+{
+    unsigned int W = W_;
+    if ( !HJ_.empty() )
+        memcpy( HJ_.data(), HJCopy_.data(), sizeof( double ) * HJ_.size() );
+
+    double* GkSum = sum_.data();
+    double* GkEkSum = sum2_.data();
+    unsigned int ichan = 0;
+    for ( unsigned int ic = 0; ic < nCompt_; ++ic )
+    {
+        for ( unsigned int c = 0; c < W; ++c )
+            GkSum[ c ] = GkEkSum[ c ] = 0.0;
+
+        for ( ; ichan < chanStart_[ ic + 1 ]; ++ichan )
+        {
+            const double* gk = &Gk_[ ichan * W ];
+            const double* ek = &Ek_[ ichan * W ];
+            for ( unsigned int c = 0; c < W; ++c )
+            {
+                GkSum[ c ]   += gk[ c ];
+                GkEkSum[ c ] += gk[ c ] * ek[ c ];
+            }
+        }
+
+        double* hs = &HS_[ 4 * ic * W ];
+        const double* v = &V_[ ic * W ];
+        const double* cmByDt = &CmByDt_[ ic * W ];
+        const double* emByRm = &EmByRm_[ ic * W ];
+        for ( unsigned int c = 0; c < W; ++c )
+        {
+            hs[ c ] = hs[ 2 * W + c ] + GkSum[ c ];
+            hs[ 3 * W + c ] = v[ c ] * cmByDt[ c ] + emByRm[ c ] + GkEkSum[ c ];
+        }
+    }
+
+    // Injection and external channels are sparse and differ per cell.
+    for ( unsigned int c = 0; c < W; ++c )
+    {
+        HSolveActive* h = cells_[ c ];
+
+        map< unsigned int, InjectStruct >::iterator inject;
+        for ( inject = h->inject_.begin(); inject != h->inject_.end(); ++inject )
+        {
+            InjectStruct& value = inject->second;
+            HS_[ ( 4 * inject->first + 3 ) * W + c ] +=
+                value.injectVarying + value.injectBasal;
+            value.injectVarying = 0.0;
+        }
+
+        const vector< double >& ec = h->externalCurrent_;
+        for ( unsigned int i = 0; 2 * i < ec.size(); ++i )
+        {
+            HS_[ 4 * i * W + c ] += ec[ 2 * i ];
+            HS_[ ( 4 * i + 3 ) * W + c ] += ec[ 2 * i + 1 ];
+        }
+    }
+}
+
+void HSolveBatch::forwardEliminate()
+{
+    unsigned int W = W_;
+    unsigned int ic = 0;
+    unsigned int iop = 0;
+    double* pivot = pivot_.data();
+
+    for ( unsigned int ij = 0; ij < junctionIndex_.size(); ++ij )
+    {
+        unsigned int index = junctionIndex_[ ij ];
+        unsigned int rank = junctionRank_[ ij ];
+
+        for ( ; ic < index; ++ic )
+        {
+            double* hs = &HS_[ 4 * ic * W ];
+            for ( unsigned int c = 0; c < W; ++c )
+            {
+                hs[ 4 * W + c ] -= hs[ W + c ] / hs[ c ] * hs[ W + c ];
+                hs[ 7 * W + c ] -= hs[ W + c ] / hs[ c ] * hs[ 3 * W + c ];
+            }
+        }
+
+        double* hs = &HS_[ 4 * ic * W ];
+        for ( unsigned int c = 0; c < W; ++c )
+            pivot[ c ] = hs[ c ];
+
+        if ( rank == 1 )
+        {
+            double* j = operand_[ iop ];
+            double* s = operand_[ iop + 1 ];
+            for ( unsigned int c = 0; c < W; ++c )
+            {
+                double division = j[ W + c ] / pivot[ c ];
+                s[ c ]         -= division * j[ c ];
+                s[ 3 * W + c ] -= division * hs[ 3 * W + c ];
+            }
+
+            iop += 3;
+        }
+        else if ( rank == 2 )
+        {
+            double* j = operand_[ iop ];
+            double* s = operand_[ iop + 1 ];
+            for ( unsigned int c = 0; c < W; ++c )
+            {
+                double division = j[ W + c ] / pivot[ c ];
+                s[ c ]         -= division * j[ c ];
+                j[ 4 * W + c ] -= division * j[ 2 * W + c ];
+                s[ 3 * W + c ] -= division * hs[ 3 * W + c ];
+            }
+
+            s = operand_[ iop + 3 ];
+            for ( unsigned int c = 0; c < W; ++c )
+            {
+                double division = j[ 3 * W + c ] / pivot[ c ];
+                j[ 5 * W + c ] -= division * j[ c ];
+                s[ c ]         -= division * j[ 2 * W + c ];
+                s[ 3 * W + c ] -= division * hs[ 3 * W + c ];
+            }
+
+            iop += 5;
+        }
+        else
+        {
+            unsigned int end = iop + 3 * rank * ( rank + 1 );
+            for ( ; iop < end; iop += 3 )
+            {
+                double* a = operand_[ iop ];
+                const double* b = operand_[ iop + 1 ];
+                const double* d = operand_[ iop + 2 ];
+                for ( unsigned int c = 0; c < W; ++c )
+                    a[ c ] -= d[ c ] / pivot[ c ] * b[ c ];
+            }
+        }
+
+        ++ic;
+    }
+
+    for ( ; ic + 1 < nCompt_; ++ic )
+    {
+        double* hs = &HS_[ 4 * ic * W ];
+        for ( unsigned int c = 0; c < W; ++c )
+        {
+            hs[ 4 * W + c ] -= hs[ W + c ] / hs[ c ] * hs[ W + c ];
+            hs[ 7 * W + c ] -= hs[ W + c ] / hs[ c ] * hs[ 3 * W + c ];
+        }
+    }
+}
+
+void HSolveBatch::backwardSubstitute()
+{
+    unsigned int W = W_;
+    int ic = nCompt_ - 1;
+    long iop = static_cast< long >( operand_.size() ) - 1;
+    long ibop = static_cast< long >( backOperand_.size() ) - 1;
+
+    // Operands are walked from the end, as in the scalar code.
+    double* hs = &HS_[ 4 * ic * W ];
+    double* vmid = &VMid_[ ic * W ];
+    double* v = &V_[ ic * W ];
+    for ( unsigned int c = 0; c < W; ++c )
+    {
+        vmid[ c ] = hs[ 3 * W + c ] / hs[ c ];
+        v[ c ] = 2 * vmid[ c ] - v[ c ];
+    }
+    --ic;
+
+    for ( long ij = static_cast< long >( junctionIndex_.size() ) - 1; ij >= 0; --ij )
+    {
+        int index = junctionIndex_[ ij ];
+        int rank = junctionRank_[ ij ];
+
+        for ( ; ic > index; --ic )
+        {
+            hs = &HS_[ 4 * ic * W ];
+            vmid = &VMid_[ ic * W ];
+            v = &V_[ ic * W ];
+            for ( unsigned int c = 0; c < W; ++c )
+            {
+                vmid[ c ] = ( hs[ 3 * W + c ] - hs[ W + c ] * vmid[ W + c ] ) / hs[ c ];
+                v[ c ] = 2 * vmid[ c ] - v[ c ];
+            }
+        }
+
+        hs = &HS_[ 4 * ic * W ];
+        vmid = &VMid_[ ic * W ];
+        v = &V_[ ic * W ];
+        if ( rank == 1 )
+        {
+            const double* a = operand_[ iop ];
+            const double* b = operand_[ iop - 2 ];
+            for ( unsigned int c = 0; c < W; ++c )
+                vmid[ c ] = ( hs[ 3 * W + c ] - a[ c ] * b[ c ] ) / hs[ c ];
+
+            iop -= 3;
+        }
+        else if ( rank == 2 )
+        {
+            const double* v0 = operand_[ iop ];
+            const double* v1 = operand_[ iop - 2 ];
+            const double* j  = operand_[ iop - 4 ];
+            for ( unsigned int c = 0; c < W; ++c )
+                vmid[ c ] = ( hs[ 3 * W + c ]
+                              - v0[ c ] * j[ 2 * W + c ]
+                              - v1[ c ] * j[ c ]
+                            ) / hs[ c ];
+
+            iop -= 5;
+        }
+        else
+        {
+            for ( unsigned int c = 0; c < W; ++c )
+                vmid[ c ] = hs[ 3 * W + c ];
+            for ( int i = 0; i < rank; ++i )
+            {
+                const double* a = backOperand_[ ibop ];
+                const double* b = backOperand_[ ibop - 1 ];
+                for ( unsigned int c = 0; c < W; ++c )
+                    vmid[ c ] -= a[ c ] * b[ c ];
+                ibop -= 2;
+            }
+            for ( unsigned int c = 0; c < W; ++c )
+                vmid[ c ] /= hs[ c ];
+
+            iop -= 3 * rank * ( rank + 1 );
+        }
+
+        for ( unsigned int c = 0; c < W; ++c )
+            v[ c ] = 2 * vmid[ c ] - v[ c ];
+        --ic;
+    }
+
+    for ( ; ic >= 0; --ic )
+    {
+        hs = &HS_[ 4 * ic * W ];
+        vmid = &VMid_[ ic * W ];
+        v = &V_[ ic * W ];
+        for ( unsigned int c = 0; c < W; ++c )
+        {
+            vmid[ c ] = ( hs[ 3 * W + c ] - hs[ W + c ] * vmid[ W + c ] ) / hs[ c ];
+            v[ c ] = 2 * vmid[ c ] - v[ c ];
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _HSOLVE_BATCH_H
+#define _HSOLVE_BATCH_H
+
+class HSolveActive;
+
+/**
+ * Advances a group of structurally identical cells together.
+ *
+ * Every cell keeps its own HSolve, but the per-step state of the whole
+ * group is held here in structure-of-arrays form: element e of an array
+ * for cell c lives at [ e * W + c ], where W is the number of cells
+ * (lanes). The channel update, current summation, matrix update and the
+ * Hines elimination then run once over the tree, with an inner loop
+ * over lanes that the compiler can vectorize.
+ *
+ * Calcium, synapses and outgoing messages stay with each cell, and run
+ * once the voltages have been solved. Parameters set on a cell are
+ * picked up by comparing its version counter before each step.
+ */
+class HSolveBatch
+{
+public:
+    HSolveBatch();
+
+    /// True if the two cells have the same tree, channels and gates.
+    static bool matches( const HSolveActive* a, const HSolveActive* b );
+
+    /// Takes over the given cells, all of which must match the first.
+    void setCells( const vector< HSolveActive* >& cells );
+    const vector< HSolveActive* >& getCells() const;
+
+    /**
+     * Reloads any cell whose parameters have changed since the last
+     * step. Returns false if a cell no longer matches the batch, in
+     * which case the batch must be rebuilt before stepping.
+     */
+    bool refresh();
+
+    /// Advances all cells by one time-step.
+    void step( ProcPtr info );
+
+    /**
+     * Advances all cells but leaves their outgoing messages to the
+     * caller, as HSolveActive::advance does.
+     */
+    void advance( ProcPtr info );
+
+private:
+    /// An operand as (array, offset) so it can be compared across cells.
+    struct OperandRef
+    {
+        unsigned int array;		///< 0: HS_, 1: HJ_, 2: VMid_
+        unsigned int offset;
+        bool operator==( const OperandRef& other ) const
+        {
+            return array == other.array && offset == other.offset;
+        }
+    };
+
+    static void translate( const HSolveActive* h,
+                           const vector< vector< double >::iterator >& op,
+                           vector< OperandRef >& ret );
+    static void caRowIndex( const HSolveActive* h, vector< int >& ret );
+
+    void build();
+    void gather( unsigned int lane );
+
+    void advanceChannels( double dt );
+    void calculateChannelCurrents();
+    void updateMatrix();
+    void forwardEliminate();
+    void backwardSubstitute();
+    void scatter();
+
+    vector< HSolveActive* >   cells_;
+    vector< unsigned long >   version_;		///< Last seen, for each cell
+    unsigned int              W_;			///< Number of lanes
+
+    /**
+     * Structure, taken from the first cell.
+     */
+    unsigned int              nCompt_;
+    vector< unsigned int >    junctionIndex_;
+    vector< unsigned int >    junctionRank_;
+    vector< double* >         operand_;		///< Lane 0 addresses
+    vector< double* >         backOperand_;
+    vector< unsigned int >    chanStart_;	///< First channel of each compt
+    vector< unsigned int >    caStart_;		///< First Ca pool of each compt
+    vector< double >          Xpower_;
+    vector< double >          Ypower_;
+    vector< double >          Zpower_;
+    vector< int >             instant_;
+    vector< unsigned int >    column_;
+    vector< int >             caRow_;		///< For each Z gate, Ca pool
+    ///< within its compt, or -1
+
+    /**
+     * State, one lane per cell.
+     */
+    vector< double >          HS_;
+    vector< double >          HJ_;
+    vector< double >          HJCopy_;
+    vector< double >          V_;
+    vector< double >          VMid_;
+    vector< double >          CmByDt_;
+    vector< double >          EmByRm_;
+    vector< double >          state_;
+    vector< double >          Gbar_;
+    vector< double >          modulation_;
+    vector< double >          Gk_;
+    vector< double >          Ek_;
+    vector< double >          ca_;
+    vector< double >          externalCalcium_;
+
+    /**
+     * Per-lane scratch space.
+     */
+    vector< LookupRow >       vRow_;
+    vector< LookupRow >       dRow_;
+    vector< LookupRow >       caRowCompt_;
+    vector< double >          C1_;
+    vector< double >          C2_;
+    vector< double >          sum_;
+    vector< double >          sum2_;
+    vector< double >          pivot_;
+};
+
+#endif // _HSOLVE_BATCH_H
@@ -74,6 +74,7 @@ double HSolve::getVm( Id id ) const
 void HSolve::setVm( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < V_.size() );
     V_[ index ] = value;
 }
@@ -88,6 +89,7 @@ double HSolve::getCm( Id id ) const
 void HSolve::setCm( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < tree_.size() );
     tree_[ index ].Cm = value;
     // Also update data structures used for calculations.
@@ -105,6 +107,7 @@ double HSolve::getEm( Id id ) const
 void HSolve::setEm( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < tree_.size() );
     tree_[ index ].Em = value;
     // Also update data structures used for calculations.
@@ -122,6 +125,7 @@ double HSolve::getRm( Id id ) const
 void HSolve::setRm( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < tree_.size() );
     tree_[ index ].Rm = value;
     // Also update data structures used for calculations.
@@ -266,6 +270,7 @@ void HSolve::setPowers(
     double Zpower )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < channel_.size() );
     channel_[ index ].setPowers( Xpower, Ypower, Zpower );
 }
@@ -280,6 +285,7 @@ int HSolve::getInstant( Id id ) const
 void HSolve::setInstant( Id id, int instant )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < channel_.size() );
     channel_[ index ].instant_ = instant;
 }
@@ -294,6 +300,7 @@ double HSolve::getHHChannelGbar( Id id ) const
 void HSolve::setHHChannelGbar( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < channel_.size() );
     channel_[ index ].Gbar_ = value;
 
@@ -309,6 +316,7 @@ double HSolve::getEk( Id id ) const
 void HSolve::setEk( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < current_.size() );
     current_[ index ].Ek = value;
 }
@@ -355,6 +363,7 @@ double HSolve::getX( Id id ) const
 void HSolve::setX( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < channel_.size() );
 
     if ( channel_[ index ].Xpower_ == 0.0 )
@@ -387,6 +396,7 @@ double HSolve::getY( Id id ) const
 void HSolve::setY( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < channel_.size() );
 
     if ( channel_[ index ].Ypower_ == 0.0 )
@@ -425,6 +435,7 @@ double HSolve::getZ( Id id ) const
 void HSolve::setZ( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < channel_.size() );
 
     if ( channel_[ index ].Zpower_ == 0.0 )
@@ -445,6 +456,7 @@ void HSolve::setZ( Id id, double value )
 void HSolve::setHHmodulation( Id id, double value )
 {
     unsigned int index = localIndex( id );
+    ++version_;
     assert( index < channel_.size() );
 	if ( value > 0.0 )
 			channel_[index].modulation_ = value;
@@ -0,0 +1,483 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "../basecode/global.h"
+#include "HSolveStruct.h"
+#include "HinesMatrix.h"
+#include "HSolvePassive.h"
+#include "RateLookup.h"
+#include "HSolveActive.h"
+#include "HSolve.h"
+#include "HSolveBatch.h"
+#include "HSolvePop.h"
+#include "../shell/Wildcard.h"
+#include "../scheduling/ThreadPool.h"
+
+const Cinfo* HSolvePop::initCinfo()
+{
+    static DestFinfo process(
+        "process",
+        "Handles 'process' call: Advances all cells by one time-step.",
+        new ProcOpFunc< HSolvePop >( &HSolvePop::process )
+    );
+
+    static DestFinfo reinit(
+        "reinit",
+        "Handles 'reinit' call: Takes over the HSolves on the path and "
+        "groups them.",
+        new ProcOpFunc< HSolvePop >( &HSolvePop::reinit )
+    );
+
+    static Finfo* processShared[] =
+    {
+        &process,
+        &reinit
+    };
+
+    static SharedFinfo proc(
+        "proc",
+        "Handles 'reinit' and 'process' calls from a clock.",
+        processShared,
+        sizeof( processShared ) / sizeof( Finfo* )
+    );
+
+    static ValueFinfo< HSolvePop, string > path(
+        "path",
+        "Wildcard path to the HSolves to be stepped together, for example "
+        "/model/cell#/hsolve. Each HSolve must already have its target "
+        "set. The HSolvePop should be on the same clock tick as the "
+        "HSolves. Takes effect at the next reinit.",
+        &HSolvePop::setPath,
+        &HSolvePop::getPath
+    );
+
+    static ValueFinfo< HSolvePop, unsigned int > numThreads(
+        "numThreads",
+        "Number of threads used to advance the cells. Batches and single "
+        "cells are advanced in parallel, after which their messages are "
+        "sent out serially, in path order. With more than one thread, "
+        "groups of identical cells are split into one batch per thread. "
+        "Takes effect at the next reinit. Default 1.",
+        &HSolvePop::setNumThreads,
+        &HSolvePop::getNumThreads
+    );
+
+    static ReadOnlyValueFinfo< HSolvePop, unsigned int > numCells(
+        "numCells",
+        "Number of HSolves taken over at the last reinit.",
+        &HSolvePop::getNumCells
+    );
+
+    static ReadOnlyValueFinfo< HSolvePop, unsigned int > numGroups(
+        "numGroups",
+        "Number of batches of identical cells. With several threads a "
+        "group of identical cells is split into one batch per thread.",
+        &HSolvePop::getNumGroups
+    );
+
+    static ReadOnlyValueFinfo< HSolvePop, unsigned int > numBatched(
+        "numBatched",
+        "Number of cells that are stepped as part of a batch. The rest "
+        "have no structural twin and are stepped one at a time.",
+        &HSolvePop::getNumBatched
+    );
+
+    static Finfo* hsolvePopFinfos[] =
+    {
+        &path,              // Value
+        &numThreads,        // Value
+        &numCells,          // ReadOnlyValue
+        &numGroups,         // ReadOnlyValue
+        &numBatched,        // ReadOnlyValue
+        &proc,              // Shared
+    };
+
+    static string doc[] =
+    {
+        "Name",             "HSolvePop",
+        "Description",      "HSolvePop: Steps a population of HSolves. "
+        "Cells with the same compartment tree, channels and gates are "
+        "advanced together, with the per-cell arithmetic laid out so "
+        "that it vectorizes across cells. Results are the same as "
+        "stepping each HSolve on its own.",
+    };
+
+    static Dinfo< HSolvePop > dinfo;
+    static Cinfo hsolvePopCinfo(
+        "HSolvePop",
+        Neutral::initCinfo(),
+        hsolvePopFinfos,
+        sizeof( hsolvePopFinfos ) / sizeof( Finfo* ),
+        &dinfo,
+        doc,
+        sizeof( doc ) / sizeof( string )
+    );
+
+    return &hsolvePopCinfo;
+}
+
+static const Cinfo* hsolvePopCinfo = HSolvePop::initCinfo();
+
+HSolvePop::HSolvePop()
+    : numThreads_( 1 )
+{
+    ;
+}
+
+/**
+ * Copies get the settings only: the cells belong to the original.
+ */
+HSolvePop::HSolvePop( const HSolvePop& other )
+    :
+    path_( other.path_ ),
+    numThreads_( other.numThreads_ )
+{
+    ;
+}
+
+HSolvePop& HSolvePop::operator=( const HSolvePop& other )
+{
+    if ( this != &other )
+    {
+        release();
+        path_ = other.path_;
+        numThreads_ = other.numThreads_;
+    }
+    return *this;
+}
+
+HSolvePop::~HSolvePop()
+{
+    release();
+}
+
+///////////////////////////////////////////////////
+// Field definitions
+///////////////////////////////////////////////////
+
+void HSolvePop::setPath( string path )
+{
+    path_ = path;
+}
+
+string HSolvePop::getPath() const
+{
+    return path_;
+}
+
+void HSolvePop::setNumThreads( unsigned int v )
+{
+    numThreads_ = ( v == 0 ) ? 1 : v;
+}
+
+unsigned int HSolvePop::getNumThreads() const
+{
+    return numThreads_;
+}
+
+unsigned int HSolvePop::getNumCells() const
+{
+    return cell_.size();
+}
+
+unsigned int HSolvePop::getNumGroups() const
+{
+    return batch_.size();
+}
+
+unsigned int HSolvePop::getNumBatched() const
+{
+    return cell_.size() - single_.size();
+}
+
+///////////////////////////////////////////////////
+// Dest function definitions
+///////////////////////////////////////////////////
+
+void HSolvePop::reinit( const Eref& e, ProcPtr p )
+{
+    release();
+    self_ = e.id();
+
+    vector< ObjId > found;
+    wildcardFind( path_, found );
+    for ( vector< ObjId >::iterator i = found.begin(); i != found.end(); ++i )
+    {
+        if ( !i->element()->cinfo()->isA( "HSolve" ) )
+            continue;
+
+        HSolve* hsolve = reinterpret_cast< HSolve* >( i->data() );
+        if ( hsolve->getPopulation() != Id() )
+        {
+            cerr << "Warning: HSolvePop::reinit: '" << i->path()
+                 << "' is already stepped by '"
+                 << hsolve->getPopulation().path() << "'. Skipping.\n";
+            continue;
+        }
+        hsolve->setPopulation( self_ );
+        cellId_.push_back( *i );
+        cell_.push_back( hsolve );
+    }
+
+    if ( numThreads_ > 1 )
+    {
+        if ( !pool_ || pool_->numThreads() != numThreads_ )
+            pool_ = make_shared< moose::ThreadPool >( numThreads_ );
+    }
+    else
+        pool_.reset();
+
+    regroup();
+}
+
+void HSolvePop::process( const Eref& e, ProcPtr p )
+{
+    high_resolution_clock::time_point t0 = high_resolution_clock::now();
+
+    prune();
+
+    bool ok = true;
+    for ( unsigned int i = 0; i < batch_.size(); ++i )
+        ok &= batch_[ i ]->refresh();
+    if ( !ok )
+        regroup();
+
+    size_t numBatches = batch_.size();
+    auto task = [this, numBatches, p]( size_t i )
+    {
+        if ( i < numBatches )
+            batch_[ i ]->advance( p );
+        else
+            single_[ i - numBatches ]->advance( p );
+    };
+    size_t numTasks = numBatches + single_.size();
+    if ( pool_ && numTasks > 1 )
+        pool_->parallelFor( numTasks, task );
+    else
+        for ( size_t i = 0; i < numTasks; ++i )
+            task( i );
+
+    for ( unsigned int i = 0; i < cell_.size(); ++i )
+        cell_[ i ]->sendOutputs( p );
+
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    addSolverProf( "HSolvePop",
+                   duration_cast< duration< double > >( t1 - t0 ).count(), 1 );
+}
+
+///////////////////////////////////////////////////
+// Grouping
+///////////////////////////////////////////////////
+
+void HSolvePop::release()
+{
+    for ( unsigned int i = 0; i < cellId_.size(); ++i )
+        if ( cellId_[ i ].element() && cell_[ i ]->getPopulation() == self_ )
+            cell_[ i ]->setPopulation( Id() );
+
+    cellId_.clear();
+    cell_.clear();
+    batch_.clear();
+    single_.clear();
+}
+
+void HSolvePop::prune()
+{
+    unsigned int live = 0;
+    for ( unsigned int i = 0; i < cellId_.size(); ++i )
+    {
+        if ( cellId_[ i ].element() )
+        {
+            cellId_[ live ] = cellId_[ i ];
+            cell_[ live ] = cell_[ i ];
+            ++live;
+        }
+    }
+
+    if ( live < cellId_.size() )
+    {
+        cellId_.resize( live );
+        cell_.resize( live );
+        regroup();
+    }
+}
+
+void HSolvePop::regroup()
+{
+    batch_.clear();
+    single_.clear();
+
+    vector< vector< HSolveActive* > > group;
+    for ( unsigned int i = 0; i < cell_.size(); ++i )
+    {
+        unsigned int g = 0;
+        for ( ; g < group.size(); ++g )
+            if ( HSolveBatch::matches( group[ g ][ 0 ], cell_[ i ] ) )
+                break;
+        if ( g == group.size() )
+            group.resize( g + 1 );
+        group[ g ].push_back( cell_[ i ] );
+    }
+
+    // With threads, split each group so every thread gets a share.
+    for ( unsigned int g = 0; g < group.size(); ++g )
+    {
+        unsigned int size = group[ g ].size();
+        unsigned int width = ( size + numThreads_ - 1 ) / numThreads_;
+        for ( unsigned int start = 0; start < size; start += width )
+        {
+            unsigned int end = min( size, start + width );
+            if ( end - start == 1 )
+            {
+                single_.push_back(
+                    static_cast< HSolve* >( group[ g ][ start ] ) );
+                continue;
+            }
+            shared_ptr< HSolveBatch > batch = make_shared< HSolveBatch >();
+            batch->setCells( vector< HSolveActive* >(
+                                 group[ g ].begin() + start,
+                                 group[ g ].begin() + end ) );
+            batch_.push_back( batch );
+        }
+    }
+}
+
+///////////////////////////////////////////////////
+
+#ifdef DO_UNIT_TESTS
+
+#include "../shell/Shell.h"
+
+/**
+ * Builds a cell with a soma, nBranch dendrites hanging off it, and a
+ * potassium-like channel on the soma.
+ */
+static void makePopCell( Shell* shell, Id parent, const string& name,
+                         unsigned int nBranch, double inject )
+{
+    Id cell = shell->doCreate( "Neutral", parent, name, 1 );
+    Id soma = shell->doCreate( "Compartment", cell, "soma", 1 );
+    Field< double >::set( soma, "Rm", 1.0e9 );
+    Field< double >::set( soma, "Cm", 1.0e-11 );
+    Field< double >::set( soma, "Ra", 1.0e7 );
+    Field< double >::set( soma, "Em", -0.065 );
+    Field< double >::set( soma, "initVm", -0.065 );
+    Field< double >::set( soma, "inject", inject );
+
+    for ( unsigned int i = 0; i < nBranch; ++i )
+    {
+        Id prev = soma;
+        for ( unsigned int j = 0; j < 2; ++j )
+        {
+            stringstream ss;
+            ss << "d" << i << "_" << j;
+            Id dend = shell->doCreate( "Compartment", cell, ss.str(), 1 );
+            Field< double >::set( dend, "Rm", 5.0e9 );
+            Field< double >::set( dend, "Cm", 2.0e-12 );
+            Field< double >::set( dend, "Ra", 5.0e7 * ( i + 1 ) );
+            Field< double >::set( dend, "Em", -0.065 );
+            Field< double >::set( dend, "initVm", -0.065 );
+            shell->doAddMsg( "Single", prev, "axial", dend, "raxial" );
+            prev = dend;
+        }
+    }
+
+    Id chan = shell->doCreate( "HHChannel", soma, "K", 1 );
+    Field< double >::set( chan, "Gbar", 1.0e-9 );
+    Field< double >::set( chan, "Ek", -0.08 );
+    Field< double >::set( chan, "Xpower", 4.0 );
+    shell->doAddMsg( "Single", soma, "channel", chan, "channel" );
+
+    Id gate( chan.path() + "/gateX" );
+    assert( gate != Id() );
+    vector< double > A( 151 ), B( 151 );
+    for ( unsigned int i = 0; i < A.size(); ++i )
+    {
+        double v = -0.1 + i * 0.001;
+        double alpha = 100.0 * exp( ( v + 0.05 ) / 0.02 );
+        double beta = 200.0 * exp( -( v + 0.05 ) / 0.02 );
+        A[ i ] = alpha;
+        B[ i ] = alpha + beta;
+    }
+    Field< double >::set( gate, "min", -0.1 );
+    Field< double >::set( gate, "max", 0.05 );
+    Field< vector< double > >::set( gate, "tableA", A );
+    Field< vector< double > >::set( gate, "tableB", B );
+
+    Id hsolve = shell->doCreate( "HSolve", cell, "hsolve", 1 );
+    Field< double >::set( hsolve, "dt", 50e-6 );
+    Field< string >::set( hsolve, "target", soma.path() );
+}
+
+static void recordPopVm( Id root, vector< double >& ret )
+{
+    vector< ObjId > compts;
+    wildcardFind( root.path() + "/#/#[ISA=CompartmentBase]", compts );
+    ret.clear();
+    for ( unsigned int i = 0; i < compts.size(); ++i )
+        ret.push_back( Field< double >::get( compts[ i ], "Vm" ) );
+}
+
+void testHSolvePop()
+{
+    Shell* shell = reinterpret_cast< Shell* >( Id().eref().data() );
+    Id root = shell->doCreate( "Neutral", Id(), "pop", 1 );
+
+    // Three identical cells with different inputs, and one odd one out.
+    makePopCell( shell, root, "a0", 3, 1.0e-10 );
+    makePopCell( shell, root, "a1", 3, 2.0e-10 );
+    makePopCell( shell, root, "a2", 3, 0.0 );
+    makePopCell( shell, root, "b0", 1, 1.0e-10 );
+
+    shell->doSetClock( 6, 50e-6 );
+    shell->doReinit();
+    shell->doStart( 0.02 );
+    vector< double > ref;
+    recordPopVm( root, ref );
+    assert( ref.size() == 3 * 7 + 3 );
+
+    Id pop = shell->doCreate( "HSolvePop", root, "hsolvePop", 1 );
+    Field< string >::set( pop, "path", root.path() + "/#/hsolve" );
+    shell->doReinit();
+    assert( Field< unsigned int >::get( pop, "numCells" ) == 4 );
+    assert( Field< unsigned int >::get( pop, "numGroups" ) == 1 );
+    assert( Field< unsigned int >::get( pop, "numBatched" ) == 3 );
+    shell->doStart( 0.02 );
+    vector< double > vm;
+    recordPopVm( root, vm );
+    assert( vm.size() == ref.size() );
+    for ( unsigned int i = 0; i < vm.size(); ++i )
+        assert( fabs( vm[ i ] - ref[ i ] ) < 1.0e-12 );
+    // The inputs differ, so the batched cells must not all agree.
+    assert( fabs( vm[ 0 ] - vm[ 7 ] ) > 1.0e-4 );
+
+    // Two threads: one batch of two, and the other two cells singly.
+    Field< unsigned int >::set( pop, "numThreads", 2 );
+    shell->doReinit();
+    assert( Field< unsigned int >::get( pop, "numGroups" ) == 1 );
+    assert( Field< unsigned int >::get( pop, "numBatched" ) == 2 );
+    shell->doStart( 0.02 );
+    recordPopVm( root, vm );
+    for ( unsigned int i = 0; i < vm.size(); ++i )
+        assert( fabs( vm[ i ] - ref[ i ] ) < 1.0e-12 );
+
+    // Deleting the population hands the cells back to their HSolves.
+    shell->doDelete( pop );
+    shell->doReinit();
+    shell->doStart( 0.02 );
+    recordPopVm( root, vm );
+    for ( unsigned int i = 0; i < vm.size(); ++i )
+        assert( fabs( vm[ i ] - ref[ i ] ) < 1.0e-12 );
+
+    shell->doDelete( root );
+    cout << "." << flush;
+}
+
+#endif // DO_UNIT_TESTS
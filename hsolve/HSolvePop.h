@@ -0,0 +1,79 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _HSOLVE_POP_H
+#define _HSOLVE_POP_H
+
+#include <memory>
+
+class HSolve;
+class HSolveBatch;
+namespace moose
+{
+    class ThreadPool;
+}
+
+/**
+ * Steps a population of HSolves. At reinit it takes over every HSolve
+ * on its path, sorts them into groups of structurally identical cells,
+ * and from then on advances each group of two or more as one
+ * HSolveBatch. Cells that have no twin are stepped one by one as
+ * before. Deleting the HSolvePop hands the cells back.
+ *
+ * With numThreads > 1 the batches and single cells are advanced in
+ * parallel, and their outgoing messages are then sent serially in the
+ * order of the path, so message traffic is the same as without threads.
+ */
+class HSolvePop
+{
+public:
+    HSolvePop();
+    HSolvePop( const HSolvePop& other );
+    HSolvePop& operator=( const HSolvePop& other );
+    ~HSolvePop();
+
+    void process( const Eref& e, ProcPtr p );
+    void reinit( const Eref& e, ProcPtr p );
+
+    void setPath( string path );
+    string getPath() const;
+    void setNumThreads( unsigned int v );
+    unsigned int getNumThreads() const;
+    unsigned int getNumCells() const;
+    unsigned int getNumGroups() const;
+    unsigned int getNumBatched() const;
+
+    static const Cinfo* initCinfo();
+
+private:
+    /// Hands all cells back to their own HSolves.
+    void release();
+
+    /// Drops cells whose HSolve has been deleted.
+    void prune();
+
+    /// Sorts the cells into batches and singles.
+    void regroup();
+
+    string path_;
+    unsigned int numThreads_;
+    Id self_;
+    vector< ObjId > cellId_;
+    vector< HSolve* > cell_;
+    vector< shared_ptr< HSolveBatch > > batch_;
+    vector< HSolve* > single_;	///< Cells without a twin.
+
+    /**
+     * Built at reinit when numThreads_ > 1. Shared rather than unique
+     * only because Dinfo needs HSolvePop to be copyable.
+     */
+    shared_ptr< moose::ThreadPool > pool_;
+};
+
+#endif // _HSOLVE_POP_H
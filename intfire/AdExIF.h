@@ -52,6 +52,8 @@ class AdExIF: public ExIF
             double tauW_;
             double a0_;
             double b0_;
+
+            friend class IntFirePop;
 };
 }
 
@@ -52,6 +52,8 @@ class AdThreshIF: public IntFireBase
             double tauThresh_;
             double a0_;
             double threshJump_;
+
+            friend class IntFirePop;
 };
 }
 
@@ -46,6 +46,8 @@ class ExIF: public IntFireBase
     protected: // needed in AdExIF
             double deltaThresh_;
             double vPeak_;
+
+            friend class IntFirePop;
 };
 }
 
@@ -64,6 +64,8 @@ protected:
     double refractT_;
     double lastEvent_;
     bool fired_;
+
+    friend class IntFirePop;
 };
 } // namespace
 
@@ -0,0 +1,688 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include <chrono>
+#include "../basecode/header.h"
+#include "../basecode/global.h"
+#include "../biophysics/CompartmentBase.h"
+#include "../biophysics/Compartment.h"
+#include "IntFireBase.h"
+#include "LIF.h"
+#include "QIF.h"
+#include "ExIF.h"
+#include "AdExIF.h"
+#include "AdThreshIF.h"
+#include "IzhIF.h"
+#include "IntFirePop.h"
+#include "../shell/Wildcard.h"
+
+using namespace moose;
+using namespace std::chrono;
+
+SrcFinfo1< vector< unsigned int > >* IntFirePop::spikesOut()
+{
+    static SrcFinfo1< vector< unsigned int > > spikesOut(
+        "spikesOut",
+        "Sends the indices, into the neurons field, of the neurons that "
+        "fired in this step. Only sent on steps with at least one spike."
+    );
+    return &spikesOut;
+}
+
+const Cinfo* IntFirePop::initCinfo()
+{
+    static DestFinfo process(
+        "process",
+        "Handles 'process' call: Advances all neurons by one time-step.",
+        new ProcOpFunc< IntFirePop >( &IntFirePop::process )
+    );
+
+    static DestFinfo reinit(
+        "reinit",
+        "Handles 'reinit' call: Takes over the neurons on the path and "
+        "reinitializes them.",
+        new ProcOpFunc< IntFirePop >( &IntFirePop::reinit )
+    );
+
+    static Finfo* processShared[] =
+    {
+        &process,
+        &reinit
+    };
+
+    static SharedFinfo proc(
+        "proc",
+        "Handles 'reinit' and 'process' calls from a clock.",
+        processShared,
+        sizeof( processShared ) / sizeof( Finfo* )
+    );
+
+    static ValueFinfo< IntFirePop, string > path(
+        "path",
+        "Wildcard path to the neuron arrays to be stepped together, for "
+        "example /network/#[ISA=IntFireBase]. Whole elements are taken "
+        "over, with all their entries. The IntFirePop should be on the "
+        "same clock tick as the neurons. Takes effect at the next reinit.",
+        &IntFirePop::setPath,
+        &IntFirePop::getPath
+    );
+
+    static ReadOnlyValueFinfo< IntFirePop, unsigned int > numNeurons(
+        "numNeurons",
+        "Number of neurons taken over at the last reinit.",
+        &IntFirePop::getNumNeurons
+    );
+
+    static ReadOnlyValueFinfo< IntFirePop, vector< ObjId > > neurons(
+        "neurons",
+        "The neurons taken over at the last reinit, in the order used by "
+        "spikes and spikesOut.",
+        &IntFirePop::getNeurons
+    );
+
+    static ReadOnlyValueFinfo< IntFirePop, vector< unsigned int > > spikes(
+        "spikes",
+        "Indices, into the neurons field, of the neurons that fired in the "
+        "last step.",
+        &IntFirePop::getSpikes
+    );
+
+    static DestFinfo activation(
+        "activation",
+        "Handles synaptic activation for all the neurons at once, indexed "
+        "as the neurons field, for example from the activationOut of a "
+        "SpikeDelivery. Each entry is added to the activation of its neuron, "
+        "as the neuron's own activation message would.",
+        new OpFunc1< IntFirePop, vector< double > >( &IntFirePop::activation )
+    );
+
+    static Finfo* intFirePopFinfos[] =
+    {
+        &path,              // Value
+        &numNeurons,        // ReadOnlyValue
+        &neurons,           // ReadOnlyValue
+        &spikes,            // ReadOnlyValue
+        &activation,        // DestFinfo
+        spikesOut(),        // SrcFinfo
+        &proc,              // Shared
+    };
+
+    static string doc[] =
+    {
+        "Name",             "IntFirePop",
+        "Description",      "IntFirePop: Steps arrays of LIF, QIF, ExIF, "
+        "AdExIF, AdThreshIF and IzhIF neurons as one population, with the "
+        "state of each array held in structure-of-arrays form during the "
+        "update. This avoids a virtual process call and a VmOut message "
+        "per neuron per step. Results are the same as stepping each neuron "
+        "on its own. Parameters are read at reinit.",
+    };
+
+    static Dinfo< IntFirePop > dinfo;
+    static Cinfo intFirePopCinfo(
+        "IntFirePop",
+        Neutral::initCinfo(),
+        intFirePopFinfos,
+        sizeof( intFirePopFinfos ) / sizeof( Finfo* ),
+        &dinfo,
+        doc,
+        sizeof( doc ) / sizeof( string )
+    );
+
+    return &intFirePopCinfo;
+}
+
+static const Cinfo* intFirePopCinfo = IntFirePop::initCinfo();
+
+IntFirePop::IntFirePop()
+{
+    ;
+}
+
+/**
+ * Copies get the settings only: the neurons belong to the original.
+ */
+IntFirePop::IntFirePop( const IntFirePop& other )
+    :
+    path_( other.path_ )
+{
+    ;
+}
+
+IntFirePop& IntFirePop::operator=( const IntFirePop& other )
+{
+    if ( this != &other )
+    {
+        release();
+        path_ = other.path_;
+    }
+    return *this;
+}
+
+IntFirePop::~IntFirePop()
+{
+    release();
+}
+
+///////////////////////////////////////////////////
+// Field definitions
+///////////////////////////////////////////////////
+
+void IntFirePop::setPath( string path )
+{
+    if ( path != path_ )
+        release();
+    path_ = path;
+}
+
+string IntFirePop::getPath() const
+{
+    return path_;
+}
+
+unsigned int IntFirePop::getNumNeurons() const
+{
+    return neuron_.size();
+}
+
+vector< ObjId > IntFirePop::getNeurons() const
+{
+    vector< ObjId > ret;
+    for ( unsigned int i = 0; i < group_.size(); ++i )
+    {
+        const Group& g = group_[ i ];
+        Element* elm = g.id.element();
+        if ( !elm )
+            continue;
+        for ( unsigned int j = 0; j < g.num; ++j )
+            ret.push_back( ObjId( g.id, elm->localDataStart() + j ) );
+    }
+    return ret;
+}
+
+vector< unsigned int > IntFirePop::getSpikes() const
+{
+    return spikes_;
+}
+
+///////////////////////////////////////////////////
+// Dest function definitions
+///////////////////////////////////////////////////
+
+void IntFirePop::activation( vector< double > v )
+{
+    for ( unsigned int i = 0; i < group_.size(); ++i )
+        if ( !group_[ i ].id.element() ) // Left for process to sort out.
+            return;
+    unsigned int num = v.size() < neuron_.size() ? v.size() : neuron_.size();
+    for ( unsigned int i = 0; i < num; ++i )
+        neuron_[ i ]->activation( v[ i ] );
+}
+
+void IntFirePop::reinit( const Eref& e, ProcPtr p )
+{
+    release();
+    takeOver( p );
+}
+
+void IntFirePop::process( const Eref& e, ProcPtr p )
+{
+    high_resolution_clock::time_point t0 = high_resolution_clock::now();
+
+    for ( unsigned int i = 0; i < group_.size(); ++i )
+    {
+        if ( !group_[ i ].id.element() )
+        {
+            // Some neurons were deleted; take over what is left.
+            release();
+            takeOver( 0 );
+            break;
+        }
+    }
+
+    spikes_.clear();
+    for ( unsigned int i = 0; i < group_.size(); ++i )
+        advance( group_[ i ], p->currTime, p->dt );
+    if ( !spikes_.empty() )
+        spikesOut()->send( e, spikes_ );
+
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    addSolverProf( "IntFirePop",
+                   duration_cast< duration< double > >( t1 - t0 ).count(), 1 );
+}
+
+///////////////////////////////////////////////////
+// Taking over and releasing neurons
+///////////////////////////////////////////////////
+
+static IntFireBase* intFireData( char* data, const string& className )
+{
+    if ( className == "LIF" )
+        return reinterpret_cast< LIF* >( data );
+    if ( className == "QIF" )
+        return reinterpret_cast< QIF* >( data );
+    if ( className == "ExIF" )
+        return reinterpret_cast< ExIF* >( data );
+    if ( className == "AdExIF" )
+        return reinterpret_cast< AdExIF* >( data );
+    if ( className == "AdThreshIF" )
+        return reinterpret_cast< AdThreshIF* >( data );
+    if ( className == "IzhIF" )
+        return reinterpret_cast< IzhIF* >( data );
+    return 0;
+}
+
+/**
+ * Called with p = 0 to retake the neurons mid-run, in which case they
+ * are not reinitialized.
+ */
+void IntFirePop::takeOver( ProcPtr p )
+{
+    static const char* kindName[] =
+        { "LIF", "QIF", "ExIF", "AdExIF", "AdThreshIF", "IzhIF" };
+    static const unsigned int numKinds = sizeof( kindName ) / sizeof( char* );
+
+    vector< ObjId > found;
+    wildcardFind( path_, found );
+    for ( vector< ObjId >::iterator i = found.begin(); i != found.end(); ++i )
+    {
+        Element* elm = i->element();
+        bool seen = false;
+        for ( unsigned int j = 0; j < group_.size(); ++j )
+            seen |= ( group_[ j ].id == i->id );
+        if ( seen || elm->hasFields() )
+            continue;
+
+        const string& className = elm->cinfo()->name();
+        unsigned int k = 0;
+        while ( k < numKinds && className != kindName[ k ] )
+            ++k;
+        if ( k == numKinds )
+        {
+            if ( elm->cinfo()->isA( "IntFireBase" ) )
+                cerr << "Warning: IntFirePop::reinit: '" << i->path()
+                     << "' is a " << className
+                     << ", which is not supported. Skipping.\n";
+            continue;
+        }
+        if ( elm->getTick() < 0 )
+        {
+            cerr << "Warning: IntFirePop::reinit: '" << i->path()
+                 << "' is not on a clock tick, or is stepped by another "
+                 << "IntFirePop. Skipping.\n";
+            continue;
+        }
+        // The init phase carries the axial messages, which the
+        // population does not send.
+        const SrcFinfo* axial = dynamic_cast< const SrcFinfo* >(
+                elm->cinfo()->findFinfo( "axialOut" ) );
+        const SrcFinfo* raxial = dynamic_cast< const SrcFinfo* >(
+                elm->cinfo()->findFinfo( "raxialOut" ) );
+        if ( ( axial && elm->hasMsgs( axial->getBindIndex() ) ) ||
+             ( raxial && elm->hasMsgs( raxial->getBindIndex() ) ) )
+        {
+            cerr << "Warning: IntFirePop::reinit: '" << i->path()
+                 << "' has axial messages. Skipping.\n";
+            continue;
+        }
+
+        Group g;
+        g.id = i->id;
+        g.kind = static_cast< Kind >( k );
+        g.start = neuron_.size();
+        g.num = elm->numLocalData();
+        g.tick = elm->getTick();
+        g.sendVm = elm->hasMsgs( CompartmentBase::VmOut()->getBindIndex() );
+        elm->setTick( -2 );
+        for ( unsigned int j = 0; j < g.num; ++j )
+        {
+            IntFireBase* nrn = intFireData( elm->data( j ), className );
+            if ( p )
+                nrn->vReinit( Eref( elm, elm->localDataStart() + j ), p );
+            neuron_.push_back( nrn );
+        }
+        group_.push_back( g );
+    }
+
+    unsigned int n = neuron_.size();
+    vector< double >* state[] = { &Vm_, &activation_, &inject_, &A_, &B_,
+        &adapt_, &lastEvent_, &threshold_, &vReset_, &refractT_, &Em_, &Rm_,
+        &Cm_, &invRm_, &vPeak_, &deltaThresh_, &a0_, &b0_, &c0_,
+        &vCritical_, &tau_, &jump_, &izhA_, &izhB_ };
+    for ( unsigned int i = 0; i < sizeof( state ) / sizeof( state[0] ); ++i )
+        state[ i ]->assign( n, 0.0 );
+    branch_.assign( n, 0 );
+
+    for ( unsigned int i = 0; i < group_.size(); ++i )
+        loadParams( group_[ i ] );
+}
+
+void IntFirePop::release()
+{
+    Element* clock = Id( 1 ).element();
+    for ( unsigned int i = 0; i < group_.size(); ++i )
+    {
+        Element* elm = group_[ i ].id.element();
+        if ( clock && elm && elm->getTick() == -2 )
+            elm->setTick( group_[ i ].tick );
+    }
+    group_.clear();
+    neuron_.clear();
+    spikes_.clear();
+}
+
+void IntFirePop::loadParams( const Group& g )
+{
+    for ( unsigned int i = g.start; i < g.start + g.num; ++i )
+    {
+        const IntFireBase* f = neuron_[ i ];
+        threshold_[ i ] = f->threshold_;
+        vReset_[ i ] = f->vReset_;
+        refractT_[ i ] = f->refractT_;
+        Em_[ i ] = f->Em_;
+        Rm_[ i ] = f->Rm_;
+        Cm_[ i ] = f->Cm_;
+        invRm_[ i ] = f->invRm_;
+        switch ( g.kind )
+        {
+        case KIND_LIF:
+            break;
+        case KIND_QIF:
+        {
+            const QIF* q = static_cast< const QIF* >( f );
+            vCritical_[ i ] = q->vCritical_;
+            a0_[ i ] = q->a0_;
+            break;
+        }
+        case KIND_EXIF:
+        {
+            const ExIF* x = static_cast< const ExIF* >( f );
+            deltaThresh_[ i ] = x->deltaThresh_;
+            vPeak_[ i ] = x->vPeak_;
+            break;
+        }
+        case KIND_ADEXIF:
+        {
+            const AdExIF* x = static_cast< const AdExIF* >( f );
+            deltaThresh_[ i ] = x->deltaThresh_;
+            vPeak_[ i ] = x->vPeak_;
+            tau_[ i ] = x->tauW_;
+            a0_[ i ] = x->a0_;
+            jump_[ i ] = x->b0_;
+            break;
+        }
+        case KIND_ADTHRESHIF:
+        {
+            const AdThreshIF* x = static_cast< const AdThreshIF* >( f );
+            tau_[ i ] = x->tauThresh_;
+            a0_[ i ] = x->a0_;
+            jump_[ i ] = x->threshJump_;
+            break;
+        }
+        case KIND_IZHIF:
+        {
+            const IzhIF* z = static_cast< const IzhIF* >( f );
+            a0_[ i ] = z->a0_;
+            b0_[ i ] = z->b0_;
+            c0_[ i ] = z->c0_;
+            izhA_[ i ] = z->a_;
+            izhB_[ i ] = z->b_;
+            jump_[ i ] = z->d_;
+            vPeak_[ i ] = z->vPeak_;
+            break;
+        }
+        }
+    }
+}
+
+///////////////////////////////////////////////////
+// Stepping
+///////////////////////////////////////////////////
+
+/**
+ * Compartment::vProcess for one neuron, as a function of its inputs.
+ * The operations are in the same order, so results are identical.
+ */
+static inline double compartmentStep( double Vm, double A, double B,
+        double inject, double Em, double invRm, double Cm, double dt,
+        double epsilon )
+{
+    A += inject + Em * invRm;
+    double x = exp( -B * dt / Cm );
+    double expEuler = Vm * x + ( A / B ) * ( 1.0 - x );
+    double euler = Vm + ( A - Vm * B ) * dt / Cm;
+    return ( B > epsilon ) ? expEuler : euler;
+}
+
+/**
+ * The loops below evaluate every branch for every neuron and then pick
+ * the result, so they have no data dependent control flow and the
+ * compiler can vectorize them. Each neuron's result is computed with the
+ * same operations in the same order as its own vProcess.
+ */
+void IntFirePop::advance( const Group& g, double t, double dt )
+{
+    const unsigned int n = g.num;
+    IntFireBase** nrn = &neuron_[ g.start ];
+    double* Vm = &Vm_[ g.start ];
+    double* act = &activation_[ g.start ];
+    double* inj = &inject_[ g.start ];
+    double* A = &A_[ g.start ];
+    double* B = &B_[ g.start ];
+    double* adapt = &adapt_[ g.start ];
+    double* last = &lastEvent_[ g.start ];
+    unsigned char* br = &branch_[ g.start ];
+    const double* th = &threshold_[ g.start ];
+    const double* vReset = &vReset_[ g.start ];
+    const double* refr = &refractT_[ g.start ];
+    const double* Em = &Em_[ g.start ];
+    const double* Rm = &Rm_[ g.start ];
+    const double* Cm = &Cm_[ g.start ];
+    const double* invRm = &invRm_[ g.start ];
+    const double* vPeak = &vPeak_[ g.start ];
+    const double* dT = &deltaThresh_[ g.start ];
+    const double* a0 = &a0_[ g.start ];
+    const double* b0 = &b0_[ g.start ];
+    const double* c0 = &c0_[ g.start ];
+    const double* vCrit = &vCritical_[ g.start ];
+    const double* tau = &tau_[ g.start ];
+    const double* jump = &jump_[ g.start ];
+    const double* izhA = &izhA_[ g.start ];
+    const double* izhB = &izhB_[ g.start ];
+    const double eps = Compartment::EPSILON;
+
+    // Gather the state changed by messages and field assignments.
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+        const IntFireBase* f = nrn[ i ];
+        Vm[ i ] = f->Vm_;
+        act[ i ] = f->activation_;
+        inj[ i ] = f->inject_ + f->sumInject_;
+        A[ i ] = f->A_;
+        B[ i ] = f->B_;
+        last[ i ] = f->lastEvent_;
+    }
+    switch ( g.kind )
+    {
+    case KIND_ADEXIF:
+        for ( unsigned int i = 0; i < n; ++i )
+            adapt[ i ] = static_cast< const AdExIF* >( nrn[ i ] )->w_;
+        break;
+    case KIND_ADTHRESHIF:
+        for ( unsigned int i = 0; i < n; ++i )
+            adapt[ i ] = static_cast< const AdThreshIF* >(
+                    nrn[ i ] )->threshAdaptive_;
+        break;
+    case KIND_IZHIF:
+        for ( unsigned int i = 0; i < n; ++i )
+            adapt[ i ] = static_cast< const IzhIF* >( nrn[ i ] )->u_;
+        break;
+    default:
+        break;
+    }
+
+    switch ( g.kind )
+    {
+    case KIND_LIF:
+        for ( unsigned int i = 0; i < n; ++i )
+        {
+            bool refractory = t < last[ i ] + refr[ i ];
+            double v = Vm[ i ] + act[ i ] * dt;
+            bool fire = !refractory && v > th[ i ];
+            double vInt = compartmentStep( v, A[ i ], B[ i ], inj[ i ],
+                    Em[ i ], invRm[ i ], Cm[ i ], dt, eps );
+            Vm[ i ] = ( refractory || fire ) ? vReset[ i ] : vInt;
+            br[ i ] = refractory ? 0 : ( fire ? 1 : 2 );
+        }
+        break;
+    case KIND_QIF:
+        for ( unsigned int i = 0; i < n; ++i )
+        {
+            bool refractory = t < last[ i ] + refr[ i ];
+            double v = Vm[ i ] + act[ i ] * dt;
+            bool fire = !refractory && v > th[ i ];
+            double vInt = v + ( inj[ i ]
+                    + a0[ i ] * ( v - Em[ i ] ) * ( v - vCrit[ i ] ) / Rm[ i ] )
+                    * dt / Cm[ i ];
+            Vm[ i ] = ( refractory || fire ) ? vReset[ i ] : vInt;
+            br[ i ] = refractory ? 0 : ( fire ? 1 : 2 );
+        }
+        break;
+    case KIND_EXIF:
+        for ( unsigned int i = 0; i < n; ++i )
+        {
+            bool refractory = t < last[ i ] + refr[ i ];
+            double v = Vm[ i ] + act[ i ] * dt;
+            bool fire = !refractory && v >= vPeak[ i ];
+            double v2 = v + dT[ i ] * exp( ( v - th[ i ] ) / dT[ i ] )
+                    * dt / Rm[ i ] / Cm[ i ];
+            double vInt = compartmentStep( v2, A[ i ], B[ i ], inj[ i ],
+                    Em[ i ], invRm[ i ], Cm[ i ], dt, eps );
+            Vm[ i ] = ( refractory || fire ) ? vReset[ i ] : vInt;
+            br[ i ] = refractory ? 0 : ( fire ? 1 : 2 );
+        }
+        break;
+    case KIND_ADEXIF:
+        for ( unsigned int i = 0; i < n; ++i )
+        {
+            bool refractory = t < last[ i ] + refr[ i ];
+            double v = Vm[ i ] + act[ i ] * dt;
+            bool fire = !refractory && v >= vPeak[ i ];
+            double w = adapt[ i ];
+            double v2 = v + ( dT[ i ] * exp( ( v - th[ i ] ) / dT[ i ] )
+                    - Rm[ i ] * w ) * dt / Rm[ i ] / Cm[ i ];
+            double wInt = w + ( -w + a0[ i ] * ( v2 - Em[ i ] ) ) * dt / tau[ i ];
+            double vInt = compartmentStep( v2, A[ i ], B[ i ], inj[ i ],
+                    Em[ i ], invRm[ i ], Cm[ i ], dt, eps );
+            Vm[ i ] = ( refractory || fire ) ? vReset[ i ] : vInt;
+            adapt[ i ] = refractory ? w : ( fire ? w + jump[ i ] : wInt );
+            br[ i ] = refractory ? 0 : ( fire ? 1 : 2 );
+        }
+        break;
+    case KIND_ADTHRESHIF:
+        for ( unsigned int i = 0; i < n; ++i )
+        {
+            bool refractory = t < last[ i ] + refr[ i ];
+            double v = Vm[ i ] + act[ i ] * dt;
+            double ta = adapt[ i ];
+            bool fire = !refractory && v > ( th[ i ] + ta );
+            double taInt = ta + ( -ta + a0[ i ] * ( v - Em[ i ] ) ) * dt / tau[ i ];
+            double vInt = compartmentStep( v, A[ i ], B[ i ], inj[ i ],
+                    Em[ i ], invRm[ i ], Cm[ i ], dt, eps );
+            Vm[ i ] = ( refractory || fire ) ? vReset[ i ] : vInt;
+            adapt[ i ] = refractory ? ta : ( fire ? ta + jump[ i ] : taInt );
+            br[ i ] = refractory ? 0 : ( fire ? 1 : 2 );
+        }
+        break;
+    case KIND_IZHIF:
+        for ( unsigned int i = 0; i < n; ++i )
+        {
+            bool refractory = t < last[ i ] + refr[ i ];
+            double v = Vm[ i ] + act[ i ] * dt;
+            bool fire = !refractory && v > vPeak[ i ];
+            double u = adapt[ i ];
+            double vInt = v + ( inj[ i ] / Cm[ i ] + a0[ i ] * pow( v, 2.0 )
+                    + b0[ i ] * v + c0[ i ] - u ) * dt;
+            double uInt = u + izhA[ i ] * ( izhB[ i ] * vInt - u ) * dt;
+            Vm[ i ] = ( refractory || fire ) ? vReset[ i ] : vInt;
+            adapt[ i ] = refractory ? u : ( fire ? u + jump[ i ] : uInt );
+            br[ i ] = refractory ? 0 : ( fire ? 1 : 2 );
+        }
+        break;
+    }
+
+    // Write back, doing the bookkeeping of each branch of vProcess.
+    // QIF and IzhIF do not use A and B, so leave them alone.
+    bool usesAB = ( g.kind != KIND_QIF && g.kind != KIND_IZHIF );
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+        IntFireBase* f = nrn[ i ];
+        f->Vm_ = Vm[ i ];
+        f->fired_ = ( br[ i ] == 1 );
+        if ( br[ i ] == 0 )
+        {
+            if ( usesAB )
+            {
+                f->A_ = 0.0;
+                f->B_ = 1.0 / f->Rm_;
+            }
+            f->sumInject_ = 0.0;
+        }
+        else if ( br[ i ] == 1 )
+        {
+            f->activation_ = 0.0;
+            f->lastEvent_ = t;
+        }
+        else
+        {
+            f->activation_ = 0.0;
+            if ( usesAB )
+            {
+                f->A_ = 0.0;
+                f->B_ = f->invRm_;
+            }
+            f->lastIm_ = f->Im_;
+            f->Im_ = 0.0;
+            f->sumInject_ = 0.0;
+        }
+    }
+    switch ( g.kind )
+    {
+    case KIND_ADEXIF:
+        for ( unsigned int i = 0; i < n; ++i )
+            static_cast< AdExIF* >( nrn[ i ] )->w_ = adapt[ i ];
+        break;
+    case KIND_ADTHRESHIF:
+        for ( unsigned int i = 0; i < n; ++i )
+            static_cast< AdThreshIF* >( nrn[ i ] )->threshAdaptive_ = adapt[ i ];
+        break;
+    case KIND_IZHIF:
+        for ( unsigned int i = 0; i < n; ++i )
+            static_cast< IzhIF* >( nrn[ i ] )->u_ = adapt[ i ];
+        break;
+    default:
+        break;
+    }
+
+    // Messages go out per neuron in index order, as they would from the
+    // neurons themselves.
+    Element* elm = g.id.element();
+    unsigned int first = elm->localDataStart();
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+        if ( br[ i ] == 1 )
+        {
+            Eref er( elm, first + i );
+            IntFireBase::spikeOut()->send( er, t );
+            spikes_.push_back( g.start + i );
+        }
+        if ( g.sendVm )
+            CompartmentBase::VmOut()->send( Eref( elm, first + i ), Vm[ i ] );
+    }
+}
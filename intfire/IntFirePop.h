@@ -0,0 +1,124 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _INT_FIRE_POP_H
+#define _INT_FIRE_POP_H
+
+namespace moose
+{
+class IntFireBase;
+
+/**
+ * Steps whole arrays of integrate-and-fire neurons (LIF, QIF, ExIF,
+ * AdExIF, AdThreshIF and IzhIF) as one population. At reinit it takes
+ * over every element on its path, taking the elements off their clock
+ * tick, and from then on advances them itself:
+ *  - Each step the varying state of every neuron (Vm, activation,
+ *    injection, the A and B terms, adaptation) is gathered into
+ *    structure-of-arrays form.
+ *  - One loop per element computes the new state of all its neurons,
+ *    with no virtual calls or branches on the neuron type.
+ *  - The results are written back, spikeOut is sent for the neurons that
+ *    fired, and VmOut only for elements that have VmOut targets.
+ * The neurons' own fields thus stay current, and messages arriving at
+ * them work as before. Parameters such as thresh or Rm are read at
+ * reinit. Deleting the IntFirePop or changing its path puts the neurons
+ * back on their ticks.
+ */
+class IntFirePop
+{
+public:
+    IntFirePop();
+    IntFirePop( const IntFirePop& other );
+    IntFirePop& operator=( const IntFirePop& other );
+    ~IntFirePop();
+
+    void process( const Eref& e, ProcPtr p );
+    void reinit( const Eref& e, ProcPtr p );
+
+    void setPath( string path );
+    string getPath() const;
+    unsigned int getNumNeurons() const;
+    vector< ObjId > getNeurons() const;
+    vector< unsigned int > getSpikes() const;
+
+    /// Adds v[i] to the activation of neuron i.
+    void activation( vector< double > v );
+
+    /// Indices, into the neurons field, of the neurons that just fired.
+    static SrcFinfo1< vector< unsigned int > >* spikesOut();
+
+    static const Cinfo* initCinfo();
+
+private:
+    enum Kind { KIND_LIF, KIND_QIF, KIND_EXIF, KIND_ADEXIF, KIND_ADTHRESHIF,
+                KIND_IZHIF };
+
+    /// One element taken over: neurons start to start + num.
+    struct Group
+    {
+        Id id;
+        Kind kind;
+        unsigned int start;
+        unsigned int num;
+        int tick;       ///< Tick to restore on release.
+        bool sendVm;    ///< Element has VmOut targets.
+    };
+
+    /// Finds and takes over the neurons on path_.
+    void takeOver( ProcPtr p );
+
+    /// Puts the neurons back on their own ticks.
+    void release();
+
+    /// Reads the parameters of group g, after the neurons' reinit.
+    void loadParams( const Group& g );
+
+    /// Advances group g by one step, writing the results back.
+    void advance( const Group& g, double t, double dt );
+
+    string path_;
+    vector< Group > group_;
+    vector< IntFireBase* > neuron_;
+
+    /// State, gathered from the neurons at each step.
+    vector< double > Vm_;
+    vector< double > activation_;
+    vector< double > inject_;   ///< inject_ + sumInject_
+    vector< double > A_;
+    vector< double > B_;
+    vector< double > adapt_;    ///< w, u or threshAdaptive.
+    vector< double > lastEvent_;
+    /// Outcome of the step: 0 refractory, 1 fired, 2 integrated.
+    vector< unsigned char > branch_;
+
+    /// Parameters, read at reinit. Unused ones are 0 for each kind.
+    vector< double > threshold_;
+    vector< double > vReset_;
+    vector< double > refractT_;
+    vector< double > Em_;
+    vector< double > Rm_;
+    vector< double > Cm_;
+    vector< double > invRm_;
+    vector< double > vPeak_;        ///< ExIF, AdExIF, IzhIF
+    vector< double > deltaThresh_;  ///< ExIF, AdExIF
+    vector< double > a0_;           ///< QIF, AdExIF, AdThreshIF, IzhIF
+    vector< double > b0_;           ///< IzhIF
+    vector< double > c0_;           ///< IzhIF
+    vector< double > vCritical_;    ///< QIF
+    vector< double > tau_;          ///< tauW, tauThresh
+    vector< double > jump_;         ///< b0 of AdExIF, threshJump, d
+    vector< double > izhA_;         ///< a of IzhIF
+    vector< double > izhB_;         ///< b of IzhIF
+
+    vector< unsigned int > spikes_;
+};
+}
+
+#endif // _INT_FIRE_POP_H
@@ -67,6 +67,8 @@ class IzhIF: public IntFireBase
             double vPeak_;
             double u_;
             double uInit_;
+
+            friend class IntFirePop;
 };
 }
 
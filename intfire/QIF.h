@@ -48,6 +48,8 @@ class QIF: public IntFireBase
     private:
             double vCritical_;
             double a0_;
+
+            friend class IntFirePop;
 };
 }
 
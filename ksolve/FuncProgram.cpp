@@ -0,0 +1,512 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <cctype>
+#include <cassert>
+using namespace std;
+
+#include "FuncProgram.h"
+
+//////////////////////////////////////////////////////////////
+// Compiler
+//////////////////////////////////////////////////////////////
+
+/**
+ * Precedence follows exprtk, from loosest to tightest: comparisons,
+ * + -, * / %, unary minus, ^. Anything unexpected makes the whole
+ * compile fail.
+ */
+class FuncProgram::Compiler
+{
+public:
+    Compiler( const string& expr, const vector< unsigned int >& varIndex,
+              vector< Instr >& code )
+        :
+        s_( expr ), pos_( 0 ), varIndex_( varIndex ), code_( code ),
+        depth_( 0 ), maxDepth_( 0 ), ok_( true )
+    {;}
+
+    bool run( unsigned int& depth )
+    {
+        comparison();
+        skipSpace();
+        depth = maxDepth_;
+        return ok_ && pos_ == s_.size() && depth_ == 1;
+    }
+
+private:
+    void skipSpace()
+    {
+        while ( pos_ < s_.size() && isspace( s_[ pos_ ] ) )
+            ++pos_;
+    }
+
+    bool accept( const char* tok )
+    {
+        skipSpace();
+        unsigned int n = 0;
+        while ( tok[n] )
+            ++n;
+        if ( s_.compare( pos_, n, tok ) != 0 )
+            return false;
+        pos_ += n;
+        return true;
+    }
+
+    void emit( OpCode op, unsigned int index = 0, double value = 0.0 )
+    {
+        Instr i = { op, index, value };
+        code_.push_back( i );
+        if ( op == CONST || op == VAR || op == TIME )
+            ++depth_;
+        else if ( isBinary( op ) )
+            --depth_;
+        maxDepth_ = max( maxDepth_, depth_ );
+    }
+
+    void comparison()
+    {
+        additive();
+        while ( ok_ )
+        {
+            if ( accept( "<=" ) )
+                additive(), emit( LE );
+            else if ( accept( ">=" ) )
+                additive(), emit( GE );
+            else if ( accept( "==" ) )
+                additive(), emit( EQ );
+            else if ( accept( "!=" ) )
+                additive(), emit( NE );
+            else if ( accept( "<" ) )
+                additive(), emit( LT );
+            else if ( accept( ">" ) )
+                additive(), emit( GT );
+            else
+                break;
+        }
+    }
+
+    void additive()
+    {
+        term();
+        while ( ok_ )
+        {
+            if ( accept( "+" ) )
+                term(), emit( ADD );
+            else if ( accept( "-" ) )
+                term(), emit( SUB );
+            else
+                break;
+        }
+    }
+
+    void term()
+    {
+        unary();
+        while ( ok_ )
+        {
+            if ( accept( "*" ) )
+                unary(), emit( MUL );
+            else if ( accept( "/" ) )
+                unary(), emit( DIV );
+            else if ( accept( "%" ) )
+                unary(), emit( MOD );
+            else
+                break;
+        }
+    }
+
+    void unary()
+    {
+        if ( accept( "-" ) )
+        {
+            unary();
+            emit( NEG );
+        }
+        else if ( accept( "+" ) )
+            unary();
+        else
+            power();
+    }
+
+    void power()
+    {
+        primary();
+        if ( ok_ && accept( "^" ) )
+        {
+            unary();
+            emit( POW );
+        }
+    }
+
+    void primary()
+    {
+        skipSpace();
+        if ( pos_ >= s_.size() )
+        {
+            ok_ = false;
+            return;
+        }
+
+        char c = s_[ pos_ ];
+        if ( isdigit( c ) || c == '.' )
+        {
+            const char* begin = s_.c_str() + pos_;
+            char* end = 0;
+            double v = strtod( begin, &end );
+            if ( end == begin )
+            {
+                ok_ = false;
+                return;
+            }
+            pos_ += end - begin;
+            emit( CONST, 0, v );
+            return;
+        }
+
+        if ( accept( "(" ) )
+        {
+            comparison();
+            if ( !accept( ")" ) )
+                ok_ = false;
+            return;
+        }
+
+        if ( !isalpha( c ) && c != '_' )
+        {
+            ok_ = false;
+            return;
+        }
+        unsigned int start = pos_;
+        while ( pos_ < s_.size() && ( isalnum( s_[ pos_ ] ) || s_[ pos_ ] == '_' ) )
+            ++pos_;
+        string name = s_.substr( start, pos_ - start );
+
+        if ( accept( "(" ) )
+        {
+            call( name );
+            return;
+        }
+        if ( name == "t" )
+            emit( TIME );
+        else if ( name == "pi" )
+            emit( CONST, 0, M_PI );
+        else if ( name.size() > 1 && name[0] == 'x' &&
+                  name.find_first_not_of( "0123456789", 1 ) == string::npos )
+        {
+            unsigned long i = strtoul( name.c_str() + 1, 0, 10 );
+            if ( i >= varIndex_.size() )
+                ok_ = false;
+            else
+                emit( VAR, varIndex_[ i ] );
+        }
+        else
+            ok_ = false;
+    }
+
+    /// The opening bracket has already been read.
+    void call( const string& name )
+    {
+        static const struct
+        {
+            const char* name;
+            OpCode op;
+        } unaryFuncs[] =
+        {
+            { "exp", EXP }, { "log", LOG }, { "ln", LOG }, { "log10", LOG10 },
+            { "log2", LOG2 }, { "sqrt", SQRT }, { "abs", ABS }, { "sin", SIN },
+            { "cos", COS }, { "tan", TAN }, { "asin", ASIN }, { "acos", ACOS },
+            { "atan", ATAN }, { "sinh", SINH }, { "cosh", COSH },
+            { "tanh", TANH }, { "floor", FLOOR }, { "ceil", CEIL },
+            { "round", ROUND }, { "sgn", SGN },
+        };
+        static const struct
+        {
+            const char* name;
+            OpCode op;
+        } binaryFuncs[] =
+        {
+            { "pow", POW2 }, { "atan2", ATAN2 }, { "fmod", FMOD },
+            { "min", MIN2 }, { "max", MAX2 },
+        };
+
+        for ( auto& f : unaryFuncs )
+        {
+            if ( name == f.name )
+            {
+                comparison();
+                if ( !accept( ")" ) )
+                    ok_ = false;
+                emit( f.op );
+                return;
+            }
+        }
+
+        for ( auto& f : binaryFuncs )
+        {
+            if ( name == f.name )
+            {
+                comparison();
+                unsigned int numArgs = 1;
+                while ( ok_ && accept( "," ) )
+                {
+                    comparison();
+                    ++numArgs;
+                    // min and max take any number of arguments.
+                    if ( numArgs > 2 && f.op != MIN2 && f.op != MAX2 )
+                        ok_ = false;
+                    if ( numArgs > 1 )
+                        emit( f.op );
+                }
+                if ( numArgs < 2 || !accept( ")" ) )
+                    ok_ = false;
+                return;
+            }
+        }
+
+        ok_ = false;
+    }
+
+    const string& s_;
+    unsigned int pos_;
+    const vector< unsigned int >& varIndex_;
+    vector< Instr >& code_;
+    unsigned int depth_;
+    unsigned int maxDepth_;
+    bool ok_;
+};
+
+//////////////////////////////////////////////////////////////
+// FuncProgram
+//////////////////////////////////////////////////////////////
+
+FuncProgram::FuncProgram()
+    : depth_( 0 )
+{;}
+
+bool FuncProgram::compile( const string& expr,
+                           const vector< unsigned int >& varIndex )
+{
+    clear();
+    Compiler c( expr, varIndex, code_ );
+    if ( !c.run( depth_ ) || depth_ > MaxDepth )
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void FuncProgram::clear()
+{
+    code_.clear();
+    depth_ = 0;
+}
+
+bool FuncProgram::empty() const
+{
+    return code_.empty();
+}
+
+bool FuncProgram::isBinary( OpCode op )
+{
+    return ( op >= ADD && op <= NE ) || op >= POW2;
+}
+
+unsigned int FuncProgram::scratchSize( unsigned int width ) const
+{
+    return depth_ * width;
+}
+
+double FuncProgram::apply1( OpCode op, double a )
+{
+    switch ( op )
+    {
+    case NEG:
+        return -a;
+    case EXP:
+        return exp( a );
+    case LOG:
+        return log( a );
+    case LOG10:
+        return log10( a );
+    case LOG2:
+        return log2( a );
+    case SQRT:
+        return sqrt( a );
+    case ABS:
+        return fabs( a );
+    case SIN:
+        return sin( a );
+    case COS:
+        return cos( a );
+    case TAN:
+        return tan( a );
+    case ASIN:
+        return asin( a );
+    case ACOS:
+        return acos( a );
+    case ATAN:
+        return atan( a );
+    case SINH:
+        return sinh( a );
+    case COSH:
+        return cosh( a );
+    case TANH:
+        return tanh( a );
+    case FLOOR:
+        return floor( a );
+    case CEIL:
+        return ceil( a );
+    case ROUND:
+        return round( a );
+    case SGN:
+        return ( a > 0.0 ) ? 1.0 : ( ( a < 0.0 ) ? -1.0 : 0.0 );
+    default:
+        assert( 0 );
+        return 0.0;
+    }
+}
+
+double FuncProgram::apply2( OpCode op, double a, double b )
+{
+    switch ( op )
+    {
+    case ADD:
+        return a + b;
+    case SUB:
+        return a - b;
+    case MUL:
+        return a * b;
+    case DIV:
+        return a / b;
+    case MOD:
+    case FMOD:
+        return fmod( a, b );
+    case POW:
+    case POW2:
+        return pow( a, b );
+    case LT:
+        return a < b ? 1.0 : 0.0;
+    case LE:
+        return a <= b ? 1.0 : 0.0;
+    case GT:
+        return a > b ? 1.0 : 0.0;
+    case GE:
+        return a >= b ? 1.0 : 0.0;
+    case EQ:
+        return a == b ? 1.0 : 0.0;
+    case NE:
+        return a != b ? 1.0 : 0.0;
+    case ATAN2:
+        return atan2( a, b );
+    case MIN2:
+        return min( a, b );
+    case MAX2:
+        return max( a, b );
+    default:
+        assert( 0 );
+        return 0.0;
+    }
+}
+
+double FuncProgram::eval( const double* S, double t ) const
+{
+    double stack[ MaxDepth ];
+    unsigned int top = 0;
+    for ( const Instr& i : code_ )
+    {
+        switch ( i.op )
+        {
+        case CONST:
+            stack[ top++ ] = i.value;
+            break;
+        case VAR:
+            stack[ top++ ] = S[ i.index ];
+            break;
+        case TIME:
+            stack[ top++ ] = t;
+            break;
+        default:
+            if ( isBinary( i.op ) )
+            {
+                --top;
+                stack[ top - 1 ] = apply2( i.op, stack[ top - 1 ], stack[ top ] );
+            }
+            else
+                stack[ top - 1 ] = apply1( i.op, stack[ top - 1 ] );
+        }
+    }
+    assert( top == 1 );
+    return stack[0];
+}
+
+/**
+ * Same as eval, but each stack entry is a row of width values, so every
+ * instruction is a loop over the voxels. The four arithmetic operators
+ * get their own loops so that they vectorize.
+ */
+void FuncProgram::evalBatch( const double* y, unsigned int width, double t,
+                             double* out, double* scratch ) const
+{
+    unsigned int top = 0;
+    for ( const Instr& i : code_ )
+    {
+        if ( i.op == CONST || i.op == VAR || i.op == TIME )
+        {
+            double* b = scratch + top * width;
+            const double* v = y + i.index * width;
+            for ( unsigned int k = 0; k < width; ++k )
+                b[k] = ( i.op == VAR ) ? v[k] : ( i.op == TIME ? t : i.value );
+            ++top;
+            continue;
+        }
+
+        double* a = scratch + ( top - 1 ) * width;
+        if ( !isBinary( i.op ) )
+        {
+            for ( unsigned int k = 0; k < width; ++k )
+                a[k] = apply1( i.op, a[k] );
+            continue;
+        }
+
+        --top;
+        a -= width;
+        const double* b = a + width;
+        switch ( i.op )
+        {
+        case ADD:
+            for ( unsigned int k = 0; k < width; ++k )
+                a[k] += b[k];
+            break;
+        case SUB:
+            for ( unsigned int k = 0; k < width; ++k )
+                a[k] -= b[k];
+            break;
+        case MUL:
+            for ( unsigned int k = 0; k < width; ++k )
+                a[k] *= b[k];
+            break;
+        case DIV:
+            for ( unsigned int k = 0; k < width; ++k )
+                a[k] /= b[k];
+            break;
+        default:
+            for ( unsigned int k = 0; k < width; ++k )
+                a[k] = apply2( i.op, a[k], b[k] );
+        }
+    }
+    assert( top == 1 );
+    for ( unsigned int k = 0; k < width; ++k )
+        out[k] = scratch[k];
+}
@@ -0,0 +1,83 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _FUNC_PROGRAM_H
+#define _FUNC_PROGRAM_H
+
+/**
+ * A FuncTerm expression compiled to a small postfix program.
+ *
+ * Unlike the parser, which reads its arguments from variables bound
+ * into its symbol table, the program takes the pool vector as an
+ * argument and keeps its stack on the caller's side. So any number of
+ * threads can evaluate the same program at once, and one call can
+ * evaluate it over a whole batch of voxels laid out as in VoxelBatch.
+ *
+ * Only the plain arithmetic subset is handled: numbers, x0, x1 ..., t,
+ * pi, + - * / % ^, comparisons, and the common maths functions. compile
+ * returns false for anything else, and the FuncTerm then keeps using
+ * its parser.
+ */
+class FuncProgram
+{
+public:
+    FuncProgram();
+
+    /**
+     * Compiles expr. The variable xi is read from S[ varIndex[i] ].
+     * Returns false, leaving the program empty, if the expression uses
+     * anything outside the supported subset.
+     */
+    bool compile( const string& expr, const vector< unsigned int >& varIndex );
+    void clear();
+    bool empty() const;
+
+    /// Evaluates on a single pool vector.
+    double eval( const double* S, double t ) const;
+
+    /**
+     * Evaluates on width voxels at once. Pool i of voxel k is at
+     * y[ i * width + k ], and the results go to out[ k ]. scratch must
+     * hold scratchSize( width ) entries.
+     */
+    void evalBatch( const double* y, unsigned int width, double t,
+                    double* out, double* scratch ) const;
+    unsigned int scratchSize( unsigned int width ) const;
+
+private:
+    enum OpCode
+    {
+        CONST, VAR, TIME,
+        NEG, ADD, SUB, MUL, DIV, MOD, POW,
+        LT, LE, GT, GE, EQ, NE,
+        EXP, LOG, LOG10, LOG2, SQRT, ABS, SIN, COS, TAN,
+        ASIN, ACOS, ATAN, SINH, COSH, TANH, FLOOR, CEIL, ROUND, SGN,
+        POW2, ATAN2, FMOD, MIN2, MAX2
+    };
+
+    struct Instr
+    {
+        OpCode op;
+        unsigned int index;		///< Pool index, for VAR
+        double value;			///< For CONST
+    };
+
+    /// Recursive descent parser, one function per precedence level.
+    class Compiler;
+
+    static bool isBinary( OpCode op );
+    static double apply1( OpCode op, double a );
+    static double apply2( OpCode op, double a, double b );
+
+    vector< Instr > code_;
+    unsigned int depth_;		///< Stack depth needed
+    static const unsigned int MaxDepth = 32;
+};
+
+#endif // _FUNC_PROGRAM_H
@@ -17,10 +17,16 @@
  *
  * The arguments are named x0, x1, x2 ..., t )
  *
+ * The parser reads its arguments from the shared args_ buffer, so it is
+ * not re-entrant. Wherever possible the expression is also compiled to
+ * a FuncProgram, which is, and which is used instead. Expressions that
+ * do not compile fall back to the parser under a lock.
  */
 
 #include <vector>
 #include <sstream>
+#include <mutex>
+#include <cmath>
 using namespace std;
 
 #include "FuncTerm.h"
@@ -37,9 +43,17 @@ FuncTerm::~FuncTerm()
         delete[] args_;
 }
 
+/// Serializes use of the non-compiled parsers and their args_ buffers.
+static std::mutex& parserLock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
 void FuncTerm::setReactantIndex( const vector< unsigned int >& mol )
 {
     reactantIndex_ = mol;
+    prog_.clear();
     if ( args_ )
     {
         delete[] args_;
@@ -87,9 +101,14 @@ void FuncTerm::setExpr( const string& expr )
 
     try
     {
+        prog_.clear();
+        expr_ = expr;
         if(! parser_.SetExpr(expr))
+        {
             MOOSE_WARN("Failed to set expression: '" << expr << "'");
-        expr_ = expr;
+            return;
+        }
+        compileProgram();
     }
     catch(moose::Parser::exception_type &e)
     {
@@ -98,6 +117,46 @@ void FuncTerm::setExpr( const string& expr )
     }
 }
 
+/**
+ * Compiles expr_ and checks the program against the parser at a couple
+ * of sample points, so that any difference between the two grammars
+ * leaves us on the parser rather than silently changing results.
+ */
+void FuncTerm::compileProgram()
+{
+    if ( !args_ || !prog_.compile( expr_, reactantIndex_ ) )
+        return;
+
+    unsigned int numPools = 0;
+    for ( auto i : reactantIndex_ )
+        numPools = max( numPools, i + 1 );
+    vector< double > S( numPools );
+    const double t[] = { 0.37, 4.1 };
+    for ( unsigned int k = 0; k < 2; ++k )
+    {
+        for ( unsigned int j = 0; j < numPools; ++j )
+            S[j] = 0.3 + 0.7 * ( ( j + k * 3 ) % 5 ) + 0.01 * j;
+        unsigned int i;
+        for ( i = 0; i < reactantIndex_.size(); ++i )
+            args_[i] = S[reactantIndex_[i]];
+        args_[i] = t[k];
+        double x = parser_.Eval();
+        double y = prog_.eval( S.data(), t[k] );
+        if ( std::isnan( x ) && std::isnan( y ) )
+            continue;
+        if ( !isClose< double >( x, y, 1.0e4 ) )
+        {
+            prog_.clear();
+            return;
+        }
+    }
+}
+
+bool FuncTerm::isCompiled() const
+{
+    return !prog_.empty();
+}
+
 const string& FuncTerm::getExpr() const
 {
     return expr_;
@@ -131,7 +190,7 @@ const FuncTerm& FuncTerm::operator=( const FuncTerm& other )
     target_ = other.target_;
     reactantIndex_ = other.reactantIndex_;
     parser_ = other.parser_;
-    setReactantIndex(reactantIndex_);
+    setReactantIndex(reactantIndex_); // Also recompiles prog_
     return *this;
 }
 
@@ -144,6 +203,10 @@ double FuncTerm::operator() ( const double* S, double t ) const
     if ( ! args_ )
         return 0.0;
 
+    if ( isCompiled() )
+        return prog_.eval( S, t ) * volScale_;
+
+    std::lock_guard< std::mutex > guard( parserLock() );
     unsigned int i = 0;
     for ( i = 0; i < reactantIndex_.size(); ++i )
         args_[i] = S[reactantIndex_[i]];
@@ -165,6 +228,13 @@ void FuncTerm::evalPool( double* S, double t ) const
     if ( !args_ || target_ == ~0U )
         return;
 
+    if ( isCompiled() )
+    {
+        S[ target_ ] = prog_.eval( S, t ) * volScale_;
+        return;
+    }
+
+    std::lock_guard< std::mutex > guard( parserLock() );
     unsigned int i;
     for ( i = 0; i < reactantIndex_.size(); ++i )
         args_[i] = S[reactantIndex_[i]];
@@ -181,3 +251,21 @@ void FuncTerm::evalPool( double* S, double t ) const
         return;
     }
 }
+
+void FuncTerm::evalPoolBatch( double* y, unsigned int width, double t,
+                              double* scratch ) const
+{
+    assert( isCompiled() );
+    if ( target_ == ~0U )
+        return;
+
+    double* out = y + target_ * width;
+    prog_.evalBatch( y, width, t, out, scratch );
+    for ( unsigned int k = 0; k < width; ++k )
+        out[k] *= volScale_;
+}
+
+unsigned int FuncTerm::scratchSize( unsigned int width ) const
+{
+    return prog_.scratchSize( width );
+}
@@ -11,6 +11,7 @@
 #define _FUNC_TERM_H
 
 #include "../builtins/MooseParser.h"
+#include "FuncProgram.h"
 
 class FuncTerm
 {
@@ -27,6 +28,23 @@ public:
 
     void evalPool( double* s, double t ) const;
 
+    /**
+     * True if the expression has been compiled to a FuncProgram. Only
+     * then are operator(), evalPool and evalPoolBatch safe to call from
+     * several threads at once; otherwise they take turns on the parser.
+     */
+    bool isCompiled() const;
+
+    /**
+     * Evaluates the function for width voxels laid out as in VoxelBatch,
+     * with pool i of voxel k at y[ i * width + k ], and writes the
+     * target pool of each. Must only be called if isCompiled().
+     * scratch must hold scratchSize( width ) entries.
+     */
+    void evalPoolBatch( double* y, unsigned int width, double t,
+                        double* scratch ) const;
+    unsigned int scratchSize( unsigned int width ) const;
+
     /**
      * This function finds the reactant indices in the vector
      * S. It returns the number of indices found, which are the
@@ -57,6 +75,11 @@ private:
 
     string expr_;
     moose::MooseParser parser_;
+
+    /// Re-entrant form of parser_, empty if expr_ could not be compiled.
+    FuncProgram prog_;
+
+    void compileProgram();
 };
 
 #endif // _FUNC_TERM_H
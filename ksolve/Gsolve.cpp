@@ -26,6 +26,7 @@
 #include "Stoich.h"
 #include "GssaVoxelPools.h"
 #include "Gsolve.h"
+#include "../scheduling/ThreadPool.h"
 
 #include <chrono>
 #include <algorithm>
@@ -139,6 +140,59 @@ const Cinfo* Gsolve::initCinfo()
         &Gsolve::setClockedUpdate,
         &Gsolve::getClockedUpdate
     );
+    static ValueFinfo< Gsolve, bool > useSumTree(
+        "useSumTree",
+        "Flag: True to pick each reaction to fire using a binary sum "
+        "tree of the propensities, in log time, rather than by a linear "
+        "scan.\n"
+        "Default: False.\n"
+        "The reactions fire with the same probabilities either way. "
+        "The tree is faster for networks with more than a few dozen "
+        "reactions. Takes effect at reinit.",
+        &Gsolve::setUseSumTree,
+        &Gsolve::getUseSumTree
+    );
+    static ValueFinfo< Gsolve, unsigned int > numReplicates(
+        "numReplicates",
+        "Number of independent replicates of the stochastic run to "
+        "carry for every voxel.\n"
+        "Default: 1.\n"
+        "When > 1 the Gsolve runs an ensemble in a single simulation. "
+        "Each voxel of each replicate draws from its own counter-based "
+        "random number stream of the global seed, so the ensemble is "
+        "reproducible and the replicates are independent. Replicates "
+        "advance in parallel on numThreads threads, and their pool Nums "
+        "are recorded on every step into the 'ensemble' field. "
+        "Pool fields such as n read and write replicate 0, except that "
+        "inputs to buffered pools drive all replicates. Ensemble "
+        "mode does not support diffusion, and is ignored if there is a "
+        "Dsolve. Takes effect at reinit.",
+        &Gsolve::setNumReplicates,
+        &Gsolve::getNumReplicates
+    );
+    static ReadOnlyLookupValueFinfo<
+    Gsolve, unsigned int, vector< double > > replicateNvec(
+        "replicateNvec",
+        "Vector of pool counts of one replicate of one voxel, "
+        "indexed as replicate * numLocalVoxels + voxel.",
+        &Gsolve::getReplicateNvec
+    );
+    static ReadOnlyValueFinfo< Gsolve, vector< unsigned int > > ensembleShape(
+        "ensembleShape",
+        "Dimensions of the recorded ensemble: "
+        "[numReplicates, numLocalVoxels * numVarPools, numSteps + 1]. "
+        "Empty unless numReplicates > 1.",
+        &Gsolve::getEnsembleShape
+    );
+    static ReadOnlyValueFinfo< Gsolve, vector< double > > ensemble(
+        "ensemble",
+        "Pool Nums of all variable pools of all replicates, recorded at "
+        "reinit and after every process step. Flattened in row-major "
+        "order of ensembleShape, that is replicate x pool x time. The "
+        "pool axis runs over voxels, and within each voxel over the "
+        "variable pools in solver order. Cleared at reinit.",
+        &Gsolve::getEnsemble
+    );
     static ReadOnlyLookupValueFinfo<
     Gsolve, unsigned int, vector< unsigned int > > numFire(
         "numFire",
@@ -207,7 +261,12 @@ const Cinfo* Gsolve::initCinfo()
         // Here we put new fields that were not there in the Ksolve.
         &useRandInit,      // Value
         &useClockedUpdate, // Value
+        &useSumTree,       // Value
         &numFire,          // ReadOnlyLookupValue
+        &numReplicates,    // Value
+        &replicateNvec,    // ReadOnlyLookupValue
+        &ensembleShape,    // ReadOnlyValue
+        &ensemble,         // ReadOnlyValue
     };
 
     static Dinfo< Gsolve > dinfo;
@@ -234,7 +293,9 @@ Gsolve::Gsolve() :
     startVoxel_( 0 ),
     dsolve_(),
     dsolvePtr_(nullptr),
-    useClockedUpdate_( false )
+    useClockedUpdate_( false ),
+    numReplicates_( 1 ),
+    numEnsembleSteps_( 0 )
 {
     // Initialize with global seed.
     rng_.setSeed(moose::getGlobalSeed());
@@ -383,6 +444,90 @@ void Gsolve::setClockedUpdate( bool val )
     useClockedUpdate_ = val;
 }
 
+bool Gsolve::getUseSumTree() const
+{
+    return sys_.useSumTree;
+}
+
+void Gsolve::setUseSumTree( bool val )
+{
+    sys_.useSumTree = val;
+}
+
+unsigned int Gsolve::getNumReplicates() const
+{
+    return numReplicates_;
+}
+
+void Gsolve::setNumReplicates( unsigned int n )
+{
+    if ( n == 0 )
+    {
+        cout << "Warning: Gsolve::setNumReplicates: must be at least 1\n";
+        return;
+    }
+    numReplicates_ = n;
+}
+
+vector< double > Gsolve::getReplicateNvec( unsigned int index ) const
+{
+    static vector< double > dummy;
+    unsigned int numVoxels = pools_.size();
+    if ( numVoxels == 0 )
+        return dummy;
+    unsigned int r = index / numVoxels;
+    if ( r == 0 || ( r < numReplicates_ && !replicates_.empty() ) )
+    {
+        const GssaVoxelPools& vp = replicate( r, index % numVoxels );
+        return const_cast< GssaVoxelPools& >( vp ).Svec();
+    }
+    return dummy;
+}
+
+vector< unsigned int > Gsolve::getEnsembleShape() const
+{
+    vector< unsigned int > ret;
+    if ( replicates_.empty() || !stoichPtr_ )
+        return ret;
+    ret.push_back( numReplicates_ );
+    ret.push_back( pools_.size() * stoichPtr_->getNumVarPools() );
+    ret.push_back( numEnsembleSteps_ );
+    return ret;
+}
+
+vector< double > Gsolve::getEnsemble() const
+{
+    vector< double > ret;
+    if ( replicates_.empty() || !stoichPtr_ )
+        return ret;
+    // Stored time-major as recorded; transpose to replicate x pool x time
+    const size_t numPools = pools_.size() * stoichPtr_->getNumVarPools();
+    const size_t numT = numEnsembleSteps_;
+    ret.resize( ensemble_.size() );
+    for ( size_t t = 0; t < numT; ++t )
+    {
+        const double* block = &ensemble_[ t * numReplicates_ * numPools ];
+        for ( size_t r = 0; r < numReplicates_; ++r )
+            for ( size_t j = 0; j < numPools; ++j )
+                ret[ ( r * numPools + j ) * numT + t ] = block[ r * numPools + j ];
+    }
+    return ret;
+}
+
+GssaVoxelPools& Gsolve::replicate( unsigned int r, unsigned int v )
+{
+    if ( r == 0 )
+        return pools_[v];
+    return replicates_[ ( r - 1 ) * pools_.size() + v ];
+}
+
+const GssaVoxelPools& Gsolve::replicate( unsigned int r, unsigned int v ) const
+{
+    if ( r == 0 )
+        return pools_[v];
+    return replicates_[ ( r - 1 ) * pools_.size() + v ];
+}
+
 
 //////////////////////////////////////////////////////////////
 // Process operations.
@@ -396,30 +541,7 @@ void Gsolve::process( const Eref& e, ProcPtr p )
     // First, handle incoming diffusion values. Note potential for
     // issues with roundoff if diffusion is not integral.
     if ( dsolvePtr_ )
-    {
-        vector< double > dvalues( 4 );
-        dvalues[0] = 0;
-        dvalues[1] = getNumLocalVoxels();
-        dvalues[2] = 0;
-        dvalues[3] = stoichPtr_->getNumVarPools();
-        dsolvePtr_->getBlock( dvalues );
-        dsolvePtr_->setPrev();
-
-        // Here we need to convert to integers, just in case. Normally
-        // one would use a stochastic (integral) diffusion method with
-        // the GSSA, but in mixed models it may be more complicated.
-        vector< double >::iterator i = dvalues.begin() + 4;
-        for ( ; i != dvalues.end(); ++i )
-        {
-#if 0
-            *i = std::round( *i );
-#else
-            // *i = approximateWithInteger_debug(__FUNCTION__, *i, rng_);
-            *i = approximateWithInteger(*i, rng_);
-#endif
-        }
-        setBlock( dvalues );
-    }
+        loadFromDsolve();
 
     if ( dsolvePtr_ )
     {
@@ -427,6 +549,12 @@ void Gsolve::process( const Eref& e, ProcPtr p )
             i->refreshAtot( &sys_ );
     }
 
+    if ( !replicates_.empty() )
+    {
+        advanceEnsemble( p );
+        return;
+    }
+
     if( 1 == numThreads_ || 1 == pools_.size())
     {
         if( numThreads_ > 1 )
@@ -524,13 +652,7 @@ void Gsolve::process( const Eref& e, ProcPtr p )
     // Finally, assemble and send the integrated values off for the Dsolve.
     if ( dsolvePtr_ )
     {
-        vector< double > kvalues( 4 );
-        kvalues[0] = 0;
-        kvalues[1] = getNumLocalVoxels();
-        kvalues[2] = 0;
-        kvalues[3] = stoichPtr_->getNumVarPools();
-        getBlock( kvalues );
-        dsolvePtr_->setBlock( kvalues );
+        storeToDsolve();
 
         // Now use the values in the Dsolve to update junction fluxes
         // for diffusion, channels, and xreacs
@@ -539,6 +661,80 @@ void Gsolve::process( const Eref& e, ProcPtr p )
     }
 }
 
+void Gsolve::advanceEnsemble( ProcPtr p )
+{
+    // One task per replicate. The replicates share only the read-only
+    // GssaSystem, and each has its own RNG streams.
+    const unsigned int numVoxels = pools_.size();
+    auto task = [this, p, numVoxels]( size_t r ) {
+        for ( unsigned int v = 0; v < numVoxels; ++v )
+        {
+            GssaVoxelPools& vp = replicate( r, v );
+            vp.advance( p, &sys_ );
+            if ( useClockedUpdate_ )
+                vp.recalcTime( &sys_, p->currTime );
+        }
+    };
+    if ( ensembleThreads_ )
+        ensembleThreads_->parallelFor( numReplicates_, task );
+    else
+        for ( unsigned int r = 0; r < numReplicates_; ++r )
+            task( r );
+    recordEnsemble();
+}
+
+void Gsolve::recordEnsemble()
+{
+    const unsigned int numVoxels = pools_.size();
+    const unsigned int numVarPools = stoichPtr_->getNumVarPools();
+    for ( unsigned int r = 0; r < numReplicates_; ++r )
+    {
+        for ( unsigned int v = 0; v < numVoxels; ++v )
+        {
+            const double* s = replicate( r, v ).S();
+            ensemble_.insert( ensemble_.end(), s, s + numVarPools );
+        }
+    }
+    ++numEnsembleSteps_;
+}
+
+void Gsolve::reinitEnsemble( unsigned int id )
+{
+    replicates_.clear();
+    ensembleThreads_.reset();
+    ensemble_.clear();
+    numEnsembleSteps_ = 0;
+
+    if ( numReplicates_ > 1 && dsolvePtr_ )
+    {
+        cout << "Warning: Gsolve::reinit: ensemble mode does not support "
+             "diffusion. Running a single replicate.\n";
+    }
+    const bool useEnsemble = ( numReplicates_ > 1 && !dsolvePtr_ );
+    const unsigned int numVoxels = pools_.size();
+    for ( unsigned int v = 0; v < numVoxels; ++v )
+        pools_[v].setRngStream( moose::RNG::streamOf( id, startVoxel_ + v ) );
+    if ( !useEnsemble )
+        return;
+
+    // Resized from empty so that no rate terms are copied.
+    replicates_.resize( ( numReplicates_ - 1 ) * numVoxels );
+    for ( unsigned int r = 1; r < numReplicates_; ++r )
+    {
+        for ( unsigned int v = 0; v < numVoxels; ++v )
+        {
+            GssaVoxelPools& vp = replicate( r, v );
+            vp.makeReplicateOf( pools_[v], &sys_ );
+            vp.setRngStream( moose::RNG::streamOf( id, r * numVoxels + v ) );
+            vp.reinit( &sys_ );
+        }
+    }
+
+    unsigned int numThreads = std::min( (unsigned int)numThreads_, numReplicates_ );
+    if ( numThreads > 1 )
+        ensembleThreads_ = make_shared< moose::ThreadPool >( numThreads );
+}
+
 size_t Gsolve::recalcTimeChunk( const size_t begin, const size_t end, ProcPtr p)
 {
     assert( begin >= std::min(pools_.size(), end));
@@ -571,6 +767,9 @@ void Gsolve::reinit( const Eref& e, ProcPtr p )
     if ( !sys_.isReady )
         rebuildGssaSystem();
 
+    // The RNG streams must be assigned before the voxels reinit.
+    reinitEnsemble( e.id().value() );
+
     // First reinit concs.
     for (auto i = pools_.begin(); i != pools_.end(); ++i )
         i->reinit( &sys_ );
@@ -579,6 +778,16 @@ void Gsolve::reinit( const Eref& e, ProcPtr p )
     for ( auto i = pools_.begin(); i != pools_.end(); ++i )
         i->refreshAtot( &sys_ );
 
+    if ( !replicates_.empty() )
+    {
+        recordEnsemble();
+        if ( ensembleThreads_ )
+            cout << "Info: Setting up gsolve ensemble of " << numReplicates_
+                 << " replicates on " << ensembleThreads_->numThreads()
+                 << " threads. " << endl;
+        return;
+    }
+
 
     // LoadBalancing. Recompute the optimal number of threads.
     size_t nvPools = pools_.size( );
@@ -953,6 +1162,12 @@ void Gsolve::setN( const Eref& e, double v )
             // refresh rates because concInit controls ongoing value of n.
             if ( sys_.isReady )
                 pools_[vox].refreshAtot( &sys_ );
+            // Buffered inputs drive all replicates alike.
+            for ( unsigned int r = 1; r < numReplicates_ && !replicates_.empty(); ++r )
+            {
+                replicate( r, vox ).setN( getPoolIndex( e ), v );
+                replicate( r, vox ).refreshAtot( &sys_ );
+            }
         }
         else
         {
@@ -1082,6 +1297,76 @@ void Gsolve::setBlock( const vector< double >& values )
     }
 }
 
+void Gsolve::loadFromDsolve()
+{
+    const unsigned int numVarPools = stoichPtr_->getNumVarPools();
+    dsolvePtr_->getPoolVecs( diffN_, diffPrev_ );
+    const bool direct = ( diffN_.size() >= numVarPools &&
+            dsolvePtr_->getNumLocalVoxels() == pools_.size() );
+    vector< double > dvalues( 4 );
+    if ( !direct )
+    {
+        dvalues[0] = 0;
+        dvalues[1] = getNumLocalVoxels();
+        dvalues[2] = 0;
+        dvalues[3] = numVarPools;
+        dsolvePtr_->getBlock( dvalues );
+        dsolvePtr_->setPrev();
+        diffN_.clear();
+    }
+    else
+    {
+        for ( unsigned int j = numVarPools; j < diffN_.size(); ++j )
+            std::copy( diffN_[j], diffN_[j] + pools_.size(), diffPrev_[j] );
+    }
+
+    // Here we need to convert to integers, just in case. Normally
+    // one would use a stochastic (integral) diffusion method with
+    // the GSSA, but in mixed models it may be more complicated.
+    // The loop runs pool by pool to keep the order of random numbers.
+    const unsigned int numVoxels = pools_.size();
+    for ( unsigned int j = 0; j < numVarPools; ++j )
+    {
+        for ( unsigned int i = 0; i < numVoxels; ++i )
+        {
+            double x;
+            if ( direct )
+                x = diffPrev_[j][i] = diffN_[j][i];
+            else
+                x = dvalues[ 4 + j * numVoxels + i ];
+#if 0
+            x = std::round( x );
+#else
+            // x = approximateWithInteger_debug(__FUNCTION__, x, rng_);
+            x = approximateWithInteger( x, rng_ );
+#endif
+            pools_[i].varS()[j] = x;
+        }
+    }
+}
+
+void Gsolve::storeToDsolve()
+{
+    const unsigned int numVarPools = stoichPtr_->getNumVarPools();
+    if ( diffN_.empty() )
+    {
+        vector< double > kvalues( 4 );
+        kvalues[0] = 0;
+        kvalues[1] = getNumLocalVoxels();
+        kvalues[2] = 0;
+        kvalues[3] = numVarPools;
+        getBlock( kvalues );
+        dsolvePtr_->setBlock( kvalues );
+        return;
+    }
+    for ( unsigned int i = 0; i < pools_.size(); ++i )
+    {
+        const double* s = pools_[i].S();
+        for ( unsigned int j = 0; j < numVarPools; ++j )
+            diffN_[j][i] = s[j];
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 void Gsolve::updateVoxelVol( vector< double > vols )
 {
@@ -1094,6 +1379,8 @@ void Gsolve::updateVoxelVol( vector< double > vols )
         {
             pools_[i].setVolumeAndDependencies( vols[i] );
         }
+        for ( unsigned int i = 0; i < replicates_.size(); ++i )
+            replicates_[i].setVolumeAndDependencies( vols[ i % vols.size() ] );
         updateRateTerms( ~0U );
     }
 }
@@ -1108,12 +1395,18 @@ void Gsolve::updateRateTerms( unsigned int index )
             pools_[i].updateAllRateTerms( stoichPtr_->getRateTerms(),
                     stoichPtr_->getNumCoreRates() );
         }
+        for ( auto& vp : replicates_ )
+            vp.updateAllRateTerms( stoichPtr_->getRateTerms(),
+                    stoichPtr_->getNumCoreRates() );
     }
     else if ( index < stoichPtr_->getNumRates() )
     {
         for ( unsigned int i = 0 ; i < pools_.size(); ++i )
             pools_[i].updateRateTerms( stoichPtr_->getRateTerms(),
                     stoichPtr_->getNumCoreRates(), index );
+        for ( auto& vp : replicates_ )
+            vp.updateRateTerms( stoichPtr_->getRateTerms(),
+                    stoichPtr_->getNumCoreRates(), index );
     }
 }
 
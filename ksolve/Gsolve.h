@@ -10,9 +10,13 @@
 #ifndef _GSOLVE_H
 #define _GSOLVE_H
 
+#include <memory>
 #include "../randnum/RNG.h"
 
 class Stoich;
+namespace moose {
+    class ThreadPool;
+}
 
 class Gsolve: public KsolveBase
 {
@@ -108,6 +112,15 @@ public:
     void getBlock( vector< double >& values ) const;
     void setBlock( const vector< double >& values );
 
+    /**
+     * Loads the variable pools of all voxels from the Dsolve, rounded
+     * to integers, and sets its prev values.
+     */
+    void loadFromDsolve();
+
+    /// Stores the variable pools of all voxels back into the Dsolve.
+    void storeToDsolve();
+
     /**
      * Rescale specified voxel rate term following rate constant change
      * or volume change. If index == ~0U then does all terms.
@@ -129,12 +142,55 @@ public:
     /// Flag: set true if randomized round to integers is to be done.
     void setClockedUpdate( bool val );
 
+    /// Flag: true if reactions are picked using a PropensityTree.
+    bool getUseSumTree() const;
+    void setUseSumTree( bool val );
+
     unsigned int getNumThreads( ) const;
     void setNumThreads( unsigned int x );
 
+    //////////////////////////////////////////////////////////////////
+    // Ensemble mode
+    //////////////////////////////////////////////////////////////////
+    /// Number of independent replicates run for every voxel.
+    unsigned int getNumReplicates() const;
+    void setNumReplicates( unsigned int n );
+
+    /**
+     * Returns the pool Num vector of one replicate of one voxel,
+     * indexed as replicate * numLocalVoxels + voxel.
+     */
+    vector< double > getReplicateNvec( unsigned int index ) const;
+
+    /// Dimensions of the recorded ensemble: replicates, pools, times.
+    vector< unsigned int > getEnsembleShape() const;
+
+    /**
+     * Recorded Num of every variable pool of every replicate, flattened
+     * in row-major replicate x pool x time order. The pool axis runs
+     * over voxels, and within each voxel over the variable pools.
+     */
+    vector< double > getEnsemble() const;
+
     //////////////////////////////////////////////////////////////////
     static const Cinfo* initCinfo();
 private:
+    /// Returns the voxel pools of replicate r, voxel v.
+    GssaVoxelPools& replicate( unsigned int r, unsigned int v );
+    const GssaVoxelPools& replicate( unsigned int r, unsigned int v ) const;
+
+    /**
+     * Assigns the RNG streams of all voxels, numbered within the id of
+     * this Gsolve, and sets up and reinits the replicates at reinit, if
+     * there are any.
+     */
+    void reinitEnsemble( unsigned int id );
+
+    /// Advances all replicates, in parallel if there are threads.
+    void advanceEnsemble( ProcPtr p );
+
+    /// Appends the current state of all replicates to ensemble_.
+    void recordEnsemble();
 
     /**
      * @brief Number of threads to use when parallel version of Gsolve is
@@ -168,11 +224,38 @@ private:
     /// Pointer to diffusion solver
     KsolveBase* dsolvePtr_;
 
+    /**
+     * Per pool arrays of the Dsolve state, from getPoolVecs. Refreshed
+     * on each step; empty if the Dsolve doesn't provide them.
+     */
+    vector< double* > diffN_;
+    vector< double* > diffPrev_;
+
     /// Flag: True if atot should be updated every clock tick
     bool useClockedUpdate_;
 
     // private rng.
     moose::RNG rng_;
+
+    /**
+     * Number of replicates requested. When > 1, reinit builds the
+     * replicates and each voxel of each replicate draws from its own
+     * stream of the global seed.
+     */
+    unsigned int numReplicates_;
+
+    /**
+     * Replicates 1 to numReplicates_ - 1. Replicate 0 is pools_. Entry
+     * ( r - 1 ) * numVoxels + v holds replicate r of voxel v.
+     */
+    vector< GssaVoxelPools > replicates_;
+
+    /// Workers for advancing replicates in parallel.
+    shared_ptr< moose::ThreadPool > ensembleThreads_;
+
+    /// Recorded ensemble, one block of replicate x voxel x pool per step.
+    vector< double > ensemble_;
+    unsigned int numEnsembleSteps_;
 };
 
 #endif	// _GSOLVE_H
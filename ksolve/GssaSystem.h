@@ -20,7 +20,8 @@ class GssaSystem
 {
 public:
     GssaSystem()
-        : stoich(0), useRandInit(true), isReady(false), honorMassConservation(true)
+        : stoich(0), useRandInit(true), isReady(false), honorMassConservation(true),
+        useSumTree(false)
     {;}
     vector< vector< unsigned int > > dependency;
     vector< vector< unsigned int > > dependentMathExpn;
@@ -53,6 +54,12 @@ public:
      * the sum of molecules is does not differ more than 1.0 molecules.
      */
     bool honorMassConservation = true;
+
+    /**
+     * Flag: True to pick reactions using a PropensityTree, in log time,
+     * rather than by a linear scan of the propensities.
+     */
+    bool useSumTree = false;
 };
 
 #endif	// _GSSA_SYSTEM_H
@@ -40,7 +40,8 @@ const double SAFETY_FACTOR = 1.0 + 1.0e-9;
 
 
 // Class definitions
-GssaVoxelPools::GssaVoxelPools(): VoxelPoolsBase(), t_( 0.0 ), atot_( 0.0 )
+GssaVoxelPools::GssaVoxelPools(): VoxelPoolsBase(), t_( 0.0 ), atot_( 0.0 ),
+    useTree_( false ), rngStream_( 0 )
 {;}
 
 GssaVoxelPools::~GssaVoxelPools()
@@ -84,6 +85,13 @@ void GssaVoxelPools::updateDependentMathExpn(
 void GssaVoxelPools::updateDependentRates(
     const vector< unsigned int >& deps, const Stoich* stoich )
 {
+    if ( useTree_ )
+    {
+        for ( auto i = deps.cbegin(); i != deps.end(); ++i )
+            tree_.set( *i, fabs( v_[ *i ] = getReacVelocity( *i, S() ) ) );
+        atot_ = tree_.total();
+        return;
+    }
     for ( auto i = deps.cbegin(); i != deps.end(); ++i )
     {
         atot_ -= fabs( v_[ *i ] );
@@ -97,12 +105,13 @@ unsigned int GssaVoxelPools::pickReac()
     double r = rng_.uniform( ) * atot_;
     double sum = 0.0;
 
-    // This is an inefficient way to do it. Can easily get to
-    // log time or thereabouts by doing one or two levels of
-    // subsidiary tables. Too many levels causes slow-down because
-    // of overhead in managing the tree.
+    if ( useTree_ )
+        return tree_.pick( r );
+
+    // Linear scan. The tree above gets to log time; it is worth it
+    // once there are more than a few dozen reactions.
     // Slepoy, Thompson and Plimpton 2008
-    // report a linear time version.
+    // report a constant time version.
     for ( auto i = v_.cbegin(); i != v_.end(); ++i )
     {
         if ( r < ( sum += fabs( *i ) ) )
@@ -131,6 +140,14 @@ bool GssaVoxelPools::refreshAtot( const GssaSystem* g )
 {
     g->stoich->updateFuncs( varS(), t_ );
     updateReacVelocities( g, S(), v_ );
+    useTree_ = g->useSumTree;
+    if ( useTree_ )
+    {
+        // The tree total does not drift, so needs no safety factor.
+        tree_.build( v_ );
+        atot_ = tree_.total();
+        return atot_ > 0.0;
+    }
     atot_ = 0;
     for ( auto i = v_.cbegin(); i != v_.cend(); ++i )
         atot_ += fabs(*i);
@@ -212,7 +229,7 @@ void GssaVoxelPools::advance( const ProcInfo* p, const GssaSystem* g )
 
 void GssaVoxelPools::reinit( const GssaSystem* g )
 {
-    rng_.setSeed( moose::getGlobalSeed() );
+    rng_.setStream( moose::getGlobalSeed(), rngStream_ );
     VoxelPoolsBase::reinit(); // Assigns S = NA * vol * Cinit;
     unsigned int numVarPools = g->stoich->getNumVarPools();
     g->stoich->updateFuncs( varS(), 0 );
@@ -329,6 +346,25 @@ void GssaVoxelPools::setStoich( const Stoich* stoichPtr )
     stoichPtr_ = stoichPtr;
 }
 
+void GssaVoxelPools::makeReplicateOf( const GssaVoxelPools& master,
+                                      const GssaSystem* g )
+{
+    for ( unsigned int i = 0; i < rates_.size(); ++i )
+        delete( rates_[i] );
+    // The base copy brings the master's rate term pointers along. They
+    // belong to the master, so drop them before building our own.
+    VoxelPoolsBase::operator=( master );
+    rates_.clear();
+    setNumReac( g->stoich->getNumRates() );
+    updateAllRateTerms( g->stoich->getRateTerms(),
+                        g->stoich->getNumCoreRates() );
+}
+
+void GssaVoxelPools::setRngStream( uint64_t stream )
+{
+    rngStream_ = stream;
+}
+
 // Handle volume updates. Inherited virtual func.
 void GssaVoxelPools::setVolumeAndDependencies( double vol )
 {
@@ -11,6 +11,7 @@
 #define _GSSA_VOXEL_POOLS_BASE_H
 
 #include "../randnum/RNG.h"
+#include "PropensityTree.h"
 
 class Stoich;
 
@@ -74,6 +75,21 @@ public:
 
     void setStoich( const Stoich* stoichPtr );
 
+    /**
+     * Makes this an independent replicate of master for ensemble runs:
+     * copies its volume, initial conditions and scaling, and builds its
+     * own rate terms. The state is assigned at reinit.
+     */
+    void makeReplicateOf( const GssaVoxelPools& master, const GssaSystem* g );
+
+    /**
+     * Selects the RNG stream of the global seed that reinit starts this
+     * voxel on. Gsolve numbers the streams by its own id and the voxel,
+     * so that each voxel draws the same numbers however the voxels are
+     * spread over threads.
+     */
+    void setRngStream( uint64_t stream );
+
 private:
     /// Time at which next event will occur.
     double t_;
@@ -93,10 +109,20 @@ private:
     // Count how many times each reaction has fired.
     vector< unsigned int > numFire_;
 
+    /**
+     * Propensities |v_| as a sum tree, used by pickReac instead of the
+     * linear scan when useTree_ is set. atot_ is then the tree total.
+     */
+    PropensityTree tree_;
+    bool useTree_;
+
     /**
      * @brief RNG.
      */
     moose::RNG rng_;
+
+    /// RNG stream used at reinit.
+    uint64_t rngStream_;
 };
 
 #endif	// _GSSA_VOXEL_POOLS_H
@@ -0,0 +1,109 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "../basecode/SparseMatrix.h"
+#include "KinSparseMatrix.h"
+#include "RateKernel.h"
+#include "KinJacobian.h"
+
+KinJacobian::KinJacobian()
+    : numVar_( 0 ), kernelVersion_( 0 ), rowStart_( 1, 0 ), termStart_( 1, 0 )
+{;}
+
+void KinJacobian::build( const KinSparseMatrix& N, unsigned int numVar,
+                         const RateKernel& rk )
+{
+    const vector< unsigned int >& dvRowStart = rk.getPartialsRowStart();
+    const vector< unsigned int >& dvCol = rk.getPartialsCol();
+    numVar_ = numVar;
+    rowStart_.assign( 1, 0 );
+    colIndex_.clear();
+    termStart_.assign( 1, 0 );
+    termN_.clear();
+    termDv_.clear();
+
+    for ( unsigned int i = 0; i < numVar; ++i )
+    {
+        // Collect ( column, N entry, dv entry ) for row i.
+        vector< pair< unsigned int, pair< double, unsigned int > > > terms;
+        const int* entry = 0;
+        const unsigned int* colIndex = 0;
+        unsigned int numEntries = ( N.nColumns() == 0 ) ? 0 :
+                                  N.getRow( i, &entry, &colIndex );
+        for ( unsigned int j = 0; j < numEntries; ++j )
+        {
+            unsigned int r = colIndex[j];
+            assert( r + 1 < dvRowStart.size() );
+            for ( unsigned int p = dvRowStart[r]; p < dvRowStart[r + 1]; ++p )
+                if ( dvCol[p] < numVar )
+                    terms.push_back( make_pair( dvCol[p],
+                                make_pair( double( entry[j] ), p ) ) );
+        }
+        // The diagonal is needed even if it has no terms.
+        terms.push_back( make_pair( i, make_pair( 0.0, ~0U ) ) );
+        sort( terms.begin(), terms.end() );
+
+        for ( unsigned int t = 0; t < terms.size(); ++t )
+        {
+            if ( t == 0 || terms[t].first != terms[t - 1].first )
+            {
+                if ( t > 0 )
+                    termStart_.push_back( termN_.size() );
+                colIndex_.push_back( terms[t].first );
+            }
+            if ( terms[t].second.second != ~0U )
+            {
+                termN_.push_back( terms[t].second.first );
+                termDv_.push_back( terms[t].second.second );
+            }
+        }
+        termStart_.push_back( termN_.size() );
+        rowStart_.push_back( colIndex_.size() );
+    }
+    assert( termStart_.size() == colIndex_.size() + 1 );
+    kernelVersion_ = rk.version();
+}
+
+void KinJacobian::compute( const double* dv, double* jac ) const
+{
+    const unsigned int n = colIndex_.size();
+    for ( unsigned int e = 0; e < n; ++e )
+    {
+        double sum = 0.0;
+        for ( unsigned int t = termStart_[e]; t < termStart_[e + 1]; ++t )
+            sum += termN_[t] * dv[ termDv_[t] ];
+        jac[e] = sum;
+    }
+}
+
+unsigned int KinJacobian::size() const
+{
+    return numVar_;
+}
+
+unsigned int KinJacobian::numEntries() const
+{
+    return colIndex_.size();
+}
+
+const vector< unsigned int >& KinJacobian::getRowStart() const
+{
+    return rowStart_;
+}
+
+const vector< unsigned int >& KinJacobian::getColIndex() const
+{
+    return colIndex_;
+}
+
+unsigned int KinJacobian::getKernelVersion() const
+{
+    return kernelVersion_;
+}
@@ -0,0 +1,61 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _KIN_JACOBIAN_H
+#define _KIN_JACOBIAN_H
+
+class KinSparseMatrix;
+class RateKernel;
+
+/**
+ * Sparse Jacobian of the reaction system, J = N.dv/dS, restricted to
+ * the variable (and proxy) pools.
+ *
+ * The pattern and the list of products N[i][r] * dv[r][k] summed into
+ * each entry J[i][k] are worked out once from the stoichiometry matrix
+ * and the RateKernel's partials pattern. compute() then only does the
+ * multiply-adds. The diagonal is always in the pattern, so the same
+ * pattern serves for the iteration matrix of stiff methods.
+ */
+class KinJacobian
+{
+public:
+    KinJacobian();
+
+    void build( const KinSparseMatrix& N, unsigned int numVar,
+                const RateKernel& rk );
+
+    /**
+     * Fills jac, in the order of the pattern, from the partials dv
+     * computed by RateKernel::evalPartials.
+     */
+    void compute( const double* dv, double* jac ) const;
+
+    /// Number of rows and columns
+    unsigned int size() const;
+    unsigned int numEntries() const;
+    const vector< unsigned int >& getRowStart() const;
+    const vector< unsigned int >& getColIndex() const;
+
+    /// RateKernel version this was built for.
+    unsigned int getKernelVersion() const;
+
+private:
+    unsigned int numVar_;
+    unsigned int kernelVersion_;
+    vector< unsigned int > rowStart_;
+    vector< unsigned int > colIndex_;
+
+    // For each entry of J, the range in termN_/termDv_ of its products.
+    vector< unsigned int > termStart_;
+    vector< double > termN_;
+    vector< unsigned int > termDv_;
+};
+
+#endif // _KIN_JACOBIAN_H
@@ -33,6 +33,7 @@
 #include "../mesh/Boundary.h"
 #include "../mesh/ChemCompt.h"
 #include "Ksolve.h"
+#include "VoxelBatch.h"
 
 #include <chrono>
 #include <algorithm>
@@ -61,7 +62,15 @@ const Cinfo* Ksolve::initCinfo()
         "rk2: The Runge-Kutta 2,3 embedded fixed dt method"
         "rkck: The Runge-Kutta Cash-Karp (4,5) method"
         "rk8: The Runge-Kutta Prince-Dormand (8,9) method"
-        "lsoda: LSODA method",
+        "lsoda: LSODA method"
+        "rosenbrock: Rosenbrock-W (3,2) adaptive dt stiff method, using "
+        "the analytic sparse Jacobian of the reaction system."
+        "rk4batch: Runge-Kutta 4th order fixed dt, integrating groups of "
+        "voxels in lockstep. Fast for large meshes."
+        "rkckbatch: Runge-Kutta Cash-Karp (4,5) adaptive dt, integrating "
+        "groups of voxels in lockstep."
+        "batch: alias for rkckbatch. "
+        "The batch methods run on a single thread and ignore numThreads.",
         &Ksolve::setMethod,
         &Ksolve::getMethod
     );
@@ -279,13 +288,16 @@ void Ksolve::setMethod( string method )
         return;
     }
 
+    if ( method == "batch" )
+        method = "rkckbatch";
 #if USE_GSL
     if ( method == "rk5" || method == "gsl" )
     {
         method_ = "rk5";
     }
     else if ( method == "rk4"  || method == "rk2" ||
-              method == "rk8" || method == "rkck" || method == "lsoda" )
+              method == "rk8" || method == "rkck" || method == "lsoda" ||
+              method == "rosenbrock" || VoxelBatch::isBatchMethod( method ) )
     {
         method_ = method;
     }
@@ -568,20 +580,13 @@ void Ksolve::process( const Eref& e, ProcPtr p )
 
     // First, handle incoming diffusion values, update S with those.
     if ( dsolvePtr_ )
-    {
-        vector< double > dvalues( 4 );
-        dvalues[0] = 0;
-        dvalues[1] = getNumLocalVoxels();
-        dvalues[2] = 0;
-        dvalues[3] = stoichPtr_->getNumVarPools();
+        loadFromDsolve();
 
-        dsolvePtr_->getBlock( dvalues );
-        // Second, set the prev_ value in DiffPoolVec
-        dsolvePtr_->setPrev();
-        setBlock( dvalues );
+    if ( batch_ )
+    {
+        batch_->advance( pools_, stoichPtr_, p );
     }
-
-    if( 1 == numThreads_ || 1 == pools_.size() )
+    else if( 1 == numThreads_ || 1 == pools_.size() )
     {
         if( numThreads_ > 1 )
         {
@@ -618,13 +623,7 @@ void Ksolve::process( const Eref& e, ProcPtr p )
     // Assemble and send the integrated values off for the Dsolve.
     if ( dsolvePtr_ )
     {
-        vector< double > kvalues( 4 );
-        kvalues[0] = 0;
-        kvalues[1] = getNumLocalVoxels();
-        kvalues[2] = 0;
-        kvalues[3] = stoichPtr_->getNumVarPools();
-        getBlock( kvalues );
-        dsolvePtr_->setBlock( kvalues );
+        storeToDsolve();
 
         // Now use the values in the Dsolve to update junction fluxes
         // for diffusion, channels, and xreacs
@@ -670,6 +669,22 @@ void Ksolve::reinit( const Eref& e, ProcPtr p )
         return;
     }
 
+    if ( VoxelBatch::isBatchMethod( method_ ) )
+    {
+        if ( !batch_ )
+            batch_ = std::make_shared< VoxelBatch >();
+        batch_->setMethod( method_ );
+        batch_->setTolerances( epsAbs_, epsRel_ );
+        batch_->reinit( p->dt );
+        if ( numThreads_ > 1 )
+            cout << "Warning:Ksolve::reinit: method " << method_
+                 << " runs on a single thread, numThreads is ignored.\n";
+    }
+    else
+    {
+        batch_.reset();
+    }
+
     if(numThreads_ > pools_.size())
         numThreads_ = pools_.size();
 
@@ -921,6 +936,59 @@ void Ksolve::setBlock( const vector< double >& values )
     }
 }
 
+void Ksolve::loadFromDsolve()
+{
+    const unsigned int numVarPools = stoichPtr_->getNumVarPools();
+    dsolvePtr_->getPoolVecs( diffN_, diffPrev_ );
+    if ( diffN_.size() < numVarPools ||
+            dsolvePtr_->getNumLocalVoxels() != pools_.size() )
+    {
+        vector< double > dvalues( 4 );
+        dvalues[0] = 0;
+        dvalues[1] = getNumLocalVoxels();
+        dvalues[2] = 0;
+        dvalues[3] = numVarPools;
+
+        dsolvePtr_->getBlock( dvalues );
+        // Second, set the prev_ value in DiffPoolVec
+        dsolvePtr_->setPrev();
+        setBlock( dvalues );
+        diffN_.clear();
+        return;
+    }
+    // Remaining pools of the Dsolve are not exchanged but still need prev.
+    for ( unsigned int j = numVarPools; j < diffN_.size(); ++j )
+        std::copy( diffN_[j], diffN_[j] + pools_.size(), diffPrev_[j] );
+    for ( unsigned int i = 0; i < pools_.size(); ++i )
+    {
+        double* s = pools_[i].varS();
+        for ( unsigned int j = 0; j < numVarPools; ++j )
+            s[j] = diffPrev_[j][i] = diffN_[j][i];
+    }
+}
+
+void Ksolve::storeToDsolve()
+{
+    const unsigned int numVarPools = stoichPtr_->getNumVarPools();
+    if ( diffN_.empty() )
+    {
+        vector< double > kvalues( 4 );
+        kvalues[0] = 0;
+        kvalues[1] = getNumLocalVoxels();
+        kvalues[2] = 0;
+        kvalues[3] = numVarPools;
+        getBlock( kvalues );
+        dsolvePtr_->setBlock( kvalues );
+        return;
+    }
+    for ( unsigned int i = 0; i < pools_.size(); ++i )
+    {
+        const double* s = pools_[i].S();
+        for ( unsigned int j = 0; j < numVarPools; ++j )
+            diffN_[j][i] = s[j];
+    }
+}
+
 void Ksolve::updateVoxelVol( vector< double > vols )
 {
     // For now we assume identical numbers of voxels. Also assume
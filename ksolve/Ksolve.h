@@ -15,6 +15,7 @@
 using namespace std::chrono;
 
 class Stoich;
+class VoxelBatch;
 
 class Ksolve: public KsolveBase
 {
@@ -125,6 +126,15 @@ public:
     void getBlock( vector< double >& values ) const;
     void setBlock( const vector< double >& values );
 
+    /**
+     * Loads the variable pools of all voxels from the Dsolve, and sets
+     * its prev values, in one pass over its arrays.
+     */
+    void loadFromDsolve();
+
+    /// Stores the variable pools of all voxels back into the Dsolve.
+    void storeToDsolve();
+
     void matchJunctionVols( vector< double >& vols, Id otherCompt )
     const;
 
@@ -185,6 +195,13 @@ private:
     /// Pointer to diffusion solver
     KsolveBase* dsolvePtr_;
 
+    /**
+     * Per pool arrays of the Dsolve state, from getPoolVecs. Refreshed
+     * on each step; empty if the Dsolve doesn't provide them.
+     */
+    vector< double* > diffN_;
+    vector< double* > diffPrev_;
+
     // Timing and benchmarking related variables.
     size_t numSteps_  = 0;
 
@@ -193,6 +210,9 @@ private:
 
     vector<std::pair<size_t, size_t>> intervals_;
 
+    /// Lockstep integrator for groups of voxels, for the batch methods.
+    std::shared_ptr< VoxelBatch > batch_;
+
     //high_resolution_clock::time_point t0_, t1_;
 	
 	static map< Id, unsigned int > defaultPoolLookup_;
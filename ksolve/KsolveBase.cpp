@@ -39,6 +39,25 @@ void KsolveBase::updateJunctions( double dt )
 void KsolveBase::setPrev()
 {;}
 
+void KsolveBase::getPoolVecs( vector< double* >& n, vector< double* >& prev )
+{
+    n.clear();
+    prev.clear();
+}
+
+double* KsolveBase::getStateVec( unsigned int index, unsigned int& size )
+{
+    VoxelPoolsBase* vp = pools( index );
+    if ( !vp )
+    {
+        size = 0;
+        return 0;
+    }
+    vector< double >& s = vp->Svec();
+    size = s.size();
+    return s.data();
+}
+
 /////////////////////////////////////////////////////////////////////
 
 Id KsolveBase::getCompartment() const
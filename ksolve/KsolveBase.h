@@ -125,6 +125,29 @@ public:
 
     /// Used to tell Dsolver to assign 'prev' values.
     virtual void setPrev();
+
+    /**
+     * Direct access to the state of a diffusion solver, so that the
+     * reac solvers can exchange values without going through
+     * getBlock/setBlock. Fills n[pool] with the array of # of molecules
+     * of that pool in each voxel, and prev[pool] with the array of its
+     * values on the previous timestep, which the caller assigns.
+     * The arrays are only good until the solver is rebuilt, so callers
+     * ask again on each step. Solvers without such arrays leave both
+     * vectors empty, and the caller falls back to getBlock/setBlock.
+     */
+    virtual void getPoolVecs( vector< double* >& n, vector< double* >& prev );
+
+    /**
+     * Returns the solver's own array of # of molecules for index, and
+     * sets size to its length, so that callers can view it without
+     * copying. For the reac solvers index is a voxel and the array
+     * holds every pool in it, in Stoich order. For the diffusion solver
+     * index is a pool and the array holds it in every voxel. Returns 0
+     * if there is no such array. Like getPoolVecs, the array is only
+     * good until the solver is rebuilt.
+     */
+    virtual double* getStateVec( unsigned int index, unsigned int& size );
     /**
      * Informs the solver that the rate terms or volumes have changed
      * and that the parameters must be updated.
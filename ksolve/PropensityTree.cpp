@@ -0,0 +1,73 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "PropensityTree.h"
+
+PropensityTree::PropensityTree()
+    : size_( 0 ), numLeaves_( 1 ), node_( 2, 0.0 )
+{;}
+
+void PropensityTree::build( const vector< double >& v )
+{
+    size_ = v.size();
+    numLeaves_ = 1;
+    while ( numLeaves_ < size_ )
+        numLeaves_ *= 2;
+    node_.assign( 2 * numLeaves_, 0.0 );
+    for ( unsigned int i = 0; i < size_; ++i )
+        node_[ numLeaves_ + i ] = fabs( v[i] );
+    for ( unsigned int k = numLeaves_ - 1; k > 0; --k )
+        node_[k] = node_[ 2 * k ] + node_[ 2 * k + 1 ];
+}
+
+void PropensityTree::set( unsigned int i, double a )
+{
+    assert( i < size_ );
+    unsigned int k = numLeaves_ + i;
+    node_[k] = a;
+    for ( k /= 2; k > 0; k /= 2 )
+        node_[k] = node_[ 2 * k ] + node_[ 2 * k + 1 ];
+}
+
+double PropensityTree::get( unsigned int i ) const
+{
+    assert( i < size_ );
+    return node_[ numLeaves_ + i ];
+}
+
+double PropensityTree::total() const
+{
+    return node_[1];
+}
+
+unsigned int PropensityTree::size() const
+{
+    return size_;
+}
+
+unsigned int PropensityTree::pick( double r ) const
+{
+    unsigned int k = 1;
+    while ( k < numLeaves_ )
+    {
+        const double left = node_[ 2 * k ];
+        // If roundoff takes r past the end, stay off empty subtrees.
+        if ( r < left || node_[ 2 * k + 1 ] == 0.0 )
+        {
+            k = 2 * k;
+        }
+        else
+        {
+            r -= left;
+            k = 2 * k + 1;
+        }
+    }
+    return k - numLeaves_;
+}
@@ -0,0 +1,61 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _PROPENSITY_TREE_H
+#define _PROPENSITY_TREE_H
+
+/**
+ * Binary sum tree over the reaction propensities, for picking the next
+ * reaction in the GSSA in log time.
+ *
+ * The leaves hold the propensities and each internal node the sum of
+ * its two children. Changing one propensity recomputes the sums on the
+ * path to the root from the children rather than adding a difference,
+ * so the total does not drift with roundoff as a running atot does.
+ *
+ * pick( r ) returns the same reaction as a linear scan of the
+ * cumulative sums would for the same r, up to roundoff at the
+ * boundaries, so the sampling is unchanged.
+ */
+class PropensityTree
+{
+public:
+    PropensityTree();
+
+    /// Sets up the tree for the propensities |v|
+    void build( const vector< double >& v );
+
+    /// Assigns the propensity of reaction i, and updates the sums.
+    void set( unsigned int i, double a );
+
+    double get( unsigned int i ) const;
+
+    /// Sum of all propensities.
+    double total() const;
+
+    /**
+     * Returns the reaction i such that the sum of the propensities
+     * before it is <= r and the sum including it is > r. Never returns
+     * a reaction with zero propensity. r must be in [0, total).
+     */
+    unsigned int pick( double r ) const;
+
+    unsigned int size() const;
+
+private:
+    unsigned int size_;
+
+    /// Number of leaves, a power of 2. The leaves start at node numLeaves_
+    unsigned int numLeaves_;
+
+    /// Node 1 is the root, node k has children 2k and 2k+1.
+    vector< double > node_;
+};
+
+#endif // _PROPENSITY_TREE_H
@@ -0,0 +1,405 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "RateTerm.h"
+#include "RateKernel.h"
+
+RateKernel::RateKernel()
+    : numRates_( 0 ), numCoeffs_( 0 ), version_( 0 )
+{;}
+
+unsigned int RateKernel::numRates() const
+{
+    return numRates_;
+}
+
+unsigned int RateKernel::numCoeffs() const
+{
+    return numCoeffs_;
+}
+
+unsigned int RateKernel::version() const
+{
+    return version_;
+}
+
+const vector< unsigned int >& RateKernel::getFallbackRates() const
+{
+    return fallbackRates_;
+}
+
+bool RateKernel::isMassAction( const RateTerm* rt )
+{
+    const type_info& t = typeid( *rt );
+    return t == typeid( ZeroOrder ) || t == typeid( FirstOrder ) ||
+           t == typeid( SecondOrder ) || t == typeid( NOrder );
+}
+
+void RateKernel::addOp( Op op, unsigned int rate, double sign,
+                        const vector< unsigned int >& reactants,
+                        unsigned int numCoeffs )
+{
+    if ( op == FallbackOp )
+        fallbackRates_.push_back( rate );
+    op_.push_back( op );
+    rate_.push_back( rate );
+    sign_.push_back( sign );
+    first_.push_back( index_.size() );
+    num_.push_back( reactants.size() );
+    coeff_.push_back( numCoeffs_ );
+    index_.insert( index_.end(), reactants.begin(), reactants.end() );
+    numCoeffs_ += numCoeffs;
+}
+
+void RateKernel::lowerHalf( const ZeroOrder* z, unsigned int rate,
+                            double sign, RateKernel* tables, vector< double >& coeffs )
+{
+    coeffs.push_back( z->getR1() );
+    if ( !tables )
+        return;
+    vector< unsigned int > reactants;
+    z->getReactants( reactants );
+    Op op = NOrderOp;
+    if ( reactants.size() == 0 )
+        op = ZeroOrderOp;
+    else if ( reactants.size() == 1 )
+        op = FirstOrderOp;
+    else if ( reactants.size() == 2 )
+        op = SecondOrderOp;
+    tables->addOp( op, rate, sign, reactants, 1 );
+}
+
+void RateKernel::lower( const RateTerm* rt, unsigned int rate,
+                        RateKernel* tables, vector< double >& coeffs )
+{
+    const type_info& t = typeid( *rt );
+    if ( isMassAction( rt ) )
+    {
+        lowerHalf( static_cast< const ZeroOrder* >( rt ), rate, 1.0,
+                   tables, coeffs );
+        return;
+    }
+    if ( t == typeid( BidirectionalReaction ) )
+    {
+        const BidirectionalReaction* br =
+            static_cast< const BidirectionalReaction* >( rt );
+        if ( isMassAction( br->getForward() ) &&
+                isMassAction( br->getBackward() ) )
+        {
+            lowerHalf( br->getForward(), rate, 1.0, tables, coeffs );
+            lowerHalf( br->getBackward(), rate, -1.0, tables, coeffs );
+            return;
+        }
+    }
+    else if ( t == typeid( MMEnzyme1 ) ||
+              ( t == typeid( MMEnzyme ) && isMassAction(
+                    static_cast< const MMEnzyme* >( rt )->getSubstrates() ) ) )
+    {
+        // Coefficients are Km, kcat, and the scale of the substrate term
+        const MMEnzymeBase* mm = static_cast< const MMEnzymeBase* >( rt );
+        coeffs.push_back( mm->getR1() );
+        coeffs.push_back( mm->getR2() );
+        if ( t == typeid( MMEnzyme ) )
+            coeffs.push_back( static_cast< const MMEnzyme* >( rt )->
+                              getSubstrates()->getR1() );
+        else
+            coeffs.push_back( 1.0 );
+        if ( tables )
+        {
+            vector< unsigned int > reactants;
+            rt->getReactants( reactants ); // Enzyme comes first.
+            tables->addOp( MMEnzOp, rate, 1.0, reactants, 3 );
+        }
+        return;
+    }
+    if ( tables )
+    {
+        vector< unsigned int > reactants;
+        rt->getReactants( reactants );
+        tables->addOp( FallbackOp, rate, 1.0, reactants, 0 );
+    }
+}
+
+void RateKernel::build( const vector< RateTerm* >& rates )
+{
+    op_.clear();
+    rate_.clear();
+    sign_.clear();
+    first_.clear();
+    num_.clear();
+    coeff_.clear();
+    index_.clear();
+    fallbackRates_.clear();
+    dvSlot_.clear();
+    source_.assign( rates.begin(), rates.end() );
+    sourceType_.clear();
+    numCoeffs_ = 0;
+    numRates_ = rates.size();
+    vector< double > coeffs;
+    for ( unsigned int i = 0; i < rates.size(); ++i )
+    {
+        sourceType_.push_back( &typeid( *rates[i] ) );
+        lower( rates[i], i, this, coeffs );
+    }
+    assert( coeffs.size() == numCoeffs_ );
+    buildPartials();
+    ++version_;
+}
+
+void RateKernel::buildPartials()
+{
+    vector< vector< unsigned int > > cols( numRates_ );
+    for ( unsigned int i = 0; i < op_.size(); ++i )
+        for ( unsigned int j = 0; j < num_[i]; ++j )
+            cols[ rate_[i] ].push_back( index_[ first_[i] + j ] );
+
+    dvRowStart_.assign( 1, 0 );
+    dvCol_.clear();
+    for ( unsigned int r = 0; r < numRates_; ++r )
+    {
+        sort( cols[r].begin(), cols[r].end() );
+        cols[r].erase( unique( cols[r].begin(), cols[r].end() ), cols[r].end() );
+        dvCol_.insert( dvCol_.end(), cols[r].begin(), cols[r].end() );
+        dvRowStart_.push_back( dvCol_.size() );
+    }
+
+    dvSlot_.resize( index_.size() );
+    for ( unsigned int i = 0; i < op_.size(); ++i )
+    {
+        vector< unsigned int >::const_iterator b =
+            dvCol_.begin() + dvRowStart_[ rate_[i] ];
+        vector< unsigned int >::const_iterator e =
+            dvCol_.begin() + dvRowStart_[ rate_[i] + 1 ];
+        for ( unsigned int j = first_[i]; j < first_[i] + num_[i]; ++j )
+            dvSlot_[j] = lower_bound( b, e, index_[j] ) - dvCol_.begin();
+    }
+}
+
+const vector< unsigned int >& RateKernel::getPartialsRowStart() const
+{
+    return dvRowStart_;
+}
+
+const vector< unsigned int >& RateKernel::getPartialsCol() const
+{
+    return dvCol_;
+}
+
+bool RateKernel::matches( const vector< RateTerm* >& rates ) const
+{
+    if ( version_ == 0 || rates.size() != source_.size() )
+        return false;
+    for ( unsigned int i = 0; i < rates.size(); ++i )
+    {
+        if ( rates[i] != source_[i] || typeid( *rates[i] ) != *sourceType_[i] )
+            return false;
+    }
+    return true;
+}
+
+bool RateKernel::loadCoeffs( const vector< RateTerm* >& rates,
+                             vector< double >& coeffs ) const
+{
+    if ( rates.size() != numRates_ )
+        return false;
+    for ( unsigned int i = 0; i < rates.size(); ++i )
+        if ( typeid( *rates[i] ) != *sourceType_[i] )
+            return false;
+    coeffs.clear();
+    coeffs.reserve( numCoeffs_ );
+    for ( unsigned int i = 0; i < rates.size(); ++i )
+        lower( rates[i], i, 0, coeffs );
+    return coeffs.size() == numCoeffs_;
+}
+
+void RateKernel::eval( const double* S, const double* coeffs,
+                       const vector< RateTerm* >& rates, double* v ) const
+{
+    for ( unsigned int i = 0; i < numRates_; ++i )
+        v[i] = 0.0;
+
+    const unsigned int numOps = op_.size();
+    for ( unsigned int i = 0; i < numOps; ++i )
+    {
+        const unsigned int* idx = index_.data() + first_[i];
+        const double* c = coeffs + coeff_[i];
+        double r;
+        switch ( op_[i] )
+        {
+        case ZeroOrderOp:
+            r = c[0];
+            break;
+        case FirstOrderOp:
+            r = c[0] * S[ idx[0] ];
+            break;
+        case SecondOrderOp:
+            r = c[0] * S[ idx[0] ] * S[ idx[1] ];
+            break;
+        case NOrderOp:
+            r = c[0];
+            for ( unsigned int j = 0; j < num_[i]; ++j )
+                r *= S[ idx[j] ];
+            break;
+        case MMEnzOp:
+        {
+            double sub = c[2];
+            for ( unsigned int j = 1; j < num_[i]; ++j )
+                sub *= S[ idx[j] ];
+            r = ( sub * c[1] * S[ idx[0] ] ) / ( c[0] + sub );
+            break;
+        }
+        default:
+            r = ( *rates[ rate_[i] ] )( S );
+            break;
+        }
+        assert( !std::isnan( r ) );
+        v[ rate_[i] ] += sign_[i] * r;
+    }
+}
+
+void RateKernel::evalBatch( const double* S, const double* coeffs,
+                            unsigned int width, double* v ) const
+{
+    for ( unsigned int i = 0; i < numRates_ * width; ++i )
+        v[i] = 0.0;
+
+    // The lane loops are innermost and unit stride, so that the compiler
+    // can vectorize them.
+    const unsigned int numOps = op_.size();
+    for ( unsigned int i = 0; i < numOps; ++i )
+    {
+        const unsigned int* idx = index_.data() + first_[i];
+        const double* c = coeffs + coeff_[i] * width;
+        double* vr = v + rate_[i] * width;
+        const double sign = sign_[i];
+        switch ( op_[i] )
+        {
+        case ZeroOrderOp:
+            for ( unsigned int k = 0; k < width; ++k )
+                vr[k] += sign * c[k];
+            break;
+        case FirstOrderOp:
+        {
+            const double* a = S + idx[0] * width;
+            for ( unsigned int k = 0; k < width; ++k )
+                vr[k] += sign * c[k] * a[k];
+            break;
+        }
+        case SecondOrderOp:
+        {
+            const double* a = S + idx[0] * width;
+            const double* b = S + idx[1] * width;
+            for ( unsigned int k = 0; k < width; ++k )
+                vr[k] += sign * c[k] * a[k] * b[k];
+            break;
+        }
+        case NOrderOp:
+            for ( unsigned int k = 0; k < width; ++k )
+            {
+                double r = c[k];
+                for ( unsigned int j = 0; j < num_[i]; ++j )
+                    r *= S[ idx[j] * width + k ];
+                vr[k] += sign * r;
+            }
+            break;
+        case MMEnzOp:
+        {
+            const double* enz = S + idx[0] * width;
+            for ( unsigned int k = 0; k < width; ++k )
+            {
+                double sub = c[ 2 * width + k ];
+                for ( unsigned int j = 1; j < num_[i]; ++j )
+                    sub *= S[ idx[j] * width + k ];
+                vr[k] += ( sub * c[ width + k ] * enz[k] ) /
+                         ( c[k] + sub );
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void RateKernel::evalPartials( double* S, const double* coeffs,
+                               const vector< RateTerm* >& rates, double* dv ) const
+{
+    for ( unsigned int i = 0; i < dvCol_.size(); ++i )
+        dv[i] = 0.0;
+
+    const unsigned int numOps = op_.size();
+    for ( unsigned int i = 0; i < numOps; ++i )
+    {
+        const unsigned int* idx = index_.data() + first_[i];
+        const unsigned int* slot = dvSlot_.data() + first_[i];
+        const double* c = coeffs + coeff_[i];
+        const double sign = sign_[i];
+        const unsigned int num = num_[i];
+        switch ( op_[i] )
+        {
+        case ZeroOrderOp:
+            break;
+        case FirstOrderOp:
+            dv[ slot[0] ] += sign * c[0];
+            break;
+        case SecondOrderOp:
+            dv[ slot[0] ] += sign * c[0] * S[ idx[1] ];
+            dv[ slot[1] ] += sign * c[0] * S[ idx[0] ];
+            break;
+        case NOrderOp:
+            // Product of all the other terms, so a zero conc is harmless.
+            for ( unsigned int j = 0; j < num; ++j )
+            {
+                double d = sign * c[0];
+                for ( unsigned int k = 0; k < num; ++k )
+                    if ( k != j )
+                        d *= S[ idx[k] ];
+                dv[ slot[j] ] += d;
+            }
+            break;
+        case MMEnzOp:
+        {
+            // v = kcat.enz.sub/(Km + sub)
+            double sub = c[2];
+            for ( unsigned int j = 1; j < num; ++j )
+                sub *= S[ idx[j] ];
+            const double denom = c[0] + sub;
+            dv[ slot[0] ] += c[1] * sub / denom;
+            const double dsub = c[1] * S[ idx[0] ] * c[0] / ( denom * denom );
+            for ( unsigned int j = 1; j < num; ++j )
+            {
+                double d = dsub * c[2];
+                for ( unsigned int k = 1; k < num; ++k )
+                    if ( k != j )
+                        d *= S[ idx[k] ];
+                dv[ slot[j] ] += d;
+            }
+            break;
+        }
+        default:
+        {
+            const RateTerm& rt = *rates[ rate_[i] ];
+            const double v0 = rt( S );
+            for ( unsigned int j = 0; j < num; ++j )
+            {
+                // Skip repeats of a reactant, the first one got it all.
+                if ( find( slot, slot + j, slot[j] ) != slot + j )
+                    continue;
+                const double orig = S[ idx[j] ];
+                const double delta = 1e-7 * max( fabs( orig ), 1.0 );
+                S[ idx[j] ] = orig + delta;
+                dv[ slot[j] ] += ( rt( S ) - v0 ) / delta;
+                S[ idx[j] ] = orig;
+            }
+            break;
+        }
+        }
+    }
+}
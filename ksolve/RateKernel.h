@@ -0,0 +1,158 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _RATE_KERNEL_H
+#define _RATE_KERNEL_H
+
+#include <typeinfo>
+#include <vector>
+
+class RateTerm;
+class ZeroOrder;
+
+/**
+ * Flattened form of the RateTerm vector, for fast evaluation of the
+ * reaction velocities in the ODE right-hand side.
+ *
+ * Stoich lowers its master rates_ vector into a set of opcode tables,
+ * one entry per half-reaction, stored structure-of-arrays. The
+ * structure (ops, reactant indices) depends only on the reaction
+ * network and is shared by all voxels. The rate constants depend on
+ * voxel volume, so each voxel keeps its own coefficient array, filled
+ * from its volume-scaled copy of the RateTerms by loadCoeffs.
+ *
+ * Terms that cannot be lowered (function-controlled rates, the
+ * stochastic variants, Flux) are kept as Fallback ops, and are
+ * evaluated through the voxel's own RateTerm.
+ */
+class RateKernel
+{
+public:
+    RateKernel();
+
+    /// Lowers the RateTerms into opcode tables.
+    void build( const std::vector< RateTerm* >& rates );
+
+    /**
+     * True if the kernel was built from exactly this set of RateTerm
+     * objects, so it need not be rebuilt.
+     */
+    bool matches( const std::vector< RateTerm* >& rates ) const;
+
+    /**
+     * Extracts the coefficients for each op from a (volume-scaled)
+     * copy of the RateTerms that was used to build the kernel.
+     * Returns false if the copy does not have the same structure.
+     */
+    bool loadCoeffs( const std::vector< RateTerm* >& rates,
+                     std::vector< double >& coeffs ) const;
+
+    /**
+     * Computes the velocity v of every reaction from the pool vector S.
+     * v must have room for numRates() entries. Does not allocate.
+     */
+    void eval( const double* S, const double* coeffs,
+               const std::vector< RateTerm* >& rates, double* v ) const;
+
+    /**
+     * Batched form of eval, for integrating several voxels in lockstep.
+     * S, coeffs and v are interleaved with the voxel as the fastest
+     * varying index: S[ pool * width + lane ]. Fallback ops are
+     * skipped, their entries in v are left at zero for the caller to
+     * fill in using getFallbackRates.
+     */
+    void evalBatch( const double* S, const double* coeffs,
+                    unsigned int width, double* v ) const;
+
+    /**
+     * Computes the partial derivatives dv/dS of the reaction
+     * velocities, in the compressed row pattern given by
+     * getPartialsRowStart and getPartialsCol (one row per rate). The
+     * mass action and enzyme terms are differentiated analytically,
+     * fallback terms by finite differences on their reactants. S is
+     * perturbed for the latter, and restored on return.
+     */
+    void evalPartials( double* S, const double* coeffs,
+                       const std::vector< RateTerm* >& rates,
+                       double* dv ) const;
+
+    const std::vector< unsigned int >& getPartialsRowStart() const;
+    const std::vector< unsigned int >& getPartialsCol() const;
+
+    /// Indices of the rates that are handled by Fallback ops.
+    const std::vector< unsigned int >& getFallbackRates() const;
+
+    unsigned int numRates() const;
+    unsigned int numCoeffs() const;
+
+    /**
+     * Incremented whenever the kernel is rebuilt, so that voxels can
+     * tell if their coefficient array is out of date.
+     */
+    unsigned int version() const;
+
+    enum Op
+    {
+        ZeroOrderOp,    // k
+        FirstOrderOp,   // k.S[a]
+        SecondOrderOp,  // k.S[a].S[b]
+        NOrderOp,       // k.S[a].S[b]...
+        MMEnzOp,        // kcat.S[enz].sub/(Km + sub), sub = ks.S[a]...
+        FallbackOp      // RateTerm::operator(), reactants for dv/dS
+    };
+
+private:
+    /// Returns false if the term must be handled by a Fallback op.
+    static bool isMassAction( const RateTerm* rt );
+
+    /**
+     * Lowers one RateTerm, appending its coefficients. If tables is
+     * not null the ops are appended to its tables as well.
+     */
+    static void lower( const RateTerm* rt, unsigned int rate,
+                RateKernel* tables, std::vector< double >& coeffs );
+    static void lowerHalf( const ZeroOrder* z, unsigned int rate,
+                double sign, RateKernel* tables,
+                std::vector< double >& coeffs );
+    void addOp( Op op, unsigned int rate, double sign,
+                const std::vector< unsigned int >& reactants,
+                unsigned int numCoeffs );
+
+    unsigned int numRates_;
+    unsigned int numCoeffs_;
+    unsigned int version_;
+
+    // One entry per op.
+    std::vector< unsigned char > op_;
+    std::vector< unsigned int > rate_;  // Index of reaction velocity.
+    std::vector< double > sign_;        // +1 forward, -1 backward.
+    std::vector< unsigned int > first_; // Offset into index_
+    std::vector< unsigned int > num_;   // Number of entries in index_
+    std::vector< unsigned int > coeff_; // Offset into coeffs.
+
+    /// Reactant indices of all ops. For MMEnzOp the enzyme comes first.
+    std::vector< unsigned int > index_;
+
+    std::vector< unsigned int > fallbackRates_;
+
+    /// Pattern of dv/dS, one row per rate.
+    std::vector< unsigned int > dvRowStart_;
+    std::vector< unsigned int > dvCol_;
+
+    /// Entry in dv for the derivative wrt each reactant in index_.
+    std::vector< unsigned int > dvSlot_;
+
+    void buildPartials();
+
+    /// The terms the kernel was built from, to detect changes.
+    std::vector< const RateTerm* > source_;
+    std::vector< const std::type_info* > sourceType_;
+};
+
+#endif // _RATE_KERNEL_H
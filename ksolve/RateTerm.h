@@ -207,6 +207,12 @@ public:
         return molIndex.size();
     }
 
+    /// The term computing the substrate product.
+    const RateTerm* getSubstrates() const
+    {
+        return substrates_;
+    }
+
     RateTerm* copyWithVolScaling(
         double vol, double sub, double prd ) const
     {
@@ -631,6 +637,16 @@ public:
         return backward_->getR1();
     }
 
+    const ZeroOrder* getForward() const
+    {
+        return forward_;
+    }
+
+    const ZeroOrder* getBackward() const
+    {
+        return backward_;
+    }
+
     unsigned int getReactants( vector< unsigned int >& molIndex ) const
     {
         forward_->getReactants( molIndex );
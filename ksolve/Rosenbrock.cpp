@@ -0,0 +1,249 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "Rosenbrock.h"
+
+using namespace std;
+
+namespace
+{
+/**
+ * Coefficients of ROS34PW2, transformed as in Hairer and Wanner,
+ * Solving ODEs II, section IV.7, so that a step needs no products with
+ * the Jacobian:
+ * (I/(h.gamma) - J) u_i = f( y + sum_j a_ij u_j ) + sum_j c_ij u_j / h
+ * y1 = y + sum_i m_i u_i
+ */
+struct Ros34pw2
+{
+    static const unsigned int S = 4;
+    double gamma;
+    double alpha[S];        // Stage times
+    double a[S][S];
+    double c[S][S];
+    double m[S];
+    double e[S];            // m - mhat, for the error estimate
+
+    Ros34pw2()
+    {
+        gamma = 4.3586652150845900e-01;
+        const double alphaIJ[S][S] = {
+            { 0, 0, 0, 0 },
+            { 8.7173304301691801e-01, 0, 0, 0 },
+            { 8.4457060015369423e-01, -1.1299064236484185e-01, 0, 0 },
+            { 0, 0, 1, 0 } };
+        const double gammaIJ[S][S] = {
+            { gamma, 0, 0, 0 },
+            { -8.7173304301691801e-01, gamma, 0, 0 },
+            { -9.0338057013044082e-01, 5.4180672388095326e-02, gamma, 0 },
+            { 2.4212380706095346e-01, -1.2232505839045147e+00,
+                5.4526025533510214e-01, gamma } };
+        const double b[S] = { 2.4212380706095346e-01,
+            -1.2232505839045147e+00, 1.5452602553351020e+00,
+            4.3586652150845900e-01 };
+        const double bhat[S] = { 3.7810903145819369e-01,
+            -9.6042292212423178e-02, 5.0000000000000000e-01,
+            2.1793326075422950e-01 };
+
+        // Inverse of the lower triangular gammaIJ.
+        double g[S][S] = { { 0 } };
+        for ( unsigned int i = 0; i < S; ++i )
+        {
+            g[i][i] = 1.0 / gammaIJ[i][i];
+            for ( unsigned int j = 0; j < i; ++j )
+            {
+                double sum = 0.0;
+                for ( unsigned int k = j; k < i; ++k )
+                    sum += gammaIJ[i][k] * g[k][j];
+                g[i][j] = -sum / gammaIJ[i][i];
+            }
+        }
+        for ( unsigned int i = 0; i < S; ++i )
+        {
+            alpha[i] = 0.0;
+            for ( unsigned int j = 0; j < S; ++j )
+            {
+                alpha[i] += alphaIJ[i][j];
+                a[i][j] = 0.0;
+                for ( unsigned int k = 0; k < S; ++k )
+                    a[i][j] += alphaIJ[i][k] * g[k][j];
+                c[i][j] = ( i == j ? 1.0 / gamma : 0.0 ) - g[i][j];
+            }
+            m[i] = 0.0;
+            e[i] = 0.0;
+        }
+        for ( unsigned int j = 0; j < S; ++j )
+        {
+            for ( unsigned int i = 0; i < S; ++i )
+            {
+                m[j] += b[i] * g[i][j];
+                e[j] += ( b[i] - bhat[i] ) * g[i][j];
+            }
+        }
+    }
+};
+
+const Ros34pw2& coeffs()
+{
+    static const Ros34pw2 ret;
+    return ret;
+}
+}
+
+Rosenbrock::Rosenbrock()
+    : n_( 0 ),
+      rhs_( nullptr ),
+      jac_( nullptr ),
+      params_( nullptr ),
+      epsAbs_( 1e-6 ),
+      epsRel_( 1e-6 ),
+      h_( 0.001 ),
+      numSteps_( 0 ),
+      numRejected_( 0 )
+{;}
+
+void Rosenbrock::setSystem( unsigned int n, const vector< unsigned int >& rowStart,
+                            const vector< unsigned int >& colIndex,
+                            RhsFunc rhs, JacFunc jac, void* params )
+{
+    n_ = n;
+    rhs_ = rhs;
+    jac_ = jac;
+    params_ = params;
+    diag_.resize( n );
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+        vector< unsigned int >::const_iterator p = find(
+            colIndex.begin() + rowStart[i], colIndex.begin() + rowStart[i + 1], i );
+        assert( p != colIndex.begin() + rowStart[i + 1] );
+        diag_[i] = p - colIndex.begin();
+    }
+    lu_.analyse( n, rowStart, colIndex );
+    jacValues_.assign( colIndex.size(), 0.0 );
+    matrix_.assign( colIndex.size(), 0.0 );
+    for ( unsigned int i = 0; i < NumStages; ++i )
+        u_[i].assign( n, 0.0 );
+    ystage_.assign( n, 0.0 );
+    yNew_.assign( n, 0.0 );
+}
+
+void Rosenbrock::setTolerances( double epsAbs, double epsRel )
+{
+    epsAbs_ = epsAbs;
+    epsRel_ = epsRel;
+}
+
+void Rosenbrock::reset( double hStart )
+{
+    h_ = hStart;
+}
+
+unsigned int Rosenbrock::size() const
+{
+    return n_;
+}
+
+unsigned int Rosenbrock::getNumSteps() const
+{
+    return numSteps_;
+}
+
+unsigned int Rosenbrock::getNumRejected() const
+{
+    return numRejected_;
+}
+
+double Rosenbrock::step( double t, double h, const double* y, double* yNew )
+{
+    const Ros34pw2& r = coeffs();
+    const double diag = 1.0 / ( h * r.gamma );
+    for ( unsigned int k = 0; k < matrix_.size(); ++k )
+        matrix_[k] = -jacValues_[k];
+    for ( unsigned int i = 0; i < n_; ++i )
+        matrix_[ diag_[i] ] += diag;
+    if ( !lu_.factor( matrix_.data() ) )
+        return -1.0;
+
+    for ( unsigned int s = 0; s < NumStages; ++s )
+    {
+        for ( unsigned int i = 0; i < n_; ++i )
+        {
+            double sum = y[i];
+            for ( unsigned int j = 0; j < s; ++j )
+                sum += r.a[s][j] * u_[j][i];
+            ystage_[i] = sum;
+        }
+        double* u = u_[s].data();
+        rhs_( t + r.alpha[s] * h, ystage_.data(), u, params_ );
+        for ( unsigned int i = 0; i < n_; ++i )
+        {
+            double sum = 0.0;
+            for ( unsigned int j = 0; j < s; ++j )
+                sum += r.c[s][j] * u_[j][i];
+            u[i] += sum / h;
+        }
+        lu_.solve( u );
+    }
+
+    double err = 0.0;
+    for ( unsigned int i = 0; i < n_; ++i )
+    {
+        double sum = y[i];
+        double e = 0.0;
+        for ( unsigned int s = 0; s < NumStages; ++s )
+        {
+            sum += r.m[s] * u_[s][i];
+            e += r.e[s] * u_[s][i];
+        }
+        yNew[i] = sum;
+        double scale = epsAbs_ + epsRel_ * max( fabs( y[i] ), fabs( sum ) );
+        err = max( err, fabs( e ) / scale );
+    }
+    if ( !std::isfinite( err ) )
+        return -1.0;
+    return err;
+}
+
+bool Rosenbrock::apply( double& t, double tEnd, double* y )
+{
+    bool newJacobian = true;
+    while ( t < tEnd )
+    {
+        if ( h_ < 1e-14 * max( 1.0, fabs( t ) ) )
+            return false;
+        const double h = min( h_, tEnd - t );
+        if ( newJacobian )
+            jac_( t, y, jacValues_.data(), params_ );
+        double err = step( t, h, y, yNew_.data() );
+        if ( err >= 0.0 && err <= 1.0 )
+        {
+            t = ( h == tEnd - t ) ? tEnd : t + h;
+            copy( yNew_.begin(), yNew_.end(), y );
+            newJacobian = true;
+            ++numSteps_;
+            // Don't let the truncated last step shrink the next start.
+            if ( h == h_ )
+                h_ = h * min( 5.0, 0.9 * pow( max( err, 1e-10 ), -1.0 / 3.0 ) );
+        }
+        else
+        {
+            // The Jacobian at y is still good for the retry.
+            newJacobian = false;
+            ++numRejected_;
+            if ( err < 0.0 )
+                h_ = h * 0.25;
+            else
+                h_ = h * max( 0.2, 0.9 * pow( err, -1.0 / 3.0 ) );
+        }
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _ROSENBROCK_H
+#define _ROSENBROCK_H
+
+#include "SparseLU.h"
+
+/**
+ * Adaptive stiff integrator using the ROS34PW2 Rosenbrock-W method of
+ * Rang and Angermann (2005): 4 stages, order 3 with an embedded order 2
+ * solution for step control, stiffly accurate.
+ *
+ * Each step takes one Jacobian and one sparse LU factorization of
+ * (I/(h.gamma) - J), with no Newton iterations. Being a W-method it
+ * keeps its order even if the Jacobian is approximate, as it is where
+ * FuncTerms feed back into the reactions.
+ *
+ * The system is supplied as callbacks in the same style as the GSL and
+ * LSODA ones, with the Jacobian in a fixed sparse pattern which must
+ * include the diagonal.
+ */
+class Rosenbrock
+{
+public:
+    typedef void ( *RhsFunc )( double t, const double* y, double* dydt,
+                               void* params );
+    typedef void ( *JacFunc )( double t, const double* y, double* jac,
+                               void* params );
+
+    Rosenbrock();
+
+    void setSystem( unsigned int n, const std::vector< unsigned int >& rowStart,
+                    const std::vector< unsigned int >& colIndex,
+                    RhsFunc rhs, JacFunc jac, void* params );
+    void setTolerances( double epsAbs, double epsRel );
+
+    /// Forgets the step size, so the next apply starts with hStart.
+    void reset( double hStart );
+
+    /**
+     * Advances y from t to tEnd, updating t. Returns false if the step
+     * size became too small.
+     */
+    bool apply( double& t, double tEnd, double* y );
+
+    unsigned int size() const;
+    unsigned int getNumSteps() const;
+    unsigned int getNumRejected() const;
+
+private:
+    static const unsigned int NumStages = 4;
+
+    /**
+     * Tries one step of size h from y using the Jacobian in jacValues_,
+     * and returns the scaled error, or a negative value if the
+     * iteration matrix is singular.
+     */
+    double step( double t, double h, const double* y, double* yNew );
+
+    unsigned int n_;
+    RhsFunc rhs_;
+    JacFunc jac_;
+    void* params_;
+    double epsAbs_;
+    double epsRel_;
+    double h_;
+
+    unsigned int numSteps_;
+    unsigned int numRejected_;
+
+    std::vector< unsigned int > diag_; // Diagonal positions in pattern.
+    std::vector< double > jacValues_;
+    std::vector< double > matrix_;
+    std::vector< double > u_[ NumStages ];
+    std::vector< double > ystage_;
+    std::vector< double > yNew_;
+    SparseLU lu_;
+};
+
+#endif // _ROSENBROCK_H
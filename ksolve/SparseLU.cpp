@@ -0,0 +1,183 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <set>
+#include "SparseLU.h"
+
+using namespace std;
+
+SparseLU::SparseLU()
+    : n_( 0 )
+{;}
+
+unsigned int SparseLU::size() const
+{
+    return n_;
+}
+
+unsigned int SparseLU::numFactorEntries() const
+{
+    return col_.size();
+}
+
+void SparseLU::analyse( unsigned int n, const vector< unsigned int >& rowStart,
+                        const vector< unsigned int >& colIndex )
+{
+    assert( rowStart.size() == n + 1 );
+    n_ = n;
+
+    // Symmetrized adjacency, without the diagonal.
+    vector< set< unsigned int > > adj( n );
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+        for ( unsigned int k = rowStart[i]; k < rowStart[i + 1]; ++k )
+        {
+            unsigned int j = colIndex[k];
+            if ( j != i )
+            {
+                adj[i].insert( j );
+                adj[j].insert( i );
+            }
+        }
+    }
+
+    // Greedy minimum degree elimination. The neighbours of a node when
+    // it is eliminated are exactly the columns of its U row and the
+    // rows of its L column, fill-in included.
+    perm_.clear();
+    vector< unsigned int > order( n, ~0U );
+    vector< vector< unsigned int > > later( n ); // By original index
+    vector< bool > done( n, false );
+    for ( unsigned int k = 0; k < n; ++k )
+    {
+        unsigned int best = ~0U;
+        for ( unsigned int i = 0; i < n; ++i )
+            if ( !done[i] && ( best == ~0U || adj[i].size() < adj[best].size() ) )
+                best = i;
+        perm_.push_back( best );
+        order[best] = k;
+        done[best] = true;
+        later[best].assign( adj[best].begin(), adj[best].end() );
+        for ( unsigned int a : adj[best] )
+        {
+            adj[a].erase( best );
+            for ( unsigned int b : adj[best] )
+                if ( a != b )
+                    adj[a].insert( b );
+        }
+        adj[best].clear();
+    }
+
+    // Row k of the factors holds L entries ( k, j < k ), the diagonal
+    // and U entries ( k, j > k ). The pattern is symmetric.
+    vector< vector< unsigned int > > rows( n );
+    for ( unsigned int k = 0; k < n; ++k )
+    {
+        rows[k].push_back( k );
+        for ( unsigned int j : later[ perm_[k] ] )
+        {
+            rows[k].push_back( order[j] );
+            rows[ order[j] ].push_back( k );
+        }
+    }
+    rowStart_.assign( 1, 0 );
+    col_.clear();
+    diag_.resize( n );
+    for ( unsigned int k = 0; k < n; ++k )
+    {
+        sort( rows[k].begin(), rows[k].end() );
+        for ( unsigned int j : rows[k] )
+        {
+            if ( j == k )
+                diag_[k] = col_.size();
+            col_.push_back( j );
+        }
+        rowStart_.push_back( col_.size() );
+    }
+    lu_.assign( col_.size(), 0.0 );
+    work_.assign( n, 0.0 );
+
+    inputPos_.resize( colIndex.size() );
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+        unsigned int r = order[i];
+        for ( unsigned int k = rowStart[i]; k < rowStart[i + 1]; ++k )
+        {
+            unsigned int c = order[ colIndex[k] ];
+            vector< unsigned int >::const_iterator p = lower_bound(
+                col_.begin() + rowStart_[r], col_.begin() + rowStart_[r + 1], c );
+            assert( p != col_.begin() + rowStart_[r + 1] && *p == c );
+            inputPos_[k] = p - col_.begin();
+        }
+    }
+}
+
+bool SparseLU::factor( const double* values )
+{
+    fill( lu_.begin(), lu_.end(), 0.0 );
+    for ( unsigned int k = 0; k < inputPos_.size(); ++k )
+        lu_[ inputPos_[k] ] += values[k];
+
+    // Row by row Doolittle elimination, using work_ as a dense row.
+    for ( unsigned int i = 0; i < n_; ++i )
+    {
+        const unsigned int begin = rowStart_[i];
+        const unsigned int end = rowStart_[i + 1];
+        for ( unsigned int p = begin; p < end; ++p )
+            work_[ col_[p] ] = lu_[p];
+        for ( unsigned int p = begin; p < diag_[i]; ++p )
+        {
+            const unsigned int k = col_[p];
+            const double l = work_[k] / lu_[ diag_[k] ];
+            work_[k] = l;
+            for ( unsigned int q = diag_[k] + 1; q < rowStart_[k + 1]; ++q )
+                work_[ col_[q] ] -= l * lu_[q];
+        }
+        for ( unsigned int p = begin; p < end; ++p )
+        {
+            lu_[p] = work_[ col_[p] ];
+            work_[ col_[p] ] = 0.0;
+        }
+        const double d = lu_[ diag_[i] ];
+        if ( d == 0.0 || !std::isfinite( d ) )
+            return false;
+    }
+    return true;
+}
+
+void SparseLU::solve( double* b ) const
+{
+    double* x = work_.data();
+    for ( unsigned int k = 0; k < n_; ++k )
+        x[k] = b[ perm_[k] ];
+    // Forward substitution with unit lower triangle.
+    for ( unsigned int i = 0; i < n_; ++i )
+    {
+        double sum = x[i];
+        for ( unsigned int p = rowStart_[i]; p < diag_[i]; ++p )
+            sum -= lu_[p] * x[ col_[p] ];
+        x[i] = sum;
+    }
+    // Back substitution.
+    for ( unsigned int i = n_; i-- > 0; )
+    {
+        double sum = x[i];
+        for ( unsigned int p = diag_[i] + 1; p < rowStart_[i + 1]; ++p )
+            sum -= lu_[p] * x[ col_[p] ];
+        x[i] = sum / lu_[ diag_[i] ];
+    }
+    for ( unsigned int k = 0; k < n_; ++k )
+    {
+        b[ perm_[k] ] = x[k];
+        x[k] = 0.0;
+    }
+}
@@ -0,0 +1,73 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _SPARSE_LU_H
+#define _SPARSE_LU_H
+
+#include <vector>
+
+/**
+ * LU factorization of a square sparse matrix whose pattern stays fixed
+ * while its values change, as for the iteration matrix of a stiff
+ * integrator.
+ *
+ * analyse() is done once per pattern. It picks a minimum degree
+ * elimination order on the symmetrized pattern and works out the
+ * fill-in, so that factor() and solve() only touch precomputed
+ * entries. There is no pivoting: the matrices this is meant for,
+ * (I/(h.gamma) - J), have a dominant diagonal. factor() reports a zero
+ * pivot so that the caller can retry with a smaller step.
+ */
+class SparseLU
+{
+public:
+    SparseLU();
+
+    /**
+     * Sets up the pattern, given in compressed row form. Every row
+     * must have its diagonal entry.
+     */
+    void analyse( unsigned int n, const std::vector< unsigned int >& rowStart,
+                  const std::vector< unsigned int >& colIndex );
+
+    /**
+     * Factors the matrix whose entries, in the order of the pattern
+     * given to analyse, are in values. Returns false on a zero pivot.
+     */
+    bool factor( const double* values );
+
+    /// Solves A.x = b in place.
+    void solve( double* b ) const;
+
+    unsigned int size() const;
+
+    /// Number of entries in the factors, including fill-in.
+    unsigned int numFactorEntries() const;
+
+private:
+    unsigned int n_;
+
+    /// perm_[k] is the original row/column eliminated k-th.
+    std::vector< unsigned int > perm_;
+
+    // Combined L\U factors by row, in elimination order. Columns in
+    // each row are sorted, L (unit diagonal, not stored) before U.
+    std::vector< unsigned int > rowStart_;
+    std::vector< unsigned int > col_;
+    std::vector< unsigned int > diag_;  // Position of the diagonal.
+    std::vector< double > lu_;
+
+    /// Where each input entry goes in lu_.
+    std::vector< unsigned int > inputPos_;
+
+    /// Dense row used during factoring and solving.
+    mutable std::vector< double > work_;
+};
+
+#endif // _SPARSE_LU_H
@@ -555,6 +555,21 @@ const vector<RateTerm*>& Stoich::getRateTerms() const
     return rates_;
 }
 
+const RateKernel& Stoich::getRateKernel() const
+{
+    if(!rateKernel_.matches(rates_))
+        rateKernel_.build(rates_);
+    return rateKernel_;
+}
+
+const KinJacobian& Stoich::getJacobian() const
+{
+    const RateKernel& rk = getRateKernel();
+    if(jacobian_.getKernelVersion() != rk.version())
+        jacobian_.build(N_, getNumVarPools() + getNumProxyPools(), rk);
+    return jacobian_;
+}
+
 unsigned int Stoich::getNumFuncs() const
 {
     return funcs_.size();
@@ -1933,6 +1948,28 @@ void Stoich::updateFuncs(double* s, double t) const
             (*i)->evalPool(s, t);
 }
 
+bool Stoich::funcsCompiled() const
+{
+    for(auto i = funcs_.cbegin(); i != funcs_.end(); ++i)
+        if(*i && !(*i)->isCompiled())
+            return false;
+    return true;
+}
+
+void Stoich::updateFuncsBatch(double* y, unsigned int width, double t,
+                              vector<double>& scratch) const
+{
+    for(auto i = funcs_.cbegin(); i != funcs_.end(); ++i)
+    {
+        if(!*i)
+            continue;
+        unsigned int n = (*i)->scratchSize(width);
+        if(scratch.size() < n)
+            scratch.resize(n);
+        (*i)->evalPoolBatch(y, width, t, scratch.data());
+    }
+}
+
 /**
  * updateJunctionRates:
  * Updates the rates for cross-compartment reactions. These are located
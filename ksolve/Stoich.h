@@ -10,6 +10,9 @@
 #ifndef _STOICH_H
 #define _STOICH_H
 
+#include "RateKernel.h"
+#include "KinJacobian.h"
+
 /**
  * Stoich is the class that handles the stoichiometry matrix for a
  * reaction system, and also setting up the computations for reaction
@@ -137,6 +140,19 @@ public:
     /// Returns a reference to the entire rates_ vector.
     const vector<RateTerm*>& getRateTerms() const;
 
+    /**
+     * Returns the rates_ vector lowered into flat opcode tables for
+     * fast evaluation. Rebuilt here if the RateTerms have been
+     * replaced since it was last built.
+     */
+    const RateKernel& getRateKernel() const;
+
+    /**
+     * Returns the sparse Jacobian of the variable pools, for the
+     * stiff methods. Rebuilt along with the RateKernel.
+     */
+    const KinJacobian& getJacobian() const;
+
     unsigned int getNumFuncs() const;
     const FuncTerm* funcs(unsigned int i) const;
     /// Returns true if the specified pool is controlled by a func
@@ -460,6 +476,16 @@ public:
     /// Updates the function values, within s.
     void updateFuncs(double* s, double t) const;
 
+    /// True if every FuncTerm is compiled, so updateFuncsBatch can be used.
+    bool funcsCompiled() const;
+
+    /**
+     * Updates the function values of width voxels at once, laid out
+     * as in VoxelBatch. scratch is resized as needed.
+     */
+    void updateFuncsBatch(double* y, unsigned int width, double t,
+                          vector<double>& scratch) const;
+
     /// Updates the rates for cross-compartment reactions.
     /*
     void updateJunctionRates( const double* s,
@@ -552,6 +578,12 @@ private:
      */
     vector<RateTerm*> rates_;
 
+    /// Lowered form of rates_, built on demand by getRateKernel.
+    mutable RateKernel rateKernel_;
+
+    /// Built on demand by getJacobian.
+    mutable KinJacobian jacobian_;
+
     /**
      * This tracks the unique volumes handled by the reac system.
      * Maps one-to-one with the vector of vector of RateTerms.
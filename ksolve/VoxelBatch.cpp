@@ -0,0 +1,356 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "../basecode/header.h"
+#include "../basecode/SparseMatrix.h"
+#include "OdeSystem.h"
+#include "VoxelPoolsBase.h"
+#include "VoxelPools.h"
+#include "RateTerm.h"
+#include "FuncTerm.h"
+#include "KinSparseMatrix.h"
+#include "XferInfo.h"
+#include "KsolveBase.h"
+#include "Stoich.h"
+#include "VoxelBatch.h"
+
+// Same cap on the step as the constant step odeint methods.
+static const double FIXED_DT = 0.1;
+static const double MIN_DT = 1e-12;
+
+VoxelBatch::VoxelBatch()
+    : adaptive_( true ),
+      epsAbs_( 1e-7 ),
+      epsRel_( 1e-7 ),
+      initDt_( 0.01 ),
+      stoich_( nullptr ),
+      pools_( nullptr ),
+      start_( 0 ),
+      numAll_( 0 ),
+      numVar_( 0 ),
+      needsGather_( false ),
+      batchFuncs_( false )
+{;}
+
+bool VoxelBatch::isBatchMethod( const string& method )
+{
+    return method == "rk4batch" || method == "rkckbatch";
+}
+
+void VoxelBatch::setMethod( const string& method )
+{
+    adaptive_ = ( method != "rk4batch" );
+}
+
+void VoxelBatch::setTolerances( double epsAbs, double epsRel )
+{
+    epsAbs_ = epsAbs;
+    epsRel_ = epsRel;
+}
+
+void VoxelBatch::reinit( double dt )
+{
+    initDt_ = dt / 10.0;
+    hStart_.clear();
+}
+
+//////////////////////////////////////////////////////////////
+// Packing
+//////////////////////////////////////////////////////////////
+
+bool VoxelBatch::pack( const vector< VoxelPools >& pools, unsigned int start )
+{
+    const RateKernel& rk = stoich_->getRateKernel();
+    const unsigned int nc = rk.numCoeffs();
+    const unsigned int last = pools.size() - 1;
+    for ( unsigned int lane = 0; lane < Width; ++lane )
+    {
+        // Spare lanes of the last group repeat its last voxel.
+        const VoxelPools& vp = pools[ min( start + lane, last ) ];
+        const double* c = vp.getRateCoeffs();
+        if ( !c )
+            return false;
+        for ( unsigned int i = 0; i < nc; ++i )
+            coeffs_[ i * Width + lane ] = c[i];
+        const double* s = const_cast< VoxelPools& >( vp ).varS();
+        for ( unsigned int i = 0; i < numAll_; ++i )
+            y_[ i * Width + lane ] = s[i];
+    }
+    return true;
+}
+
+void VoxelBatch::unpack( vector< VoxelPools >& pools, unsigned int start ) const
+{
+    const bool clamp = !stoich_->getAllowNegative();
+    const unsigned int numVarPools = stoich_->getNumVarPools();
+    const unsigned int end = min( start + Width, ( unsigned int )pools.size() );
+    for ( unsigned int v = start; v < end; ++v )
+    {
+        const unsigned int lane = v - start;
+        double* s = pools[v].varS();
+        for ( unsigned int i = 0; i < numAll_; ++i )
+            s[i] = y_[ i * Width + lane ];
+        if ( clamp )   // clean out negatives
+        {
+            for ( unsigned int i = 0; i < numVarPools; ++i )
+                if ( std::signbit( s[i] ) )
+                    s[i] = 0.0;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////
+// Right hand side
+//////////////////////////////////////////////////////////////
+
+void VoxelBatch::rhs( double t, double* y, double* dydt )
+{
+    const RateKernel& rk = stoich_->getRateKernel();
+    const vector< unsigned int >& fallback = rk.getFallbackRates();
+    const unsigned int last = pools_->size() - 1;
+
+    if ( batchFuncs_ )
+        stoich_->updateFuncsBatch( y, Width, t, funcScratch_ );
+
+    // Parsed FuncTerms and fallback RateTerms only know a single voxel,
+    // so they each get a copy of their voxel's state.
+    if ( needsGather_ )
+    {
+        for ( unsigned int lane = 0; lane < Width; ++lane )
+        {
+            double* s = &laneS_[ lane * numAll_ ];
+            for ( unsigned int i = 0; i < numAll_; ++i )
+                s[i] = y[ i * Width + lane ];
+            if ( !batchFuncs_ )
+            {
+                stoich_->updateFuncs( s, t );
+                for ( unsigned int i = 0; i < numAll_; ++i )
+                    y[ i * Width + lane ] = s[i];
+            }
+        }
+    }
+
+    rk.evalBatch( y, coeffs_.data(), Width, v_.data() );
+
+    for ( unsigned int lane = 0; lane < Width && !fallback.empty(); ++lane )
+    {
+        const vector< RateTerm* >& rates =
+            ( *pools_ )[ min( start_ + lane, last ) ].getRateTerms();
+        const double* s = &laneS_[ lane * numAll_ ];
+        for ( unsigned int r : fallback )
+            v_[ r * Width + lane ] = ( *rates[r] )( s );
+    }
+
+    const KinSparseMatrix& N = stoich_->getStoichiometryMatrix();
+    for ( unsigned int i = 0; i < numVar_; ++i )
+    {
+        double* d = dydt + i * Width;
+        for ( unsigned int k = 0; k < Width; ++k )
+            d[k] = 0.0;
+        const int* entry = 0;
+        const unsigned int* colIndex = 0;
+        unsigned int numEntries = N.getRow( i, &entry, &colIndex );
+        for ( unsigned int j = 0; j < numEntries; ++j )
+        {
+            const double n = entry[j];
+            const double* v = &v_[ colIndex[j] * Width ];
+            for ( unsigned int k = 0; k < Width; ++k )
+                d[k] += n * v[k];
+        }
+    }
+    for ( unsigned int i = numVar_ * Width; i < numAll_ * Width; ++i )
+        dydt[i] = 0.0;
+}
+
+//////////////////////////////////////////////////////////////
+// Steppers
+//////////////////////////////////////////////////////////////
+
+void VoxelBatch::stepRk4( double t, double h )
+{
+    const unsigned int n = numAll_ * Width;
+    double* y = y_.data();
+    double* yt = ytmp_.data();
+    double* k1 = k_[0].data();
+    double* k2 = k_[1].data();
+    double* k3 = k_[2].data();
+    double* k4 = k_[3].data();
+
+    rhs( t, y, k1 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + 0.5 * h * k1[i];
+    rhs( t + 0.5 * h, yt, k2 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + 0.5 * h * k2[i];
+    rhs( t + 0.5 * h, yt, k3 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + h * k3[i];
+    rhs( t + h, yt, k4 );
+    for ( unsigned int i = 0; i < n; ++i )
+        y[i] += h * ( k1[i] + 2.0 * ( k2[i] + k3[i] ) + k4[i] ) / 6.0;
+}
+
+/**
+ * One Cash-Karp step from y_, leaving the 5th order solution in ytmp_.
+ * Uses the same coefficients as gsl_odeiv2_step_rkck.
+ */
+double VoxelBatch::stepRkck( double t, double h )
+{
+    static const double b21 = 1.0 / 5.0;
+    static const double b31 = 3.0 / 40.0, b32 = 9.0 / 40.0;
+    static const double b41 = 3.0 / 10.0, b42 = -9.0 / 10.0, b43 = 6.0 / 5.0;
+    static const double b51 = -11.0 / 54.0, b52 = 5.0 / 2.0,
+        b53 = -70.0 / 27.0, b54 = 35.0 / 27.0;
+    static const double b61 = 1631.0 / 55296.0, b62 = 175.0 / 512.0,
+        b63 = 575.0 / 13824.0, b64 = 44275.0 / 110592.0,
+        b65 = 253.0 / 4096.0;
+    static const double c1 = 37.0 / 378.0, c3 = 250.0 / 621.0,
+        c4 = 125.0 / 594.0, c6 = 512.0 / 1771.0;
+    static const double ec1 = c1 - 2825.0 / 27648.0,
+        ec3 = c3 - 18575.0 / 48384.0, ec4 = c4 - 13525.0 / 55296.0,
+        ec5 = -277.0 / 14336.0, ec6 = c6 - 0.25;
+
+    const unsigned int n = numAll_ * Width;
+    const double* y = y_.data();
+    double* yt = ytmp_.data();
+    double* k1 = k_[0].data();
+    double* k2 = k_[1].data();
+    double* k3 = k_[2].data();
+    double* k4 = k_[3].data();
+    double* k5 = k_[4].data();
+    double* k6 = k_[5].data();
+
+    // y_ is only written by rhs through the FuncTerms, at the start time.
+    rhs( t, y_.data(), k1 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + h * b21 * k1[i];
+    rhs( t + 0.2 * h, yt, k2 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + h * ( b31 * k1[i] + b32 * k2[i] );
+    rhs( t + 0.3 * h, yt, k3 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + h * ( b41 * k1[i] + b42 * k2[i] + b43 * k3[i] );
+    rhs( t + 0.6 * h, yt, k4 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + h * ( b51 * k1[i] + b52 * k2[i] + b53 * k3[i] +
+                             b54 * k4[i] );
+    rhs( t + h, yt, k5 );
+    for ( unsigned int i = 0; i < n; ++i )
+        yt[i] = y[i] + h * ( b61 * k1[i] + b62 * k2[i] + b63 * k3[i] +
+                             b64 * k4[i] + b65 * k5[i] );
+    rhs( t + 0.875 * h, yt, k6 );
+
+    double err = 0.0;
+    for ( unsigned int i = 0; i < numVar_ * Width; ++i )
+    {
+        yt[i] = y[i] + h * ( c1 * k1[i] + c3 * k3[i] + c4 * k4[i] +
+                             c6 * k6[i] );
+        double e = h * ( ec1 * k1[i] + ec3 * k3[i] + ec4 * k4[i] +
+                         ec5 * k5[i] + ec6 * k6[i] );
+        double scale = epsAbs_ + epsRel_ * max( fabs( y[i] ), fabs( yt[i] ) );
+        err = max( err, fabs( e ) / scale );
+    }
+    for ( unsigned int i = numVar_ * Width; i < n; ++i )
+        yt[i] = y[i];
+    return err;
+}
+
+void VoxelBatch::integrateFixed( double t, double tend )
+{
+    const double span = tend - t;
+    unsigned int numSteps = ceil( span / FIXED_DT - 1e-9 );
+    if ( numSteps == 0 )
+        numSteps = 1;
+    const double h = span / numSteps;
+    for ( unsigned int i = 0; i < numSteps; ++i )
+        stepRk4( t + i * h, h );
+}
+
+bool VoxelBatch::integrateAdaptive( double t, double tend, double& h )
+{
+    while ( t < tend )
+    {
+        double step = min( h, tend - t );
+        double err = stepRkck( t, step );
+        if ( err <= 1.0 )
+        {
+            t += step;
+            y_.swap( ytmp_ );
+            // Don't let the truncated last step shrink the next start.
+            if ( step == h )
+                h = step * min( 5.0, 0.9 * pow( max( err, 1e-10 ), -0.2 ) );
+        }
+        else
+        {
+            h = step * max( 0.2, 0.9 * pow( err, -0.25 ) );
+        }
+        if ( h < MIN_DT )
+            return false;
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+// Driver
+//////////////////////////////////////////////////////////////
+
+void VoxelBatch::advance( vector< VoxelPools >& pools, const Stoich* stoich,
+                          const ProcInfo* p )
+{
+    if ( pools.size() == 0 )
+        return;
+    stoich_ = stoich;
+    pools_ = &pools;
+    numAll_ = stoich->getNumAllPools();
+    numVar_ = stoich->getNumVarPools() + stoich->getNumProxyPools();
+    const RateKernel& rk = stoich->getRateKernel();
+    batchFuncs_ = stoich->getNumFuncPools() > 0 && stoich->funcsCompiled();
+    needsGather_ = ( stoich->getNumFuncPools() > 0 && !batchFuncs_ ) ||
+                   !rk.getFallbackRates().empty();
+
+    const unsigned int n = numAll_ * Width;
+    y_.resize( n );
+    ytmp_.resize( n );
+    for ( unsigned int i = 0; i < 6; ++i )
+        k_[i].resize( n );
+    coeffs_.resize( rk.numCoeffs() * Width );
+    v_.resize( rk.numRates() * Width );
+    laneS_.resize( needsGather_ ? n : 0 );
+
+    const unsigned int numGroups = ( pools.size() + Width - 1 ) / Width;
+    if ( hStart_.size() != numGroups )
+        hStart_.assign( numGroups, initDt_ );
+
+    for ( unsigned int g = 0; g < numGroups; ++g )
+    {
+        start_ = g * Width;
+        if ( !pack( pools, start_ ) )
+        {
+            unsigned int end = min( start_ + Width, ( unsigned int )pools.size() );
+            for ( unsigned int i = start_; i < end; ++i )
+                pools[i].advance( p );
+            continue;
+        }
+        double t = p->currTime - p->dt;
+        if ( adaptive_ )
+        {
+            if ( !integrateAdaptive( t, p->currTime, hStart_[g] ) )
+            {
+                cerr << "Error: VoxelBatch::advance: Timestep has gotten "
+                     "too small at time " << t << endl;
+                assert( 0 );
+            }
+        }
+        else
+        {
+            integrateFixed( t, p->currTime );
+        }
+        unpack( pools, start_ );
+    }
+}
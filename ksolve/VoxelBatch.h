@@ -0,0 +1,102 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _VOXEL_BATCH_H
+#define _VOXEL_BATCH_H
+
+class Stoich;
+class VoxelPools;
+class ProcInfo;
+
+/**
+ * Integrates the voxels of a Ksolve in groups of Width, in lockstep.
+ *
+ * All voxels of a Ksolve share one reaction network, and differ only in
+ * volume and state. VoxelBatch copies the state of a group of voxels
+ * into arrays interleaved voxel-fastest ( y[ pool * Width + lane ] ),
+ * so that the RateKernel and the stoichiometry product run as short
+ * unit-stride loops over the lanes, which the compiler vectorizes.
+ * The whole group shares one timestep.
+ *
+ * Methods:
+ * rk4batch: Fixed step Runge-Kutta 4th order.
+ * rkckbatch: Adaptive Runge-Kutta Cash-Karp (4,5). The error is the
+ * worst over all voxels of the group, so the step is set by the
+ * stiffest voxel.
+ *
+ * If a voxel's rate coefficients are out of date with the Stoich, its
+ * group is handed back to VoxelPools::advance for that step.
+ */
+class VoxelBatch
+{
+public:
+    VoxelBatch();
+
+    /// Number of voxels integrated together.
+    static const unsigned int Width = 8;
+
+    /// True if method names one of the batched methods.
+    static bool isBatchMethod( const string& method );
+
+    void setMethod( const string& method );
+    void setTolerances( double epsAbs, double epsRel );
+
+    /// Resets the step size estimates.
+    void reinit( double dt );
+
+    /// Advances all the voxels from p->currTime - p->dt to p->currTime.
+    void advance( vector< VoxelPools >& pools, const Stoich* stoich,
+                  const ProcInfo* p );
+
+private:
+    /// Copies the state and coefficients of a group into the arrays.
+    bool pack( const vector< VoxelPools >& pools, unsigned int start );
+    void unpack( vector< VoxelPools >& pools, unsigned int start ) const;
+
+    /// Computes dydt for all lanes.
+    void rhs( double t, double* y, double* dydt );
+
+    void stepRk4( double t, double h );
+
+    /// Returns the scaled error norm of the step, worst over all lanes.
+    double stepRkck( double t, double h );
+
+    void integrateFixed( double t, double tend );
+    bool integrateAdaptive( double t, double tend, double& h );
+
+    bool adaptive_;
+    double epsAbs_;
+    double epsRel_;
+    double initDt_;
+
+    /// Last accepted step for each group, used to start the next.
+    vector< double > hStart_;
+
+    // Set up for the group being integrated.
+    const Stoich* stoich_;
+    const vector< VoxelPools >* pools_;
+    unsigned int start_;
+    unsigned int numAll_;
+    unsigned int numVar_;
+    bool needsGather_;
+    bool batchFuncs_;		///< All FuncTerms compiled, run them batched
+
+    vector< double > y_;
+    vector< double > ytmp_;
+    vector< double > yerr_;
+    vector< double > k_[6];
+    vector< double > coeffs_;
+    vector< double > v_;
+
+    /// Single voxel copy of the state, for FuncTerms and fallback rates.
+    vector< double > laneS_;
+    vector< double > funcScratch_;
+};
+
+#endif // _VOXEL_BATCH_H
@@ -30,11 +30,14 @@ using namespace boost::numeric;
 #include "KsolveBase.h"
 #include "Ksolve.h"
 #include "Stoich.h"
+#include "Rosenbrock.h"
 
 //////////////////////////////////////////////////////////////
 // Class definitions
 
-VoxelPools::VoxelPools() : pLSODA(nullptr)
+VoxelPools::VoxelPools() : pLSODA(nullptr),
+    rateKernel_( nullptr ),
+    rateKernelVersion_( 0 )
 {
 	lsodaState_ = 1;
 #ifdef USE_GSL
@@ -73,6 +76,22 @@ void VoxelPools::reinit( double dt )
         pLSODA.reset(new LSODA());
         pLSODA->param = (void *) this;
     }
+
+    if( getMethod() == "rosenbrock" )
+    {
+        const KinJacobian& jac = stoichPtr_->getJacobian();
+        stiff_.reset( new Rosenbrock() );
+        stiff_->setSystem( jac.size(), jac.getRowStart(), jac.getColIndex(),
+                &VoxelPools::stiffRhs, &VoxelPools::stiffJac, this );
+        stiff_->setTolerances( epsAbs_, epsRel_ );
+        stiff_->reset( dt / 10.0 );
+        stiffDv_.resize(
+                stoichPtr_->getRateKernel().getPartialsCol().size() );
+    }
+    else
+    {
+        stiff_.reset();
+    }
 }
 
 void VoxelPools::setStoich( Stoich* s, const OdeSystem* ode )
@@ -136,6 +155,17 @@ void VoxelPools::advance( const ProcInfo* p )
             assert(0);
         }
     }
+    else if( stiff_ )
+    {
+        if ( !stiff_->apply( t, p->currTime, varS() ) )
+        {
+            cerr << "Error: VoxelPools::advance: Rosenbrock timestep has "
+                 "gotten too small at time " << t << "\n";
+            assert( 0 );
+        }
+        // Leave the function pools consistent with the new state.
+        stoichPtr_->updateFuncs( varS(), p->currTime );
+    }
     else
     {
 
@@ -362,6 +392,48 @@ void VoxelPools::lsodaSys( double t, double* y, double* dydt, void* param)
     vp->updateRates( y, dydt );
 }
 
+void VoxelPools::loadStiffState( double t, const double* y )
+{
+    // Buffered pools may have been changed from outside since the
+    // integrator state was set up, so take them from S.
+    stiffS_.assign( Svec().begin(), Svec().end() );
+    std::copy( y, y + stiff_->size(), stiffS_.begin() );
+    stoichPtr_->updateFuncs( stiffS_.data(), t );
+}
+
+void VoxelPools::stiffRhs( double t, const double* y, double* dydt,
+                           void* params )
+{
+    VoxelPools* vp = reinterpret_cast< VoxelPools* >( params );
+    vp->loadStiffState( t, y );
+    vp->stiffDydt_.resize( vp->stiffS_.size() );
+    vp->updateRates( vp->stiffS_.data(), vp->stiffDydt_.data() );
+    std::copy( vp->stiffDydt_.begin(),
+               vp->stiffDydt_.begin() + vp->stiff_->size(), dydt );
+}
+
+/**
+ * Analytic sparse Jacobian. If the rate coefficients are out of date
+ * the Jacobian is left at zero, which the W-method tolerates at the
+ * cost of smaller steps.
+ */
+void VoxelPools::stiffJac( double t, const double* y, double* jac,
+                           void* params )
+{
+    VoxelPools* vp = reinterpret_cast< VoxelPools* >( params );
+    const KinJacobian& J = vp->stoichPtr_->getJacobian();
+    const double* coeffs = vp->getRateCoeffs();
+    if ( !coeffs )
+    {
+        std::fill( jac, jac + J.numEntries(), 0.0 );
+        return;
+    }
+    vp->loadStiffState( t, y );
+    vp->stoichPtr_->getRateKernel().evalPartials( vp->stiffS_.data(),
+            coeffs, vp->rates_, vp->stiffDv_.data() );
+    J.compute( vp->stiffDv_.data(), jac );
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Here are the internal reaction rate calculation functions
 ///////////////////////////////////////////////////////////////////////
@@ -387,6 +459,7 @@ void VoxelPools::updateAllRateTerms( const vector< RateTerm* >& rates,
                 getXreacScaleProducts(i-numCoreRates) 
                 );
     }
+    loadRateCoeffs();
 }
 
 void VoxelPools::updateRateTerms( const vector< RateTerm* >& rates,
@@ -406,13 +479,41 @@ void VoxelPools::updateRateTerms( const vector< RateTerm* >& rates,
     }
     else
         rates_[index] = rates[index]->copyWithVolScaling(getVolume(), 1.0, 1.0);
+    loadRateCoeffs();
+}
+
+void VoxelPools::loadRateCoeffs()
+{
+    rateKernel_ = nullptr;
+    if ( !stoichPtr_ )
+        return;
+    const RateKernel& rk = stoichPtr_->getRateKernel();
+    // If rates_ is out of step with the Stoich, as happens during
+    // setup, stay with the RateTerms till the next update.
+    if ( !rk.loadCoeffs( rates_, rateCoeffs_ ) )
+        return;
+    rateKernel_ = &rk;
+    rateKernelVersion_ = rk.version();
+}
+
+const double* VoxelPools::getRateCoeffs() const
+{
+    if ( rateKernel_ && rateKernel_->version() == rateKernelVersion_ )
+        return rateCoeffs_.data();
+    return nullptr;
+}
+
+const vector< RateTerm* >& VoxelPools::getRateTerms() const
+{
+    return rates_;
 }
 
 void VoxelPools::updateRates( const double* s, double* yprime ) const
 {
     const KinSparseMatrix& N = stoichPtr_->getStoichiometryMatrix();
-    vector< double > v( N.nColumns(), 0.0 );
-    vector< double >::iterator j = v.begin();
+    if ( v_.size() != N.nColumns() )
+        v_.assign( N.nColumns(), 0.0 );
+    vector< double >& v = v_;
     // totVar should include proxyPools only if this voxel uses them
     unsigned int totVar = stoichPtr_->getNumVarPools() + stoichPtr_->getNumProxyPools();
     // totVar should include proxyPools if this voxel does not use them
@@ -420,8 +521,16 @@ void VoxelPools::updateRates( const double* s, double* yprime ) const
     assert( N.nColumns() == 0 || N.nRows() == stoichPtr_->getNumAllPools() );
     assert( N.nColumns() == rates_.size() );
 
-    for ( auto i = rates_.cbegin(); i != rates_.end(); i++)
-        *j++ = (**i)( s );
+    if ( rateKernel_ && rateKernel_->version() == rateKernelVersion_ )
+    {
+        rateKernel_->eval( s, rateCoeffs_.data(), rates_, v.data() );
+    }
+    else
+    {
+        vector< double >::iterator j = v.begin();
+        for ( auto i = rates_.cbegin(); i != rates_.end(); i++)
+            *j++ = (**i)( s );
+    }
     for (unsigned int i = 0; i < totVar; ++i)
     {
         auto rate = N.computeRowRate( i, v );
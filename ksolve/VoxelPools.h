@@ -20,6 +20,8 @@
 
 class Stoich;
 class ProcInfo;
+class RateKernel;
+class Rosenbrock;
 
 /**
  * This is the class for handling reac-diff voxels used for deterministic
@@ -62,6 +64,12 @@ public:
     // System of LSODA.
     static void lsodaSys( double t, double* y, double* dydt, void* params);
 
+    // System and sparse Jacobian for the Rosenbrock stiff method.
+    static void stiffRhs( double t, const double* y, double* dydt,
+                          void* params );
+    static void stiffJac( double t, const double* y, double* jac,
+                          void* params );
+
     //////////////////////////////////////////////////////////////////
     // Rate manipulation and calculation functions
     //////////////////////////////////////////////////////////////////
@@ -94,6 +102,15 @@ public:
      */
     void updateReacVelocities( const double* s, vector< double >& v ) const;
 
+    /**
+     * Returns the coefficients for the Stoich's RateKernel, or null if
+     * they are out of date and the RateTerms must be used instead.
+     */
+    const double* getRateCoeffs() const;
+
+    /// The volume-scaled RateTerms of this voxel.
+    const vector< RateTerm* >& getRateTerms() const;
+
     /// Used for debugging.
     void print() const;
 
@@ -103,6 +120,16 @@ private:
     LSODA_ODE_SYSTEM_TYPE lsodaSystem;
     int lsodaState_;
 
+    std::shared_ptr< Rosenbrock > stiff_;
+
+    /// Scratch for the stiff method: full pool vector, dydt, and dv/dS.
+    vector< double > stiffS_;
+    vector< double > stiffDydt_;
+    vector< double > stiffDv_;
+
+    /// Copies the stiff integrator's y into stiffS_ and updates funcs.
+    void loadStiffState( double t, const double* y );
+
 #ifdef USE_GSL
     gsl_odeiv2_driver* driver_;
     gsl_odeiv2_system sys_;
@@ -112,6 +139,25 @@ private:
     double epsRel_;
     string method_;
 
+    /**
+     * Volume-scaled coefficients for the Stoich's RateKernel, loaded
+     * from rates_ whenever the rate terms are updated.
+     */
+    vector< double > rateCoeffs_;
+
+    /// Kernel the coefficients were loaded for, and its version.
+    const RateKernel* rateKernel_;
+    unsigned int rateKernelVersion_;
+
+    /**
+     * Scratch space for the reaction velocities, so that updateRates
+     * does not allocate. Each voxel is advanced by one thread at a time.
+     */
+    mutable vector< double > v_;
+
+    /// Reloads rateCoeffs_ from rates_.
+    void loadRateCoeffs();
+
 };
 
 #endif	// _VOXEL_POOLS_H
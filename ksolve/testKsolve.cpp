@@ -19,10 +19,15 @@
 #include "XferInfo.h"
 #include "KsolveBase.h"
 #include "Stoich.h"
+#include "SparseLU.h"
+#include "PropensityTree.h"
+#include "../randnum/Philox.h"
+#include "../randnum/randnum.h"
 #include "../mesh/VoxelJunction.h"
 
 #include "../builtins/MooseParser.h"
 #include "../utility/testing_macros.hpp"
+#include <thread>
 
 /**
  * Tab controlled by table
@@ -265,6 +270,75 @@ void testRunKsolve()
     cout << "." << flush;
 }
 
+/**
+ * Runs the reac test with the given Ksolve method, and returns the
+ * final n of its pools. If initial is given, it gets their n at the
+ * start of the run.
+ */
+vector< double > runKsolveMethod( const string& method,
+                                  vector< double >* initial = 0 )
+{
+    static const char* names[] = { "A", "B", "C", "D", "E", "e1Pool",
+        "e2Pool", "e1Pool/e1/cplx" };
+    const unsigned int numNames = sizeof( names ) / sizeof( char* );
+    Shell* s = reinterpret_cast< Shell* >( Id().eref().data() );
+    Id kin = makeReacTest();
+    Id ksolve = s->doCreate( "Ksolve", kin, "ksolve", 1 );
+    Field< string >::set( ksolve, "method", method );
+    Id stoich = s->doCreate( "Stoich", ksolve, "stoich", 1 );
+    Field< Id >::set( stoich, "compartment", kin );
+    Field< Id >::set( stoich, "ksolve", ksolve );
+    Field< string >::set( stoich, "reacSystemPath", "/kinetics/##" );
+    assert( Field< unsigned int >::get( stoich, "numAllPools" ) > 0 );
+    s->doUseClock( "/kinetics/ksolve", "process", 4 );
+    s->doSetClock( 4, 0.1 );
+    s->doReinit();
+    if ( initial )
+    {
+        initial->clear();
+        for ( unsigned int i = 0; i < numNames; ++i )
+            initial->push_back( Field< double >::get(
+                        Id( string( "/kinetics/" ) + names[i] ), "n" ) );
+    }
+    s->doStart( 20.0 );
+    vector< double > ret;
+    for ( unsigned int i = 0; i < numNames; ++i )
+        ret.push_back( Field< double >::get(
+                    Id( string( "/kinetics/" ) + names[i] ), "n" ) );
+    s->doDelete( kin );
+    return ret;
+}
+
+/// True if any of the pools ended up away from its initial n.
+static bool poolsMoved( const vector< double >& initial,
+                        const vector< double >& final )
+{
+    for ( unsigned int i = 0; i < initial.size(); ++i )
+        if ( fabs( final[i] - initial[i] ) > 1e-3 * ( 1.0 + fabs( initial[i] ) ) )
+            return true;
+    return false;
+}
+
+/**
+ * The batched methods must agree with the per-voxel GSL one. The
+ * test model has a Function and both kinds of enzyme.
+ */
+void testRunKsolveBatch()
+{
+    vector< double > initial;
+    vector< double > ref = runKsolveMethod( "rk5", &initial );
+    assert( poolsMoved( initial, ref ) );
+    vector< double > rkck = runKsolveMethod( "rkckbatch" );
+    vector< double > rk4 = runKsolveMethod( "rk4batch" );
+    for ( unsigned int i = 0; i < ref.size(); ++i )
+    {
+        double tol = 1e-4 * ( 1.0 + fabs( ref[i] ) );
+        assert( fabs( rkck[i] - ref[i] ) < tol );
+        assert( fabs( rk4[i] - ref[i] ) < tol );
+    }
+    cout << "." << flush;
+}
+
 void testRunKsolveWithLSODA()
 {
     double simDt = 0.1;
@@ -343,6 +417,141 @@ void testRunGsolve()
     cout << "." << flush;
 }
 
+/**
+ * The sum tree must pick the same reaction as the linear scan in
+ * GssaVoxelPools::pickReac, and never one with zero propensity.
+ */
+void testPropensityTree()
+{
+    vector< double > v( 13 );
+    for ( unsigned int i = 0; i < v.size(); ++i )
+        v[i] = ( i % 4 == 1 ) ? 0.0 : ( i % 2 ? -1.0 : 1.0 ) * ( 1.0 + i );
+    v.back() = 0.0;
+    PropensityTree tree;
+    tree.build( v );
+    for ( unsigned int trial = 0; trial < 2; ++trial )
+    {
+        double total = 0.0;
+        for ( unsigned int i = 0; i < v.size(); ++i )
+            total += fabs( v[i] );
+        ASSERT_DOUBLE_EQ( tree.total(), total, "testPropensityTree" );
+        for ( double r = 0.01; r < total; r += 0.1 )
+        {
+            double sum = 0.0;
+            unsigned int j = 0;
+            for ( ; j < v.size(); ++j )
+                if ( r < ( sum += fabs( v[j] ) ) )
+                    break;
+            assert( tree.pick( r ) == j );
+        }
+        assert( fabs( v[ tree.pick( total ) ] ) > 0.0 );
+        // Change a few and try again.
+        v[3] = 0.0;
+        tree.set( 3, 0.0 );
+        v[5] = 2.5;
+        tree.set( 5, 2.5 );
+    }
+
+    // A stochastic run with the tree, one voxel.
+    Shell* s = reinterpret_cast< Shell* >( Id().eref().data() );
+    Id kin = makeReacTest();
+    Field< double >::set( kin, "volume", 1e-21 );
+    Id gsolve = s->doCreate( "Gsolve", kin, "gsolve", 1 );
+    Field< bool >::set( gsolve, "useSumTree", true );
+    Id stoich = s->doCreate( "Stoich", gsolve, "stoich", 1 );
+    Field< Id >::set( stoich, "compartment", kin );
+    Field< Id >::set( stoich, "ksolve", gsolve );
+    Field< string >::set( stoich, "reacSystemPath", "/kinetics/##" );
+    s->doUseClock( "/kinetics/gsolve", "process", 4 );
+    s->doSetClock( 4, 0.1 );
+    s->doReinit();
+    s->doStart( 20.0 );
+    vector< unsigned int > numFire = LookupField< unsigned int,
+        vector< unsigned int > >::get( gsolve, "numFire", 0 );
+    unsigned int tot = 0;
+    for ( unsigned int i = 0; i < numFire.size(); ++i )
+        tot += numFire[i];
+    assert( tot > 0 );
+    s->doDelete( kin );
+    cout << "." << flush;
+}
+
+/**
+ * Runs the ensemble of 4 replicates under gsolve on the given number of
+ * threads and returns the recorded tensor, checking its shape and its
+ * final slice.
+ */
+static vector< double > runGsolveEnsemble( Id gsolve, unsigned int numThreads )
+{
+    Shell* s = reinterpret_cast< Shell* >( Id().eref().data() );
+    Field< unsigned int >::set( gsolve, "numThreads", numThreads );
+    s->doReinit();
+    s->doStart( 2.0 );
+
+    Id stoich( gsolve.path() + "/stoich" );
+    vector< unsigned int > shape =
+        Field< vector< unsigned int > >::get( gsolve, "ensembleShape" );
+    unsigned int numVarPools =
+        Field< unsigned int >::get( stoich, "numVarPools" );
+    assert( shape.size() == 3 );
+    assert( shape[0] == 4 );
+    assert( shape[1] == numVarPools );
+    assert( shape[2] > 1 );
+    vector< double > data =
+        Field< vector< double > >::get( gsolve, "ensemble" );
+    assert( data.size() == shape[0] * shape[1] * shape[2] );
+    for ( unsigned int r = 0; r < shape[0]; ++r )
+    {
+        vector< double > n = LookupField< unsigned int, vector< double > >::
+            get( gsolve, "replicateNvec", r );
+        for ( unsigned int j = 0; j < shape[1]; ++j )
+            assert( doubleEq( data[ ( r * shape[1] + j + 1 ) * shape[2] - 1 ], n[j] ) );
+    }
+    return data;
+}
+
+/**
+ * Replicates must differ from each other, and the ensemble must be
+ * reproducible whatever the threads do. The streams are keyed by the
+ * Gsolve's id, so the reruns use the same model.
+ */
+void testGsolveEnsemble()
+{
+    moose::Philox a( 7, 3 );
+    moose::Philox b( 7, 3 );
+    moose::Philox c( 7, 4 );
+    for ( unsigned int i = 0; i < 5; ++i )
+        a();
+    b.discard( 5 );
+    assert( a() == b() );
+    assert( a() != c() );
+
+    Shell* s = reinterpret_cast< Shell* >( Id().eref().data() );
+    Id kin = makeReacTest();
+    Field< double >::set( kin, "volume", 1e-21 );
+    Id gsolve = s->doCreate( "Gsolve", kin, "gsolve", 1 );
+    Field< unsigned int >::set( gsolve, "numReplicates", 4 );
+    Id stoich = s->doCreate( "Stoich", gsolve, "stoich", 1 );
+    Field< Id >::set( stoich, "compartment", kin );
+    Field< Id >::set( stoich, "ksolve", gsolve );
+    Field< string >::set( stoich, "reacSystemPath", "/kinetics/##" );
+    s->doUseClock( "/kinetics/gsolve", "process", 4 );
+    s->doSetClock( 4, 0.1 );
+
+    // A zero seed would draw fresh streams at every reinit.
+    moose::mtseed( 5489UL );
+    vector< double > first = runGsolveEnsemble( gsolve, 2 );
+    vector< double > second = runGsolveEnsemble( gsolve, 2 );
+    vector< double > single = runGsolveEnsemble( gsolve, 1 );
+    assert( first == second );
+    assert( first == single );
+    unsigned int perReplicate = first.size() / 4;
+    assert( !std::equal( first.begin(), first.begin() + perReplicate,
+                         first.begin() + perReplicate ) );
+    s->doDelete( kin );
+    cout << "." << flush;
+}
+
 void testFuncTerm()
 {
     FuncTerm ft;
@@ -367,13 +576,234 @@ void testFuncTerm()
     cout << "." << flush;
 }
 
+/**
+ * Checks that compiled FuncTerms agree with the parser and with
+ * hand-written C++, over single voxels, batches and several threads,
+ * and that expressions outside the compiled subset still evaluate.
+ */
+void testFuncProgram()
+{
+    double args[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    vector< unsigned int > mol( 3 );
+    mol[0] = 2;
+    mol[1] = 0;
+    mol[2] = 3;
+
+    FuncTerm ft;
+    ft.setReactantIndex( mol );
+    ft.setExpr( "exp(-x0/2)*x1 + (x2 > 3.5) - x1^2/max(t, 1, 0.5)"
+                " + sqrt(abs(x0 - x2)) % 0.7 + -2^2" );
+    assert( ft.isCompiled() );
+    for ( double t = 0.0; t < 3.0; t += 0.5 )
+    {
+        double x0 = args[2], x1 = args[0], x2 = args[3];
+        double y = exp( -x0 / 2 ) * x1 + ( x2 > 3.5 ) -
+                   x1 * x1 / max( t, 1.0 ) +
+                   fmod( sqrt( fabs( x0 - x2 ) ), 0.7 ) - 4.0;
+        assert( doubleEq( ft( args, t ), y ) );
+    }
+
+    // Not in the compiled subset, so it stays on the parser.
+    FuncTerm sum;
+    sum.setReactantIndex( mol );
+    sum.setExpr( "sum(x0, x1, x2)" );
+    assert( !sum.isCompiled() );
+    assert( doubleEq( sum( args, 0.0 ), 8.0 ) );
+
+    // Batch: four voxels, pool i of voxel k at y[ i * 4 + k ].
+    const unsigned int width = 4;
+    vector< double > y( 10 * width );
+    for ( unsigned int i = 0; i < 10; ++i )
+        for ( unsigned int k = 0; k < width; ++k )
+            y[ i * width + k ] = args[i] + 0.25 * k;
+    ft.setTarget( 5 );
+    ft.setVolScale( 2.0 );
+    vector< double > scratch( ft.scratchSize( width ) );
+    ft.evalPoolBatch( y.data(), width, 1.5, scratch.data() );
+    for ( unsigned int k = 0; k < width; ++k )
+    {
+        double s[10];
+        for ( unsigned int i = 0; i < 10; ++i )
+            s[i] = args[i] + 0.25 * k;
+        ft.evalPool( s, 1.5 );
+        assert( doubleEq( y[ 5 * width + k ], s[5] ) );
+    }
+
+    // Several threads on the same FuncTerms, each with its own voxel.
+    vector< double > ret( 4 );
+    vector< std::thread > threads;
+    for ( unsigned int j = 0; j < ret.size(); ++j )
+    {
+        threads.push_back( std::thread( [&, j]() {
+            double s[10];
+            for ( unsigned int i = 0; i < 10; ++i )
+                s[i] = args[i] * ( j + 1 );
+            double tot = 0.0;
+            for ( unsigned int n = 0; n < 1000; ++n )
+                tot += ft( s, 0.1 * j ) + sum( s, 0.0 );
+            ret[j] = tot;
+        } ) );
+    }
+    for ( auto& t : threads )
+        t.join();
+    for ( unsigned int j = 0; j < ret.size(); ++j )
+    {
+        double s[10];
+        for ( unsigned int i = 0; i < 10; ++i )
+            s[i] = args[i] * ( j + 1 );
+        assert( doubleApprox( ret[j], 1000 * ( ft( s, 0.1 * j ) + sum( s, 0.0 ) ) ) );
+    }
+    cout << "." << flush;
+}
+
+/**
+ * Checks that the flattened RateKernel gives the same reaction
+ * velocities as evaluating the RateTerms one by one, including a
+ * fallback term and volume-scaled copies.
+ */
+void testRateKernel()
+{
+    vector< unsigned int > two( 2 );
+    two[0] = 1;
+    two[1] = 2;
+    vector< unsigned int > three( 3, 0 );
+    three[2] = 3;
+    vector< RateTerm* > rates;
+    rates.push_back( new ZeroOrder( 0.5 ) );
+    rates.push_back( new FirstOrder( 2.0, 1 ) );
+    rates.push_back( new SecondOrder( 3.0, 1, 2 ) );
+    rates.push_back( new NOrder( 0.1, three ) );
+    rates.push_back( new BidirectionalReaction(
+                new FirstOrder( 1.5, 0 ), new SecondOrder( 0.7, 2, 3 ) ) );
+    rates.push_back( new MMEnzyme1( 2.0, 5.0, 3, 0 ) );
+    RateTerm* mmSub = new NOrder( 1.0, two );
+    rates.push_back( new MMEnzyme( 1.0, 4.0, 0, mmSub ) );
+    rates.push_back( new StochSecondOrderSingleSubstrate( 0.2, 2 ) );
+
+    RateKernel rk;
+    assert( !rk.matches( rates ) );
+    rk.build( rates );
+    assert( rk.matches( rates ) );
+    assert( rk.numRates() == rates.size() );
+
+    double S[] = { 1.0, 2.0, 3.0, 4.0 };
+    vector< double > coeffs;
+    bool ok = rk.loadCoeffs( rates, coeffs );
+    assert( ok );
+    vector< double > v( rates.size() );
+    rk.eval( S, coeffs.data(), rates, v.data() );
+    for ( unsigned int i = 0; i < rates.size(); ++i )
+        ASSERT_DOUBLE_EQ( v[i], ( *rates[i] )( S ), "testRateKernel" );
+
+    // Volume-scaled copies share the tables but not the coefficients.
+    vector< RateTerm* > scaled;
+    for ( unsigned int i = 0; i < rates.size(); ++i )
+        scaled.push_back( rates[i]->copyWithVolScaling( 1e-18, 1, 1 ) );
+    ok = rk.loadCoeffs( scaled, coeffs );
+    assert( ok );
+    rk.eval( S, coeffs.data(), scaled, v.data() );
+    for ( unsigned int i = 0; i < scaled.size(); ++i )
+        ASSERT_DOUBLE_EQ( v[i], ( *scaled[i] )( S ), "testRateKernel" );
+
+    // Partials against central differences of the RateTerms.
+    const vector< unsigned int >& dvRow = rk.getPartialsRowStart();
+    const vector< unsigned int >& dvCol = rk.getPartialsCol();
+    vector< double > dv( dvCol.size() );
+    ok = rk.loadCoeffs( rates, coeffs );
+    assert( ok );
+    rk.evalPartials( S, coeffs.data(), rates, dv.data() );
+    assert( S[0] == 1.0 && S[3] == 4.0 ); // Restored.
+    for ( unsigned int r = 0; r < rates.size(); ++r )
+    {
+        for ( unsigned int p = dvRow[r]; p < dvRow[r + 1]; ++p )
+        {
+            double orig = S[ dvCol[p] ];
+            S[ dvCol[p] ] = orig + 1e-6;
+            double up = ( *rates[r] )( S );
+            S[ dvCol[p] ] = orig - 1e-6;
+            double down = ( *rates[r] )( S );
+            S[ dvCol[p] ] = orig;
+            assert( fabs( dv[p] - ( up - down ) / 2e-6 ) < 1e-5 );
+        }
+    }
+
+    for ( unsigned int i = 0; i < rates.size(); ++i )
+    {
+        delete rates[i];
+        delete scaled[i];
+    }
+    delete mmSub;  // MMEnzyme does not own its substrate term.
+    cout << "." << flush;
+}
+
+/**
+ * Solves a sparse system with some fill-in, and runs the reac test
+ * with the Rosenbrock stiff method.
+ */
+void testStiffKsolve()
+{
+    // Arrow matrix: the minimum degree order must put the hub last to
+    // avoid filling in everything.
+    const unsigned int n = 20;
+    vector< unsigned int > rowStart( 1, 0 );
+    vector< unsigned int > colIndex;
+    vector< double > values;
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+        if ( i > 0 )
+        {
+            colIndex.push_back( 0 );
+            values.push_back( 1.0 );
+        }
+        colIndex.push_back( i );
+        values.push_back( 4.0 + i );
+        if ( i == 0 )
+        {
+            for ( unsigned int j = 1; j < n; ++j )
+            {
+                colIndex.push_back( j );
+                values.push_back( -1.0 );
+            }
+        }
+        rowStart.push_back( colIndex.size() );
+    }
+    SparseLU lu;
+    lu.analyse( n, rowStart, colIndex );
+    assert( lu.numFactorEntries() == colIndex.size() );
+    bool ok = lu.factor( values.data() );
+    assert( ok );
+    vector< double > x( n ), b( n, 0.0 );
+    for ( unsigned int i = 0; i < n; ++i )
+        x[i] = sin( i + 1.0 );
+    for ( unsigned int i = 0; i < n; ++i )
+        for ( unsigned int k = rowStart[i]; k < rowStart[i + 1]; ++k )
+            b[i] += values[k] * x[ colIndex[k] ];
+    lu.solve( b.data() );
+    for ( unsigned int i = 0; i < n; ++i )
+        assert( fabs( b[i] - x[i] ) < 1e-12 );
+
+    vector< double > initial;
+    vector< double > ref = runKsolveMethod( "rk5" );
+    vector< double > stiff = runKsolveMethod( "rosenbrock", &initial );
+    assert( poolsMoved( initial, stiff ) );
+    for ( unsigned int i = 0; i < ref.size(); ++i )
+        assert( fabs( stiff[i] - ref[i] ) < 1e-4 * ( 1.0 + fabs( ref[i] ) ) );
+    cout << "." << flush;
+}
+
 void testKsolve()
 {
     testSetupReac();
     testBuildStoich();
     testRunKsolve();
+    testRunKsolveBatch();
+    testStiffKsolve();
     testRunGsolve();
+    testPropensityTree();
+    testGsolveEnsemble();
     testFuncTerm();
+    testFuncProgram();
+    testRateKernel();
 }
 
 void testKsolveProcess()
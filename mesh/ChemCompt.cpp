@@ -93,6 +93,19 @@ const Cinfo* ChemCompt::initCinfo()
         &ChemCompt::getDimensions
     );
 
+    static ReadOnlyLookupValueFinfo<
+			ChemCompt, vector< double >, vector< double > >
+	nearestVoxels(
+        "nearestVoxels",
+        "Batch lookup of the voxels nearest to a set of points. The key "
+        "is a flat vector of coordinates x0 y0 z0 x1 y1 z1 ... "
+        "Returns index0 distance0 index1 distance1 ..., one pair per "
+        "point, as from the mesh's nearest-entry query. The distance is "
+        "negative if the point is outside the compartment, and the index "
+        "is then the nearest voxel on the surface where one exists.",
+        &ChemCompt::getNearestVoxels
+    );
+
     static ReadOnlyLookupValueFinfo< ChemCompt, unsigned int, vector< double > > stencilRate(
         "stencilRate",
         "vector of diffusion rates in the stencil for specified voxel."
@@ -182,6 +195,7 @@ const Cinfo* ChemCompt::initCinfo()
         &oneVoxelMidpoint,		// ReadOnlyLookupValue
         &oneVoxelVolume,	// ReadOnlyLookupValue
         &voxelCoords,	// ReadOnlyLookupValue
+        &nearestVoxels,	// ReadOnlyLookupValue
         &numDimensions,	// ReadOnlyValue
         &stencilRate,	// ReadOnlyLookupValue
         &stencilIndex,	// ReadOnlyLookupValue
@@ -381,6 +395,21 @@ vector< double > ChemCompt::getOneVoxelMidpoint( unsigned int vox ) const
 	return ret;
 }
 
+vector< double > ChemCompt::getNearestVoxels(
+				vector< double > coords ) const
+{
+	unsigned int num = coords.size() / 3;
+	vector< double > ret( num * 2 );
+	for ( unsigned int i = 0; i < num; ++i ) {
+		unsigned int index = 0;
+		double r = nearest( coords[i*3], coords[i*3+1], coords[i*3+2],
+						index );
+		ret[i*2] = index;
+		ret[i*2+1] = r;
+	}
+	return ret;
+}
+
 double ChemCompt::getOneVoxelVolume( const Eref& e, unsigned int dataIndex ) const
 {
     return this->getMeshEntryVolume( dataIndex );
@@ -100,6 +100,12 @@ public:
 	/// Looks up specified voxel midpoint, from vGetVoxelMidpoint.
 	vector< double > getOneVoxelMidpoint( unsigned int vox ) const;
 
+	/**
+	 * Batch form of nearest(). coords holds x y z triplets, and the
+	 * return has the nearest index and the distance for each point.
+	 */
+	vector< double > getNearestVoxels( vector< double > coords ) const;
+
     //////////////////////////////////////////////////////////////////
     // Dest Finfo
     //////////////////////////////////////////////////////////////////
@@ -422,6 +422,7 @@ void CubeMesh::updateCoords()
 
     // Fill out surface vector
     surface_.resize( 0 );
+    surfaceGrid_.clear();
     /*
     if ( numDims() == 0 ) {
     	surface_.push_back( 0 );
@@ -691,6 +692,7 @@ vector< unsigned int > CubeMesh::getSpaceToMesh() const
 void CubeMesh::setSurface( vector< unsigned int > v )
 {
     surface_ = v;
+    surfaceGrid_.clear();
 }
 
 vector< unsigned int > CubeMesh::getSurface() const
@@ -1240,19 +1242,24 @@ double CubeMesh::nearest( double x, double y, double z,
         }
         else     // Outside volume. Look over surface for nearest.
         {
-            double rmin = 1e99;
-            for ( vector< unsigned int >::const_iterator
-                    i = surface_.begin(); i != surface_.end(); ++i )
+            if ( !surfaceGrid_.isBuilt() )
             {
-                double tx, ty, tz;
-                indexToSpace( *i, tx, ty, tz );
-                double r = distance( tx - x, ty - y, tz - z );
-                if ( rmin > r )
-                {
-                    rmin = r;
-                    index = *i;
-                }
+                vector< double > centres( surface_.size() * 3 );
+                for ( unsigned int i = 0; i < surface_.size(); ++i )
+                    indexToSpace( surface_[i], centres[i * 3],
+                                  centres[i * 3 + 1], centres[i * 3 + 2] );
+                surfaceGrid_.build( centres, centres );
             }
+            unsigned int item;
+            double rmin = surfaceGrid_.nearest( x, y, z,
+                [&]( unsigned int it ) -> double {
+                    double tx, ty, tz;
+                    indexToSpace( surface_[it], tx, ty, tz );
+                    return distance( tx - x, ty - y, tz - z );
+                }, item );
+            if ( rmin < 0 )
+                return -1e99;
+            index = surface_[item];
             return -rmin; // Negative distance indicates xyz is outside vol
         }
     }
@@ -10,6 +10,8 @@
 #ifndef _CUBE_MESH_H
 #define _CUBE_MESH_H
 
+#include "SpatialGrid.h"
+
 /**
  * The CubeMesh represents a chemically identified compartment shaped
  * like a cuboid. This is not really an effective geometry for most
@@ -343,6 +345,13 @@ class CubeMesh: public MeshCompt
 		 * CubeMesh.
 		 */
 		vector< unsigned int > surface_;
+
+		/**
+		 * Spatial index over the centres of the surface_ voxels, used by
+		 * nearest() for points in empty voxels. Built on demand and
+		 * cleared whenever surface_ or the grid spacing changes.
+		 */
+		mutable SpatialGrid surfaceGrid_;
 };
 
 #endif	// _CUBE_MESH_H
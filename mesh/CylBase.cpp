@@ -260,6 +260,7 @@ double CylBase::selectGridSize( double h, double dia1,
 static void fillPointsOnCircle(
 				const Vec& u, const Vec& v, const Vec& q,
 				double h, double r, vector< double >& area,
+				vector< unsigned int >& touched,
 				const CubeMesh* other
 				)
 {
@@ -280,14 +281,18 @@ static void fillPointsOnCircle(
 		double p1 = q.a1() + r * ( u.a1() * c + v.a1() * s );
 		double p2 = q.a2() + r * ( u.a2() * c + v.a2() * s );
 		unsigned int index = other->spaceToIndex( p0, p1, p2 );
-		if ( index != CubeMesh::EMPTY )
+		if ( index != CubeMesh::EMPTY ) {
+			if ( area[index] == 0.0 )
+				touched.push_back( index );
 			area[index] += dArea;
+		}
 	}
 }
 
 static void fillPointsOnDisc(
 				const Vec& u, const Vec& v, const Vec& q,
 				double h, double r, vector< double >& area,
+				vector< unsigned int >& touched,
 				const CubeMesh* other
 				)
 {
@@ -308,8 +313,11 @@ static void fillPointsOnDisc(
 			double p1 = q.a1() + a * ( u.a1() * c + v.a1() * s );
 			double p2 = q.a2() + a * ( u.a2() * c + v.a2() * s );
 			unsigned int index = other->spaceToIndex( p0, p1, p2 );
-			if ( index != CubeMesh::EMPTY )
+			if ( index != CubeMesh::EMPTY ) {
+				if ( area[index] == 0.0 )
+					touched.push_back( index );
 				area[index] += dArea;
+			}
 		}
 	}
 }
@@ -336,8 +344,17 @@ void CylBase::matchCubeMeshEntries( const ChemCompt* compt,
 	// March along axis of cylinder.
 	// q is the location of the point along axis.
 	double rSlope = ( dia_ - parent.dia_ ) * 0.5 / length_;
+	// Areas are accumulated into a dense scratch vector that is kept at
+	// zero between divisions, and only the entries hit by the sample
+	// points are visited. This keeps the cost of each division
+	// proportional to its surface rather than to the size of the
+	// CubeMesh, which matters when matching a whole neuron.
+	static thread_local vector< double > area;
+	static thread_local vector< unsigned int > touched;
+	if ( area.size() < other->getNumEntries() )
+		area.resize( other->getNumEntries(), 0.0 );
 	for ( unsigned int i = 0; i < numDivs_; ++i ) {
-		vector< double >area( other->getNumEntries(), 0.0 );
+		touched.clear();
 		if ( useCylinderCurve ) {
 			for ( unsigned int j = 0; j < num; ++j ) {
 				unsigned int m = i * num + j;
@@ -350,20 +367,24 @@ void CylBase::matchCubeMeshEntries( const ChemCompt* compt,
 				if ( !isCylinder_ ) // Use the more complicated conic value
 				r = parent.dia_/2.0 + frac * rSlope;
 				fillPointsOnCircle( u, v, Vec( q0, q1, q2 ),
-							h, r, area, other );
+							h, r, area, touched, other );
 			}
 		}
 		if ( useCylinderCap && i == numDivs_ - 1 ) {
 			fillPointsOnDisc( u, v, Vec( x_, y_, z_ ),
-							h, dia_/2.0, area, other );
+							h, dia_/2.0, area, touched, other );
 		}
 		// Go through all cubeMesh entries and compute diffusion
 		// cross-section. Assume this is through a membrane, so the
 		// only factor relevant is area. Not the distance.
-		for ( unsigned int k = 0; k < area.size(); ++k ) {
-			if ( area[k] > EPSILON ) {
-				ret.push_back( VoxelJunction( i + startIndex, k, area[k] ));
+		// Sorted, so that the junctions come out in mesh entry order.
+		sort( touched.begin(), touched.end() );
+		for ( vector< unsigned int >::const_iterator
+				k = touched.begin(); k != touched.end(); ++k ) {
+			if ( area[*k] > EPSILON ) {
+				ret.push_back( VoxelJunction( i + startIndex, *k, area[*k] ));
 			}
+			area[*k] = 0.0;
 		}
 	}
 }
@@ -321,6 +321,7 @@ NeuroMesh& NeuroMesh::operator=( const NeuroMesh& other )
     diffLength_ = other.diffLength_;
     separateSpines_ = other.separateSpines_;
     geometryPolicy_ = other.geometryPolicy_;
+    grid_.clear();
     return *this;
 }
 
@@ -341,6 +342,7 @@ NeuroMesh::~NeuroMesh()
 void NeuroMesh::updateCoords()
 {
     unsigned int startFid = 0;
+    grid_.clear();
     if ( nodes_.size() <= 1 ) // One for soma and one for dummy pa of soma
     {
         buildStencil();
@@ -1294,11 +1296,11 @@ void NeuroMesh::indexToSpace( unsigned int index,
     z = pt.a2();
 }
 
-double NeuroMesh::nearest( double x, double y, double z,
-                           unsigned int& index ) const
+void NeuroMesh::buildGrid() const
 {
-    double best = 1e12;
-    index = 0;
+    vector< double > a;
+    vector< double > b;
+    gridNodes_.clear();
     for( unsigned int i = 0; i < nodes_.size(); ++i )
     {
         const NeuroNode& nn = nodes_[i];
@@ -1306,27 +1308,59 @@ double NeuroMesh::nearest( double x, double y, double z,
         {
             assert( nn.parent() < nodes_.size() );
             const NeuroNode& pa = nodes_[ nn.parent() ];
+            a.push_back( pa.getX() );
+            a.push_back( pa.getY() );
+            a.push_back( pa.getZ() );
+            b.push_back( nn.getX() );
+            b.push_back( nn.getY() );
+            b.push_back( nn.getZ() );
+            gridNodes_.push_back( i );
+        }
+    }
+    grid_.build( a, b );
+}
+
+/**
+ * Only the nodes whose segment has the foot of the perpendicular from
+ * the point qualify, so the distance is to a point on the segment and
+ * the spatial grid can prune the others. Ties go to the lower node, as
+ * they would in a scan over nodes_.
+ */
+double NeuroMesh::nearest( double x, double y, double z,
+                           unsigned int& index ) const
+{
+    index = 0;
+    if ( !grid_.isBuilt() )
+        buildGrid();
+    unsigned int item;
+    double best = grid_.nearest( x, y, z,
+        [&]( unsigned int it ) -> double {
+            const NeuroNode& nn = nodes_[ gridNodes_[it] ];
             double linePos;
             double r;
-            double near = nn.nearest( x, y, z, pa, linePos, r );
+            double near = nn.nearest( x, y, z, nodes_[ nn.parent() ],
+                                      linePos, r );
             if ( linePos >= 0 && linePos < 1.0 )
-            {
-                if ( best > near )
-                {
-                    best = near;
-                    index = linePos * nn.getNumDivs() + nn.startFid();
-                }
-            }
-        }
-    }
-    if ( best == 1e12 )
+                return near;
+            return -1.0;
+        }, item );
+    if ( best < 0 )
         return -1;
+    const NeuroNode& nn = nodes_[ gridNodes_[item] ];
+    double linePos;
+    double r;
+    nn.nearest( x, y, z, nodes_[ nn.parent() ], linePos, r );
+    index = linePos * nn.getNumDivs() + nn.startFid();
     return best;
 }
 
 void NeuroMesh::matchCubeMeshEntries( const ChemCompt* other,
                                       vector< VoxelJunction >& ret ) const
 {
+    const CubeMesh* cube = dynamic_cast< const CubeMesh* >( other );
+    assert( cube );
+    double lo[3] = { cube->getX0(), cube->getY0(), cube->getZ0() };
+    double hi[3] = { cube->getX1(), cube->getY1(), cube->getZ1() };
     for( unsigned int i = 0; i < nodes_.size(); ++i )
     {
         const NeuroNode& nn = nodes_[i];
@@ -1334,6 +1368,18 @@ void NeuroMesh::matchCubeMeshEntries( const ChemCompt* other,
         {
             assert( nn.parent() < nodes_.size() );
             const NeuroNode& pa = nodes_[ nn.parent() ];
+            // Skip segments whose surface cannot reach into the cube, as
+            // none of their sample points would land in a voxel.
+            double r = 0.5 * max( nn.getDia(), pa.getDia() );
+            double p[3] = { pa.getX(), pa.getY(), pa.getZ() };
+            double q[3] = { nn.getX(), nn.getY(), nn.getZ() };
+            bool outside = false;
+            for ( unsigned int d = 0; d < 3; ++d )
+                if ( min( p[d], q[d] ) - r > hi[d] ||
+                        max( p[d], q[d] ) + r < lo[d] )
+                    outside = true;
+            if ( outside )
+                continue;
             nn.matchCubeMeshEntries( other, pa, nn.startFid(),
                                      surfaceGranularity_, ret, true, false );
         }
@@ -10,6 +10,8 @@
 #ifndef _NEURO_MESH_H
 #define _NEURO_MESH_H
 
+#include "SpatialGrid.h"
+
 /**
  * The NeuroMesh represents sections of a neuron whose spatial attributes
  * are obtained from a neuronal model.
@@ -229,6 +231,9 @@ class NeuroMesh: public MeshCompt
 		 */
 		void insertDummyNodes();
 
+		/// Indexes the segments of the non-dummy nodes for nearest().
+		void buildGrid() const;
+
 		/// This shuffles the nodes_ vector to put soma node at the start
 		Id putSomaAtStart( Id origSoma, unsigned int maxDiaIndex );
 
@@ -328,6 +333,14 @@ class NeuroMesh: public MeshCompt
 		 */
 		vector< Id > shaft_; /// Id of shaft compartment.
 		vector< Id > head_;	/// Id of head compartment
+
+		/**
+		 * Spatial index over the parent-to-node segments, built on the
+		 * first nearest() query and cleared by updateCoords whenever the
+		 * nodes change. gridNodes_[item] is the node of each grid item.
+		 */
+		mutable SpatialGrid grid_;
+		mutable vector< unsigned int > gridNodes_;
 		vector< unsigned int > parent_; /// Index of parent voxel of spines
 		/**
 		 * Index of parent voxel of each voxel. The root voxel has a
@@ -0,0 +1,133 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include <cmath>
+#include <cassert>
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid()
+	: built_( false ), cell_( 1.0 )
+{
+	origin_[0] = origin_[1] = origin_[2] = 0.0;
+	n_[0] = n_[1] = n_[2] = 1;
+}
+
+void SpatialGrid::clear()
+{
+	built_ = false;
+	start_.clear();
+	items_.clear();
+}
+
+bool SpatialGrid::isBuilt() const
+{
+	return built_;
+}
+
+void SpatialGrid::cellOf( double x, double y, double z, int* c ) const
+{
+	double p[3] = { x, y, z };
+	for ( unsigned int d = 0; d < 3; ++d ) {
+		double f = floor( ( p[d] - origin_[d] ) / cell_ );
+		if ( !( f > 0 ) ) // Also catches NaN
+			c[d] = 0;
+		else if ( f >= n_[d] )
+			c[d] = n_[d] - 1;
+		else
+			c[d] = f;
+	}
+}
+
+void SpatialGrid::build( const vector< double >& a,
+				const vector< double >& b )
+{
+	assert( a.size() == b.size() && a.size() % 3 == 0 );
+	clear();
+	unsigned int num = a.size() / 3;
+	double lo[3] = { 0.0, 0.0, 0.0 };
+	double hi[3] = { 0.0, 0.0, 0.0 };
+	double totLength = 0.0;
+	for ( unsigned int i = 0; i < num; ++i ) {
+		double len2 = 0.0;
+		for ( unsigned int d = 0; d < 3; ++d ) {
+			double p = a[ i * 3 + d ];
+			double q = b[ i * 3 + d ];
+			if ( i == 0 || lo[d] > p ) lo[d] = p;
+			if ( i == 0 || hi[d] < p ) hi[d] = p;
+			if ( lo[d] > q ) lo[d] = q;
+			if ( hi[d] < q ) hi[d] = q;
+			len2 += ( p - q ) * ( p - q );
+		}
+		totLength += sqrt( len2 );
+	}
+
+	// Aim for about one item per cell over the dimensions that the items
+	// actually span, but keep cells at least as long as the average
+	// segment so that segments do not spread over many cells.
+	double maxExtent = 0.0;
+	for ( unsigned int d = 0; d < 3; ++d )
+		if ( maxExtent < hi[d] - lo[d] )
+			maxExtent = hi[d] - lo[d];
+	double volume = 1.0;
+	unsigned int numDims = 0;
+	for ( unsigned int d = 0; d < 3; ++d ) {
+		if ( hi[d] - lo[d] > 1e-6 * maxExtent ) {
+			volume *= hi[d] - lo[d];
+			++numDims;
+		}
+	}
+	cell_ = 1.0;
+	if ( numDims > 0 && num > 0 ) {
+		cell_ = pow( volume / num, 1.0 / numDims );
+		if ( cell_ < totLength / num )
+			cell_ = totLength / num;
+	}
+	for ( unsigned int d = 0; d < 3; ++d ) {
+		origin_[d] = lo[d];
+		double n = ceil( ( hi[d] - lo[d] ) / cell_ );
+		n_[d] = n < 1 ? 1 : n;
+	}
+
+	// Two passes over the cell ranges of the bounding boxes: count, then
+	// fill, so that the lists are contiguous.
+	unsigned int numCells = n_[0] * n_[1] * n_[2];
+	start_.assign( numCells + 1, 0 );
+	for ( unsigned int pass = 0; pass < 2; ++pass ) {
+		for ( unsigned int i = 0; i < num; ++i ) {
+			int c0[3];
+			int c1[3];
+			cellOf( a[i*3], a[i*3+1], a[i*3+2], c0 );
+			cellOf( b[i*3], b[i*3+1], b[i*3+2], c1 );
+			for ( unsigned int d = 0; d < 3; ++d )
+				if ( c0[d] > c1[d] ) {
+					int t = c0[d]; c0[d] = c1[d]; c1[d] = t;
+				}
+			for ( int m = c0[2]; m <= c1[2]; ++m )
+				for ( int j = c0[1]; j <= c1[1]; ++j )
+					for ( int k = c0[0]; k <= c1[0]; ++k ) {
+						unsigned int cell = ( m * n_[1] + j ) * n_[0] + k;
+						if ( pass == 0 )
+							++start_[ cell + 1 ];
+						else
+							items_[ start_[cell]++ ] = i;
+					}
+		}
+		if ( pass == 0 ) {
+			for ( unsigned int c = 0; c < numCells; ++c )
+				start_[ c + 1 ] += start_[c];
+			items_.resize( start_[ numCells ] );
+		} else {
+			// Filling advanced each start_ to the next cell's start.
+			for ( unsigned int c = numCells; c > 0; --c )
+				start_[c] = start_[c - 1];
+			start_[0] = 0;
+		}
+	}
+	built_ = true;
+}
@@ -0,0 +1,115 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _SPATIAL_GRID_H
+#define _SPATIAL_GRID_H
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * Uniform grid over a set of line segments, for nearest item queries
+ * on meshes. Item i is the segment from a[i] to b[i], and a point is a
+ * segment whose ends coincide. Each item is listed in every cell
+ * overlapped by its bounding box, and a query visits shells of cells of
+ * increasing size around the query point until no unvisited cell can
+ * hold anything closer than the best item so far.
+ *
+ * The grid only holds geometry. Meshes build it lazily on the first
+ * query and clear it whenever their nodes or voxels change.
+ */
+class SpatialGrid
+{
+	public:
+		SpatialGrid();
+
+		/// Drops the index, so that isBuilt() is false.
+		void clear();
+
+		bool isBuilt() const;
+
+		/**
+		 * Indexes the segments a[i] to b[i]. Both vectors hold x y z
+		 * triplets, one per item.
+		 */
+		void build( const vector< double >& a, const vector< double >& b );
+
+		/**
+		 * Finds the item with the smallest dist( item ), ties going to
+		 * the lower item, so the result is the same as a linear scan
+		 * in item order. dist returns a negative value for items that
+		 * do not qualify, and otherwise the distance from (x,y,z) to
+		 * some point of the item's segment.
+		 * Returns that distance, or -1 if no item qualifies.
+		 */
+		template< class D > double nearest( double x, double y, double z,
+						D dist, unsigned int& item ) const
+		{
+			item = 0;
+			double best = -1.0;
+			if ( !built_ )
+				return best;
+			int c[3];
+			cellOf( x, y, z, c );
+			int maxRing = n_[0];
+			if ( maxRing < n_[1] ) maxRing = n_[1];
+			if ( maxRing < n_[2] ) maxRing = n_[2];
+			for ( int k = 0; k <= maxRing; ++k ) {
+				// Cells in shell k and beyond are at least k - 1 cells
+				// away from the query point.
+				if ( best >= 0 && best * ( 1.0 + 1e-9 ) < ( k - 1 ) * cell_ )
+					break;
+				for ( int i = c[0] - k; i <= c[0] + k; ++i ) {
+					if ( i < 0 || i >= n_[0] )
+						continue;
+					bool iEdge = ( i == c[0] - k || i == c[0] + k );
+					for ( int j = c[1] - k; j <= c[1] + k; ++j ) {
+						if ( j < 0 || j >= n_[1] )
+							continue;
+						bool edge = iEdge ||
+								( j == c[1] - k || j == c[1] + k );
+						int step = ( edge || k == 0 ) ? 1 : 2 * k;
+						for ( int m = c[2] - k; m <= c[2] + k; m += step ) {
+							if ( m < 0 || m >= n_[2] )
+								continue;
+							unsigned int cell = ( m * n_[1] + j ) * n_[0] + i;
+							for ( unsigned int q = start_[cell];
+									q < start_[cell + 1]; ++q ) {
+								unsigned int it = items_[q];
+								double r = dist( it );
+								if ( r < 0 )
+									continue;
+								if ( best < 0 || r < best ||
+										( r == best && it < item ) ) {
+									best = r;
+									item = it;
+								}
+							}
+						}
+					}
+				}
+			}
+			return best;
+		}
+
+	private:
+		/// Cell holding (x,y,z), clamped to the grid.
+		void cellOf( double x, double y, double z, int* c ) const;
+
+		bool built_;
+		double origin_[3];
+		double cell_;
+		int n_[3];
+		/// Items of cell c are items_[ start_[c] ] to items_[ start_[c+1] ]
+		vector< unsigned int > start_;
+		vector< unsigned int > items_;
+};
+
+#endif // _SPATIAL_GRID_H
@@ -1706,6 +1706,107 @@ void testVec()
 	cout << "." << flush;
 }
 
+/**
+ * Checks the spatial grid against a linear scan over segments and
+ * points, including exact ties, which must go to the lower item.
+ */
+void testSpatialGrid()
+{
+	vector< double > a;
+	vector< double > b;
+	unsigned int seed = 12345;
+	for ( unsigned int i = 0; i < 300; ++i ) {
+		for ( unsigned int d = 0; d < 3; ++d ) {
+			seed = seed * 1103515245 + 12345;
+			double p = ( seed >> 8 ) % 1000 * 1e-6;
+			seed = seed * 1103515245 + 12345;
+			double q = p + ( ( seed >> 8 ) % 21 - 10.0 ) * 1e-6;
+			a.push_back( p );
+			b.push_back( q );
+		}
+	}
+	// A duplicate of item 7, which must lose ties to it.
+	a.insert( a.end(), a.begin() + 21, a.begin() + 24 );
+	b.insert( b.end(), b.begin() + 21, b.begin() + 24 );
+	unsigned int num = a.size() / 3;
+
+	SpatialGrid grid;
+	assert( !grid.isBuilt() );
+	grid.build( a, b );
+	assert( grid.isBuilt() );
+
+	for ( unsigned int t = 0; t < 200; ++t ) {
+		double c[3];
+		for ( unsigned int d = 0; d < 3; ++d ) {
+			seed = seed * 1103515245 + 12345;
+			c[d] = ( ( seed >> 8 ) % 1400 - 200.0 ) * 1e-6;
+		}
+		if ( t == 0 ) { // Exactly on item 7 and its duplicate.
+			c[0] = b[21]; c[1] = b[22]; c[2] = b[23];
+		}
+		Vec cv( c[0], c[1], c[2] );
+		auto dist = [&]( unsigned int i ) -> double {
+			Vec p( a[i*3], a[i*3+1], a[i*3+2] );
+			Vec q( b[i*3], b[i*3+1], b[i*3+2] );
+			double len = p.distance( q );
+			double k = 0.0;
+			if ( len > 0 )
+				k = ( q - p ).dotProduct( cv - p ) / ( len * len );
+			if ( k < 0 || k > 1 )
+				return -1.0; // Only the segment interior qualifies.
+			return cv.distance( p.pointOnLine( q, k ) );
+		};
+		double best = -1.0;
+		unsigned int bestItem = 0;
+		for ( unsigned int i = 0; i < num; ++i ) {
+			double r = dist( i );
+			if ( r >= 0 && ( best < 0 || r < best ) ) {
+				best = r;
+				bestItem = i;
+			}
+		}
+		unsigned int item = ~0U;
+		double r = grid.nearest( c[0], c[1], c[2], dist, item );
+		assert( doubleEq( r, best ) );
+		if ( best >= 0 )
+			assert( item == bestItem );
+		if ( t == 0 )
+			assert( item == 7 );
+	}
+
+	grid.clear();
+	assert( !grid.isBuilt() );
+	unsigned int item;
+	assert( grid.nearest( 0, 0, 0, []( unsigned int ) { return 0.0; },
+							item ) < 0 );
+
+	// Points outside the filled volume of a CubeMesh go to the nearest
+	// surface voxel.
+	CubeMesh cube;
+	cube.setPreserveNumEntries( 0 );
+	vector< double > coords( 9, 10.0 );
+	coords[0] = coords[1] = coords[2] = 0.0;
+	coords[6] = coords[7] = coords[8] = 1.0;
+	cube.innerSetCoords( coords );
+	vector< unsigned int > s2m( 1000, CubeMesh::EMPTY );
+	s2m[0] = 0; // Voxel at 0.5, 0.5, 0.5
+	s2m[999] = 1; // Voxel at 9.5, 9.5, 9.5
+	cube.setSpaceToMesh( s2m );
+	vector< unsigned int > surface( 2 );
+	surface[0] = 0;
+	surface[1] = 999;
+	cube.setSurface( surface );
+	unsigned int index;
+	double r = cube.nearest( 8.1, 8.2, 8.3, index );
+	assert( index == 999 );
+	assert( doubleEq( r, -ChemCompt::distance( 1.4, 1.3, 1.2 ) ) );
+	r = cube.nearest( 1.5, 2.5, 1.5, index );
+	assert( index == 0 );
+	assert( doubleEq( r, -ChemCompt::distance( 1.0, 2.0, 1.0 ) ) );
+
+	cout << "." << flush;
+}
+
 #if 0
 void testSpineEntry()
 {
@@ -2136,6 +2237,7 @@ void testCellPortion()
 void testMesh()
 {
 	testVec();
+	testSpatialGrid();
 	testVolScaling();
 	// testCylBase();
 	// testNeuroNode();
@@ -175,6 +175,11 @@ ObjId Msg::getAdjacent(ObjId obj) const
     return findOtherEnd(obj);
 }
 
+bool Msg::sparseTargets( vector< SparseTargets >& v ) const
+{
+    return false;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // Here we set up the Element related stuff for Msgs.
 ///////////////////////////////////////////////////////////////////////////
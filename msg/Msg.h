@@ -10,6 +10,8 @@
 #ifndef _MSG_H
 #define _MSG_H
 
+struct SparseTargets;
+
 /**
  * Manages data flow between two elements. Is always many-to-many, with
  * assorted variants.
@@ -55,6 +57,15 @@ class Msg
 		  */
 		 virtual void targets( vector< vector< Eref > >& v ) const = 0;
 
+		/**
+		 * Fills v with a run of targets for each data entry on e1,
+		 * pointing into the Msg's own storage, and returns true. Msgs
+		 * that cannot do this return false, and the digest falls back to
+		 * targets(). The runs stay valid until the Msg marks e1 as
+		 * rewired, so the Msg must do so whenever its storage changes.
+		 */
+		virtual bool sparseTargets( vector< SparseTargets >& v ) const;
+
 		/**
 		 * Return the first element
 		 */
@@ -12,7 +12,12 @@
 #include "../randnum/randnum.h"
 #include "../shell/Shell.h"
 #include "../basecode/SparseMatrix.h"
+#include "../utility/utility.h"
+#include "../scheduling/ThreadPool.h"
 #include "SparseMsg.h"
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 // Initializing static variables
 Id SparseMsg::managerId_;
@@ -86,11 +91,37 @@ const Cinfo* SparseMsg::initCinfo()
 
     static ValueFinfo< SparseMsg, int > seed(
         "seed",
-        "Random number seed for generating probabilistic connectivity.",
+        "Random number seed for generating probabilistic connectivity. "
+        "Assigning it redoes the last random connectivity with the new "
+        "seed.",
         &SparseMsg::setSeed,
         &SparseMsg::getSeed
     );
 
+    static ValueFinfo< SparseMsg, double > spaceConstant(
+        "spaceConstant",
+        "If positive, random connectivity scales the connection "
+        "probability by exp( -distance / spaceConstant ), using the "
+        "sourcePositions and targetPositions. Applies from the next "
+        "assignment of connectivity. Default 0: no distance dependence.",
+        &SparseMsg::setSpaceConstant,
+        &SparseMsg::getSpaceConstant
+    );
+
+    static ValueFinfo< SparseMsg, vector< double > > sourcePositions(
+        "sourcePositions",
+        "Coordinates of the sources, as x0, y0, z0, x1, y1, z1 ...",
+        &SparseMsg::setSourcePositions,
+        &SparseMsg::getSourcePositions
+    );
+
+    static ValueFinfo< SparseMsg, vector< double > > targetPositions(
+        "targetPositions",
+        "Coordinates of the targets, as x0, y0, z0, x1, y1, z1 ...",
+        &SparseMsg::setTargetPositions,
+        &SparseMsg::getTargetPositions
+    );
+
 ////////////////////////////////////////////////////////////////////////
 // DestFinfos
 ////////////////////////////////////////////////////////////////////////
@@ -100,6 +131,18 @@ const Cinfo* SparseMsg::initCinfo()
             new OpFunc2< SparseMsg, double, long >(
                 &SparseMsg::setRandomConnectivity ) );
 
+    static DestFinfo setFixedInDegree( "setFixedInDegree",
+            "Connects each target to the specified number of distinct "
+            "sources, chosen at random with the specified seed",
+            new OpFunc2< SparseMsg, unsigned int, long >(
+                &SparseMsg::setFixedInDegree ) );
+
+    static DestFinfo setFixedOutDegree( "setFixedOutDegree",
+            "Connects each source to the specified number of distinct "
+            "targets, chosen at random with the specified seed",
+            new OpFunc2< SparseMsg, unsigned int, long >(
+                &SparseMsg::setFixedOutDegree ) );
+
     static DestFinfo setEntry( "setEntry",
             "Assigns single row,column value",
             new OpFunc3< SparseMsg, unsigned int, unsigned int, unsigned int >(
@@ -156,7 +199,12 @@ const Cinfo* SparseMsg::initCinfo()
         &rowStart,              // ReadOnlyValue
         &probability,           // value
         &seed,                  // value
+        &spaceConstant,         // value
+        &sourcePositions,       // value
+        &targetPositions,       // value
         &setRandomConnectivity, // dest
+        &setFixedInDegree,      // dest
+        &setFixedOutDegree,     // dest
         &setEntry,              // dest
         &unsetEntry,            // dest
         &clear,                 // dest
@@ -184,6 +232,7 @@ static const Cinfo* sparseMsgCinfo = SparseMsg::initCinfo();
 void SparseMsg::setProbability ( double probability )
 {
     p_ = probability;
+    rule_ = PROBABILITY;
     randomConnect( probability );
 }
 
@@ -197,7 +246,7 @@ void SparseMsg::setSeed (int seed)
     seed_ = seed;
     if( seed_ >= 0)
         rng_.setSeed((size_t)seed_);
-    randomConnect(p_);
+    reconnect();
 }
 
 int SparseMsg::getSeed () const
@@ -205,6 +254,36 @@ int SparseMsg::getSeed () const
     return seed_;
 }
 
+void SparseMsg::setSpaceConstant( double value )
+{
+    spaceConstant_ = value;
+}
+
+double SparseMsg::getSpaceConstant() const
+{
+    return spaceConstant_;
+}
+
+void SparseMsg::setSourcePositions( vector< double > v )
+{
+    sourcePositions_ = v;
+}
+
+vector< double > SparseMsg::getSourcePositions() const
+{
+    return sourcePositions_;
+}
+
+void SparseMsg::setTargetPositions( vector< double > v )
+{
+    targetPositions_ = v;
+}
+
+vector< double > SparseMsg::getTargetPositions() const
+{
+    return targetPositions_;
+}
+
 unsigned int SparseMsg::getNumRows() const
 {
     return matrix_.nRows();
@@ -265,24 +344,47 @@ vector< unsigned int > SparseMsg::getEntryPairs() const
 void SparseMsg::setRandomConnectivity( double probability, long seed )
 {
     p_ = probability;
+    rule_ = PROBABILITY;
     rng_.setSeed( seed );
     randomConnect( probability );
 }
 
+void SparseMsg::setFixedInDegree( unsigned int k, long seed )
+{
+    degree_ = k;
+    rule_ = FIXED_IN_DEGREE;
+    rng_.setSeed( seed );
+    fixedInDegreeConnect( k );
+}
+
+void SparseMsg::setFixedOutDegree( unsigned int k, long seed )
+{
+    degree_ = k;
+    rule_ = FIXED_OUT_DEGREE;
+    rng_.setSeed( seed );
+    fixedOutDegreeConnect( k );
+}
+
 void SparseMsg::setEntry(
     unsigned int row, unsigned int column, unsigned int value )
 {
     matrix_.set( row, column, value );
+    e1()->markRewired();
+    e2()->markRewired();
 }
 
 void SparseMsg::unsetEntry( unsigned int row, unsigned int column )
 {
     matrix_.unset( row, column );
+    e1()->markRewired();
+    e2()->markRewired();
 }
 
 void SparseMsg::clear()
 {
     matrix_.clear();
+    e1()->markRewired();
+    e2()->markRewired();
 }
 
 void SparseMsg::transpose()
@@ -385,6 +487,9 @@ SparseMsg::SparseMsg( Element* e1, Element* e2, unsigned int msgIndex )
       numThreads_( 1 ),
       nrows_( 0 ),
       p_( 0.0 ),
+      rule_( PROBABILITY ),
+      degree_( 0 ),
+      spaceConstant_( 0.0 ),
       seed_(-1)
 {
     unsigned int nrows = 0;
@@ -448,77 +553,267 @@ Eref SparseMsg::firstTgt( const Eref& src ) const
     return Eref( 0, 0 );
 }
 
+namespace {
+
+/// Rows of connectivity are generated this many to a task.
+const unsigned int RowsPerTask = 256;
+
+unsigned int numConnectThreads()
+{
+    static const unsigned int n = max( 1, moose::getEnvInt(
+                "MOOSE_NUM_THREADS", thread::hardware_concurrency() ) );
+    return n;
+}
+
+/**
+ * Fills out with the indices in [0, n) that are each picked with
+ * probability p, in increasing order. Rather than drawing a number for
+ * every index, it draws the gap to the next pick, which is geometric, so
+ * the cost goes as the number of picks.
+ */
+void bernoulliRow( moose::RNG& rng, unsigned int n, double p,
+                   vector< unsigned int >& out )
+{
+    out.clear();
+    if ( p <= 0.0 )
+        return;
+    if ( p >= 1.0 )
+    {
+        out.resize( n );
+        for ( unsigned int i = 0; i < n; ++i )
+            out[i] = i;
+        return;
+    }
+    const double logq = log1p( -p );
+    unsigned int j = 0; // Next candidate index.
+    while ( true )
+    {
+        // 1 - uniform is in (0, 1], so the log is finite.
+        double skip = floor( log( 1.0 - rng.uniform() ) / logq );
+        if ( skip >= n - j )
+            break;
+        j += static_cast< unsigned int >( skip );
+        out.push_back( j );
+        ++j;
+    }
+}
+
+/**
+ * Fills out with k distinct indices in [0, n) picked at random, in
+ * increasing order, using Floyd's algorithm: k draws whatever n is.
+ */
+void chooseRow( moose::RNG& rng, unsigned int n, unsigned int k,
+                vector< unsigned int >& out )
+{
+    out.clear();
+    if ( k >= n )
+    {
+        bernoulliRow( rng, n, 1.0, out );
+        return;
+    }
+    unordered_set< unsigned int > picked( 2 * k );
+    for ( unsigned int j = n - k; j < n; ++j )
+    {
+        unsigned int t = rng.uniform() * ( j + 1.0 );
+        if ( t > j ) // Rounding.
+            t = j;
+        if ( !picked.insert( t ).second )
+        {
+            // Nothing before has picked j, as all picks so far are < j.
+            t = j;
+            picked.insert( t );
+        }
+        out.push_back( t );
+    }
+    sort( out.begin(), out.end() );
+}
+
+double distance( const vector< double >& a, unsigned int i,
+                 const vector< double >& b, unsigned int j )
+{
+    double dx = a[3 * i] - b[3 * j];
+    double dy = a[3 * i + 1] - b[3 * j + 1];
+    double dz = a[3 * i + 2] - b[3 * j + 2];
+    return sqrt( dx * dx + dy * dy + dz * dz );
+}
+
+}
+
 /**
  * Returns number of synapses formed.
- * Fills it in transpose form, because we need to count and index the
- * number of synapses on the target, so we need to iterate over the sources
- * in the inner loop. Once full, does the transpose.
- * Should really have a seed argument for the random number.
- * Later need a way to fast-forward mtrand to just the entries we
- * need to fill.
+ * Each source row draws from its own stream, skipping straight from one
+ * connection to the next, so the cost goes as the number of synapses
+ * rather than the size of the matrix. If the spaceConstant is set, each
+ * candidate connection is then kept with probability
+ * exp( -distance / spaceConstant ).
  */
 unsigned int SparseMsg::randomConnect( double probability )
 {
-    unsigned int nRows = matrix_.nRows(); // Sources
-    unsigned int nCols = matrix_.nColumns();	// Destinations
-    matrix_.clear();
-    unsigned int totalSynapses = 0;
-    vector< unsigned int > sizes( nCols, 0 );
-    unsigned int totSynNum = 0;
-    Element* syn = e2_;
-    unsigned int startData = syn->localDataStart();
-    unsigned int endData = startData + syn->numLocalData();
+    unsigned int nRows = matrix_.nRows();
+    unsigned int nCols = matrix_.nColumns();
+    if ( spaceConstant_ <= 0.0 )
+    {
+        return buildConnectivity( false,
+            [=]( moose::RNG& rng, unsigned int, vector< unsigned int >& out )
+            {
+                bernoulliRow( rng, nCols, probability, out );
+            } );
+    }
+
+    if ( sourcePositions_.size() != 3 * nRows ||
+            targetPositions_.size() != 3 * nCols )
+    {
+        cout << "Warning: SparseMsg::randomConnect: spaceConstant is set "
+             "but there are " << sourcePositions_.size() / 3 <<
+             " source and " << targetPositions_.size() / 3 <<
+             " target positions, for " << nRows << " sources and " <<
+             nCols << " targets. Aborting\n";
+        return 0;
+    }
+    const vector< double >& src = sourcePositions_;
+    const vector< double >& tgt = targetPositions_;
+    const double lambda = spaceConstant_;
+    return buildConnectivity( false,
+        [=, &src, &tgt]( moose::RNG& rng, unsigned int row,
+                         vector< unsigned int >& out )
+        {
+            bernoulliRow( rng, nCols, probability, out );
+            unsigned int num = 0;
+            for ( unsigned int j : out )
+                if ( rng.uniform() < exp( -distance( src, row, tgt, j ) /
+                                          lambda ) )
+                    out[num++] = j;
+            out.resize( num );
+        } );
+}
 
-    assert( nCols == syn->numData() );
+unsigned int SparseMsg::fixedInDegreeConnect( unsigned int k )
+{
+    unsigned int nRows = matrix_.nRows();
+    return buildConnectivity( true,
+        [=]( moose::RNG& rng, unsigned int, vector< unsigned int >& out )
+        {
+            chooseRow( rng, nRows, k, out );
+        } );
+}
 
-    matrix_.transpose();
-    for ( unsigned int i = 0; i < nCols; ++i )
+unsigned int SparseMsg::fixedOutDegreeConnect( unsigned int k )
+{
+    unsigned int nCols = matrix_.nColumns();
+    return buildConnectivity( false,
+        [=]( moose::RNG& rng, unsigned int, vector< unsigned int >& out )
+        {
+            chooseRow( rng, nCols, k, out );
+        } );
+}
+
+unsigned int SparseMsg::reconnect()
+{
+    if ( rule_ == FIXED_IN_DEGREE )
+        return fixedInDegreeConnect( degree_ );
+    if ( rule_ == FIXED_OUT_DEGREE )
+        return fixedOutDegreeConnect( degree_ );
+    return randomConnect( p_ );
+}
+
+unsigned int SparseMsg::buildConnectivity( bool byColumn,
+    const std::function< void( moose::RNG&, unsigned int,
+                               vector< unsigned int >& ) >& gen )
+{
+    unsigned int nRows = matrix_.nRows(); // Sources
+    unsigned int nCols = matrix_.nColumns(); // Destinations
+    matrix_.clear();
+    e1()->markRewired();
+    e2()->markRewired();
+    if ( nRows == 0 || nCols == 0 )
+        return 0;
+    assert( nCols == e2_->numData() );
+
+    // Generate the lists, each from stream i of the seed.
+    const unsigned long seed = static_cast< unsigned long >( rng_.getSeed() );
+    const unsigned int numLists = byColumn ? nCols : nRows;
+    vector< vector< unsigned int > > lists( numLists );
+    const size_t numTasks = ( numLists + RowsPerTask - 1 ) / RowsPerTask;
+    auto task = [&]( size_t t )
     {
-        vector< unsigned int > synIndex;
-        // This needs to be obtained from current size of syn array.
-        // unsigned int synNum = sizes[ i ];
-        unsigned int synNum = 0;
-        for ( unsigned int j = 0; j < nRows; ++j )
+        moose::RNG rng;
+        unsigned int end = min( numLists,
+                static_cast< unsigned int >( ( t + 1 ) * RowsPerTask ) );
+        for ( unsigned int i = t * RowsPerTask; i < end; ++i )
         {
-            double r = rng_.uniform(); // Want to ensure it is called each time round the loop.
-            if ( r < probability )
-            {
-                synIndex.push_back( synNum );
-                ++synNum;
-                ++totSynNum;
-            }
-            else
-            {
-                synIndex.push_back( ~0 );
-            }
+            rng.setStream( seed, i );
+            gen( rng, i, lists[i] );
+        }
+    };
+    bool done = false;
+    if ( numTasks > 1 && numConnectThreads() > 1 )
+    {
+        static moose::ThreadPool pool( numConnectThreads() );
+        static mutex poolLock;
+        unique_lock< mutex > lock( poolLock, try_to_lock );
+        if ( lock.owns_lock() )
+        {
+            pool.parallelFor( numTasks, task );
+            done = true;
         }
+    }
+    if ( !done )
+        for ( size_t t = 0; t < numTasks; ++t )
+            task( t );
+
+    size_t total = 0;
+    for ( const auto& l : lists )
+        total += l.size();
+    if ( total >= ~0U )
+    {
+        cout << "Warning: SparseMsg::buildConnectivity: " << total <<
+             " synapses are too many to index. Aborting\n";
+        return 0;
+    }
 
-        if ( i >= startData && i < endData )
+    // Fill the CSR arrays directly.
+    vector< unsigned int > rowStart( nRows + 1, 0 );
+    vector< unsigned int > colIndex( total );
+    if ( byColumn )
+    {
+        // Counting sort of (source, target) by source. Going through the
+        // targets in order leaves each row sorted by column.
+        for ( const auto& l : lists )
+            for ( unsigned int r : l )
+                ++rowStart[ r + 1 ];
+        for ( unsigned int r = 0; r < nRows; ++r )
+            rowStart[ r + 1 ] += rowStart[ r ];
+        vector< unsigned int > next( rowStart.begin(), rowStart.end() - 1 );
+        for ( unsigned int c = 0; c < nCols; ++c )
         {
-            e2_->resizeField( i - startData, synNum );
+            for ( unsigned int r : lists[c] )
+                colIndex[ next[r]++ ] = c;
+            vector< unsigned int >().swap( lists[c] );
         }
-        totalSynapses += synNum;
-        matrix_.addRow( i, synIndex );
-        /*
-         * This is the correct form, but I need to implement something
-         * to check up for target nodes in order to use this.
-        if ( i >= startData && i < endData ) {
-        	e2_->resizeField( i - startData, synNum );
-        	totalSynapses += synNum;
-        	matrix_.addRow( i, synIndex );
-        } else {
-        	synIndex.resize( 0 );
-        	synIndex.assign( nRows, ~0 );
-        	matrix_.addRow( i, synIndex );
+    }
+    else
+    {
+        for ( unsigned int r = 0; r < nRows; ++r )
+        {
+            rowStart[ r + 1 ] = rowStart[ r ] + lists[r].size();
+            std::copy( lists[r].begin(), lists[r].end(),
+                       colIndex.begin() + rowStart[ r ] );
+            vector< unsigned int >().swap( lists[r] );
         }
-        */
     }
 
-    matrix_.transpose();
-    // cout << Shell::myNode() << ": sizes.size() = " << sizes.size() << ", ncols = " << nCols << ", startSynapse = " << startSynapse << endl;
-    e1()->markRewired();
-    e2()->markRewired();
-    return totalSynapses;
+    // Synapses on each target are numbered in order of source.
+    vector< unsigned int > entry( total );
+    vector< unsigned int > numAtTarget( nCols, 0 );
+    for ( size_t j = 0; j < total; ++j )
+        entry[j] = numAtTarget[ colIndex[j] ]++;
+    matrix_.swapArrays( entry, colIndex, rowStart );
+
+    unsigned int startData = e2_->localDataStart();
+    unsigned int endData = startData + e2_->numLocalData();
+    for ( unsigned int i = startData; i < endData; ++i )
+        e2_->resizeField( i - startData, numAtTarget[i] );
+    return total;
 }
 
 Id SparseMsg::managerId() const
@@ -529,9 +824,11 @@ Id SparseMsg::managerId() const
 void SparseMsg::setMatrix( const SparseMatrix< unsigned int >& m )
 {
     matrix_ = m;
+    e1()->markRewired();
+    e2()->markRewired();
 }
 
-SparseMatrix< unsigned int >& SparseMsg::getMatrix( )
+const SparseMatrix< unsigned int >& SparseMsg::getMatrix( ) const
 {
     return matrix_;
 }
@@ -628,6 +925,24 @@ void SparseMsg::targets( vector< vector< Eref > >& v ) const
     fillErefsFromMatrix( matrix_, v, e1_, e2_ );
 }
 
+bool SparseMsg::sparseTargets( vector< SparseTargets >& v ) const
+{
+    // A transposed matrix runs from e2 to e1, so leave it to targets().
+    if ( e1_->numData() != matrix_.nRows() ||
+            e2_->numData() != matrix_.nColumns() )
+        return false;
+    v.resize( matrix_.nRows() );
+    for ( unsigned int i = 0; i < matrix_.nRows(); ++i )
+    {
+        SparseTargets& st = v[i];
+        st.e = e2_;
+        st.dataIndex = 0;
+        st.fieldIndex = 0;
+        st.size = matrix_.getRow( i, &st.fieldIndex, &st.dataIndex );
+    }
+    return true;
+}
+
 /// Static function for Msg access
 unsigned int SparseMsg::numMsg()
 {
@@ -10,6 +10,7 @@
 #ifndef _SPARSE_MSG_H
 #define _SPARSE_MSG_H
 
+#include <functional>
 #include "../randnum/randnum.h"
 
 /**
@@ -57,8 +58,22 @@ public:
     void sources( vector< vector< Eref > >& v ) const;
     void targets( vector< vector< Eref > >& v ) const;
 
+    /// Hands out the rows of matrix_ in place, one run per source.
+    bool sparseTargets( vector< SparseTargets >& v ) const;
+
+    /**
+     * Connects each source to each target with the given probability,
+     * scaled by exp( -distance / spaceConstant ) if spaceConstant is
+     * positive. Returns the number of synapses formed.
+     */
     unsigned int randomConnect( double probability );
 
+    /// Connects each target to k distinct sources chosen at random.
+    unsigned int fixedInDegreeConnect( unsigned int k );
+
+    /// Connects each source to k distinct targets chosen at random.
+    unsigned int fixedOutDegreeConnect( unsigned int k );
+
     Id managerId() const;
 
     ObjId findOtherEnd( ObjId end ) const;
@@ -72,17 +87,28 @@ public:
     void setMatrix( const SparseMatrix< unsigned int >& m );
 
     /**
-     * Returns the connection matrix
+     * Returns the connection matrix. It is read-only because the send
+     * digests point into it: all changes go through the setters, which
+     * mark the message as rewired.
      */
-    SparseMatrix< unsigned int >& getMatrix();
+    const SparseMatrix< unsigned int >& getMatrix() const;
 
     // Uses default addToQ function.
 
     // Here we define the Element interface functions for SparseMsg
     void setRandomConnectivity( double probability, long seed );
+    void setFixedInDegree( unsigned int k, long seed );
+    void setFixedOutDegree( unsigned int k, long seed );
     double getProbability() const;
     void setProbability( double value );
 
+    void setSpaceConstant( double value );
+    double getSpaceConstant() const;
+    void setSourcePositions( vector< double > v );
+    vector< double > getSourcePositions() const;
+    void setTargetPositions( vector< double > v );
+    vector< double > getTargetPositions() const;
+
     vector< unsigned int > getMatrixEntry() const;
     vector< unsigned int > getColIndex() const;
     vector< unsigned int > getRowStart() const;
@@ -141,14 +167,41 @@ public:
     static const Cinfo* initCinfo();
 
 private:
+    /// The rule used by the last random connection, redone on setSeed.
+    enum ConnectRule { PROBABILITY, FIXED_IN_DEGREE, FIXED_OUT_DEGREE };
+
+    unsigned int reconnect();
+
+    /**
+     * Builds the whole matrix from per-row lists of column indices,
+     * each generated by gen( rng, row, list ) from its own stream of
+     * the seed, so that the rows can be made in parallel and the result
+     * does not depend on the number of threads.
+     * If byColumn is true the lists are the sources of each target
+     * instead, and are transposed into rows.
+     * Assigns the field index of each synapse, in order of source, and
+     * resizes the target fields. Returns the number of synapses.
+     */
+    unsigned int buildConnectivity( bool byColumn,
+        const std::function< void( moose::RNG&, unsigned int,
+                                   vector< unsigned int >& ) >& gen );
+
     SparseMatrix< unsigned int > matrix_;
     unsigned int numThreads_; // Number of threads to partition
     unsigned int nrows_; // The original size of the matrix.
     double p_;
+    ConnectRule rule_;
+    unsigned int degree_; // For the fixed degree rules.
+
+    /// Length constant for distance-dependent probability. 0 to ignore.
+    double spaceConstant_;
+    /// x, y, z of each source and of each target, for spaceConstant_.
+    vector< double > sourcePositions_;
+    vector< double > targetPositions_;
     static Id managerId_; // The Element that manages Sparse Msgs.
     static vector< SparseMsg* > msg_;
 
-    // RNG.
+    // RNG. Only its seed is used, as rows draw from their own streams.
     int seed_;
     moose::RNG rng_;
 };
@@ -154,6 +154,14 @@ py::cpp_function getDestFinfoSetterFunc2(const ObjId &oid, const Finfo *finfo,
         }
     }
 
+    if(ftype1 == "unsigned int" && ftype2 == "long") {
+        std::function<bool(unsigned int, long)> func =
+            [oid, fname](const unsigned int a, const long b) {
+                return SetGet2<unsigned int, long>::set(oid, fname, a, b);
+            };
+        return func;
+    }
+
     if(ftype1 == "string") {
         if(ftype2 == "string") {
             std::function<bool(string, string)> func = [oid, fname](string a,
@@ -87,12 +87,13 @@ public:
 
         bool isSameType = (expectedType == givenType);
 
+        FieldAccessor<T> field(name);
         bool res = true;
         for (size_t i = 0; i < size(); i++)
         {
             if (isSameType)
             {
-                res &= Field<T>::set(getItem(i), name, val);
+                res &= field.set(getItem(i), val);
                 continue;
             }
 
@@ -124,12 +125,13 @@ public:
                 "Expected " +
                 to_string(size()) + ", got " + to_string(val.size()));
 
+        FieldAccessor<T> field(name);
         bool res = true;
         for (size_t i = 0; i < size(); i++)
         {
             if (isSameType)
             {
-                res &= Field<T>::set(getItem(i), name, val[i]);
+                res &= field.set(getItem(i), val[i]);
                 continue;
             }
 
@@ -155,9 +157,11 @@ public:
     template <typename T>
     py::array_t<T> getAttributeNumpy(const string& name)
     {
-        vector<T> res(size());
+        vector<ObjId> items(size());
         for (unsigned int i = 0; i < size(); i++)
-            res[i] = Field<T>::get(getItem(i), name);
+            items[i] = getItem(i);
+        vector<T> res;
+        FieldAccessor<T>(name).getAll(items, res);
         return py::array_t<T>(res.size(), res.data());
     }
 
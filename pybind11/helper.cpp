@@ -14,6 +14,7 @@
 //
 // =====================================================================================
 
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <csignal>
@@ -40,6 +41,14 @@ namespace py = pybind11;
 #include "../shell/Wildcard.h"
 #include "../utility/strutil.h"
 #include "../randnum/randnum.h"
+#include "../ksolve/VoxelPoolsBase.h"
+#include "../ksolve/KsolveBase.h"
+#include "../hsolve/HSolveStruct.h"
+#include "../hsolve/HinesMatrix.h"
+#include "../hsolve/HSolvePassive.h"
+#include "../hsolve/RateLookup.h"
+#include "../hsolve/HSolveActive.h"
+#include "../hsolve/HSolve.h"
 
 #include "helper.h"
 
@@ -625,3 +634,172 @@ string mooseShowMsg(const ObjId& obj)
     }
     return ss.str();
 }
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @Synopsis  NumPy array viewing a solver's own state, without copying.
+ *
+ * For Ksolve and Gsolve, index is a voxel and the array holds n of every
+ * pool in it. For Dsolve, index is a pool and the array holds its n in
+ * every voxel. For HSolve, index is ignored and the array holds Vm of
+ * each compartment, in the order of HSolve.compartments.
+ *
+ * The array's base is the solver object. It points into the solver's
+ * storage, so it is only valid until the solver is rebuilt, e.g. by
+ * changing its compartment or stoich. Ask for a fresh view after that.
+ *
+ * @Param solver
+ * @Param index
+ * @Param writable If false (default) the array is read-only.
+ *
+ * @Returns
+ */
+/* ----------------------------------------------------------------------------*/
+py::array_t<double> mooseStateView(const ObjId& solver, unsigned int index,
+                                   bool writable)
+{
+    auto cinfo = solver.element()->cinfo();
+    double* data = nullptr;
+    unsigned int size = 0;
+    if(cinfo->isA("Ksolve") || cinfo->isA("Gsolve") || cinfo->isA("Dsolve"))
+        data = reinterpret_cast<KsolveBase*>(solver.data())
+                   ->getStateVec(index, size);
+    else if(cinfo->isA("HSolve"))
+        data = reinterpret_cast<HSolve*>(solver.data())->getVmVec(size);
+    else
+        throw py::type_error("stateView: '" + solver.path() +
+                             "' is not a Ksolve, Gsolve, Dsolve or HSolve.");
+
+    if(!data)
+        throw py::index_error("stateView: index " + to_string(index) +
+                              " is out of range on '" + solver.path() + "'.");
+
+    // Passing a base stops pybind11 from copying the data.
+    py::array_t<double> ret(size, data, py::cast(solver));
+    if(!writable)
+        ret.attr("setflags")(py::arg("write") = false);
+    return ret;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @Synopsis  Index of a trace column given by name or number.
+ */
+/* ----------------------------------------------------------------------------*/
+static size_t traceColumnIndex(const trace::Reader& reader,
+                               const py::object& column)
+{
+    int col = -1;
+    if(py::isinstance<py::str>(column)) {
+        col = reader.columnIndex(column.cast<string>());
+        if(col < 0)
+            throw py::key_error("No column '" + column.cast<string>() +
+                                "' in trace file.");
+    }
+    else {
+        col = column.cast<int>();
+        if(col < 0 || col >= (int)reader.columns().size())
+            throw py::index_error("Column " + to_string(col) +
+                                  " is out of range.");
+    }
+    return col;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @Synopsis  Rows [first, last) of a trace within [tmin, tmax]. None on
+ * either side leaves the window open on that side.
+ */
+/* ----------------------------------------------------------------------------*/
+static void traceRows(const trace::Reader& reader, const py::object& tmin,
+                      const py::object& tmax, uint64_t& first, uint64_t& last)
+{
+    double lo = tmin.is_none() ? -numeric_limits<double>::infinity()
+                               : tmin.cast<double>();
+    double hi = tmax.is_none() ? numeric_limits<double>::infinity()
+                               : tmax.cast<double>();
+    if(tmin.is_none() && tmax.is_none()) {
+        first = 0;
+        last = reader.numRows();
+    }
+    else
+        reader.timeWindow(lo, hi, first, last);
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @Synopsis  One column of a trace file, optionally limited to a time
+ * window.
+ *
+ * If the rows lie in one uncompressed block, the array is a read-only view
+ * of the mapped file and its base is the TraceFile. Otherwise only the
+ * blocks holding the rows are read, into a new array.
+ */
+/* ----------------------------------------------------------------------------*/
+py::array_t<double> mooseTraceColumn(const shared_ptr<trace::Reader>& reader,
+                                     const py::object& column,
+                                     const py::object& tmin,
+                                     const py::object& tmax)
+{
+    size_t col = traceColumnIndex(*reader, column);
+    uint64_t first, last;
+    traceRows(*reader, tmin, tmax, first, last);
+    const size_t n = last - first;
+
+    const auto& blocks = reader->blocks();
+    for(size_t b = 0; b < blocks.size() && n > 0; b++) {
+        if(first < blocks[b].firstRow ||
+           last > blocks[b].firstRow + blocks[b].numRows)
+            continue;
+        const double* p = reader->chunk(b, col);
+        if(!p)
+            break;
+        py::array_t<double> ret(n, p + first - blocks[b].firstRow,
+                                py::cast(reader));
+        ret.attr("setflags")(py::arg("write") = false);
+        return ret;
+    }
+
+    py::array_t<double> ret(n);
+    if(n > 0)
+        reader->read(col, first, n, ret.mutable_data());
+    return ret;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @Synopsis  A column of a trace file as a list of arrays, one per block in
+ * the time window. Uncompressed blocks are read-only views of the mapped
+ * file, so nothing is copied.
+ */
+/* ----------------------------------------------------------------------------*/
+py::list mooseTraceBlocks(const shared_ptr<trace::Reader>& reader,
+                          const py::object& column, const py::object& tmin,
+                          const py::object& tmax)
+{
+    size_t col = traceColumnIndex(*reader, column);
+    uint64_t first, last;
+    traceRows(*reader, tmin, tmax, first, last);
+
+    py::list ret;
+    py::object base = py::cast(reader);
+    const auto& blocks = reader->blocks();
+    for(size_t b = 0; b < blocks.size(); b++) {
+        uint64_t lo = max(first, blocks[b].firstRow);
+        uint64_t hi = min(last, blocks[b].firstRow + blocks[b].numRows);
+        if(lo >= hi)
+            continue;
+        const double* p = reader->chunk(b, col);
+        if(p) {
+            py::array_t<double> a(hi - lo, p + lo - blocks[b].firstRow, base);
+            a.attr("setflags")(py::arg("write") = false);
+            ret.append(a);
+        }
+        else {
+            py::array_t<double> a(hi - lo);
+            reader->read(col, lo, hi - lo, a.mutable_data());
+            ret.append(a);
+        }
+    }
+    return ret;
+}
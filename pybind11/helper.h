@@ -19,6 +19,7 @@
 
 #include "../shell/Shell.h"
 #include "../utility/strutil.h"
+#include "../utility/TraceFile.h"
 
 #include "MooseVec.h"
 #include "Finfo.h"
@@ -227,4 +228,16 @@ string mooseShowMsg(const ObjId& obj);
 
 vector<ObjId> mooseListMsg(const ObjId& obj);
 
+py::array_t<double> mooseStateView(const ObjId& solver, unsigned int index,
+                                   bool writable);
+
+py::array_t<double> mooseTraceColumn(const shared_ptr<trace::Reader>& reader,
+                                     const py::object& column,
+                                     const py::object& tmin,
+                                     const py::object& tmax);
+
+py::list mooseTraceBlocks(const shared_ptr<trace::Reader>& reader,
+                          const py::object& column, const py::object& tmin,
+                          const py::object& tmax);
+
 #endif /* end of include guard: HELPER_H */
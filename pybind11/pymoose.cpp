@@ -199,6 +199,10 @@ PYBIND11_MODULE(_moose, m)
 
     initModule(m);
 
+    // Output files must be closed while their writer thread still exists.
+    py::module::import("atexit").attr("register")(
+        py::cpp_function([]() { Shell::cleanUp(); }));
+
     // A thin wrapper around Id from ../basecode/Id.h .
     py::class_<Id>(m, "Id")
         .def_property_readonly("path", &Id::path)
@@ -397,6 +401,44 @@ PYBIND11_MODULE(_moose, m)
         // Wrapped object.
         .def_property_readonly("objid", &MooseVec::obj);
 
+    // Reader for the chunked trace files written by Table and Streamer.
+    py::class_<trace::Reader, shared_ptr<trace::Reader>>(m, "TraceFile",
+        R"moosedoc(TraceFile(path)
+
+    Memory mapped reader of an mtr or mtrz file written by a Table or
+    Streamer. Only the parts of the file that are accessed are read.
+    )moosedoc")
+        .def(py::init<const string &>(), "path"_a)
+        .def_property_readonly("columns", &trace::Reader::columns)
+        .def_property_readonly("numRows", &trace::Reader::numRows)
+        .def_property_readonly("blockRows", &trace::Reader::blockRows)
+        .def_property_readonly("numBlocks",
+                               [](const trace::Reader &r) {
+                                   return r.blocks().size();
+                               })
+        .def("__len__", &trace::Reader::numRows)
+        .def("column", &mooseTraceColumn, "column"_a, "tmin"_a = py::none(),
+             "tmax"_a = py::none(),
+             R"moosedoc(column(column, tmin=None, tmax=None)
+
+    Values of a column, given by name or number, for the rows whose time
+    (the first column) is in [tmin, tmax]. The array is a read-only view of
+    the file if the rows lie in one uncompressed block, and a copy of just
+    those rows otherwise.
+    )moosedoc")
+        .def("blocks", &mooseTraceBlocks, "column"_a, "tmin"_a = py::none(),
+             "tmax"_a = py::none(),
+             R"moosedoc(blocks(column, tmin=None, tmax=None)
+
+    Like column, but returns a list with one array per block. Arrays of
+    uncompressed blocks are read-only views of the file.
+    )moosedoc")
+        .def("__repr__", [](const trace::Reader &r) {
+            return "<moose.TraceFile columns=" +
+                   to_string(r.columns().size()) +
+                   " rows=" + to_string(r.numRows()) + ">";
+        });
+
     /**
      * MODULE FUNCTIONS such as moose.seed(10) etc.
      */
@@ -462,6 +504,18 @@ PYBIND11_MODULE(_moose, m)
 
     m.def("version_info", &mooseVersionInfo);
 
+    m.def("stateView", &mooseStateView, "solver"_a, "index"_a = 0,
+          "writable"_a = false,
+          R"moosedoc(stateView(solver, index=0, writable=False)
+
+    NumPy array viewing the state of a Ksolve, Gsolve, Dsolve or HSolve in
+    place, without copying. For Ksolve and Gsolve, index is a voxel and the
+    array holds n of every pool in it. For Dsolve, index is a pool and the
+    array holds its n in every voxel. For HSolve it holds the Vm of each
+    compartment, in the order of HSolve.compartments. The array follows the
+    simulation as it runs. It is only valid until the solver is rebuilt.
+    )moosedoc");
+
     // Attributes.
     m.attr("NA") = NA;
     m.attr("PI") = PI;
@@ -17,18 +17,32 @@
 #ifndef PYMOOSE_H
 #define PYMOOSE_H
 
+#include <unordered_map>
 #include "MooseVec.h"
 
+// Accessors are kept for the life of the module, so repeated access to the
+// same field from Python resolves its OpFunc only once per class. Python
+// calls hold the GIL, so these are never used from two threads at once.
+template <typename T>
+inline const FieldAccessor<T>& fieldAccessor(const string& fname)
+{
+    static unordered_map<string, FieldAccessor<T>> accessors;
+    auto it = accessors.find(fname);
+    if(it == accessors.end())
+        it = accessors.emplace(fname, FieldAccessor<T>(fname)).first;
+    return it->second;
+}
+
 template <typename T>
 inline bool setField(const ObjId& id, const string& fname, T val)
 {
-    return Field<T>::set(id, fname, val);
+    return fieldAccessor<T>(fname).set(id, val);
 }
 
 template <typename T>
 inline T getField(const ObjId& id, const string& fname)
 {
-    return Field<T>::get(id, fname);
+    return fieldAccessor<T>(fname).get(id);
 }
 
 // FIXME: Is it most efficient?
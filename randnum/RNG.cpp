@@ -8,10 +8,22 @@
  *        License:  MIT License
  */
 
+#include <cmath>
 #include "RNG.h"
 
 namespace moose {
 
+namespace {
+
+/// 53 bit double in [0, 1) from two 32 bit words.
+inline double toUniform( uint32_t a, uint32_t b )
+{
+    return ( ( a >> 5 ) * 67108864.0 + ( b >> 6 ) ) *
+           ( 1.0 / 9007199254740992.0 );
+}
+
+}
+
 RNG::RNG ()                                  /* constructor      */
 {
     // Setup a random seed if possible.
@@ -39,6 +51,11 @@ double RNG::getSeed( void )
  * @param seed
  */
 void RNG::setSeed( const unsigned long seed )
+{
+    setStream( seed, 0 );
+}
+
+void RNG::setStream( const unsigned long seed, const uint64_t stream )
 {
     seed_ = seed;
     if( seed == 0 )
@@ -46,7 +63,12 @@ void RNG::setSeed( const unsigned long seed )
         MOOSE_RANDOM_DEVICE rd_;
         seed_ = rd_();
     }
-    rng_.seed( seed_ );
+    stream_.seed( static_cast< uint64_t >( seed_ ), stream );
+}
+
+uint64_t RNG::streamOf( unsigned int id, unsigned int index )
+{
+    return ( static_cast< uint64_t >( id ) << 32 ) | index;
 }
 
 /**
@@ -57,7 +79,7 @@ void RNG::setSeed( const unsigned long seed )
  */
 double RNG::uniform( const double a, const double b)
 {
-    return ( b - a ) * dist_( rng_ ) + a;
+    return ( b - a ) * uniform() + a;
 }
 
 /**
@@ -68,7 +90,45 @@ double RNG::uniform( const double a, const double b)
  */
 double RNG::uniform( void )
 {
-    return dist_( rng_ );
+    uint32_t a = stream_();
+    return toUniform( a, stream_() );
+}
+
+void RNG::uniform( double* x, size_t n )
+{
+    // Raw words are made a chunk at a time, so that Philox::fill can
+    // run whole blocks back to back.
+    const size_t chunk = 256;
+    uint32_t w[ 2 * chunk ];
+    for ( size_t i = 0; i < n; i += chunk )
+    {
+        size_t m = ( n - i < chunk ) ? n - i : chunk;
+        stream_.fill( w, 2 * m );
+        for ( size_t j = 0; j < m; ++j )
+            x[ i + j ] = toUniform( w[ 2 * j ], w[ 2 * j + 1 ] );
+    }
+}
+
+void RNG::normal( double* x, size_t n )
+{
+    const double twoPi = 6.283185307179586;
+    const size_t chunk = 256;
+    double u[ chunk ];
+    for ( size_t i = 0; i < n; i += chunk )
+    {
+        size_t m = ( n - i < chunk ) ? n - i : chunk;
+        size_t numU = ( m + 1 ) & ~static_cast< size_t >( 1 );
+        uniform( u, numU );
+        for ( size_t j = 0; j < m; j += 2 )
+        {
+            // 1 - u is in (0, 1], so the log is finite.
+            double r = sqrt( -2.0 * log( 1.0 - u[ j ] ) );
+            double theta = twoPi * u[ j + 1 ];
+            x[ i + j ] = r * cos( theta );
+            if ( j + 1 < m )
+                x[ i + j + 1 ] = r * sin( theta );
+        }
+    }
 }
 
 }
@@ -23,9 +23,12 @@
 #include <iostream>
 #include <random>
 #include <cassert>
+#include <cstdint>
+#include <cstddef>
 
 #include "Definitions.h"
 #include "Distributions.h"
+#include "Philox.h"
 
 using namespace std;
 
@@ -35,7 +38,20 @@ namespace moose
 /*
  * =====================================================================================
  *        Class:  RNG
- *  Description:  Random number generator class.
+ *  Description:  Random number generator class, for objects that need their
+ *                own generator.
+ *
+ *  Built on the counter-based Philox engine: the state is the key (seed),
+ *  a 64 bit stream number and a counter, about 50 bytes in all, so it is
+ *  cheap to give every voxel or array entry its own stream. The numbers an
+ *  object draws depend only on (seed, stream) and on how many it has drawn
+ *  before, never on what other objects or threads do, so runs are
+ *  reproducible for any number of threads. streamOf names the usual stream
+ *  of an (object id, entry) pair.
+ *
+ *  The doubles are built from the raw bits here rather than through the
+ *  standard distributions, so sequences are also the same across compilers
+ *  and standard libraries.
  * =====================================================================================
  */
 
@@ -50,20 +66,41 @@ class RNG
         /* ====================  ACCESSORS     ======================================= */
         double getSeed( void );
 
+        /// Uses stream 0 of the given seed. A seed of 0 picks a random one.
         void setSeed( const unsigned long seed );
 
+        /**
+         * Switch to the given stream of the given seed. Distinct streams
+         * are independent, so callers that need many reproducible
+         * generators (e.g. voxels, Gsolve replicates) can number them
+         * rather than derive seeds.
+         */
+        void setStream( const unsigned long seed, const uint64_t stream );
+
+        /// The stream for entry index of the object with the given id.
+        static uint64_t streamOf( unsigned int id, unsigned int index );
+
         double uniform( const double a, const double b);
 
+        /// Uniform in [0, 1), with 53 random bits.
         double uniform( void );
 
+        /// Fills x with n uniforms in [0, 1), the same as n calls.
+        void uniform( double* x, size_t n );
+
+        /**
+         * Fills x with n standard normal deviates, by the Box-Muller
+         * transform on successive pairs of uniforms. An odd n uses up a
+         * whole pair for the last deviate.
+         */
+        void normal( double* x, size_t n );
+
 
     private:
         /* ====================  DATA MEMBERS  ======================================= */
-        double res_;
         double seed_;
 
-        moose::MOOSE_RNG_DEFAULT_ENGINE rng_;
-        moose::MOOSE_UNIFORM_DISTRIBUTION<double> dist_;
+        moose::Philox stream_;
 
 }; /* -----  end of template class RNG  ----- */
 
@@ -13,7 +13,32 @@ namespace moose {
 
 unsigned long __rng_seed__ = 0;
 
-RNG rng;
+namespace {
+
+/**
+ * The global generator stays a Mersenne Twister behind moose.seed and
+ * moose.rand, so that seeded scripts keep their numbers. Objects that
+ * draw numbers during a run have their own RNG streams instead.
+ */
+struct GlobalRNG
+{
+    GlobalRNG()
+    {
+        MOOSE_RANDOM_DEVICE rd;
+        engine.seed( rd() );
+    }
+
+    MOOSE_RNG_DEFAULT_ENGINE engine;
+    MOOSE_UNIFORM_DISTRIBUTION<double> dist;
+};
+
+GlobalRNG& globalRNG()
+{
+    static GlobalRNG g;
+    return g;
+}
+
+}
 
 /**
  * @brief Set the global seed or all rngs.
@@ -22,16 +47,21 @@ RNG rng;
  */
 void mtseed(unsigned int x)
 {
-    static bool isRNGInitialized = false;
     moose::__rng_seed__ = x;
-    moose::rng.setSeed(x);
-    isRNGInitialized = true;
+    unsigned long seed = x;
+    if( seed == 0 )
+    {
+        MOOSE_RANDOM_DEVICE rd;
+        seed = rd();
+    }
+    globalRNG().engine.seed( seed );
 }
 
 /*  Generate a random number */
 double mtrand(void)
 {
-    return moose::rng.uniform();
+    GlobalRNG& g = globalRNG();
+    return g.dist( g.engine );
 }
 
 double mtrand(double a, double b)
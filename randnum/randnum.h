@@ -17,11 +17,6 @@ using namespace std;
 
 namespace moose {
 
-/**
- * @Synopsis  Global RNG.
- */
-extern RNG rng;
-
 /**
  * @brief A global seed for all RNGs in moose. When moose.seed( x ) is called,
  * this variable is set. Other's RNGs (except muparser) uses this seed to
@@ -51,10 +51,7 @@
 #include "../basecode/header.h"
 #include "../utility/print_function.hpp"
 #include "Clock.h"
-
-#if PARALLELIZE_CLOCK_USING_CPP11_ASYNC
-#include <future>
-#endif
+#include "ThreadPool.h"
 
 // Declaration of some static variables.
 const unsigned int Clock::numTicks = 32;
@@ -181,6 +178,22 @@ const Cinfo* Clock::initCinfo()
         &Clock::getDts
     );
 
+    static ValueFinfo< Clock, unsigned int > numThreads(
+        "numThreads",
+        "Number of threads used to call the process functions of the "
+        "objects on a single tick. Since the order of execution within "
+        "a tick is undefined, the targets of a tick are split into tasks "
+        "and run on a persistent work-stealing pool that is built at "
+        "reinit. Default is 1, which calls all targets serially. "
+        "Only classes that declare their process function safe to run "
+        "concurrently are split up, and only if none of their messages "
+        "lead to an object on the same tick. Their sends are queued and "
+        "delivered serially once the tick is done. All other targets "
+        "are called serially, in their usual order.",
+        &Clock::setNumThreads,
+        &Clock::getNumThreads
+    );
+
     static ReadOnlyValueFinfo< Clock, bool > isRunning(
         "isRunning",
         "Utility function to report if simulation is in progress.",
@@ -268,6 +281,7 @@ const Cinfo* Clock::initCinfo()
         &currentStep,           // ReadOnlyValue
         &dts,                   // ReadOnlyValue
         &isRunning,             // ReadOnlyValue
+        &numThreads,            // Value
         &tickStep,              // LookupValue
         &tickDt,                // LookupValue
         &defaultTick,           // ReadOnlyLookupValue
@@ -360,6 +374,7 @@ const Cinfo* Clock::initCinfo()
         "   STDPSynHandler       1       50e-6\n"
         "   GraupnerBrunel2012CaPlasticitySynHandler    1        50e-6\n"
         "   SeqSynHandler        1       50e-6\n"
+        "   SpikeDelivery        1       50e-6\n"
         "    CaConc              1       50e-6\n"
         "    CaConcBase          1       50e-6\n"
         "    DifShell            1       50e-6\n"
@@ -378,6 +393,7 @@ const Cinfo* Clock::initCinfo()
         "    AdExIF              2       50e-6\n"
         "    AdThreshIF          2       50e-6\n"
         "    IzhIF               2       50e-6\n"
+        "    IntFirePop          2       50e-6\n"
         "    IzhikevichNrn       2       50e-6\n"        
         "    MarkovGslSolver     2       50e-6\n"
         "    MarkovRateTable     2       50e-6\n"
@@ -401,6 +417,7 @@ const Cinfo* Clock::initCinfo()
         "    MarkovChannel       4       50e-6\n"        
         "    SpikeGen             5      50e-6\n"
         "    HSolve               6      50e-6\n"
+        "    HSolvePop            6      50e-6\n"
         "    SpikeStats           7      50e-6\n"
         "    Table                8      0.1e-3\n"
         "    TimeTable            8      0.1e-3\n"
@@ -459,7 +476,8 @@ Clock::Clock()
       isRunning_( false ),
       doingReinit_( false ),
       info_(),
-      ticks_( Clock::numTicks, 0 )
+      ticks_( Clock::numTicks, 0 ),
+      numThreads_( 1 )
 {
     buildDefaultTick();
     dt_ = defaultDt_[0];
@@ -538,6 +556,21 @@ vector< double > Clock::getDts() const
     return ret;
 }
 
+void Clock::setNumThreads( unsigned int v )
+{
+    if ( isRunning_ || doingReinit_ )
+    {
+        cout << "Warning: Clock::setNumThreads: Cannot change numThreads while simulation is running\n";
+        return;
+    }
+    numThreads_ = ( v == 0 ) ? 1 : v;
+}
+
+unsigned int Clock::getNumThreads() const
+{
+    return numThreads_;
+}
+
 bool Clock::isRunning() const
 {
     return isRunning_;
@@ -685,6 +718,172 @@ void Clock::buildTicks( const Eref& e )
     // Should really do the HCF of N numbers here to get the stride.
 }
 
+/**
+ * True if any message of elm leads to one of the Elements in tickElms.
+ * Messages into a FieldElement count as messages into its parent, since
+ * that is where the field data lives.
+ */
+static bool sendsIntoTick( const Element* elm,
+        const vector< const Element* >& tickElms )
+{
+    for ( BindIndex b = 0; b < elm->cinfo()->numBindIndex(); ++b )
+    {
+        const vector< MsgFuncBinding >* mb = elm->getMsgAndFunc( b );
+        if ( !mb )
+            continue;
+        for ( const MsgFuncBinding& i : *mb )
+        {
+            const Msg* m = Msg::getMsg( i.mid );
+            const Element* tgt = ( m->e1() == elm ) ? m->e2() : m->e1();
+            if ( tgt->hasFields() )
+                tgt = Neutral::parent( ObjId( tgt->id() ) ).element();
+            if ( find( tickElms.begin(), tickElms.end(), tgt ) !=
+                    tickElms.end() )
+                return true;
+        }
+    }
+    return false;
+}
+
+void Clock::buildTickTasks( const Eref& e )
+{
+    tickTasks_.clear();
+    if ( !pool_ )
+        return;
+    unsigned int nt = pool_->numThreads();
+    tickTasks_.resize( activeTicksMap_.size() );
+    for ( unsigned int i = 0; i < activeTicksMap_.size(); ++i )
+    {
+        const SrcFinfo1< ProcPtr >* sf = processVec()[ activeTicksMap_[i] ];
+        MsgDigestRange md = e.msgDigest( sf->getBindIndex() );
+
+        vector< const Element* > tickElms;
+        for ( const MsgDigest* j = md.begin(); j != md.end(); ++j )
+        {
+            for ( const Eref* k = j->targets.begin();
+                    k != j->targets.end(); ++k )
+                tickElms.push_back( k->element() );
+            for ( const SparseTargets& s : j->sparseTargets )
+                tickElms.push_back( s.e );
+        }
+
+        vector< TickTask >& tasks = tickTasks_[i];
+        bool anyParallel = false;
+        for ( const MsgDigest* j = md.begin(); j != md.end(); ++j )
+        {
+            const OpFunc1Base< ProcPtr >* f =
+                j->typedFunc< OpFunc1Base< ProcPtr > >();
+            for ( const Eref* k = j->targets.begin();
+                    k != j->targets.end(); ++k )
+            {
+                Element* elm = k->element();
+                bool par = elm->cinfo()->parallelProcess() &&
+                    !sendsIntoTick( elm, tickElms );
+                anyParallel |= par;
+                if ( k->dataIndex() != ALLDATA || !par )
+                {
+                    tasks.push_back( TickTask{ f, *k, 0, par } );
+                    continue;
+                }
+                // A few blocks per thread leaves room for stealing.
+                unsigned int start = elm->localDataStart();
+                unsigned int end = start + elm->numLocalData();
+                unsigned int block = 1 + ( end - start ) / ( 4 * nt );
+                for ( unsigned int b = start; b < end; b += block )
+                    tasks.push_back( TickTask{ f, Eref( elm, b ),
+                            min( end, b + block ), true } );
+            }
+            for ( const SparseTargets& s : j->sparseTargets )
+            {
+                bool par = s.e->cinfo()->parallelProcess() &&
+                    !sendsIntoTick( s.e, tickElms );
+                anyParallel |= par;
+                for ( unsigned int k = 0; k < s.size; ++k )
+                    tasks.push_back( TickTask{ f,
+                        Eref( s.e, s.dataIndex[k], s.fieldIndex[k] ), 0,
+                        par } );
+            }
+        }
+        // Nothing to gain over the plain send.
+        if ( !anyParallel )
+            tasks.clear();
+    }
+}
+
+void Clock::runTask( const TickTask& t, ProcPtr p )
+{
+    if ( t.end == 0 )
+    {
+        if ( t.er.dataIndex() != ALLDATA )
+        {
+            t.func->op( t.er, p );
+            return;
+        }
+        // A whole Element that is not split up, as send would do it.
+        Element* elm = t.er.element();
+        unsigned int start = elm->localDataStart();
+        unsigned int end = start + elm->numLocalData();
+        for ( unsigned int k = start; k < end; ++k )
+            t.func->op( Eref( elm, k ), p );
+        return;
+    }
+    Element* elm = t.er.element();
+    for ( unsigned int k = t.er.dataIndex(); k < t.end; ++k )
+        t.func->op( Eref( elm, k ), p );
+}
+
+void Clock::runParallel( const vector< TickTask >& tasks,
+        size_t begin, size_t end )
+{
+    size_t n = end - begin;
+    if ( sendQueues_.size() < n )
+        sendQueues_.resize( n );
+    vector< vector< function< void() > > >& queues = sendQueues_;
+    ProcPtr p = &info_;
+    pool_->parallelFor( n, [&tasks, &queues, begin, p]( size_t i )
+    {
+        SrcFinfo::sendQueue = &queues[i];
+        runTask( tasks[ begin + i ], p );
+        SrcFinfo::sendQueue = 0;
+    } );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        for ( const function< void() >& f : queues[i] )
+            f();
+        queues[i].clear();
+    }
+}
+
+void Clock::dispatchTick( const Eref& e, unsigned int tick,
+        unsigned int activeIndex )
+{
+    if ( !pool_ || tickTasks_[ activeIndex ].size() < 2 )
+    {
+        processVec()[ tick ]->send( e, &info_ );
+        return;
+    }
+    // Runs of parallel tasks go to the pool. The others are called
+    // here, in their place in the serial order.
+    const vector< TickTask >& tasks = tickTasks_[ activeIndex ];
+    size_t i = 0;
+    while ( i < tasks.size() )
+    {
+        size_t j = i;
+        while ( j < tasks.size() && tasks[j].parallel )
+            ++j;
+        if ( j - i > 1 )
+        {
+            runParallel( tasks, i, j );
+            i = j;
+        }
+        else
+        {
+            runTask( tasks[i], &info_ );
+            ++i;
+        }
+    }
+}
+
 /**
  * Start has to happen gracefully: If the simulation was stopped for any
  * reason, it has to pick up where it left off.
@@ -713,6 +912,7 @@ void Clock::handleStep( const Eref& e, unsigned long numSteps )
     char now[80];
 
     buildTicks( e );
+    buildTickTasks( e );
 	if (nSteps_ == 0 )
 		info_.setFirstStep();
 	else
@@ -728,40 +928,6 @@ void Clock::handleStep( const Eref& e, unsigned long numSteps )
         unsigned long endStep = currentStep_ + stride_;
         currentTime_ = info_.currTime = dt_ * endStep;
 
-#if 0
-
-//#if PARALLELIZE_CLOCK_USING_CPP11_ASYNC
-
-        // NOTE: It does not produce very promising results. The challenge here
-        // is doing load-balancing.
-        // TODO: To start with, we can put one solver on one thread and everything
-        // else onto 1 thread. Each Hsove, Ksolve, and Gsolve can take its own
-        // thread and rest are on different threads.
-
-        unsigned int nTasks = activeTicks_.size( );
-        unsigned int numThreads_ = 3;
-        unsigned int blockSize = 1 + (nTasks / numThreads_);
-
-        for( unsigned int i = 0; i < numThreads_; ++i  )
-        {
-            std::async( std::launch::async, [this,blockSize,i,nTasks,endStep,e]
-            {
-                unsigned int mapI = i * blockSize;
-                // Get the block we want to run in paralle.
-                for( unsigned int ii = i * blockSize; ii < min((i+1) * blockSize, nTasks); ii++ )
-                {
-                    unsigned int j = activeTicks_[ ii ];
-                    if( endStep % j == 0  )
-                    {
-                        info_.dt = j * dt_;
-                        processVec( )[ activeTicksMap_[mapI] ]->send( e, &info_ );
-                    }
-                    mapI++;
-                }
-            }
-          );
-        }
-#else
         vector< unsigned int >::const_iterator k = activeTicksMap_.begin();
         for ( vector< unsigned int>::iterator j =
                     activeTicks_.begin(); j != activeTicks_.end(); ++j )
@@ -769,11 +935,10 @@ void Clock::handleStep( const Eref& e, unsigned long numSteps )
             if ( endStep % *j == 0 )
             {
                 info_.dt = *j * dt_;
-                processVec()[*k]->send( e, &info_ );
+                dispatchTick( e, *k, k - activeTicksMap_.begin() );
             }
             ++k;
         }
-#endif
 		info_.setRunning();
 
         // When 10% of simulation is over, notify user when notify_ is set to
@@ -813,6 +978,15 @@ void Clock::handleReinit( const Eref& e )
     currentStep_ = 0;
     nSteps_ = 0;
     buildTicks( e );
+    if ( numThreads_ > 1 )
+    {
+        if ( !pool_ || pool_->numThreads() != numThreads_ )
+            pool_ = make_shared< moose::ThreadPool >( numThreads_ );
+    }
+    else
+    {
+        pool_.reset();
+    }
     doingReinit_ = true;
     // Curr time is end of current step.
     info_.currTime = 0.0;
@@ -881,6 +1055,7 @@ void Clock::buildDefaultTick()
     defaultTick_["STDPSynHandler"] = 1;
     defaultTick_["GraupnerBrunel2012CaPlasticitySynHandler"] = 1;
     defaultTick_["SeqSynHandler"] = 1;
+    defaultTick_["SpikeDelivery"] = 1;
     defaultTick_["CaConc"] = 1;
     defaultTick_["CaConcBase"] = 1;
     defaultTick_["DifShell"] = 1;
@@ -899,6 +1074,7 @@ void Clock::buildDefaultTick()
     defaultTick_["AdExIF"] = 2;
     defaultTick_["AdThreshIF"] = 2;
     defaultTick_["IzhIF"] = 2;
+    defaultTick_["IntFirePop"] = 2;
     defaultTick_["IzhikevichNrn"] = 2;
     defaultTick_["MarkovOdeSolver"] = 2;
     defaultTick_["MarkovRateTable"] = 2;
@@ -919,6 +1095,7 @@ void Clock::buildDefaultTick()
     defaultTick_["MarkovChannel"] = 4;
     defaultTick_["SpikeGen"] = 5;
     defaultTick_["HSolve"] = 6;
+    defaultTick_["HSolvePop"] = 6;
     defaultTick_["SpikeStats"] = 7;
     defaultTick_["Table"] = 8;
     defaultTick_["TimeTable"] = 8;
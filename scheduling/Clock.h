@@ -10,6 +10,12 @@
 #ifndef _CLOCK_H
 #define _CLOCK_H
 
+#include <memory>
+
+namespace moose {
+    class ThreadPool;
+}
+
 /**
  * Clock now uses integral scheduling. The Clock has an array of child
  * Ticks, each of which controls the process and reinit calls of its
@@ -48,6 +54,9 @@ class Clock
 
     vector< double > getDts() const;
 
+    void setNumThreads( unsigned int v );
+    unsigned int getNumThreads() const;
+
     //////////////////////////////////////////////////////////
     //  Dest functions
     //////////////////////////////////////////////////////////
@@ -122,6 +131,44 @@ class Clock
 
     private:
     void buildTicks( const Eref& e );
+
+    /**
+     * Flattens the process targets of each active tick into a list of
+     * tasks for the worker pool. Element arrays are split into blocks of
+     * data entries. A task may run in parallel only if its class has
+     * declared Cinfo::parallelProcess, and none of its messages lead to
+     * an Element processed on the same tick.
+     */
+    void buildTickTasks( const Eref& e );
+
+    /// Sends process to all targets of tick i, using the pool if any.
+    void dispatchTick( const Eref& e, unsigned int tick,
+            unsigned int activeIndex );
+
+    /**
+     * One unit of work within a tick: either a single target
+     * Eref (end == 0), or the block of data entries from the
+     * dataIndex of er up to end on an Element array.
+     */
+    struct TickTask
+    {
+        const OpFunc1Base< ProcPtr >* func;
+        Eref er;
+        unsigned int end;
+        bool parallel;
+    };
+
+    /// Calls process on the target(s) of one task.
+    static void runTask( const TickTask& t, ProcPtr p );
+
+    /**
+     * Runs tasks [begin, end) of a tick on the pool. Their sends are
+     * queued per task and delivered serially, in task order, after all
+     * of them are done.
+     */
+    void runParallel( const vector< TickTask >& tasks,
+            size_t begin, size_t end );
+
     double runTime_;
     double currentTime_;
     unsigned long nSteps_;
@@ -170,6 +217,28 @@ class Clock
 
     static vector< double > defaultDt_;
 
+    /**
+     * Number of threads used to dispatch the targets of a tick. 1 means
+     * the original serial dispatch.
+     */
+    unsigned int numThreads_;
+
+    /**
+     * Persistent worker pool, built at reinit when numThreads_ > 1.
+     * Shared rather than unique only because Dinfo needs Clock to be
+     * copyable.
+     */
+    shared_ptr< moose::ThreadPool > pool_;
+
+    /**
+     * Task lists indexed in parallel with activeTicks_. Empty for ticks
+     * that have nothing to run in parallel.
+     */
+    vector< vector< TickTask > > tickTasks_;
+
+    /// Queued sends of each task of a parallel run, reused across ticks.
+    vector< vector< function< void() > > > sendQueues_;
+
     /**
      * @brief When set to true, notify user about the status of
      * simulation by emitting message whenever 10\% of simultion is
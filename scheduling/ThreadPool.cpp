@@ -0,0 +1,149 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include <cassert>
+#include "ThreadPool.h"
+
+using namespace std;
+
+namespace moose
+{
+
+ThreadPool::ThreadPool( unsigned int numThreads )
+    : job_( nullptr ),
+      pending_( 0 ),
+      generation_( 0 ),
+      shutdown_( false )
+{
+    if ( numThreads == 0 )
+        numThreads = 1;
+    for ( unsigned int i = 0; i < numThreads; ++i )
+        queues_.push_back( unique_ptr< TaskQueue >( new TaskQueue() ) );
+    for ( unsigned int i = 1; i < numThreads; ++i )
+        workers_.push_back( thread( &ThreadPool::workerLoop, this, i ) );
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard< mutex > lock( lock_ );
+        shutdown_ = true;
+    }
+    wake_.notify_all();
+    for ( auto& w : workers_ )
+        w.join();
+}
+
+unsigned int ThreadPool::numThreads() const
+{
+    return queues_.size();
+}
+
+void ThreadPool::parallelFor( size_t numTasks,
+        const function< void( size_t ) >& task )
+{
+    if ( numTasks == 0 )
+        return;
+    if ( queues_.size() == 1 || numTasks == 1 )
+    {
+        for ( size_t i = 0; i < numTasks; ++i )
+            task( i );
+        return;
+    }
+
+    job_ = &task;
+    pending_ = numTasks;
+
+    // Deal out contiguous blocks so neighbouring data entries stay on
+    // one core unless someone has to steal them.
+    size_t nq = queues_.size();
+    size_t block = ( numTasks + nq - 1 ) / nq;
+    for ( size_t q = 0; q < nq; ++q )
+    {
+        lock_guard< mutex > lock( queues_[q]->lock );
+        size_t end = min( numTasks, ( q + 1 ) * block );
+        for ( size_t i = q * block; i < end; ++i )
+            queues_[q]->tasks.push_back( i );
+    }
+    {
+        lock_guard< mutex > lock( lock_ );
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    drain( 0 );
+
+    unique_lock< mutex > lock( lock_ );
+    done_.wait( lock, [this] { return pending_ == 0; } );
+    job_ = nullptr;
+}
+
+void ThreadPool::workerLoop( unsigned int id )
+{
+    unsigned long seen = 0;
+    while ( true )
+    {
+        {
+            unique_lock< mutex > lock( lock_ );
+            wake_.wait( lock,
+                    [this, seen] { return shutdown_ || generation_ != seen; } );
+            if ( shutdown_ )
+                return;
+            seen = generation_;
+        }
+        drain( id );
+    }
+}
+
+void ThreadPool::drain( unsigned int id )
+{
+    size_t task;
+    while ( popLocal( id, task ) || steal( id, task ) )
+    {
+        assert( job_ );
+        ( *job_ )( task );
+        if ( --pending_ == 0 )
+        {
+            // Take the lock so the notification cannot slip in between
+            // the caller testing the predicate and going to sleep.
+            lock_guard< mutex > lock( lock_ );
+            done_.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::popLocal( unsigned int id, size_t& task )
+{
+    TaskQueue& q = *queues_[id];
+    lock_guard< mutex > lock( q.lock );
+    if ( q.tasks.empty() )
+        return false;
+    task = q.tasks.back();
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal( unsigned int id, size_t& task )
+{
+    size_t nq = queues_.size();
+    for ( size_t i = 1; i < nq; ++i )
+    {
+        TaskQueue& q = *queues_[ ( id + i ) % nq ];
+        lock_guard< mutex > lock( q.lock );
+        if ( !q.tasks.empty() )
+        {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace moose
@@ -0,0 +1,90 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace moose
+{
+
+/**
+ * Persistent pool of worker threads with work-stealing.
+ *
+ * The pool is built once (typically at reinit) and reused for every
+ * parallelFor call, so there is no thread creation cost per timestep.
+ * Each call deals the task indices out in contiguous blocks, one deque
+ * per worker. A worker pops from the back of its own deque and, when that
+ * is empty, steals from the front of the others. This evens out the load
+ * when a few tasks (an HSolve, a big Ksolve) are much more expensive than
+ * the rest.
+ *
+ * The calling thread takes part as worker 0, so a pool of N threads
+ * spawns N-1 helpers.
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool( unsigned int numThreads );
+    ~ThreadPool();
+
+    /// Total number of threads that execute tasks, including the caller.
+    unsigned int numThreads() const;
+
+    /**
+     * Runs task( i ) for every i in [0, numTasks), and returns when all
+     * of them are complete. Must not be called re-entrantly from within
+     * a task.
+     */
+    void parallelFor( size_t numTasks,
+            const std::function< void( size_t ) >& task );
+
+private:
+    struct TaskQueue
+    {
+        std::mutex lock;
+        std::deque< size_t > tasks;
+    };
+
+    void workerLoop( unsigned int id );
+
+    /// Runs tasks, own ones first and then stolen ones, till none are left
+    void drain( unsigned int id );
+    bool popLocal( unsigned int id, size_t& task );
+    bool steal( unsigned int id, size_t& task );
+
+    std::vector< std::thread > workers_;
+    std::vector< std::unique_ptr< TaskQueue > > queues_;
+
+    /// The job of the current parallelFor call.
+    const std::function< void( size_t ) >* job_;
+
+    /// Number of tasks of the current call not yet completed.
+    std::atomic< size_t > pending_;
+
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    /// Incremented for every parallelFor call, to wake up the workers.
+    unsigned long generation_;
+    bool shutdown_;
+};
+
+}  // namespace moose
+
+#endif // _THREAD_POOL_H
@@ -10,12 +10,14 @@
 #include "../basecode/header.h"
 #include "testScheduling.h"
 #include "Clock.h"
+#include "ThreadPool.h"
 
 #include "../basecode/SparseMatrix.h"
 #include "../msg/SparseMsg.h"
 #include "../msg/SingleMsg.h"
 #include "../builtins/Arith.h"
 #include "../shell/Shell.h"
+#include "../randnum/randnum.h"
 
 
 //////////////////////////////////////////////////////////////////////
@@ -180,14 +182,125 @@ void testClockMessaging()
 	cout << "." << flush;
 }
 
+/**
+ * Check that the work-stealing pool runs every task exactly once, also
+ * when the tasks are very uneven in cost.
+ */
+void testThreadPool()
+{
+	moose::ThreadPool pool( 4 );
+	assert( pool.numThreads() == 4 );
+	const size_t numTasks = 1000;
+	vector< unsigned int > hits( numTasks, 0 );
+	for ( unsigned int rep = 0; rep < 10; ++rep ) {
+		pool.parallelFor( numTasks, [&hits]( size_t i ) {
+			// A few expensive tasks at the start to force stealing.
+			double x = 0.0;
+			if ( i < 4 )
+				for ( unsigned int j = 0; j < 100000; ++j )
+					x += sqrt( j );
+			hits[i] += 1 + ( x < 0.0 );
+		} );
+	}
+	for ( size_t i = 0; i < numTasks; ++i )
+		assert( hits[i] == 10 );
+
+	moose::ThreadPool serial( 1 );
+	size_t tot = 0;
+	serial.parallelFor( numTasks, [&tot]( size_t i ) { tot += i; } );
+	assert( tot == numTasks * ( numTasks - 1 ) / 2 );
+	cout << "." << flush;
+}
+
+/**
+ * Builds a sparse IntFire network with SimpleSynHandlers and spike
+ * Tables, runs it with the given number of Clock threads, and returns
+ * the final Vms followed by all recorded spike times.
+ */
+static vector< double > runIntFireNetwork( unsigned int numThreads )
+{
+	Shell* shell = reinterpret_cast< Shell* >( Id().eref().data() );
+	const unsigned int size = 400;
+	const double timestep = 0.2;
+
+	Id fire = shell->doCreate( "IntFire", Id(), "pnet", size );
+	Id syns = shell->doCreate( "SimpleSynHandler", fire, "syns", size );
+	Id synId( syns.value() + 1 );
+	Id tabs = shell->doCreate( "Table", fire, "tabs", size );
+
+	ObjId mid = shell->doAddMsg( "Sparse", fire, "spikeOut",
+			ObjId( synId, 0 ), "addSpike" );
+	SetGet2< double, long >::set( mid, "setRandomConnectivity",
+			0.1, 4321UL );
+	shell->doAddMsg( "OneToOne", syns, "activationOut", fire, "activation" );
+	shell->doAddMsg( "OneToOne", fire, "spikeOut", tabs, "spike" );
+
+	moose::mtseed( 4321UL );
+	vector< double > temp( size, 0.8 );
+	Field< double >::setVec( fire, "thresh", temp );
+	temp.assign( size, 0.4 );
+	Field< double >::setVec( fire, "refractoryPeriod", temp );
+	vector< unsigned int > numSyn;
+	Field< unsigned int >::getVec( syns, "numSynapses", numSyn );
+	for ( unsigned int i = 0; i < size; ++i ) {
+		vector< double > weight( numSyn[i] );
+		vector< double > delay( numSyn[i] );
+		for ( unsigned int j = 0; j < numSyn[i]; ++j ) {
+			weight[j] = moose::mtrand() * 0.02;
+			delay[j] = moose::mtrand() * 4.0;
+		}
+		Field< double >::setVec( ObjId( synId, i ), "weight", weight );
+		Field< double >::setVec( ObjId( synId, i ), "delay", delay );
+	}
+	vector< double > Vm( size );
+	for ( unsigned int i = 0; i < size; ++i )
+		Vm[i] = moose::mtrand();
+
+	Field< unsigned int >::set( ObjId( 1 ), "numThreads", numThreads );
+	shell->doUseClock( "/pnet/syns", "process", 0 );
+	shell->doUseClock( "/pnet", "process", 1 );
+	shell->doSetClock( 0, timestep );
+	shell->doSetClock( 1, timestep );
+	shell->doSetClock( 9, timestep );
+	shell->doReinit();
+	Field< double >::setVec( fire, "Vm", Vm );
+	shell->doStart( timestep * 50 );
+
+	vector< double > ret;
+	Field< double >::getVec( fire, "Vm", ret );
+	for ( unsigned int i = 0; i < size; ++i ) {
+		vector< double > spikes = Field< vector< double > >::get(
+				ObjId( tabs, i ), "vector" );
+		ret.insert( ret.end(), spikes.begin(), spikes.end() );
+	}
+	Field< unsigned int >::set( ObjId( 1 ), "numThreads", 1 );
+	shell->doDelete( fire );
+	return ret;
+}
+
+/**
+ * The IntFires and SynHandlers run in parallel, and all their spikes go
+ * through queued sends. The results must match the serial run exactly.
+ */
+void testClockThreadsMatchSerial()
+{
+	vector< double > serial = runIntFireNetwork( 1 );
+	vector< double > threaded = runIntFireNetwork( 4 );
+	assert( serial.size() > 400 ); // Some spikes were recorded.
+	assert( serial == threaded );
+	cout << "." << flush;
+}
+
 void testScheduling()
 {
 	testClockMessaging();
 	testClock();
+	testThreadPool();
 }
 
 void testSchedulingProcess()
 {
+	testClockThreadsMatchSerial();
 }
 
 void testMpiScheduling()
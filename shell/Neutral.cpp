@@ -651,35 +651,26 @@ bool Neutral::isDescendant(Id me, Id ancestor)
 // static function
 Id Neutral::child(const Eref& e, const string& name)
 {
-    static const Finfo* pf = neutralCinfo->findFinfo("parentMsg");
-    static const DestFinfo* pf2 = dynamic_cast<const DestFinfo*>(pf);
-    static const FuncId pafid = pf2->getFid();
-    static const Finfo* cf = neutralCinfo->findFinfo("childOut");
-    static const SrcFinfo* cf2 = dynamic_cast<const SrcFinfo*>(cf);
-    static const BindIndex bi = cf2->getBindIndex();
-
-    const vector<MsgFuncBinding>* bvec = e.element()->getMsgAndFunc(bi);
-
-    vector<Id> ret;
-
-    for(vector<MsgFuncBinding>::const_iterator i = bvec->begin();
-        i != bvec->end(); ++i) {
-        if(i->fid == pafid) {
-            const Msg* m = Msg::getMsg(i->mid);
-            assert(m);
-            Element* e2 = m->e2();
-            if(e2->getName() == name) {
-                if(e.dataIndex() == ALLDATA)  // Child of any index is OK
-                {
-                    return e2->id();
-                } else {
-                    ObjId parent = m->findOtherEnd(m->getE2());
-                    // If child is a fieldElement, then all parent indices
-                    // are permitted. Otherwise insist parent dataIndex OK.
-                    if(e2->hasFields() || parent == e.objId())
-                        return e2->id();
-                }
-            }
+    // The Element keeps an index of its children by name, so this does
+    // not have to scan every child.
+    vector<ObjId> mids;
+    e.element()->getChildMsgs(name, mids);
+
+    for(vector<ObjId>::const_iterator i = mids.begin(); i != mids.end();
+        ++i) {
+        const Msg* m = Msg::getMsg(*i);
+        assert(m);
+        Element* e2 = m->e2();
+        assert(e2->getName() == name);
+        if(e.dataIndex() == ALLDATA)  // Child of any index is OK
+        {
+            return e2->id();
+        } else {
+            ObjId parent = m->findOtherEnd(m->getE2());
+            // If child is a fieldElement, then all parent indices
+            // are permitted. Otherwise insist parent dataIndex OK.
+            if(e2->hasFields() || parent == e.objId())
+                return e2->id();
         }
     }
     return Id();
@@ -709,50 +700,54 @@ ObjId Neutral::parent(ObjId oid)
     return pa;
 }
 
-// Static function
-string Neutral::path(const Eref& e)
+/**
+ * Path of oid without its field index, or "" for the root. Each Element
+ * caches the path of the last data entry asked for, so this only walks
+ * up the tree until it meets a cached ancestor. Renames and moves
+ * invalidate the caches.
+ */
+static string innerPath(const ObjId& oid)
 {
-    static const Finfo* pf = neutralCinfo->findFinfo("parentMsg");
+    static const Finfo* pf = Neutral::initCinfo()->findFinfo("parentMsg");
     static const DestFinfo* pf2 = dynamic_cast<const DestFinfo*>(pf);
     static const FuncId pafid = pf2->getFid();
 
-    vector<ObjId> pathVec;
-    ObjId curr = e.objId();
-    stringstream ss;
-
-    pathVec.push_back(curr);
-    while(curr.id != Id()) {
-        ObjId mid = curr.eref().element()->findCaller(pafid);
-        if(mid == ObjId()) {
-            cout << "Error: Neutral::path:Cannot follow msg of ObjId: "
-                 << e.objId() << " for func: " << pafid << endl;
-            break;
-        }
-        curr = Msg::getMsg(mid)->findOtherEnd(curr);
-        pathVec.push_back(curr);
-    }
-    if(pathVec.size() <= 1)
+    if(oid.id == Id())
+        return "";
+
+    Element* elm = oid.element();
+    string ret;
+    if(elm->getCachedPath(oid.dataIndex, ret))
+        return ret;
+
+    ObjId mid = elm->findCaller(pafid);
+    bool ok = (mid != ObjId(0, BADINDEX));
+    if(ok)
+        ret = innerPath(Msg::getMsg(mid)->findOtherEnd(oid));
+    else
+        cout << "Error: Neutral::path:Cannot follow msg of ObjId: " << oid
+             << " for func: " << pafid << endl;
+
+    ret += "/" + elm->getName();
+    if(!elm->hasFields())
+        ret += "[" + to_string(oid.dataIndex) + "]";
+    if(ok)
+        elm->setCachedPath(oid.dataIndex, ret);
+    return ret;
+}
+
+// Static function
+string Neutral::path(const Eref& e)
+{
+    if(e.id() == Id())
         return "/";
-    for(unsigned int i = 1; i < pathVec.size(); ++i) {
-        ss << "/";
-        ObjId& oid = pathVec[pathVec.size() - i - 1];
-        ss << oid.element()->getName();
-        if(!oid.element()->hasFields())
-            ss << "[" << oid.dataIndex << "]";
-        /*
-        if ( !oid.element()->hasFields() )
-                ss << "[" << oid.dataIndex << "]";
-        if ( oid.element()->numData() > 1 )
-                ss << "[" << oid.dataIndex << "]";
-                */
-    }
+
+    string ret = innerPath(e.objId());
     // Append braces if Eref was for a fieldElement. This should
     // work even if it is off-node.
-    if(e.element()->hasFields()) {
-        ss << "[" << e.fieldIndex() << "]";
-    }
-
-    return ss.str();
+    if(e.element()->hasFields())
+        ret += "[" + to_string(e.fieldIndex()) + "]";
+    return ret;
 }
 
 // Neutral does not have any fields.
@@ -322,6 +322,10 @@ void Shell::doStart(double runtime, bool notify)
         pStreamer->cleanUp();
     }
 
+    // Tables and Streamers keep their files open and write them on a
+    // background thread. Make sure the files are complete before returning.
+    StreamerBase::flushOutFiles();
+
     // Print the stats collected by profiling map.
     char* p = getenv("MOOSE_SHOW_SOLVER_PERF");
     if (p != NULL) moose::printSolverProfMap();
@@ -757,6 +761,7 @@ bool Shell::innerMove(Id orig, ObjId newParent)
 
     ObjId mid = orig.element()->findCaller(pafid);
     Msg::deleteMsg(mid);
+    Element::invalidatePaths();
 
     Msg* m = new OneToAllMsg(newParent.eref(), orig.element(), 0);
     assert(m);
@@ -931,3 +936,8 @@ void Shell::cleanSimulation()
     }
     LOG(moose::info, "Cleaned up!");
 }
+
+void Shell::cleanUp()
+{
+    StreamerBase::closeOutFiles();
+}
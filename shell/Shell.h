@@ -510,6 +510,12 @@ public:
      */
     static void cleanSimulation();
 
+    /**
+     * Closes the output files of Tables and Streamers and stops their
+     * writer thread. Called once at exit, before static destructors run.
+     */
+    static void cleanUp();
+
     /**
      * set the gettingVector_ flag
      */
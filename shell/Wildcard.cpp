@@ -8,100 +8,298 @@
 **********************************************************************/
 
 #include "../basecode/header.h"
+#include "../utility/utility.h"
+#include "../scheduling/ThreadPool.h"
 #include "Neutral.h"
 #include "Shell.h"
 #include "Wildcard.h"
-
-static int wildcardRelativeFind( ObjId start, const vector< string >& path,
-                                 unsigned int depth, vector< ObjId >& ret );
+#include <mutex>
+#include <thread>
 
 static unsigned int findBraceContent( const string& path,
                                       string& beforeBrace, string& insideBrace );
 
-static bool matchName( ObjId id, unsigned int index,
-                       const string& beforeBrace, const string& insideBrace );
+static bool matchInsideBrace( ObjId id, const string& inside );
 
-// static bool matchBeforeBrace( ObjId id, const string& name );
+unsigned int findWithSingleCharWildcard(
+    const string& name, unsigned int start, const string& wild );
+
+/**
+ * Searches of more than one subtree are split over threads only in
+ * models with at least this many Ids. Below that, a plain depth-first
+ * search is fast enough.
+ */
+static const unsigned int MinIdsForParallelFind = 20000;
+
+/**
+ * How many levels of a ## search are expanded, at most, to find enough
+ * subtrees to hand out to the threads.
+ */
+static const unsigned int MaxSplitDepth = 4;
 
-static bool matchInsideBrace( ObjId id, const string& inside );
 /**
- * wildcardFieldComparison returns true if the value of the
- * specified field matches the value in the comparsion string mid.
- * Format is FIELD(name)=val
- * If the format or the value does not match, return 0
+ * The part of one level of a wildcard path that comes before the braces,
+ * chopped at its '#'s once so that matching a name needs no allocation.
+ * The matching rules are those of matchBeforeBrace.
  */
-static bool wildcardFieldComparison( ObjId oid, const string& mid )
+class NameMatcher
 {
-    // where = could be the usual comparison operators and val
-    // could be a number. No strings yet
+public:
+    NameMatcher( const string& wild )
+        :
+        wild_( wild ),
+        any_( wild == "#" || wild == "##" ),
+        hasWild_( wild.find_first_of( "#?" ) != string::npos ),
+        anchored_( wild.length() > 0 && wild[0] != '#' )
+    {
+        if ( hasWild_ )
+            Shell::chopString( wild, chops_, '#' );
+    }
 
-    auto pos = mid.find(')');
-    if ( pos == string::npos )
-        return 0;
-    string fieldName = mid.substr( 0, pos );
-    auto pos2 = mid.find_last_of( "=<>" );
-    if ( pos2 == string::npos )
-        return 0;
-    string op = mid.substr( pos + 1, pos2 - pos );
+    bool match( const string& name ) const
+    {
+        if ( any_ || name == wild_ )
+            return true;
+        if ( !hasWild_ )
+            return false;
+        unsigned int prev = 0;
+        for ( vector< string >::const_iterator
+                i = chops_.begin(); i != chops_.end(); ++i )
+        {
+            unsigned int start = findWithSingleCharWildcard( name, prev, *i );
+            if ( start == ~0U )
+                return false;
+            if ( prev == 0 && start > 0 && anchored_ )
+                return false;
+            prev = start + i->length();
+        }
+        return true;
+    }
 
-    string testValue = mid.substr( pos2 + 1 );
+    /// True if the name has no wildcards, so it can be looked up directly.
+    bool isLiteral() const
+    {
+        return !hasWild_;
+    }
 
-    if ( testValue.length() == 0 )
-        return 0;
+    const string& wild() const
+    {
+        return wild_;
+    }
+
+private:
+    string wild_;
+    vector< string > chops_;
+    bool any_;
+    bool hasWild_;
+    bool anchored_;
+};
+
+/**
+ * The expression inside the braces of a wildcard level, parsed once.
+ * TYPE, CLASS and ISA tests resolve the class name to its Cinfo up front,
+ * so testing an object compares Cinfo pointers instead of class names.
+ * FIELD tests still go through SetGet::strGet.
+ */
+class WildcardCondition
+{
+public:
+    WildcardCondition( const string& inside )
+        :
+        kind_( NEVER ), isEquality_( true ), isA_( false ), cinfo_( 0 ),
+        neutral_( Neutral::initCinfo() )
+    {
+        if ( inside == "" )
+        {
+            kind_ = NONE;  // No condition to apply.
+        }
+        else if ( inside.substr( 0, 4 ) == "TYPE" ||
+                  inside.substr( 0, 5 ) == "CLASS" ||
+                  inside.substr( 0, 3 ) == "ISA" )
+        {
+            auto pos = inside.rfind( "=" );
+            if ( pos == string::npos )
+                return;
+            isEquality_ = ( inside[ pos - 1 ] != '!' );
+            string typeName = inside.substr( pos + 1 );
+            // Legacy names from GENESIS scripts.
+            if ( typeName == "membrane" )
+                typeName = "Compartment";
+            if ( inside.substr( 0, 5 ) == "CLASS" && typeName == "channel" )
+                typeName = "HHChannel";
+
+            kind_ = CLASS;
+            isA_ = ( inside.substr( 0, 3 ) == "ISA" );
+            cinfo_ = Cinfo::find( typeName );
+            if ( isA_ && typeName == "Neutral" )
+                cinfo_ = neutral_;
+        }
+        else if ( inside.substr( 0, 6 ) == "FIELD(" )
+        {
+            // Format is FIELD(name)<op>value, where the value could be a
+            // number. No strings yet.
+            string mid = inside.substr( 6 );
+            auto pos = mid.find( ')' );
+            if ( pos == string::npos )
+                return;
+            auto pos2 = mid.find_last_of( "=<>" );
+            if ( pos2 == string::npos )
+                return;
+            fieldName_ = mid.substr( 0, pos );
+            op_ = mid.substr( pos + 1, pos2 - pos );
+            testValue_ = mid.substr( pos2 + 1 );
+            if ( testValue_.length() > 0 )
+                kind_ = FIELD;
+        }
+    }
 
-    /*
-    const Finfo* f = id()->findFinfo( fieldName );
-    if ( !f )
-    	return 0;
+    bool match( ObjId id ) const
+    {
+        switch ( kind_ )
+        {
+        case NONE:
+            return true;
+        case CLASS:
+            return ( matchClass( id.element()->cinfo() ) == isEquality_ );
+        case FIELD:
+            if ( id.dataIndex == ALLDATA )
+                return matchField( id.id );
+            return matchField( id );
+        default:
+            return false;
+        }
+    }
 
-    string actualValue;
-    bool ret = f->strGet( id.eref(), actualValue );
-    */
-    string actualValue;
+    /**
+     * FIELD tests call into the objects, so they are only done from the
+     * calling thread.
+     */
+    bool isThreadSafe() const
+    {
+        return kind_ != FIELD;
+    }
 
-    bool ret = SetGet::strGet( oid, fieldName, actualValue );
-    if ( ret == 0 )
-        return 0;
-    if ( op == "==" || op == "=" )
-        return ( testValue == actualValue );
-    if ( op == "!=" )
-        return ( testValue != actualValue );
-
-    double v1 = atof( actualValue.c_str() );
-    double v2 = atof( testValue.c_str() );
-    if ( op == ">" )
-        return ( v1 > v2 );
-    if ( op == ">=" )
-        return ( v1 >= v2 );
-    if ( op == "<" )
-        return ( v1 < v2 );
-    if ( op == "<=" )
-        return ( v1 <= v2 );
-
-    return 0;
-}
+private:
+    bool matchClass( const Cinfo* c ) const
+    {
+        if ( !isA_ )
+            return c == cinfo_;
+        if ( cinfo_ == neutral_ )
+            return true;
+        for ( ; c && c != neutral_; c = c->baseCinfo() )
+            if ( c == cinfo_ )
+                return true;
+        return false;
+    }
+
+    bool matchField( ObjId oid ) const
+    {
+        string actualValue;
+        if ( !SetGet::strGet( oid, fieldName_, actualValue ) )
+            return false;
+        if ( op_ == "==" || op_ == "=" )
+            return ( testValue_ == actualValue );
+        if ( op_ == "!=" )
+            return ( testValue_ != actualValue );
+
+        double v1 = atof( actualValue.c_str() );
+        double v2 = atof( testValue_.c_str() );
+        if ( op_ == ">" )
+            return ( v1 > v2 );
+        if ( op_ == ">=" )
+            return ( v1 >= v2 );
+        if ( op_ == "<" )
+            return ( v1 < v2 );
+        if ( op_ == "<=" )
+            return ( v1 <= v2 );
+        return false;
+    }
+
+    enum Kind { NONE, CLASS, FIELD, NEVER };
+    Kind kind_;
+    bool isEquality_;
+    bool isA_;
+    const Cinfo* cinfo_;	///< Null if the class does not exist.
+    const Cinfo* neutral_;
+    string fieldName_;
+    string op_;
+    string testValue_;
+};
 
 /**
- * Does the wildcard find on a single path
+ * One level of a wildcard path, such as foo#[3][TYPE=Pool].
  */
-static int innerFind( const string& path, vector< ObjId >& ret)
+struct WildcardLevel
+{
+    WildcardLevel( const string& path, const string& beforeBrace,
+                   unsigned int index, const string& insideBrace )
+        :
+        path( path ), name( beforeBrace ), index( index ),
+        condition( insideBrace ), isRecursive( beforeBrace == "##" )
+    {;}
+
+    string path;
+    NameMatcher name;
+    unsigned int index;
+    WildcardCondition condition;
+    bool isRecursive;
+};
+
+/**
+ * One comma-separated entry of a wildcard path, compiled once per
+ * search rather than once per visited object.
+ */
+class WildcardPath
 {
-    if ( path == "/" || path == "/root")
+public:
+    WildcardPath( const string& path )
+        : isRoot_( path == "/" || path == "/root" )
     {
-        ret.push_back( Id() );
-        return 1;
+        vector< string > names;
+        isAbsolute_ = Shell::chopString( path, names, '/' );
+        for ( vector< string >::const_iterator
+                i = names.begin(); i != names.end(); ++i )
+        {
+            string beforeBrace;
+            string insideBrace;
+            // This has to handle ghastly cases like foo[][FIELD(x)=12.3]
+            unsigned int index = findBraceContent( *i, beforeBrace, insideBrace );
+            levels_.push_back(
+                WildcardLevel( *i, beforeBrace, index, insideBrace ) );
+        }
     }
 
-    vector< string > names;
-    vector< vector< unsigned int > > indices;
-    bool isAbsolute = Shell::chopString( path, names, '/' );
-    ObjId start; // set to root id.
-    if ( !isAbsolute )
+    int find( vector< ObjId >& ret ) const
     {
-        Shell* s = reinterpret_cast< Shell* >( ObjId().data() );
-        start = s->getCwe();
+        if ( isRoot_ )
+        {
+            ret.push_back( Id() );
+            return 1;
+        }
+        ObjId start; // set to root id.
+        if ( !isAbsolute_ )
+        {
+            Shell* s = reinterpret_cast< Shell* >( ObjId().data() );
+            start = s->getCwe();
+        }
+        return relativeFind( start, 0, ret );
     }
-    return wildcardRelativeFind( start, names, 0, ret );
+
+private:
+    int relativeFind( ObjId start, unsigned int depth,
+                      vector< ObjId >& ret ) const;
+
+    bool isRoot_;
+    bool isAbsolute_;
+    vector< WildcardLevel > levels_;
+};
+
+/**
+ * Does the wildcard find on a single path
+ */
+static int innerFind( const string& path, vector< ObjId >& ret)
+{
+    return WildcardPath( path ).find( ret );
 }
 
 /**
@@ -163,48 +361,229 @@ vector<ObjId> wildcardFind2(const char* path)
 }
 
 /**
- * 	singleLevelWildcard parses a single level of the path and returns all
- * 	ids that match it. If there is a suitable doublehash, it will recurse
- * 	into child elements.
- * 	Returns # of ids found.
+ * Gets the children of start called name, in the same order as
+ * Neutral::children would list them, using the parent's index of
+ * children by name.
  */
-int singleLevelWildcard( ObjId start, const string& path, vector< ObjId >& ret )
+static void namedChildren( ObjId start, const string& name, vector< Id >& ret )
 {
-    if ( path.length() == 0 )
-        return 0;
-    unsigned int nret = ret.size();
+    vector< ObjId > mids;
+    start.element()->getChildMsgs( name, mids );
+    for ( vector< ObjId >::const_iterator
+            i = mids.begin(); i != mids.end(); ++i )
+    {
+        const Msg* m = Msg::getMsg( *i );
+        assert( m );
+        vector< vector< Eref > > kids;
+        m->targets( kids );
+        for ( unsigned int j = 0; j < kids.size(); ++j )
+        {
+            if ( start.dataIndex != ALLDATA && start.dataIndex != j )
+                continue;
+            for ( vector< Eref >::const_iterator
+                    k = kids[j].begin(); k != kids[j].end(); ++k )
+                ret.push_back( k->id() );
+        }
+    }
+}
 
-    string beforeBrace;
-    string insideBrace;
-    // This has to handle ghastly cases like foo[][FIELD(x)=12.3]
-    unsigned int index = findBraceContent( path, beforeBrace, insideBrace );
-    if ( beforeBrace == "##" )
-        // recursive.
-        return allChildren( start, index, insideBrace, ret );
+/**
+ * An entry in the ordered output of a ## search: either an object that
+ * matched, or a subtree that is still to be searched.
+ */
+struct PendingMatch
+{
+    ObjId oid;
+    bool isSubtree;
+};
 
+/**
+ * Lists the outcome of one level of a ## search below start, in search
+ * order. Each non-field child is followed by itself if it matches, so
+ * that a subtree comes before its root in the output.
+ */
+static void expandLevel( ObjId start, unsigned int index,
+                         const WildcardCondition& cond, vector< PendingMatch >& ret )
+{
     vector< Id > kids;
     Neutral::children( start.eref(), kids );
     vector< Id >::iterator i;
     for ( i = kids.begin(); i != kids.end(); i++ )
     {
-        if ( matchName( ObjId( *i, ALLDATA ),
-                        index, beforeBrace, insideBrace ) )
+        if ( i->element()->hasFields() )
         {
-            if ( index == ALLDATA )
-            {
-                for ( unsigned int j = 0; j < i->element()->numData(); ++j )
-                    ret.push_back( ObjId( *i, j ) );
-            }
-            else if ( i->element()->hasFields() && index < i->element()->numField( start.dataIndex ) )
+            if ( cond.match( *i ) )
             {
-                ret.push_back( ObjId( *i, start.dataIndex, index ) );
+                if ( index == ALLDATA )
+                {
+                    PendingMatch p = { ObjId( *i, start.dataIndex ), false };
+                    ret.push_back( p );
+                }
+                else if (index < i->element()->numField( start.dataIndex ) )
+                {
+                    PendingMatch p = { ObjId( *i, start.dataIndex, index ), false };
+                    ret.push_back( p );
+                }
             }
-            else if ( !i->element()->hasFields() && index < i->element()->numData() )
+        }
+        else
+        {
+            for ( unsigned int j = 0; j < i->element()->numData(); ++j )
             {
-                ret.push_back( ObjId( *i, index ) );
+                ObjId oid( *i, j );
+                PendingMatch sub = { oid, true };
+                ret.push_back( sub );
+                if ( (index == ALLDATA || index == j) && cond.match( oid ) )
+                {
+                    PendingMatch p = { oid, false };
+                    ret.push_back( p );
+                }
             }
         }
     }
+}
+
+/**
+ * Depth-first search of all descendants of start.
+ */
+static void searchTree( ObjId start, unsigned int index,
+                        const WildcardCondition& cond, vector< ObjId >& ret )
+{
+    vector< PendingMatch > level;
+    expandLevel( start, index, cond, level );
+    for ( vector< PendingMatch >::const_iterator
+            i = level.begin(); i != level.end(); ++i )
+    {
+        if ( i->isSubtree )
+            searchTree( i->oid, index, cond, ret );
+        else
+            ret.push_back( i->oid );
+    }
+}
+
+static unsigned int numFindThreads()
+{
+    static const unsigned int n = max( 1, moose::getEnvInt(
+                "MOOSE_NUM_THREADS", thread::hardware_concurrency() ) );
+    return n;
+}
+
+/**
+ * Same as searchTree, but splits the search over threads. The first few
+ * levels are expanded on the calling thread until there are several
+ * subtrees per thread. Each subtree is then searched into its own list,
+ * and the lists are joined in order, so the result is exactly that of
+ * searchTree.
+ * Returns false, having done nothing, if the pool is busy with a search
+ * from another thread.
+ */
+static bool parallelSearchTree( ObjId start, unsigned int index,
+                                const WildcardCondition& cond, vector< ObjId >& ret )
+{
+    static moose::ThreadPool pool( numFindThreads() );
+    static mutex poolLock;
+    unique_lock< mutex > lock( poolLock, try_to_lock );
+    if ( !lock.owns_lock() )
+        return false;
+
+    vector< PendingMatch > frontier;
+    expandLevel( start, index, cond, frontier );
+    for ( unsigned int depth = 0; depth < MaxSplitDepth; ++depth )
+    {
+        unsigned int numSubtrees = 0;
+        for ( vector< PendingMatch >::const_iterator
+                i = frontier.begin(); i != frontier.end(); ++i )
+            numSubtrees += i->isSubtree;
+        if ( numSubtrees == 0 || numSubtrees >= 4 * pool.numThreads() )
+            break;
+        vector< PendingMatch > next;
+        for ( vector< PendingMatch >::const_iterator
+                i = frontier.begin(); i != frontier.end(); ++i )
+        {
+            if ( i->isSubtree )
+                expandLevel( i->oid, index, cond, next );
+            else
+                next.push_back( *i );
+        }
+        frontier.swap( next );
+    }
+
+    vector< vector< ObjId > > found( frontier.size() );
+    pool.parallelFor( frontier.size(), [&]( size_t i )
+    {
+        if ( frontier[i].isSubtree )
+            searchTree( frontier[i].oid, index, cond, found[i] );
+    } );
+    for ( unsigned int i = 0; i < frontier.size(); ++i )
+    {
+        if ( frontier[i].isSubtree )
+            ret.insert( ret.end(), found[i].begin(), found[i].end() );
+        else
+            ret.push_back( frontier[i].oid );
+    }
+    return true;
+}
+
+/**
+ * Finds the descendants of start for a ## level. Large models are
+ * searched in parallel when the condition allows it.
+ */
+static void findDescendants( ObjId start, unsigned int index,
+                             const WildcardCondition& cond, vector< ObjId >& ret )
+{
+    if ( cond.isThreadSafe() && numFindThreads() > 1 &&
+            Id::numIds() >= MinIdsForParallelFind &&
+            parallelSearchTree( start, index, cond, ret ) )
+        return;
+    searchTree( start, index, cond, ret );
+}
+
+/**
+ * 	singleLevelWildcard finds all ids below start that match a single
+ * 	level of the path. If there is a suitable doublehash, it will recurse
+ * 	into child elements.
+ * 	Returns # of ids found.
+ */
+static int singleLevelWildcard( ObjId start, const WildcardLevel& level,
+                                vector< ObjId >& ret )
+{
+    if ( level.path.length() == 0 )
+        return 0;
+    unsigned int nret = ret.size();
+    unsigned int index = level.index;
+
+    if ( level.isRecursive )
+    {
+        findDescendants( start, index, level.condition, ret );
+        return ret.size() - nret;
+    }
+
+    vector< Id > kids;
+    if ( level.name.isLiteral() )
+        namedChildren( start, level.name.wild(), kids );
+    else
+        Neutral::children( start.eref(), kids );
+    vector< Id >::iterator i;
+    for ( i = kids.begin(); i != kids.end(); i++ )
+    {
+        const string& name = i->element()->getName();
+        if ( name.length() == 0 || !level.name.match( name ) ||
+                !level.condition.match( ObjId( *i, ALLDATA ) ) )
+            continue;
+        if ( index == ALLDATA )
+        {
+            for ( unsigned int j = 0; j < i->element()->numData(); ++j )
+                ret.push_back( ObjId( *i, j ) );
+        }
+        else if ( i->element()->hasFields() && index < i->element()->numField( start.dataIndex ) )
+        {
+            ret.push_back( ObjId( *i, start.dataIndex, index ) );
+        }
+        else if ( !i->element()->hasFields() && index < i->element()->numData() )
+        {
+            ret.push_back( ObjId( *i, index ) );
+        }
+    }
 
     return ret.size() - nret;
 }
@@ -271,96 +650,13 @@ unsigned int findBraceContent( const string& path, string& beforeBrace,
     return index;
 }
 
-/**
- * Compares the various parts of the wildcard name with the id
- * Indexing is messy here because we may refer to any of 3 things:
- * - Regular array indexing
- * - Wildcards within the braces
- * - Simple elements with index as part of their names.
- */
-bool matchName( ObjId id, unsigned int index,
-                const string& beforeBrace, const string& insideBrace )
-{
-    string temp = id.element()->getName();
-    if ( temp.length() <= 0 )
-    {
-        return false;
-    }
-
-    // if ( index == ALLDATA || index == id.dataIndex ) {
-    if ( matchBeforeBrace( id, beforeBrace ) )
-    {
-        if ( insideBrace.length() == 0 )
-        {
-            return true;
-        }
-        else
-        {
-            return matchInsideBrace( id, insideBrace );
-        }
-    }
-    // }
-    return 0;
-}
-
 /**
  * matchInsideBrace checks for element property matches
  * Still has some legacy hacks for reading GENESIS code.
  */
 bool matchInsideBrace( ObjId id, const string& inside )
 {
-    /* Map from Genesis class names to Moose class names */
-    // const map< string, string >& classNameMap = sliClassNameConvert();
-    if ( inside == "" )
-        return true; // empty means that there is no condition to apply.
-
-    if ( inside.substr(0, 4 ) == "TYPE" ||
-            inside.substr(0, 5 ) == "CLASS" ||
-            inside.substr(0, 3 ) == "ISA" )
-    {
-        auto pos = inside.rfind( "=" );
-        if ( pos == string::npos )
-            return false;
-        bool isEquality = ( inside[ pos - 1 ] != '!' );
-        string typeName = inside.substr( pos + 1 );
-        if ( typeName == "membrane" )
-            typeName = "Compartment";
-
-        if ( inside.substr( 0, 5 ) == "CLASS" && typeName == "channel" )
-            typeName = "HHChannel";
-
-        bool isEqual;
-        if ( inside.substr( 0, 3 ) == "ISA" )
-        {
-            isEqual = id.element()->cinfo()->isA( typeName );
-        }
-        else
-        {
-            isEqual = ( typeName == id.element()->cinfo()->name() );
-        }
-        /*
-        map< string, string >::const_iterator iter = classNameMap.find( typeName );
-        if ( iter != classNameMap.end() )
-        	isEqual = ( iter->second == id()->className() );
-        else
-        	isEqual = ( typeName == id()->className() );
-        	*/
-
-        return ( isEqual == isEquality );
-    }
-    else if ( inside.substr( 0, 6 ) == "FIELD(" )
-    {
-        if ( id.dataIndex == ALLDATA )
-        {
-            return wildcardFieldComparison( id.id, inside.substr( 6 ) );
-        }
-        else
-        {
-            return wildcardFieldComparison( id, inside.substr( 6 ) );
-        }
-    }
-
-    return false;
+    return WildcardCondition( inside ).match( id );
 }
 
 /**
@@ -399,7 +695,12 @@ unsigned int findWithSingleCharWildcard(
     unsigned int end = 1 + name.length() - len;
     for ( unsigned int i = start; i < end; ++i )
     {
-        if ( alignedSingleWildcardMatch( name.substr(i), wild ) )
+        // Same as alignedSingleWildcardMatch( name.substr( i ), wild ),
+        // without the copy.
+        unsigned int j = 0;
+        while ( j < len && ( wild[j] == '?' || name[i + j] == wild[j] ) )
+            ++j;
+        if ( j == len )
             return i;
     }
     return ~0;
@@ -419,103 +720,20 @@ unsigned int findWithSingleCharWildcard(
  */
 bool matchBeforeBrace( ObjId id, const string& wild )
 {
-    if ( wild == "#" || wild == "##" )
-        return true;
-
-    string ename = id.element()->getName();
-    if ( wild == ename )
-        return true;
-
-    // Check if the wildcard string has any # or ? symbols.
-    if ( wild.find_first_of( "#?" ) == string::npos )
-        return false;
-
-    // Break the 'wild' into the sections that must match, at the #s.
-    // Then go through each of these sections doing a match to ename.
-    // If not found, then return false.
-    vector< string > chops;
-    Shell::chopString( wild, chops, '#' );
-    unsigned int prev = 0;
-    unsigned int start = 0;
-
-    for ( vector< string >::iterator
-            i = chops.begin(); i != chops.end(); ++i )
-    {
-        start = findWithSingleCharWildcard( ename, prev, *i );
-        if ( start == ~0U )
-            return false;
-        if ( prev == 0 && start > 0 && wild[0] != '#' )
-            return false;
-        prev = start + i->length();
-    }
-    return true;
-
-    /*
-
-    auto pre = name.find( "#" );
-    auto post = name.rfind( "#" );
-
-    // # may only be used once in the wildcard, but substitutes for any
-    // number of characters.
-    if ( pre != string::npos && post == pre ) {
-    	if ( ename.length() < ( name.length() - post - 1 ) )
-    			return false;
-    	unsigned int epos = ename.length() - ( name.length() - post - 1 );
-    	return ( name.substr( 0, pre ) == ename.substr( 0, pre ) &&
-    		name.substr( post + 1 ) == ename.substr( epos ) );
-    }
-
-    // ? may be used any number of times in the wildcard, and
-    // must substitute exactly for characters.
-    if ( name.length() != ename.length() )
-    	return 0;
-    for ( unsigned int i = 0; i < name.length(); i++ )
-    	if ( name[i] != '?' && name[i] != ename[i] )
-    		return false;
-    return true;
-    */
+    return NameMatcher( wild ).match( id.element()->getName() );
 }
 
 /**
  * Recursive function to compare all descendants and cram matches into ret.
  * Returns number of matches.
+ * This is always a serial search: it is called once per object in
+ * setup loops, where the subtrees are small.
  */
 int allChildren( ObjId start,
                  unsigned int index, const string& insideBrace, vector< ObjId >& ret )
 {
     unsigned int nret = ret.size();
-    vector< Id > kids;
-    Neutral::children( start.eref(), kids );
-    vector< Id >::iterator i;
-    for ( i = kids.begin(); i != kids.end(); i++ )
-    {
-        if ( i->element()->hasFields() )
-        {
-            if ( matchInsideBrace( *i, insideBrace ) )
-            {
-                if ( index == ALLDATA )
-                {
-                    ObjId oid( *i, start.dataIndex );
-                    ret.push_back( oid );
-                }
-                else if (index < i->element()->numField( start.dataIndex ) )
-                {
-                    ObjId oid( *i, start.dataIndex, index );
-                    ret.push_back( oid );
-                }
-            }
-        }
-        else
-        {
-            for ( unsigned int j = 0; j < i->element()->numData(); ++j )
-            {
-                ObjId oid( *i, j );
-                allChildren( oid, index, insideBrace, ret );
-                if ( (index == ALLDATA || index == j) && matchInsideBrace( oid, insideBrace ) )
-                    ret.push_back( oid );
-            }
-        }
-    }
+    searchTree( start, index, WildcardCondition( insideBrace ), ret );
     return ret.size() - nret;
 }
 
@@ -529,12 +747,12 @@ int allChildren( ObjId start,
  * refers to messaging and basic Element information that is present on
  * all nodes.
  */
-int wildcardRelativeFind( ObjId start, const vector< string >& path,
-                          unsigned int depth, vector< ObjId >& ret )
+int WildcardPath::relativeFind( ObjId start, unsigned int depth,
+                                vector< ObjId >& ret ) const
 {
     int nret = 0;
     vector< ObjId > currentLevelIds;
-    if ( depth == path.size() )
+    if ( depth == levels_.size() )
     {
         if ( ret.size() == 0 || ret.back() != start )
         {
@@ -543,11 +761,11 @@ int wildcardRelativeFind( ObjId start, const vector< string >& path,
         return 1;
     }
 
-    if ( singleLevelWildcard( start, path[depth], currentLevelIds ) > 0 )
+    if ( singleLevelWildcard( start, levels_[ depth ], currentLevelIds ) > 0 )
     {
         vector< ObjId >::iterator i;
         for ( i = currentLevelIds.begin(); i != currentLevelIds.end(); ++i )
-            nret += wildcardRelativeFind( *i, path, depth + 1, ret );
+            nret += relativeFind( *i, depth + 1, ret );
     }
     return nret;
 }
@@ -853,6 +1071,32 @@ void testWildcard()
     simpleWildcardFind( "/a1/x[]", vec );
     assert( vec.size() == 5 );
 
+    // Literal names are looked up in the child index, which must follow
+    // renames.
+    xyzzy.element()->setName( "plugh" );
+    vec.clear();
+    simpleWildcardFind( "/a1/xyzzy", vec );
+    assert( vec.size() == 0 );
+    simpleWildcardFind( "/a1/plugh[3]", vec );
+    assert( vec.size() == 1 );
+    assert( vec[0] == ObjId( xyzzy, 3 ) );
+
+    // The parallel search must give the same objects in the same order
+    // as the serial one.
+    WildcardCondition cond( "ISA=Arith" );
+    vector< ObjId > serial;
+    searchTree( a1, ALLDATA, cond, serial );
+    assert( serial.size() == 28 );
+    vec.clear();
+    bool done = parallelSearchTree( a1, ALLDATA, cond, vec );
+    assert( done );
+    assert( vec == serial );
+    serial.clear();
+    vec.clear();
+    searchTree( ObjId(), 3, WildcardCondition( "" ), serial );
+    parallelSearchTree( ObjId(), 3, WildcardCondition( "" ), vec );
+    assert( vec == serial );
+
     //a1.destroy();
     shell->doDelete( a1 );
     cout << "." << flush;
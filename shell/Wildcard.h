@@ -49,6 +49,10 @@ class ObjId;
  *   [CLASS!=<string>]
  *   [ISA!=<string>]
  *   [FIELD(<fieldName)=<string>]
+ *
+ * In large models, ## searches without a FIELD condition are split over
+ * MOOSE_NUM_THREADS threads (all cores if unset). The order of the
+ * result is the same as for a serial search.
  */
 int simpleWildcardFind(const string& path, vector<ObjId>& ret);
 
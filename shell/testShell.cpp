@@ -319,6 +319,48 @@ void testChildren()
     cout << "." << flush;
 }
 
+/**
+ * Checks the child name index and path cache stay right through
+ * creation, rename, move and delete.
+ */
+void testChildIndex()
+{
+    Eref sheller = Id().eref();
+    Shell* shell = reinterpret_cast<Shell*>(sheller.data());
+
+    Id f1 = shell->doCreate("Neutral", Id(), "f1", 1);
+    vector<Id> kids;
+    for (unsigned int i = 0; i < 1000; ++i)
+        kids.push_back(shell->doCreate("Neutral", f1, "k" + to_string(i), 1));
+    for (unsigned int i = 0; i < kids.size(); ++i)
+        assert(Neutral::child(f1.eref(), "k" + to_string(i)) == kids[i]);
+    assert(Neutral::child(f1.eref(), "k1000") == Id());
+
+    Id g = shell->doCreate("Neutral", kids[5], "g", 1);
+    assert(g.path() == "/f1[0]/k5[0]/g");
+    assert(g.path() == "/f1[0]/k5[0]/g");  // Now from the cache
+
+    Field<string>::set(kids[5], "name", "five");
+    assert(Neutral::child(f1.eref(), "k5") == Id());
+    assert(Neutral::child(f1.eref(), "five") == kids[5]);
+    assert(g.path() == "/f1[0]/five[0]/g");
+
+    shell->doMove(kids[5], kids[6]);
+    assert(Neutral::child(f1.eref(), "five") == Id());
+    assert(Neutral::child(kids[6].eref(), "five") == kids[5]);
+    assert(g.path() == "/f1[0]/k6[0]/five[0]/g");
+    assert(ObjId("/f1/k6/five/g") == ObjId(g));
+
+    shell->doDelete(kids[7]);
+    assert(Neutral::child(f1.eref(), "k7") == Id());
+    Id k7 = shell->doCreate("Neutral", f1, "k7", 1);
+    assert(Neutral::child(f1.eref(), "k7") == k7);
+    assert(Neutral::child(f1.eref(), "k8") == kids[8]);
+
+    shell->doDelete(f1);
+    cout << "." << flush;
+}
+
 void testMove()
 {
     Eref sheller = Id().eref();
@@ -1814,6 +1856,7 @@ void testShell()
     testChopPath();
     testTreeTraversal();
     testChildren();
+    testChildIndex();
     testWildcard();
     ////// testShellParserQuit();
     testGetMsgs();  // Tests getting Msg info from Neutral.
@@ -35,6 +35,7 @@ const Cinfo* SimpleSynHandler::initCinfo()
                                  sizeof(synHandlerFinfos) / sizeof(Finfo*),
                                  &dinfo, doc, sizeof(doc) / sizeof(string));
 
+    synHandlerCinfo.setParallelProcess();
     return &synHandlerCinfo;
 }
 
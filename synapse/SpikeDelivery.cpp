@@ -0,0 +1,401 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include "../basecode/header.h"
+#include "../basecode/global.h"
+#include "SpikeDelivery.h"
+
+using namespace std::chrono;
+
+SrcFinfo1< vector< double > >* SpikeDelivery::activationOut()
+{
+    static SrcFinfo1< vector< double > > activationOut(
+        "activationOut",
+        "Sends the activation of every target, weight / dt summed over the "
+        "spikes falling due in this step. Only sent on steps with at least "
+        "one spike due."
+    );
+    return &activationOut;
+}
+
+const Cinfo* SpikeDelivery::initCinfo()
+{
+    static DestFinfo process(
+        "process",
+        "Handles 'process' call: Sends the input falling due in this step.",
+        new ProcOpFunc< SpikeDelivery >( &SpikeDelivery::process )
+    );
+
+    static DestFinfo reinit(
+        "reinit",
+        "Handles 'reinit' call: Drops pending spikes and converts the "
+        "delays to time steps.",
+        new ProcOpFunc< SpikeDelivery >( &SpikeDelivery::reinit )
+    );
+
+    static Finfo* processShared[] =
+    {
+        &process,
+        &reinit
+    };
+
+    static SharedFinfo proc(
+        "proc",
+        "Handles 'reinit' and 'process' calls from a clock.",
+        processShared,
+        sizeof( processShared ) / sizeof( Finfo* )
+    );
+
+    static ReadOnlyValueFinfo< SpikeDelivery, unsigned int > numSources(
+        "numSources",
+        "Number of presynaptic sources, one more than the largest source "
+        "index of any synapse.",
+        &SpikeDelivery::getNumSources
+    );
+
+    static ValueFinfo< SpikeDelivery, unsigned int > numTargets(
+        "numTargets",
+        "Length of the activation vector. Grows to fit the targets of the "
+        "synapses, and can be set larger, for example to the number of "
+        "neurons in the target population. Takes effect at the next reinit.",
+        &SpikeDelivery::setNumTargets,
+        &SpikeDelivery::getNumTargets
+    );
+
+    static ReadOnlyValueFinfo< SpikeDelivery, unsigned int > numSynapses(
+        "numSynapses",
+        "Number of synapses.",
+        &SpikeDelivery::getNumSynapses
+    );
+
+    static ReadOnlyValueFinfo< SpikeDelivery, vector< unsigned int > > rowStart(
+        "rowStart",
+        "Start of the synapses of each source in the targets, weights and "
+        "delays fields, with a final entry holding numSynapses.",
+        &SpikeDelivery::getRowStart
+    );
+
+    static ReadOnlyValueFinfo< SpikeDelivery, vector< unsigned int > > targets(
+        "targets",
+        "Target of each synapse, ordered by source and then by delay.",
+        &SpikeDelivery::getTargets
+    );
+
+    static ReadOnlyValueFinfo< SpikeDelivery, vector< double > > weights(
+        "weights",
+        "Weight of each synapse, in the same order as targets.",
+        &SpikeDelivery::getWeights
+    );
+
+    static ReadOnlyValueFinfo< SpikeDelivery, vector< double > > delays(
+        "delays",
+        "Delay of each synapse, in the same order as targets.",
+        &SpikeDelivery::getDelays
+    );
+
+    static DestFinfo connect(
+        "connect",
+        "Adds synapses, given as one vector holding the source indices, "
+        "then the target indices, then the weights and then the delays, "
+        "each of the same length:\n"
+        "(s0, s1,... sn-1, t0, t1,... tn-1, w0, w1,... wn-1, d0, d1,... "
+        "dn-1)\n"
+        "Takes effect at the next reinit.",
+        new OpFunc1< SpikeDelivery, vector< double > >(
+            &SpikeDelivery::connect )
+    );
+
+    static DestFinfo clear(
+        "clear",
+        "Removes all synapses.",
+        new OpFunc0< SpikeDelivery >( &SpikeDelivery::clear )
+    );
+
+    static DestFinfo spikes(
+        "spikes",
+        "Handles the indices of the sources that spiked in the current "
+        "step, as sent by the spikesOut of an IntFirePop. Indices with no "
+        "synapses are ignored.",
+        new OpFunc1< SpikeDelivery, vector< unsigned int > >(
+            &SpikeDelivery::spikes )
+    );
+
+    static Finfo* spikeDeliveryFinfos[] =
+    {
+        &numSources,        // ReadOnlyValue
+        &numTargets,        // Value
+        &numSynapses,       // ReadOnlyValue
+        &rowStart,          // ReadOnlyValue
+        &targets,           // ReadOnlyValue
+        &weights,           // ReadOnlyValue
+        &delays,            // ReadOnlyValue
+        &connect,           // DestFinfo
+        &clear,             // DestFinfo
+        &spikes,            // DestFinfo
+        activationOut(),    // SrcFinfo
+        &proc,              // Shared
+    };
+
+    static string doc[] =
+    {
+        "Name",             "SpikeDelivery",
+        "Description",      "SpikeDelivery: Delivers spikes from a "
+        "population of sources to a population of targets through fixed "
+        "synapses. The synapses are stored by source, and pending input is "
+        "held in a ring of time step bins per target, so that a spike is "
+        "delivered to all the synapses of its source by a single loop, "
+        "without a message or a queue operation per synapse. Delays are "
+        "rounded up to whole time steps at reinit, and are at least one "
+        "step. Otherwise the timing of input is the same as through "
+        "SimpleSynHandlers on the same clock tick.",
+    };
+
+    static Dinfo< SpikeDelivery > dinfo;
+    static Cinfo spikeDeliveryCinfo(
+        "SpikeDelivery",
+        Neutral::initCinfo(),
+        spikeDeliveryFinfos,
+        sizeof( spikeDeliveryFinfos ) / sizeof( Finfo* ),
+        &dinfo,
+        doc,
+        sizeof( doc ) / sizeof( string )
+    );
+
+    return &spikeDeliveryCinfo;
+}
+
+static const Cinfo* spikeDeliveryCinfo = SpikeDelivery::initCinfo();
+
+SpikeDelivery::SpikeDelivery()
+    :
+    rowStart_( 1, 0 ),
+    numTargets_( 0 ),
+    mask_( 0 ),
+    step_( 0 )
+{
+    ;
+}
+
+///////////////////////////////////////////////////
+// Field definitions
+///////////////////////////////////////////////////
+
+unsigned int SpikeDelivery::getNumSources() const
+{
+    return rowStart_.size() - 1;
+}
+
+void SpikeDelivery::setNumTargets( unsigned int v )
+{
+    for ( unsigned int j = 0; j < target_.size(); ++j )
+    {
+        if ( target_[ j ] >= v )
+        {
+            cout << "Warning: SpikeDelivery::setNumTargets: " << v <<
+                 " is too small for target " << target_[ j ] << endl;
+            return;
+        }
+    }
+    numTargets_ = v;
+    ring_.clear();
+    pending_.clear();
+}
+
+unsigned int SpikeDelivery::getNumTargets() const
+{
+    return numTargets_;
+}
+
+unsigned int SpikeDelivery::getNumSynapses() const
+{
+    return target_.size();
+}
+
+vector< unsigned int > SpikeDelivery::getRowStart() const
+{
+    return rowStart_;
+}
+
+vector< unsigned int > SpikeDelivery::getTargets() const
+{
+    return target_;
+}
+
+vector< double > SpikeDelivery::getWeights() const
+{
+    return weight_;
+}
+
+vector< double > SpikeDelivery::getDelays() const
+{
+    return delay_;
+}
+
+///////////////////////////////////////////////////
+// Dest function definitions
+///////////////////////////////////////////////////
+
+namespace
+{
+struct SynEntry
+{
+    unsigned int source;
+    unsigned int target;
+    double weight;
+    double delay;
+};
+
+bool operator<( const SynEntry& a, const SynEntry& b )
+{
+    if ( a.source != b.source )
+        return a.source < b.source;
+    return a.delay < b.delay;
+}
+}
+
+void SpikeDelivery::connect( vector< double > v )
+{
+    if ( v.size() % 4 != 0 )
+    {
+        cout << "Warning: SpikeDelivery::connect: size " << v.size() <<
+             " is not a multiple of 4, ignored\n";
+        return;
+    }
+    unsigned int num = v.size() / 4;
+    for ( unsigned int i = 0; i < 2 * num; ++i )
+    {
+        if ( !( v[ i ] >= 0 ) || v[ i ] != floor( v[ i ] ) )
+        {
+            cout << "Warning: SpikeDelivery::connect: bad index " << v[ i ] <<
+                 ", ignored\n";
+            return;
+        }
+    }
+
+    vector< SynEntry > entry;
+    entry.reserve( target_.size() + num );
+    for ( unsigned int s = 0; s + 1 < rowStart_.size(); ++s )
+    {
+        for ( unsigned int j = rowStart_[ s ]; j < rowStart_[ s + 1 ]; ++j )
+        {
+            SynEntry se = { s, target_[ j ], weight_[ j ], delay_[ j ] };
+            entry.push_back( se );
+        }
+    }
+    for ( unsigned int i = 0; i < num; ++i )
+    {
+        SynEntry se = { static_cast< unsigned int >( v[ i ] ),
+                        static_cast< unsigned int >( v[ num + i ] ),
+                        v[ 2 * num + i ], v[ 3 * num + i ] };
+        if ( se.delay < 0.0 )
+            se.delay = 0.0;
+        entry.push_back( se );
+    }
+    // Existing synapses stay ahead of new ones with the same delay.
+    stable_sort( entry.begin(), entry.end() );
+
+    unsigned int numSources = entry.empty() ? 0 : entry.back().source + 1;
+    rowStart_.assign( numSources + 1, 0 );
+    target_.resize( entry.size() );
+    weight_.resize( entry.size() );
+    delay_.resize( entry.size() );
+    for ( unsigned int j = 0; j < entry.size(); ++j )
+    {
+        ++rowStart_[ entry[ j ].source + 1 ];
+        target_[ j ] = entry[ j ].target;
+        weight_[ j ] = entry[ j ].weight;
+        delay_[ j ] = entry[ j ].delay;
+        if ( numTargets_ <= target_[ j ] )
+            numTargets_ = target_[ j ] + 1;
+    }
+    for ( unsigned int s = 0; s < numSources; ++s )
+        rowStart_[ s + 1 ] += rowStart_[ s ];
+    ring_.clear();
+    pending_.clear();
+}
+
+void SpikeDelivery::clear()
+{
+    rowStart_.assign( 1, 0 );
+    target_.clear();
+    weight_.clear();
+    delay_.clear();
+    delaySteps_.clear();
+    ring_.clear();
+    pending_.clear();
+}
+
+void SpikeDelivery::spikes( vector< unsigned int > sources )
+{
+    if ( pending_.empty() ) // Synapses changed since reinit.
+        return;
+    for ( vector< unsigned int >::const_iterator
+            i = sources.begin(); i != sources.end(); ++i )
+    {
+        if ( *i + 1 >= rowStart_.size() )
+            continue;
+        for ( unsigned int j = rowStart_[ *i ]; j < rowStart_[ *i + 1 ]; ++j )
+        {
+            unsigned int bin = ( step_ + delaySteps_[ j ] ) & mask_;
+            ring_[ bin * numTargets_ + target_[ j ] ] += weight_[ j ];
+            ++pending_[ bin ];
+        }
+    }
+}
+
+void SpikeDelivery::reinit( const Eref& e, ProcPtr p )
+{
+    step_ = 0;
+    delaySteps_.resize( delay_.size() );
+    unsigned int maxSteps = 1;
+    for ( unsigned int j = 0; j < delay_.size(); ++j )
+    {
+        // Same as a SynEvent at t + delay, delivered at the first step
+        // whose time is not earlier, allowing for roundoff in delay / dt.
+        double steps = ceil( delay_[ j ] / p->dt - 1e-9 );
+        delaySteps_[ j ] = steps < 1.0 ? 1 : steps;
+        if ( maxSteps < delaySteps_[ j ] )
+            maxSteps = delaySteps_[ j ];
+    }
+    unsigned int numBins = 2;
+    while ( numBins <= maxSteps )
+        numBins *= 2;
+    mask_ = numBins - 1;
+    ring_.assign( numBins * numTargets_, 0.0 );
+    pending_.assign( numBins, 0 );
+    activation_.assign( numTargets_, 0.0 );
+}
+
+void SpikeDelivery::process( const Eref& e, ProcPtr p )
+{
+    if ( pending_.empty() )
+        return;
+    ++step_;
+    unsigned int bin = step_ & mask_;
+    if ( pending_[ bin ] == 0 )
+        return;
+
+    high_resolution_clock::time_point t0 = high_resolution_clock::now();
+
+    double* w = &ring_[ bin * numTargets_ ];
+    for ( unsigned int i = 0; i < numTargets_; ++i )
+    {
+        activation_[ i ] = w[ i ] / p->dt;
+        w[ i ] = 0.0;
+    }
+    pending_[ bin ] = 0;
+    activationOut()->send( e, activation_ );
+
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    moose::addSolverProf( "SpikeDelivery",
+                          duration_cast< duration< double > >( t1 - t0 ).count(),
+                          1 );
+}
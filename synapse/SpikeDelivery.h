@@ -0,0 +1,83 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _SPIKE_DELIVERY_H
+#define _SPIKE_DELIVERY_H
+
+/**
+ * Delivers spikes from a population of presynaptic sources to a
+ * population of targets through fixed synapses, without a message or a
+ * queue operation per synapse.
+ *  - The synapses are held in CSR form: row s lists the target, weight
+ *    and delay of every synapse made by source s, sorted by delay.
+ *  - Pending input is a calendar ring of delay bins, one bin per time
+ *    step, each bin holding the summed weight for every target. This is
+ *    the SpikeRingBuffer idea applied to a whole population at once.
+ *  - A spike from source s is a single scatter-add of its row into the
+ *    ring, at offsets precomputed from the delays at reinit.
+ * Each step the bin that falls due is sent as one activation vector,
+ * weight / dt per target, the same as SimpleSynHandler sends per target.
+ * Typically the sources and the targets are both IntFirePops: spikesOut
+ * goes to spikes, and activationOut to the activation of the targets.
+ */
+class SpikeDelivery
+{
+public:
+    SpikeDelivery();
+
+    void process( const Eref& e, ProcPtr p );
+    void reinit( const Eref& e, ProcPtr p );
+
+    /**
+     * Adds synapses. The vector holds the sources, then the targets,
+     * then the weights, then the delays, each of the same length.
+     */
+    void connect( vector< double > v );
+    void clear();
+
+    /// Handles spikes from the listed sources, at the current time.
+    void spikes( vector< unsigned int > sources );
+
+    unsigned int getNumSources() const;
+    void setNumTargets( unsigned int v );
+    unsigned int getNumTargets() const;
+    unsigned int getNumSynapses() const;
+    vector< unsigned int > getRowStart() const;
+    vector< unsigned int > getTargets() const;
+    vector< double > getWeights() const;
+    vector< double > getDelays() const;
+
+    static SrcFinfo1< vector< double > >* activationOut();
+
+    static const Cinfo* initCinfo();
+
+private:
+    /// Synapse j is target_[j], weight_[j], delay_[j]. The synapses of
+    /// source s are j = rowStart_[s] to rowStart_[s+1].
+    vector< unsigned int > rowStart_;
+    vector< unsigned int > target_;
+    vector< double > weight_;
+    vector< double > delay_;
+    unsigned int numTargets_;
+
+    /// Steps from arrival of a spike to its delivery, per synapse, >= 1.
+    vector< unsigned int > delaySteps_;
+
+    /// Bin b holds ring_[ b * numTargets_ ] on. Size is a power of 2.
+    vector< double > ring_;
+    /// Number of spikes added to each bin, so that empty bins are skipped.
+    vector< unsigned int > pending_;
+    unsigned int mask_;
+    /// Steps taken since reinit.
+    unsigned long step_;
+
+    vector< double > activation_;
+};
+
+#endif // _SPIKE_DELIVERY_H
@@ -72,7 +72,13 @@ def makeGlobalBalanceNetwork():
     # This was before we used c++11 <random> to generate random numbers. This
     # test has changes on Tuesday 31 July 2018 11:12:35 AM IST
     #  expectedCl = [ 1,4,13,13,26,42,52,56,80,82,95,97,4,9,0,9,4,8,0,6,1,6,6,7]
-    expectedCl=[0,6,47,50,56,67,98,2,0,3,5,4,8,3]
+    # Changed again when moose::RNG moved to counter-based Philox streams.
+    #  expectedCl=[0,6,47,50,56,67,98,2,0,3,5,4,8,3]
+    #  expectedCl=[0,26,28,39,71,90,95,1,6,7,1,1,3,7]
+    # Changed again when each source row got its own stream and skips
+    # straight to its next connection.
+    expectedCl=[0,1,15,16,18,35,46,52,69,73,76,78,88,
+            7,1,7,4,6,7,6,0,3,8,2,1,3]
 
     assert list(cl) == expectedCl, "Expected %s, got %s" % (expectedCl, cl)
 
@@ -88,7 +94,7 @@ def makeGlobalBalanceNetwork():
 
     # print("ConnMtxEntries: ", inhibMatrix.numEntries, excMatrix.numEntries, negFFMatrix.numEntries)
     got = (inhibMatrix.numEntries, excMatrix.numEntries, negFFMatrix.numEntries)
-    expected = (7, 62, 55)
+    expected = (13, 58, 49)
     assert expected == got, "Expected %s, Got %s" % (expected,got)
 
     cl = negFFMatrix.connectionList
@@ -103,7 +109,9 @@ def makeGlobalBalanceNetwork():
             i.synapse.weight = params['wtStimToInh']
 
     #  expected = [2,1,0,0,2,0,3,1,1,2]
-    expected = [1, 0, 1, 2, 1, 1, 0, 0, 1, 0]
+    #  expected = [1, 0, 1, 2, 1, 1, 0, 0, 1, 0]
+    #  expected = [0, 3, 0, 1, 0, 0, 1, 2, 0, 0]
+    expected = [1, 2, 1, 2, 1, 0, 2, 3, 1, 0]
     assert numInhSyns == expected, "Expected %s, got %s" % (expected,numInhSyns)
 
     for i in moose.vec( outsyn ):
@@ -118,11 +126,11 @@ def makeGlobalBalanceNetwork():
             i.synapse.weight = params['wtInhToOut']
 
     print("SUMS: ", sum( iv.numField ), sum( ov.numField ), sum( oiv.numField ))
-    assert [1, 64, 25] == [sum( iv.numField ), sum( ov.numField ), sum( oiv.numField )]
+    assert [1, 16, 16] == [sum( iv.numField ), sum( ov.numField ), sum( oiv.numField )]
     print("SUMS2: ", niv, nov, noiv)
-    assert [7, 62, 55] ==  [ niv, nov, noiv ]
+    assert [13, 58, 49] ==  [ niv, nov, noiv ]
     print("SUMS3: ", sum( insyn.vec.numSynapses ), sum( outsyn.vec.numSynapses ), sum( outInhSyn.vec.numSynapses ))
-    assert [7,62,55] == [ sum( insyn.vec.numSynapses ), sum( outsyn.vec.numSynapses ), sum( outInhSyn.vec.numSynapses ) ]
+    assert [13,58,49] == [ sum( insyn.vec.numSynapses ), sum( outsyn.vec.numSynapses ), sum( outInhSyn.vec.numSynapses ) ]
 
     # print(oiv.numField)
     # print(insyn.vec[1].synapse.num)
@@ -65,7 +65,7 @@ def makeModel():
     stoich.compartment = compartment
     stoich.ksolve = ksolve
     stoich.dsolve = dsolve
-    stoich.path = "/model/compartment/##"
+    stoich.reacSystemPath = "/model/compartment/##"
     assert( dsolve.numPools == 4 )
     a.vec.concInit = concA
     b.vec.concInit = concA / 5.0
@@ -136,7 +136,7 @@ def test_diffusion_gsolve_dsolve():
     msg += 'a=%f b=%f, c=%f, d=%f' % (tuple(got))
     print(msg)
     print('Initial to final (b+c)=%f' % (float(btot2 + ctot2) / (btot + ctot )))
-    expected = np.array((1.00003087, 1.39036644, 0.92191184, 1.11427514))
+    expected = np.array((1.00000423, 1.39136704, 0.921733185, 1.11445222))
     error = got - expected
     rerror = np.abs( error ) / expected
     assert np.allclose(got, expected, atol=1e-3), "Got %s, expected %s" % (got, expected)
@@ -0,0 +1,104 @@
+# -*- coding: utf-8 -*-
+# Tests IntFirePop, which steps arrays of integrate-and-fire neurons as one
+# population. Results must match stepping the neurons one by one.
+
+import numpy as np
+import pytest
+import moose
+
+print('Using moose from %s' % moose.__file__)
+
+N = 20
+
+# Parameters on top of the shared passive ones, per class.
+PARAMS = {
+    'LIF': {},
+    'QIF': {'vCritical': -0.054, 'a0': 0.3, 'thresh': -0.03},
+    'ExIF': {'vPeak': 0.0, 'deltaThresh': 2e-3},
+    'AdExIF': {'vPeak': 0.0, 'deltaThresh': 2e-3, 'tauW': 0.05,
+               'a0': 1e-9, 'b0': 5e-11},
+    'AdThreshIF': {'tauThresh': 0.05, 'a0': 0.1, 'threshJump': 5e-3},
+    'IzhIF': {'a0': 0.04e6, 'b0': 5e3, 'c0': 140, 'a': 20.0, 'b': 200.0,
+              'd': 2.0, 'vPeak': 0.03, 'vReset': -0.065, 'initVm': -0.065,
+              'uInit': -13.0, 'refractoryPeriod': 0.0},
+}
+
+
+def run(cls, usePop):
+    if moose.exists('/model'):
+        moose.delete('/model')
+    moose.Neutral('/model')
+    nrn = getattr(moose, cls)('/model/nrn', N)
+    vec = nrn.vec
+    vec.Rm = [1e8] * N
+    vec.Cm = [1e-10] * N
+    vec.Em = [-0.07] * N
+    vec.initVm = [-0.07] * N
+    vec.thresh = [-0.05] * N
+    vec.vReset = [-0.07] * N
+    vec.refractoryPeriod = [2e-3] * N
+    for field, value in PARAMS[cls].items():
+        setattr(vec, field, [value] * N)
+    vec.inject = list(np.linspace(0, 6e-10, N))
+
+    vm = moose.Table('/model/vm', N)
+    moose.connect(vm, 'requestOut', nrn, 'getVm', 'OneToOne')
+    spikes = moose.Table('/model/spikes', N)
+    moose.connect(nrn, 'spikeOut', spikes, 'spike', 'OneToOne')
+
+    pop = None
+    if usePop:
+        pop = moose.IntFirePop('/model/pop')
+        pop.path = '/model/nrn'
+    moose.reinit()
+    moose.start(0.1)
+    ret = ([np.array(t.vector) for t in vm.vec],
+           [np.array(t.vector) for t in spikes.vec])
+    if pop is not None:
+        assert pop.numNeurons == N
+        assert len(pop.neurons) == N
+    return ret
+
+
+@pytest.mark.parametrize('cls', sorted(PARAMS))
+def test_intfire_pop_matches(cls):
+    refVm, refSpikes = run(cls, False)
+    vm, spikes = run(cls, True)
+    assert sum(len(s) for s in refSpikes) > 0, 'Nothing fired'
+    for a, b in zip(refVm, vm):
+        assert np.allclose(a, b, rtol=0, atol=1e-12)
+    for a, b in zip(refSpikes, spikes):
+        assert np.array_equal(a, b)
+
+
+def test_intfire_pop_release():
+    refVm, refSpikes = run('LIF', False)
+    run('LIF', True)
+    # Deleting the population puts the neurons back on their clock.
+    moose.delete('/model/pop')
+    moose.reinit()
+    moose.start(0.1)
+    vm = [np.array(t.vector) for t in moose.element('/model/vm').vec]
+    for a, b in zip(refVm, vm):
+        assert np.allclose(a, b, rtol=0, atol=1e-12)
+
+
+def test_intfire_pop_spikes():
+    moose.Neutral('/spk')
+    nrn = moose.LIF('/spk/nrn', 4)
+    nrn.vec.Rm = [1e8] * 4
+    nrn.vec.Cm = [1e-10] * 4
+    nrn.vec.Em = [-0.07] * 4
+    nrn.vec.initVm = [-0.07] * 4
+    nrn.vec.thresh = [-0.05] * 4
+    nrn.vec.vReset = [-0.07] * 4
+    nrn.vec.inject = [0.0, 1e-9, 0.0, 1e-9]
+    pop = moose.IntFirePop('/spk/pop')
+    pop.path = '/spk/nrn'
+    moose.reinit()
+    fired = set()
+    for i in range(400):
+        moose.start(50e-6)
+        fired.update(pop.spikes)
+    assert fired == {1, 3}
+    moose.delete('/spk')
@@ -0,0 +1,98 @@
+# -*- coding: utf-8 -*-
+# Tests that stochastic objects draw from their own RNG streams, keyed by
+# the global seed and the object, so that results do not depend on the
+# number of threads that run them.
+
+import numpy as np
+import moose
+
+print('Using moose from %s' % moose.__file__)
+
+
+def makeRandSpikes():
+    if moose.exists('/model'):
+        moose.delete('/model')
+    moose.Neutral('/model')
+    N = 50
+    rs = moose.RandSpike('/model/rs', N)
+    rs.vec.rate = [100.0] * N
+    rs.vec.refractT = [1e-3] * N
+    # Spike times only go up, so each Table keeps the first spike of
+    # its entry.
+    tab = moose.Table('/model/tab', N)
+    moose.connect(rs, 'spikeOut', tab, 'spike', 'OneToOne')
+    return tab
+
+
+def runRandSpikes(tab, seed, nT):
+    moose.element('/clock').numThreads = nT
+    moose.seed(seed)
+    moose.reinit()
+    moose.start(1.0)
+    moose.element('/clock').numThreads = 1
+    return [np.array(t.vector) for t in tab.vec]
+
+
+def test_randspike_streams():
+    # The streams are keyed by object id, so every run uses the same model.
+    tab = makeRandSpikes()
+    a = runRandSpikes(tab, 42, 1)
+    b = runRandSpikes(tab, 42, 4)
+    c = runRandSpikes(tab, 43, 1)
+    assert sum(len(x) for x in a) > 0, 'Nothing fired'
+    for x, y in zip(a, b):
+        assert np.array_equal(x, y)
+    assert any(not np.array_equal(x, y) for x, y in zip(a, c))
+    # Entries do not share a stream.
+    assert any(not np.array_equal(a[0], x) for x in a[1:])
+
+
+def makeGsolve():
+    if moose.exists('/model'):
+        moose.delete('/model')
+    moose.Neutral('/model')
+    compt = moose.CylMesh('/model/compt')
+    compt.r0 = compt.r1 = 1e-6
+    compt.x1 = 20e-6
+    compt.diffLength = 1e-6
+    assert compt.numDiffCompts == 20
+    A = moose.Pool('/model/compt/A')
+    B = moose.Pool('/model/compt/B')
+    r = moose.Reac('/model/compt/r')
+    moose.connect(r, 'sub', A, 'reac')
+    moose.connect(r, 'prd', B, 'reac')
+    r.Kf = 0.5
+    r.Kb = 0.2
+    gsolve = moose.Gsolve('/model/compt/gsolve')
+    stoich = moose.Stoich('/model/compt/stoich')
+    stoich.compartment = compt
+    stoich.ksolve = gsolve
+    stoich.reacSystemPath = '/model/compt/##'
+    # The pools only have one entry per voxel once the solver is built.
+    A.vec.nInit = [200.0] * 20
+    return gsolve, B
+
+
+def runGsolve(gsolve, B, seed, nT):
+    gsolve.numThreads = nT
+    moose.seed(seed)
+    moose.reinit()
+    moose.start(20.0)
+    return np.array(B.vec.n)
+
+
+def test_gsolve_streams():
+    gsolve, B = makeGsolve()
+    a = runGsolve(gsolve, B, 42, 1)
+    b = runGsolve(gsolve, B, 42, 3)
+    c = runGsolve(gsolve, B, 43, 1)
+    assert np.array_equal(a, b), "Got %s and %s" % (a, b)
+    assert not np.array_equal(a, c)
+    # Each voxel has its own stream.
+    assert len(set(a)) > 1
+    assert np.all(a <= 200.0)
+
+
+if __name__ == '__main__':
+    test_randspike_streams()
+    test_gsolve_streams()
@@ -0,0 +1,108 @@
+# -*- coding: utf-8 -*-
+# Tests the random connectivity rules of SparseMsg: probability, fixed
+# in-degree, fixed out-degree and distance-dependent probability.
+
+import numpy as np
+import moose
+
+print('Using moose from %s' % moose.__file__)
+
+NSRC = 300
+NTGT = 200
+
+
+def makeMsg():
+    if moose.exists('/net'):
+        moose.delete('/net')
+    moose.Neutral('/net')
+    src = moose.RandSpike('/net/src', NSRC)
+    syns = moose.SimpleSynHandler('/net/syns', NTGT)
+    synVec = moose.vec(syns.path + '/synapse')
+    sm = moose.element(moose.connect(src, 'spikeOut', synVec, 'addSpike',
+                                     'Sparse'))
+    return sm, syns
+
+
+def pairs(sm):
+    cl = list(sm.connectionList)
+    n = len(cl) // 2
+    return cl[:n], cl[n:]
+
+
+def checkFieldIndices(sm, syns):
+    # Synapses on each target are numbered 0, 1, ... in order of source.
+    rows, cols = pairs(sm)
+    entries = list(sm.matrixEntry)
+    seen = {}
+    for r, c, e in zip(rows, cols, entries):
+        assert e == seen.get(c, 0)
+        seen[c] = e + 1
+    for i, h in enumerate(syns.vec):
+        assert h.numSynapses == seen.get(i, 0)
+
+
+def test_probability():
+    sm, syns = makeMsg()
+    p = 0.05
+    sm.setRandomConnectivity(p, 42)
+    n = sm.numEntries
+    mean = p * NSRC * NTGT
+    assert abs(n - mean) < 5 * np.sqrt(mean), n
+    checkFieldIndices(sm, syns)
+    first = list(sm.connectionList)
+    sm.setRandomConnectivity(p, 42)
+    assert list(sm.connectionList) == first
+    sm.setRandomConnectivity(p, 43)
+    assert list(sm.connectionList) != first
+    # The seed field redoes the same rule.
+    sm.seed = 42
+    assert list(sm.connectionList) == first
+    sm.setRandomConnectivity(1.0, 42)
+    assert sm.numEntries == NSRC * NTGT
+    sm.setRandomConnectivity(0.0, 42)
+    assert sm.numEntries == 0
+
+
+def test_fixed_degree():
+    sm, syns = makeMsg()
+    sm.setFixedInDegree(7, 11)
+    assert sm.numEntries == 7 * NTGT
+    assert list(syns.vec.numSynapses) == [7] * NTGT
+    rows, cols = pairs(sm)
+    assert len(set(zip(rows, cols))) == len(rows)
+    checkFieldIndices(sm, syns)
+
+    sm.setFixedOutDegree(5, 11)
+    assert sm.numEntries == 5 * NSRC
+    assert list(np.diff(sm.rowStart)) == [5] * NSRC
+    rows, cols = pairs(sm)
+    assert len(set(zip(rows, cols))) == len(rows)
+    checkFieldIndices(sm, syns)
+    first = list(sm.connectionList)
+    sm.seed = 11
+    assert list(sm.connectionList) == first
+
+
+def test_distance():
+    sm, syns = makeMsg()
+    # Sources and targets on the same line, 1 apart.
+    sm.sourcePositions = [float(x) for i in range(NSRC) for x in (i, 0, 0)]
+    sm.targetPositions = [float(x) for i in range(NTGT) for x in (i, 0, 0)]
+    sm.spaceConstant = 5.0
+    sm.setRandomConnectivity(1.0, 3)
+    rows, cols = pairs(sm)
+    d = np.abs(np.array(rows) - np.array(cols))
+    assert len(d) > 0
+    assert (d < 5).sum() > (d >= 5).sum()
+    # Expected number: sum over pairs of exp(-d/5).
+    s = np.arange(NSRC)[:, None]
+    t = np.arange(NTGT)[None, :]
+    mean = np.exp(-np.abs(s - t) / 5.0).sum()
+    assert abs(len(d) - mean) < 5 * np.sqrt(mean)
+    checkFieldIndices(sm, syns)
+
+
+if __name__ == '__main__':
+    test_probability()
+    test_fixed_degree()
+    test_distance()
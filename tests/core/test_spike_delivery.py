@@ -0,0 +1,129 @@
+# -*- coding: utf-8 -*-
+# Tests SpikeDelivery, which delivers spikes between populations through
+# synapses stored by source. A network of LIFs wired through an IntFirePop
+# and a SpikeDelivery must match the same network wired through
+# SimpleSynHandlers and a SparseMsg.
+
+import numpy as np
+import moose
+
+print('Using moose from %s' % moose.__file__)
+
+N = 40
+DT = 50e-6
+
+
+def makeNeurons():
+    if moose.exists('/model'):
+        moose.delete('/model')
+    moose.Neutral('/model')
+    nrn = moose.LIF('/model/nrn', N)
+    vec = nrn.vec
+    vec.Rm = [1e8] * N
+    vec.Cm = [1e-10] * N
+    vec.Em = [-0.07] * N
+    vec.initVm = [-0.07] * N
+    vec.thresh = [-0.05] * N
+    vec.vReset = [-0.07] * N
+    vec.refractoryPeriod = [2e-3] * N
+    vec.inject = list(np.linspace(0, 4e-10, N))
+    vm = moose.Table('/model/vm', N)
+    moose.connect(vm, 'requestOut', nrn, 'getVm', 'OneToOne')
+    spikes = moose.Table('/model/spikes', N)
+    moose.connect(nrn, 'spikeOut', spikes, 'spike', 'OneToOne')
+    return nrn
+
+
+def results():
+    return ([np.array(t.vector) for t in moose.element('/model/vm').vec],
+            [np.array(t.vector) for t in moose.element('/model/spikes').vec])
+
+
+def runReference():
+    """Runs through SimpleSynHandlers, and returns the results and the
+    synapses in the form taken by SpikeDelivery.connect."""
+    nrn = makeNeurons()
+    syns = moose.SimpleSynHandler('/model/syns', N)
+    moose.connect(syns, 'activationOut', nrn, 'activation', 'OneToOne')
+    synVec = moose.vec(syns.path + '/synapse')
+    sm = moose.element(moose.connect(nrn, 'spikeOut', synVec, 'addSpike',
+                                     'Sparse'))
+    sm.setRandomConnectivity(0.2, 123)
+
+    rng = np.random.RandomState(7)
+    weight = {}
+    delay = {}
+    for i, h in enumerate(syns.vec):
+        num = h.numSynapses
+        weight[i] = rng.uniform(0, 4e-3, num)
+        delay[i] = (rng.randint(0, 9, num) + 0.5) * DT
+        if num > 0:
+            h.synapse.weight = list(weight[i])
+            h.synapse.delay = list(delay[i])
+
+    src, tgt, w, d = [], [], [], []
+    rowStart = sm.rowStart
+    for s in range(N):
+        for j in range(rowStart[s], rowStart[s + 1]):
+            t = sm.columnIndex[j]
+            f = sm.matrixEntry[j]
+            src.append(s)
+            tgt.append(t)
+            w.append(weight[t][f])
+            d.append(delay[t][f])
+
+    moose.reinit()
+    moose.start(0.1)
+    return results(), src + tgt + w + d
+
+
+def runPop(conn):
+    nrn = makeNeurons()
+    pop = moose.IntFirePop('/model/pop')
+    pop.path = nrn.path
+    sd = moose.SpikeDelivery('/model/sd')
+    sd.connect(conn)
+    moose.connect(pop, 'spikesOut', sd, 'spikes')
+    moose.connect(sd, 'activationOut', pop, 'activation')
+    moose.reinit()
+    moose.start(0.1)
+    assert sd.numSynapses == len(conn) // 4
+    return results()
+
+
+def test_spike_delivery_matches():
+    (refVm, refSpikes), conn = runReference()
+    vm, spikes = runPop(conn)
+    assert len(conn) > 0
+    # Only the upper half of the neurons fire on their injection alone, so
+    # this checks that synaptic input arrives.
+    assert sum(len(s) > 0 for s in refSpikes) > N // 2
+    for a, b in zip(refVm, vm):
+        assert np.allclose(a, b, rtol=0, atol=1e-12)
+    for a, b in zip(refSpikes, spikes):
+        assert np.array_equal(a, b)
+
+
+def test_spike_delivery_storage():
+    sd = moose.SpikeDelivery('/sd')
+    # Synapses are stored by source and then by delay.
+    sd.connect([2, 0, 2, 0,   1, 3, 0, 1,   1.0, 2.0, 3.0, 4.0,
+                2e-3, 1e-3, 1e-3, 0.0])
+    assert sd.numSources == 3
+    assert sd.numTargets == 4
+    assert sd.numSynapses == 4
+    assert list(sd.rowStart) == [0, 2, 2, 4]
+    assert list(sd.targets) == [1, 3, 0, 1]
+    assert np.allclose(sd.weights, [4.0, 2.0, 3.0, 1.0])
+    assert np.allclose(sd.delays, [0.0, 1e-3, 1e-3, 2e-3])
+    sd.numTargets = 10
+    assert sd.numTargets == 10
+    sd.clear()
+    assert sd.numSynapses == 0
+    assert sd.numSources == 0
+    moose.delete(sd)
+
+
+if __name__ == '__main__':
+    test_spike_delivery_matches()
+    test_spike_delivery_storage()
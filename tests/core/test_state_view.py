@@ -0,0 +1,90 @@
+# -*- coding: utf-8 -*-
+# Tests moose.stateView, which gives NumPy arrays over solver state without
+# copying.
+
+import numpy as np
+import pytest
+import moose
+
+print('Using moose from %s' % moose.__file__)
+
+
+def makeReacs(path):
+    compt = moose.CubeMesh(path)
+    compt.volume = 1e-20
+    a = moose.Pool(path + '/a')
+    b = moose.Pool(path + '/b')
+    c = moose.BufPool(path + '/c')
+    a.concInit = 2.0
+    b.concInit = 0.5
+    c.concInit = 1.0
+    r = moose.Reac(path + '/r')
+    moose.connect(r, 'sub', a, 'reac')
+    moose.connect(r, 'prd', b, 'reac')
+    r.Kf = 0.3
+    r.Kb = 0.1
+    return compt, [a, b, c]
+
+
+def test_ksolve_view():
+    compt, pools = makeReacs('/kview')
+    ksolve = moose.Ksolve('/kview/ksolve')
+    stoich = moose.Stoich('/kview/stoich')
+    stoich.compartment = compt
+    stoich.ksolve = ksolve
+    stoich.reacSystemPath = '/kview/##'
+    moose.reinit()
+
+    view = moose.stateView(ksolve, 0)
+    assert not view.flags.writeable
+    with pytest.raises(ValueError):
+        view[0] = 1.0
+
+    # The view follows the simulation without being fetched again.
+    moose.start(10)
+    ns = sorted(p.n for p in pools)
+    assert np.allclose(sorted(view[:len(pools)]), ns)
+
+    w = moose.stateView(ksolve, 0, writable=True)
+    i = int(np.argmin(np.abs(w - pools[0].n)))
+    w[i] = 1234.0
+    assert np.isclose(pools[0].n, 1234.0)
+
+    with pytest.raises(IndexError):
+        moose.stateView(ksolve, 10)
+    moose.delete('/kview')
+
+
+def test_hsolve_view():
+    model = moose.Neutral('/hview')
+    compts = []
+    for i in range(4):
+        c = moose.Compartment('/hview/c%d' % i)
+        c.Rm = 1e9
+        c.Cm = 1e-11
+        c.Ra = 1e6
+        c.Em = -0.065
+        c.initVm = -0.065 + 0.001 * i
+        if compts:
+            moose.connect(compts[-1], 'raxial', c, 'axial')
+        compts.append(c)
+    compts[0].inject = 1e-10
+    hsolve = moose.HSolve('/hview/hsolve')
+    hsolve.dt = 50e-6
+    hsolve.target = '/hview/c0'
+    moose.reinit()
+    moose.start(0.01)
+
+    view = moose.stateView(hsolve)
+    order = hsolve.compartments
+    assert len(view) == len(compts)
+    assert np.allclose(view, [moose.element(c).Vm for c in order])
+
+    with pytest.raises(TypeError):
+        moose.stateView(model)
+    moose.delete('/hview')
+
+
+if __name__ == '__main__':
+    test_ksolve_view()
+    test_hsolve_view()
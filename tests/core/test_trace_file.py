@@ -0,0 +1,70 @@
+# -*- coding: utf-8 -*-
+# Tests the chunked trace format (mtr, mtrz) written by Streamer, and
+# moose.TraceFile, which reads it through a memory map.
+
+import os
+import numpy as np
+import pytest
+import moose
+
+print('Using moose from %s' % moose.__file__)
+
+
+def record(path, runtime=2.0):
+    moose.Neutral('/trace')
+    pulse = moose.PulseGen('/trace/pulse')
+    pulse.delay[0] = 0.5
+    pulse.width[0] = 0.5
+    pulse.level[0] = 1.0
+    tab = moose.Table('/trace/tab')
+    moose.connect(tab, 'requestOut', pulse, 'getOutputValue')
+    st = moose.Streamer('/trace/st')
+    st.outfile = path
+    st.addTable(tab)
+    moose.reinit()
+    moose.start(runtime)
+    return st
+
+
+@pytest.mark.parametrize('ext', ['mtr', 'mtrz'])
+def test_trace_file(ext):
+    path = os.path.join(os.path.dirname(__file__), '_trace.' + ext)
+    st = record(path)
+    assert st.format == ext
+
+    f = moose.TraceFile(path)
+    assert f.columns[0] == 'time'
+    assert len(f) == f.numRows > 0
+    t = f.column('time')
+    y = f.column(1)
+    assert len(t) == len(y) == len(f)
+    assert np.all(np.diff(t) > 0)
+    assert y.min() == 0.0 and y.max() == 1.0
+    assert np.array_equal(np.concatenate(f.blocks(1)), y)
+
+    w = f.column(1, tmin=0.6, tmax=0.9)
+    assert np.all(w == 1.0)
+    assert np.array_equal(w, y[(t >= 0.6) & (t <= 0.9)])
+    if ext == 'mtr' and f.numBlocks == 1:
+        # A window inside one uncompressed block is a view of the file.
+        assert w.base is not None and not w.flags.writeable
+
+    with pytest.raises(KeyError):
+        f.column('nothere')
+
+    # Running again replaces the file, and leaves the arrays that map the
+    # old one readable.
+    old = y.copy()
+    moose.reinit()
+    moose.start(1.0)
+    assert np.array_equal(y, old)
+    assert np.array_equal(w, old[(t >= 0.6) & (t <= 0.9)])
+    assert len(moose.TraceFile(path)) < len(f)
+    del f, t, y, w
+    moose.delete('/trace')
+    os.remove(path)
+
+
+if __name__ == '__main__':
+    test_trace_file('mtr')
+    test_trace_file('mtrz')
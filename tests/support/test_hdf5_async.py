@@ -0,0 +1,115 @@
+# -*- coding: utf-8 -*-
+# Checks that HDF5DataWriter and NSDFWriter2 write the same data with
+# asyncWrite on as with it off.
+
+import os
+import numpy as np
+import pytest
+import moose
+
+h5py = pytest.importorskip('h5py')
+print('using moose from: %s' % moose.__file__)
+
+
+def record(path, asyncWrite):
+    model = moose.Neutral('/async')
+    pulses = []
+    for ii in range(3):
+        p = moose.PulseGen('/async/pulse%d' % ii)
+        p.level[0] = ii + 1.0
+        p.delay[0] = 0.01 * (ii + 1)
+        p.width[0] = 0.02
+        pulses.append(p)
+    writer = moose.HDF5DataWriter('/async/writer')
+    writer.filename = path
+    writer.mode = 2
+    writer.flushLimit = 1000
+    writer.asyncWrite = asyncWrite
+    for p in pulses:
+        moose.connect(writer, 'requestOut', p, 'getOutputValue')
+    # The writers' default tick has a dt of 1 s.
+    moose.setClock(writer.tick, 1e-4)
+    moose.reinit()
+    moose.start(1.0)
+    writer.close()
+    moose.setClock(writer.tick, 1.0)
+    data = []
+    with h5py.File(path, 'r') as f:
+        for p in pulses:
+            data.append(np.array(f[p.path + '/outputValue']))
+    moose.delete(model)
+    os.remove(path)
+    return data
+
+
+def test_async_matches_sync():
+    sync = record('_sync.h5', False)
+    asyn = record('_async.h5', True)
+    assert len(sync[0]) > 1000
+    for a, b in zip(sync, asyn):
+        assert np.array_equal(a, b)
+
+
+def datasets(group):
+    data = {}
+    def add(name, obj):
+        if isinstance(obj, h5py.Dataset):
+            data[name] = np.array(obj)
+    group.visititems(add)
+    return data
+
+
+def recordNSDF(path, asyncWrite):
+    # NSDFWriter2 blocks need a Neuron or ChemCompt as container.
+    model = moose.Neutral('/nsdfasync')
+    cell = moose.Neuron('/nsdfasync/cell')
+    for ii in range(3):
+        p = moose.PulseGen('/nsdfasync/cell/pulse%d' % ii)
+        p.level[0] = ii + 1.0
+        p.delay[0] = 0.01 * (ii + 1)
+        p.width[0] = 0.02
+    spike = moose.SpikeGen('/nsdfasync/spike')
+    spike.threshold = 0.5
+    spike.edgeTriggered = 1
+    moose.connect(moose.element('/nsdfasync/cell/pulse0'), 'output',
+                  spike, 'Vm')
+    writer = moose.NSDFWriter2('/nsdfasync/writer')
+    writer.filename = path
+    writer.mode = 2
+    writer.modelRoot = ''
+    writer.flushLimit = 100
+    writer.asyncWrite = asyncWrite
+    writer.blocks = ['/nsdfasync/cell/pulse#.outputValue']
+    writer.eventInput.num = 1
+    moose.connect(spike, 'spikeOut', writer.eventInput[0], 'input')
+    moose.setClock(writer.tick, 1e-4)
+    moose.reinit()
+    moose.start(1.0)
+    writer.close()
+    moose.setClock(writer.tick, 1.0)
+    with h5py.File(path, 'r') as f:
+        uniform = datasets(f['/data/uniform'])
+        event = datasets(f['/data/event'])
+    moose.delete(model)
+    os.remove(path)
+    return uniform, event
+
+
+def test_nsdf_async_matches_sync():
+    syncUniform, syncEvent = recordNSDF('_nsdf_sync.h5', False)
+    asynUniform, asynEvent = recordNSDF('_nsdf_async.h5', True)
+    assert len(syncUniform) == 1
+    assert len(syncEvent) == 1
+    assert sorted(syncUniform) == sorted(asynUniform)
+    assert sorted(syncEvent) == sorted(asynEvent)
+    for name, data in syncUniform.items():
+        assert data.shape[0] == 3 and data.shape[1] > 1000
+        assert np.array_equal(data, asynUniform[name])
+    for name, data in syncEvent.items():
+        assert len(data) > 10
+        assert np.array_equal(data, asynEvent[name])
+
+
+if __name__ == '__main__':
+    test_async_matches_sync()
+    test_nsdf_async_matches_sync()
@@ -0,0 +1,396 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#include "TraceFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace trace
+{
+
+static const char headMagic[ 8 ] = { 'M', 'O', 'O', 'S', 'E', 'T', 'R', 1 };
+static const char tailMagic[ 8 ] = { 'M', 'T', 'R', 'I', 'N', 'D', 'E', 'X' };
+static const size_t trailerSize = 32;
+
+template< class T > static void put( string& s, T v )
+{
+    s.append( reinterpret_cast< const char* >( &v ), sizeof( T ) );
+}
+
+template< class T > static T get( const char* p )
+{
+    T v;
+    memcpy( &v, p, sizeof( T ) );
+    return v;
+}
+
+string headerBytes( const vector< string >& columns, size_t blockRows,
+                    bool compress )
+{
+    string s( headMagic, 8 );
+    put< uint32_t >( s, columns.size() );
+    put< uint32_t >( s, blockRows );
+    put< uint32_t >( s, compress ? 1 : 0 );
+    for ( auto i = columns.begin(); i != columns.end(); ++i )
+    {
+        put< uint32_t >( s, i->size() );
+        s += *i;
+    }
+    s.append( ( 8 - s.size() % 8 ) % 8, '\0' );
+    return s;
+}
+
+string footerBytes( const vector< Block >& blocks, uint64_t footerOffset )
+{
+    string s;
+    uint64_t numRows = 0;
+    for ( auto b = blocks.begin(); b != blocks.end(); ++b )
+    {
+        put< uint64_t >( s, b->firstRow );
+        put< uint64_t >( s, b->numRows );
+        put< double >( s, b->tStart );
+        put< double >( s, b->tEnd );
+        for ( size_t j = 0; j < b->offset.size(); ++j )
+        {
+            put< uint64_t >( s, b->offset[ j ] );
+            put< uint64_t >( s, b->bytes[ j ] );
+        }
+        numRows = b->firstRow + b->numRows;
+    }
+    put< uint64_t >( s, footerOffset );
+    put< uint64_t >( s, blocks.size() );
+    put< uint64_t >( s, numRows );
+    s.append( tailMagic, 8 );
+    return s;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Chunk compression
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * After the XOR and shuffle the chunk is a byte stream made of tokens.
+ * A token byte with the high bit set stands for (b & 0x7f) + 1 zero
+ * bytes. Otherwise it is followed by b + 1 literal bytes.
+ */
+void encodeChunk( const double* x, size_t n, string& out )
+{
+    const size_t len = n * 8;
+    vector< unsigned char > s( len );
+    uint64_t prev = 0;
+    for ( size_t i = 0; i < n; ++i )
+    {
+        uint64_t u;
+        memcpy( &u, x + i, 8 );
+        uint64_t d = u ^ prev;
+        prev = u;
+        for ( size_t k = 0; k < 8; ++k )
+            s[ k * n + i ] = ( d >> ( 8 * k ) ) & 0xff;
+    }
+
+    size_t i = 0;
+    while ( i < len )
+    {
+        size_t z = 0;
+        while ( i + z < len && z < 128 && s[ i + z ] == 0 )
+            ++z;
+        if ( z >= 2 )
+        {
+            out += static_cast< char >( 0x80 | ( z - 1 ) );
+            i += z;
+            continue;
+        }
+        size_t j = i;
+        while ( j < len && j - i < 128 &&
+                !( s[ j ] == 0 && j + 1 < len && s[ j + 1 ] == 0 ) )
+            ++j;
+        out += static_cast< char >( j - i - 1 );
+        out.append( reinterpret_cast< const char* >( &s[ i ] ), j - i );
+        i = j;
+    }
+}
+
+bool decodeChunk( const char* data, size_t bytes, size_t n, double* x )
+{
+    const size_t len = n * 8;
+    vector< unsigned char > s( len );
+    size_t i = 0;
+    const unsigned char* p = reinterpret_cast< const unsigned char* >( data );
+    const unsigned char* end = p + bytes;
+    while ( p < end )
+    {
+        size_t m = ( *p & 0x7f ) + 1;
+        if ( i + m > len )
+            return false;
+        if ( *p++ & 0x80 )
+        {
+            memset( &s[ i ], 0, m );
+        }
+        else
+        {
+            if ( p + m > end )
+                return false;
+            memcpy( &s[ i ], p, m );
+            p += m;
+        }
+        i += m;
+    }
+    if ( i != len )
+        return false;
+
+    uint64_t prev = 0;
+    for ( size_t r = 0; r < n; ++r )
+    {
+        uint64_t d = 0;
+        for ( size_t k = 0; k < 8; ++k )
+            d |= uint64_t( s[ k * n + r ] ) << ( 8 * k );
+        prev ^= d;
+        memcpy( x + r, &prev, 8 );
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reader
+//////////////////////////////////////////////////////////////////////
+
+Reader::Reader( const string& path )
+    :
+    path_( path ), data_( 0 ), size_( 0 ), mapping_( 0 ),
+    numRows_( 0 ), blockRows_( 0 )
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                               NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( file == INVALID_HANDLE_VALUE )
+        throw runtime_error( "Cannot open " + path );
+    LARGE_INTEGER sz;
+    GetFileSizeEx( file, &sz );
+    size_ = sz.QuadPart;
+    if ( size_ > 0 )
+    {
+        mapping_ = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+        if ( mapping_ )
+            data_ = static_cast< const char* >(
+                        MapViewOfFile( mapping_, FILE_MAP_READ, 0, 0, 0 ) );
+    }
+    CloseHandle( file );
+#else
+    int fd = ::open( path.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        throw runtime_error( "Cannot open " + path );
+    struct stat st;
+    fstat( fd, &st );
+    size_ = st.st_size;
+    if ( size_ > 0 )
+    {
+        void* p = mmap( 0, size_, PROT_READ, MAP_SHARED, fd, 0 );
+        if ( p != MAP_FAILED )
+            data_ = static_cast< const char* >( p );
+    }
+    ::close( fd );
+#endif
+    if ( !data_ && size_ > 0 )
+        throw runtime_error( "Cannot map " + path );
+
+    // Check the header and trailer, then read the index.
+    const string bad = path + " is not a complete trace file";
+    if ( size_ < 20 + trailerSize || memcmp( data_, headMagic, 8 ) != 0 ||
+            memcmp( data_ + size_ - 8, tailMagic, 8 ) != 0 )
+    {
+        unmap();
+        throw runtime_error( bad );
+    }
+    const size_t numCols = get< uint32_t >( data_ + 8 );
+    blockRows_ = get< uint32_t >( data_ + 12 );
+    size_t pos = 20;
+    for ( size_t i = 0; i < numCols && pos + 4 <= size_; ++i )
+    {
+        size_t len = get< uint32_t >( data_ + pos );
+        pos += 4;
+        if ( pos + len > size_ )
+            break;
+        columns_.push_back( string( data_ + pos, len ) );
+        pos += len;
+    }
+
+    const char* t = data_ + size_ - trailerSize;
+    uint64_t footer = get< uint64_t >( t );
+    uint64_t numBlocks = get< uint64_t >( t + 8 );
+    numRows_ = get< uint64_t >( t + 16 );
+    const size_t entry = 32 + 16 * numCols;
+    if ( columns_.size() != numCols || footer < pos ||
+            footer + numBlocks * entry + trailerSize != size_ )
+    {
+        unmap();
+        throw runtime_error( bad );
+    }
+
+    blocks_.resize( numBlocks );
+    const char* p = data_ + footer;
+    for ( size_t b = 0; b < numBlocks; ++b )
+    {
+        Block& blk = blocks_[ b ];
+        blk.firstRow = get< uint64_t >( p );
+        blk.numRows = get< uint64_t >( p + 8 );
+        blk.tStart = get< double >( p + 16 );
+        blk.tEnd = get< double >( p + 24 );
+        p += 32;
+        blk.offset.resize( numCols );
+        blk.bytes.resize( numCols );
+        for ( size_t j = 0; j < numCols; ++j )
+        {
+            blk.offset[ j ] = get< uint64_t >( p );
+            blk.bytes[ j ] = get< uint64_t >( p + 8 );
+            p += 16;
+            if ( blk.offset[ j ] + blk.bytes[ j ] > footer ||
+                    blk.bytes[ j ] > blk.numRows * 8 )
+            {
+                unmap();
+                throw runtime_error( bad );
+            }
+        }
+    }
+}
+
+Reader::~Reader()
+{
+    unmap();
+}
+
+void Reader::unmap()
+{
+    if ( !data_ )
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile( data_ );
+    CloseHandle( mapping_ );
+#else
+    munmap( const_cast< char* >( data_ ), size_ );
+#endif
+    data_ = 0;
+}
+
+const vector< string >& Reader::columns() const
+{
+    return columns_;
+}
+
+const vector< Block >& Reader::blocks() const
+{
+    return blocks_;
+}
+
+uint64_t Reader::numRows() const
+{
+    return numRows_;
+}
+
+size_t Reader::blockRows() const
+{
+    return blockRows_;
+}
+
+int Reader::columnIndex( const string& name ) const
+{
+    auto i = find( columns_.begin(), columns_.end(), name );
+    return ( i == columns_.end() ) ? -1 : i - columns_.begin();
+}
+
+const double* Reader::chunk( size_t b, size_t col ) const
+{
+    const Block& blk = blocks_[ b ];
+    if ( blk.bytes[ col ] != blk.numRows * 8 )
+        return 0;
+    return reinterpret_cast< const double* >( data_ + blk.offset[ col ] );
+}
+
+size_t Reader::blockOf( uint64_t row ) const
+{
+    auto i = upper_bound( blocks_.begin(), blocks_.end(), row,
+    []( uint64_t r, const Block& b ) { return r < b.firstRow; } );
+    return ( i - blocks_.begin() ) - 1;
+}
+
+void Reader::blockColumn( size_t b, size_t col, vector< double >& x ) const
+{
+    const Block& blk = blocks_[ b ];
+    x.resize( blk.numRows );
+    const double* raw = chunk( b, col );
+    if ( raw )
+        memcpy( x.data(), raw, blk.numRows * 8 );
+    else if ( !decodeChunk( data_ + blk.offset[ col ], blk.bytes[ col ],
+                            blk.numRows, x.data() ) )
+        throw runtime_error( "Corrupt chunk in " + path_ );
+}
+
+void Reader::read( size_t col, uint64_t first, uint64_t n, double* x ) const
+{
+    if ( col >= columns_.size() || first + n > numRows_ )
+        throw out_of_range( "Trace read out of range" );
+    vector< double > buf;
+    for ( size_t b = blockOf( first ); n > 0; ++b )
+    {
+        const Block& blk = blocks_[ b ];
+        uint64_t from = first - blk.firstRow;
+        uint64_t m = min( n, blk.numRows - from );
+        const double* raw = chunk( b, col );
+        if ( !raw )
+        {
+            blockColumn( b, col, buf );
+            raw = buf.data();
+        }
+        memcpy( x, raw + from, m * 8 );
+        x += m;
+        first += m;
+        n -= m;
+    }
+}
+
+void Reader::timeWindow( double tmin, double tmax,
+                         uint64_t& first, uint64_t& last ) const
+{
+    first = last = numRows_;
+    vector< double > t;
+    auto b = lower_bound( blocks_.begin(), blocks_.end(), tmin,
+    []( const Block& blk, double v ) { return blk.tEnd < v; } );
+    if ( b == blocks_.end() )
+        return;
+    blockColumn( b - blocks_.begin(), 0, t );
+    first = b->firstRow +
+            ( lower_bound( t.begin(), t.end(), tmin ) - t.begin() );
+
+    auto e = upper_bound( blocks_.begin(), blocks_.end(), tmax,
+    []( double v, const Block& blk ) { return v < blk.tStart; } );
+    if ( e == blocks_.begin() )
+    {
+        last = first = 0;
+        return;
+    }
+    --e;
+    if ( e != b )
+        blockColumn( e - blocks_.begin(), 0, t );
+    last = e->firstRow +
+           ( upper_bound( t.begin(), t.end(), tmax ) - t.begin() );
+    if ( last < first )
+        last = first;
+}
+
+} // namespace trace
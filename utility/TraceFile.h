@@ -0,0 +1,130 @@
+/**********************************************************************
+** This program is part of 'MOOSE', the
+** Messaging Object Oriented Simulation Environment.
+**           Copyright (C) 2003-2026 Upinder S. Bhalla. and NCBS
+** It is made available under the terms of the
+** GNU Lesser General Public License version 2.1
+** See the file COPYING.LIB for the full notice.
+**********************************************************************/
+
+#ifndef _TRACE_FILE_H
+#define _TRACE_FILE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * Chunked, columnar binary trace format (extension .mtr).
+ *
+ * Layout, all little endian:
+ *  - Header: 8 byte magic "MOOSETR\1", then uint32 number of columns,
+ *    uint32 rows per block, uint32 compression flag, and for each column
+ *    a uint32 length followed by the name. Padded with zeros to a
+ *    multiple of 8 bytes.
+ *  - Blocks: each block holds up to blockRows rows, stored column by
+ *    column. Each column is one chunk. Uncompressed chunks are plain
+ *    doubles at 8 byte aligned offsets, so a reader can map them as
+ *    arrays in place.
+ *  - Footer: for each block, uint64 first row, uint64 number of rows,
+ *    the first and last value of column 0 (the time) as doubles, then for
+ *    each column the uint64 offset and stored size of its chunk. A chunk
+ *    whose stored size is less than 8 * rows is compressed.
+ *  - Trailer, the last 32 bytes: uint64 footer offset, uint64 number of
+ *    blocks, uint64 number of rows, 8 byte magic "MTRINDEX".
+ *
+ * Blocks are full except the last one written before each flush, since
+ * the file is made readable at the end of every run.
+ *
+ * Compression is lossless: each value is XORed with the previous one in
+ * the column, the bytes are shuffled so that equal byte positions are
+ * together, and runs of zero bytes are collapsed. Slowly varying traces
+ * compress well. A chunk is stored raw if this does not make it smaller.
+ */
+namespace trace
+{
+
+/// Index entry of one block.
+struct Block
+{
+    uint64_t firstRow;
+    uint64_t numRows;
+    double tStart;
+    double tEnd;
+    vector< uint64_t > offset;
+    vector< uint64_t > bytes;
+};
+
+string headerBytes( const vector< string >& columns, size_t blockRows,
+                    bool compress );
+
+/// Footer and trailer for the given blocks, which end at footerOffset.
+string footerBytes( const vector< Block >& blocks, uint64_t footerOffset );
+
+/// Appends the compressed form of n doubles to out.
+void encodeChunk( const double* x, size_t n, string& out );
+
+/// Decodes a chunk of n doubles written by encodeChunk. False if corrupt.
+bool decodeChunk( const char* data, size_t bytes, size_t n, double* x );
+
+/**
+ * Read only view of a trace file. The file is memory mapped, so opening
+ * is cheap, and only the pages of the chunks that are read are loaded.
+ */
+class Reader
+{
+public:
+    /// Throws runtime_error if path is not a complete trace file.
+    Reader( const string& path );
+    ~Reader();
+
+    const vector< string >& columns() const;
+    const vector< Block >& blocks() const;
+    uint64_t numRows() const;
+    size_t blockRows() const;
+
+    /// Index of the named column, or -1.
+    int columnIndex( const string& name ) const;
+
+    /**
+     * Pointer to the values of column col in block b, or 0 if the chunk
+     * is compressed.
+     */
+    const double* chunk( size_t b, size_t col ) const;
+
+    /// Copies numRows values of column col starting at row first into x.
+    void read( size_t col, uint64_t first, uint64_t numRows, double* x ) const;
+
+    /**
+     * Rows [first, last) whose time, column 0, lies in [tmin, tmax].
+     * Times must be non decreasing, as they are for Table and Streamer.
+     * Only the blocks at the ends of the window are read.
+     */
+    void timeWindow( double tmin, double tmax,
+                     uint64_t& first, uint64_t& last ) const;
+
+private:
+    /// Values of column col in block b, decoded if needed.
+    void blockColumn( size_t b, size_t col, vector< double >& x ) const;
+
+    /// Block holding row, from the index.
+    size_t blockOf( uint64_t row ) const;
+
+    void unmap();
+
+    string path_;
+    const char* data_;
+    size_t size_;
+    void* mapping_;
+
+    vector< string > columns_;
+    vector< Block > blocks_;
+    uint64_t numRows_;
+    size_t blockRows_;
+};
+
+} // namespace trace
+
+#endif // _TRACE_FILE_H
@@ -164,21 +164,11 @@ void changeHeaderShape(std::fstream& fs, const size_t data_len, const size_t num
     fs.write(newHeader.c_str(), newHeader.size());
 }
 
-size_t writeHeader(std::fstream& fs, const vector<string>& colnames, const vector<size_t>& shape)
+string headerBytes(const vector<string>& colnames, const vector<size_t>& shape, size_t length)
 {
-    // Heder are always at the begining of file.
-    fs.seekp(0);
-
-    // Write the format string. 8 bytes.
-    fs.write(&__pre__[0], __pre__.size());
-
     char endianChar = cnpy2::BigEndianTest();
     const char formatChar = 'd';
 
-    // Next 4 bytes are header length. This is computed again when data is
-    // appended to the file. We can have maximum of 2^32 bytes of header which
-    // ~4GB.
-
     string header = ""; // This is the header to numpy file
     header += "{'descr':[";
     for( auto it = colnames.cbegin(); it != colnames.end(); it++ )
@@ -190,23 +180,46 @@ size_t writeHeader(std::fstream& fs, const vector<string>& colnames, const vecto
     header += shapeToString(shape);
     header += ",}";
 
-    // Add some extra sapce for safety.
-    header += string(12, ' ');
-
-    // FROM THE DOC: It is terminated by a newline (\n) and padded with spaces
-    // (\x20) to make the total of len(magic string) + 2 + len(length) +
-    // HEADER_LEN be evenly divisible by 64 for alignment purposes.
-    // pad with spaces so that preamble+headerlen+header is modulo 16 bytes.
-    // preamble is 8 bytes, header len is 4 bytes, total 12.
-    // header needs to end with \n
-    unsigned int remainder = 16 - (12 + header.size()) % 16;
-    header.insert(header.end(), remainder-1, ' ');
-    header += '\n';                             // Add newline. 
+    if( length > 0 )
+    {
+        // Rewriting an existing header: pad to exactly the old length, so
+        // that the data does not move.
+        if( __pre__.size() + 4 + header.size() + 1 > length )
+            return "";
+        header.insert(header.end(), length - __pre__.size() - 4 - header.size() - 1, ' ');
+        header += '\n';
+    }
+    else
+    {
+        // Add some extra sapce for safety.
+        header += string(12, ' ');
+
+        // FROM THE DOC: It is terminated by a newline (\n) and padded with spaces
+        // (\x20) to make the total of len(magic string) + 2 + len(length) +
+        // HEADER_LEN be evenly divisible by 64 for alignment purposes.
+        // pad with spaces so that preamble+headerlen+header is modulo 16 bytes.
+        // preamble is 8 bytes, header len is 4 bytes, total 12.
+        // header needs to end with \n
+        unsigned int remainder = 16 - (12 + header.size()) % 16;
+        header.insert(header.end(), remainder-1, ' ');
+        header += '\n';                             // Add newline. 
+    }
 
-    // Now write the size of header. Its 4 byte long in version 2.
+    // Format string of 8 bytes, then the size of header. Its 4 byte long in
+    // version 2, so we can have maximum of 2^32 bytes of header which ~4GB.
+    string ret(__pre__.begin(), __pre__.end());
     uint32_t s = header.size();
-    fs.write((char*)&s, 4);
-    fs << header;
+    ret.append((const char*)&s, 4);
+    ret += header;
+    return ret;
+}
+
+size_t writeHeader(std::fstream& fs, const vector<string>& colnames, const vector<size_t>& shape)
+{
+    // Heder are always at the begining of file.
+    fs.seekp(0);
+    string header = headerBytes(colnames, shape, 0);
+    fs.write(header.data(), header.size());
     return fs.tellp();
 }
 
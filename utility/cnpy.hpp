@@ -81,6 +81,16 @@ static vector<char> __pre__ {
     , (char)0x02, (char) 0x00               /* format */
 };
 
+/**
+ * @brief Complete header of a numpy file: magic string, header length and
+ * the dictionary.
+ *
+ * @param length If nonzero, the header is padded to exactly this many bytes
+ * so that it can replace an existing header in place. Returns an empty string
+ * if it does not fit.
+ */
+string headerBytes(const vector<string>& colnames, const vector<size_t>& shape, size_t length);
+
 size_t writeHeader(std::fstream& fp, const vector<string>& colnames, const vector<size_t>& shape);
 
 void writeNumpy(const string& outfile, const vector<double>& vec, const vector<string>& colnames);
@@ -77,6 +77,13 @@ double approximateWithInteger(const double x, moose::RNG& rng)
 
 double approximateWithInteger(const double x)
 {
-    return approximateWithInteger(x, moose::rng);
+    assert(x >= 0.0);
+    double xf = std::floor(x);
+    double base = x - xf;
+    if( base == 0.0)
+        return x;
+    if( moose::mtrand() < base)
+        return xf+1.0;
+    return xf;
 }
 